@@ -0,0 +1,124 @@
+#include "AllSetsLoader.h"
+
+#include <QFileInfo>
+#include <QTimer>
+#include <QtConcurrent>
+#include <algorithm>
+
+#include "qtutils_core.h"        // for logging QString
+
+#include "MtgJsonAllSetsData.h"
+
+// How often progress is checked while parsing.
+static const int PROGRESS_INTERVAL_MILLIS = 100;
+
+
+AllSetsLoader::AllSetsLoader( const Logging::Config& loggingConfig,
+                              QObject*               parent )
+:   QObject( parent ),
+    mFileSize( 0 ),
+    mBytesRead( 0 ),
+    mLastPercent( -1 ),
+    mParseAllSetsDataPtr( nullptr ),
+    mParseFile( NULL ),
+    mLoggingConfig( loggingConfig ),
+    mLogger( loggingConfig.createLogger() )
+{
+    mProgressTimer = new QTimer( this );
+    connect( mProgressTimer, &QTimer::timeout, this, &AllSetsLoader::handleProgressTimerTimeout );
+
+    connect( &mParseFutureWatcher, SIGNAL(finished()), this, SLOT(parsingFinished()) );
+}
+
+
+AllSetsLoader::~AllSetsLoader()
+{
+    // The parse can't be interrupted; let it run out before cleaning up.
+    if( mParseFile != NULL )
+    {
+        mParseFutureWatcher.disconnect( this );
+        mParseFuture.waitForFinished();
+        fclose( mParseFile );
+        delete mParseAllSetsDataPtr;
+    }
+}
+
+
+bool
+AllSetsLoader::start( const QString& filePath )
+{
+    if( mParseFile != NULL )
+    {
+        mLogger->warn( "load already in progress" );
+        return false;
+    }
+
+    mParseFile = fopen( filePath.toStdString().c_str(), "r" );
+    if( mParseFile == NULL )
+    {
+        // This may be normal, e.g. first session.
+        mLogger->notice( "failed to open AllSets file at {}", filePath );
+        return false;
+    }
+
+    mLogger->debug( "loading AllSets file at {}", filePath );
+    mFileSize = QFileInfo( filePath ).size();
+    mBytesRead = 0;
+    mLastPercent = -1;
+
+    std::atomic<qint64>* bytesReadPtr = &mBytesRead;
+    MtgJsonAllSetsData::ProgressCallback progressCallback = [bytesReadPtr]( std::size_t bytesRead ) {
+            bytesReadPtr->store( bytesRead );
+        };
+
+    mParseAllSetsDataPtr = new MtgJsonAllSetsData( mLoggingConfig.createChildConfig( "mtgjson" ) );
+    MtgJsonAllSetsData* allSetsDataPtr = mParseAllSetsDataPtr;
+    FILE* fp = mParseFile;
+    mParseFuture = QtConcurrent::run( [allSetsDataPtr, fp, progressCallback]() {
+            return allSetsDataPtr->parse( fp, progressCallback );
+        } );
+    mParseFutureWatcher.setFuture( mParseFuture );
+
+    emit progress( 0 );
+    mProgressTimer->start( PROGRESS_INTERVAL_MILLIS );
+    return true;
+}
+
+
+void
+AllSetsLoader::handleProgressTimerTimeout()
+{
+    if( mFileSize <= 0 ) return;
+
+    const int percent = static_cast<int>( 100 * mBytesRead.load() / mFileSize );
+    if( percent != mLastPercent )
+    {
+        mLastPercent = percent;
+        emit progress( std::min( percent, 100 ) );
+    }
+}
+
+
+void
+AllSetsLoader::parsingFinished()
+{
+    mProgressTimer->stop();
+    fclose( mParseFile );
+    mParseFile = NULL;
+
+    AllSetsDataSharedPtr allSetsDataSptr;
+    if( mParseFuture.result() )
+    {
+        mLogger->debug( "parsing succeeded" );
+        allSetsDataSptr.reset( mParseAllSetsDataPtr );
+    }
+    else
+    {
+        mLogger->warn( "failed to parse AllSets file" );
+        delete mParseAllSetsDataPtr;
+    }
+    mParseAllSetsDataPtr = nullptr;
+
+    emit progress( 100 );
+    emit finished( allSetsDataSptr );
+}
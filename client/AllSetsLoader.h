@@ -0,0 +1,57 @@
+#ifndef ALLSETSLOADER_H
+#define ALLSETSLOADER_H
+
+#include <QObject>
+#include <QFuture>
+#include <QFutureWatcher>
+#include <atomic>
+
+QT_BEGIN_NAMESPACE
+class QTimer;
+QT_END_NAMESPACE
+
+class MtgJsonAllSetsData;
+
+#include "clienttypes.h"
+#include "Logging.h"
+
+// Loads the cached AllSets file on a worker thread so the client can
+// start without waiting on it.  Progress is signaled periodically while
+// parsing, then finished() delivers the data (null on failure).
+class AllSetsLoader : public QObject
+{
+    Q_OBJECT
+
+public:
+    AllSetsLoader( const Logging::Config& loggingConfig = Logging::Config(),
+                   QObject*               parent = 0 );
+    virtual ~AllSetsLoader();
+
+    // Start loading a file.  Returns false if the file can't be opened.
+    bool start( const QString& filePath );
+
+signals:
+    void progress( int percent );
+    void finished( const AllSetsDataSharedPtr& allSetsDataSptr );
+
+private slots:
+    void handleProgressTimerTimeout();
+    void parsingFinished();
+
+private:
+
+    qint64               mFileSize;
+    std::atomic<qint64>  mBytesRead;
+    int                  mLastPercent;
+    QTimer*              mProgressTimer;
+
+    MtgJsonAllSetsData*  mParseAllSetsDataPtr;
+    FILE*                mParseFile;
+    QFuture<bool>        mParseFuture;
+    QFutureWatcher<bool> mParseFutureWatcher;
+
+    Logging::Config mLoggingConfig;
+    std::shared_ptr<spdlog::logger> mLogger;
+};
+
+#endif
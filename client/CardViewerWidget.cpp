@@ -1,12 +1,15 @@
 #include "CardViewerWidget.h"
 
+#include <algorithm>
+#include <QHash>
 #include <QVariant>
+#include <QVector>
 #include <QStyleOption>
 #include <QPainter>
+#include <QTimer>
 
 #include "qtutils_core.h"
 #include "qtutils_widget.h"
-#include "StringUtil.h"
 
 #include "CardData.h"
 #include "ImageLoader.h"
@@ -21,6 +24,13 @@ const static QString gStyleSheet =
     "QLabel { background-color: white; }\n"
     "QLabel[alert=\"true\"] { color: white; background-color: #FF2828; }\n";
 
+// Size of a card widget before its image loads.
+const static QSize gCardDefaultSize( 223, 310 );
+
+// Views with more cards than this only create widgets for cards as they
+// scroll into view; the rest are reserved with placeholders.
+const static std::size_t gVirtualizeCardCount = 100;
+
 
 CardViewerWidget::CardViewerWidget( ImageLoaderFactory*    imageLoaderFactory,
                                     const Logging::Config& loggingConfig,
@@ -32,14 +42,20 @@ CardViewerWidget::CardViewerWidget( ImageLoaderFactory*    imageLoaderFactory,
     mZoomFactor( 1.0f ),
     mAlerted( false ),
     mLoggingConfig( loggingConfig ),
-    mLogger( loggingConfig.createLogger() )
+    mLogger( loggingConfig.createLogger() ),
+    mSectionsDirty( true ),
+    mSortedCardsDirty( true ),
+    mPlaceholderCount( 0 ),
+    mMaterializePending( false )
 {
     setStyleSheet( gStyleSheet );
 
     mLayout = new QVBoxLayout();
 
-    // This will initialize the internal filtering.
-    setFilters( {} );
+    // This will initialize the internal filtering.  Layout is deferred
+    // until cards are set so that subclasses with their own layouts
+    // never see the filter sections.
+    initFilters( {} );
 
     setLayout( mLayout );
 }
@@ -53,160 +69,348 @@ CardViewerWidget::~CardViewerWidget()
 void
 CardViewerWidget::setCards( const QList<CardDataSharedPtr>& cards )
 {
-    mCardsList = cards;
+    // Sort and categorize up front.  As we filter, everything will stay
+    // sorted.
+    updateSortedCards( cards );
+
+    QList<CardDataSharedPtr> sortedCardsList;
+    sortedCardsList.reserve( mSortedCards.size() );
+    for( const SortedCard& sortedCard : mSortedCards )
+    {
+        sortedCardsList.append( sortedCard.cardData );
+    }
+    mCardsList = sortedCardsList;
 
     //
     // Performance gets bad if creating all new widgets from scratch,
-    // especially when images are scaled.  Instead need to extract the
-    // widgets from the layout, then only create new stuff as needed.
+    // especially when images are scaled.  Instead the section layouts
+    // persist and are handed their new widget order; existing widgets
+    // are matched by card identity and only new cards get widgets.
     //
-    
-    // Liberate the widgets we want to retain before clearing out the layout.
-    for( auto w : mCardWidgetsList )
+
+    if( mSectionsDirty || (mSections.size() != (int)mFilters.size()) )
     {
-        w->setParent( 0 );
+        rebuildSections();
     }
 
-    // Clear out layout-tracking list.
-    mFilteredCardsLayouts.clear();
-
-    // Clear our label-tracking list.
-    mFilteredCardsLabels.clear();
+    // Index the current widgets by card so they can be reused.  Basic
+    // lands share card data, hence a list per card.
+    QHash<CardData*,QList<CardWidget*>> reusableCardWidgets;
+    reusableCardWidgets.reserve( mCardWidgetsList.size() );
+    for( auto w : mCardWidgetsList )
+    {
+        if( w ) reusableCardWidgets[w->getCardData().get()].append( w );
+    }
 
-    // Clear out the top-level layout - we're rebuilding it here.
-    qtutils::clearLayout( mLayout );
+    // For large views, cards without a widget get a placeholder (null)
+    // until they are painted.  Basic lands always get widgets so that
+    // placeholders map directly onto mSortedCards.
+    const bool virtualize = (mSortedCards.size() > gVirtualizeCardCount);
+    mPlaceholderCount = 0;
 
-    // This will contain all widgets once they're created/reused.
+    // Each card goes to the section of the first filter that matches it.
+    QVector<QList<QWidget*>> sectionWidgets( mFilters.size() );
     QList<CardWidget*> newCardWidgetsList;
-
-    // This local function picks a matching already-created CardWidget from
-    // our tracking list to speed up the overall "setCards" operation which happens
-    // on every sort, categorize, etc.
-    auto takeWidgetFromCardWidgetsList =
-        [this]( const CardDataSharedPtr& cardDataSharedPtr ) -> CardWidget* {
-            for( int i = 0; i < mCardWidgetsList.count(); ++i ) {
-                CardWidget* w = mCardWidgetsList[i];
-                if( w->getCardData() == cardDataSharedPtr ) {
-                    mLogger->debug( "reusing CardWidget for name={} muid={}",
-                            cardDataSharedPtr->getName(), cardDataSharedPtr->getMultiverseId() );
-                    mCardWidgetsList.takeAt( i );
-                    return w;
-                }
+    newCardWidgetsList.reserve( mSortedCards.size() + mBasicLandQtys.getTotalQuantity() );
+    auto placeCardFn = [&]( const CardDataSharedPtr& cardDataSharedPtr, int category, bool allowPlaceholder )
+        {
+            // Look for an existing card widget that matches our card data,
+            // and extract it if found; otherwise create one.
+            CardWidget* cardWidget = nullptr;
+            auto iter = reusableCardWidgets.find( cardDataSharedPtr.get() );
+            if( (iter != reusableCardWidgets.end()) && !iter->isEmpty() )
+            {
+                cardWidget = iter->takeFirst();
             }
-            return nullptr;
-        };
-
-    // This local function creates and connects a CardWidget.
-    auto createCardWidget =
-        [this]( const CardDataSharedPtr& cardDataSharedPtr ) -> CardWidget* {
-            mLogger->debug( "creating CardWidget name={} muid={}", cardDataSharedPtr->getName(), cardDataSharedPtr->getMultiverseId() );
-            QString card = QString::fromStdString( cardDataSharedPtr->getName() );
-
-            CardWidget* cardWidget = new CardWidget( cardDataSharedPtr,
-                                                     mImageLoaderFactory,
-                                                     QSize( 223, 310 ),
-                                                     mLoggingConfig.createChildConfig( "cardwidget" ) );
-            cardWidget->setZoomFactor( mZoomFactor );
-            cardWidget->setPreselectable( mCardsPreselectable );
-            cardWidget->loadImage();
-            connect(cardWidget, SIGNAL(preselectRequested()),
-                    this, SLOT(handleCardPreselectRequested()));
-            connect(cardWidget, SIGNAL(selectRequested()),
-                    this, SLOT(handleCardSelectRequested()));
-            connect(cardWidget, SIGNAL(moveRequested()),
-                    this, SLOT(handleCardMoveRequested()));
-            cardWidget->setContextMenuPolicy( Qt::CustomContextMenu );
-            connect(cardWidget, SIGNAL(customContextMenuRequested(const QPoint&)),
-                    this, SLOT(handleCardContextMenu(const QPoint&)));
-            return cardWidget;
+            else if( allowPlaceholder )
+            {
+                ++mPlaceholderCount;
+            }
+            else
+            {
+                cardWidget = createCardWidget( cardDataSharedPtr );
+            }
+            sectionWidgets[category].append( cardWidget );
+            newCardWidgetsList.append( cardWidget );
         };
 
-    //
-    // Do the sorting and card list management on the big list up front.
-    // As we filter, everything will stay sorted.
-    //
-
-    // Stable-sort our list here based on current sort functions.
-    for( auto sortFunc : mSortFunctions )
+    for( const SortedCard& sortedCard : mSortedCards )
     {
-        std::stable_sort( mCardsList.begin(), mCardsList.end(), sortFunc );
+        placeCardFn( sortedCard.cardData, sortedCard.category, virtualize );
     }
 
-    // Add basic lands to the list here so they don't get sorted with the
-    // other cards.
-    QList<CardDataSharedPtr> displayedCardsList = mCardsList;
+    // Add basic lands here so they don't get sorted with the other cards.
     for( auto basic : gBasicLandTypeArray )
     {
-        for( int i = 0; i < mBasicLandQtys.getQuantity( basic ); ++i )
+        const int qty = mBasicLandQtys.getQuantity( basic );
+        if( qty <= 0 ) continue;
+        CardDataSharedPtr cardDataSharedPtr = mBasicLandCardDataMap.getCardData( basic );
+        const int category = getCategory( cardDataSharedPtr );
+        for( int i = 0; i < qty; ++i )
         {
-            displayedCardsList.append( mBasicLandCardDataMap.getCardData( basic ) );
+            placeCardFn( cardDataSharedPtr, category, false );
         }
     }
 
-    for( auto filter : mFilters )
+    for( int f = 0; f < mSections.size(); ++f )
     {
-        // Move matching cards into a filtered card list.
-        QList<CardDataSharedPtr> filteredCardsList;
-        QMutableListIterator<CardDataSharedPtr> i( displayedCardsList );
-        while( i.hasNext() )
-        {
-            CardDataSharedPtr c = i.next();
-            if( filter.filterFunc( c ) )
-            {
-                filteredCardsList.push_back( c );
-                i.remove();
-            }
-        }
+        mSections[f].layout->setWidgets( sectionWidgets[f] );
+        updateSectionLabel( f );
+    }
+
+    // Clean up any cardwidgets that weren't reused.
+    for( auto& widgets : reusableCardWidgets )
+    {
+        for( auto w : widgets ) w->deleteLater();
+    }
+
+    // Old is new.
+    mCardWidgetsList = newCardWidgetsList;
+}
+
+
+void
+CardViewerWidget::addCard( const CardDataSharedPtr& cardDataSharedPtr )
+{
+    if( !canUpdateSingleCard() )
+    {
+        QList<CardDataSharedPtr> cards = mCardsList;
+        cards.append( cardDataSharedPtr );
+        setCards( cards );
+        return;
+    }
+
+    // Insert after any equal keys, as a stable sort of the appended card
+    // would.
+    const SortedCard sortedCard = createSortedCard( cardDataSharedPtr );
+    auto iter = std::upper_bound( mSortedCards.begin(), mSortedCards.end(), sortedCard, compareSortedCards );
+    const int index = iter - mSortedCards.begin();
+    mSortedCards.insert( iter, sortedCard );
+    mCardsList.insert( index, cardDataSharedPtr );
+
+    // Basic lands follow the sorted cards in each section, so the position
+    // within the section is the position within the category.
+    CardWidget* cardWidget = createCardWidget( cardDataSharedPtr );
+    mCardWidgetsList.insert( index, cardWidget );
+    const int category = sortedCard.category;
+    mSections[category].layout->insertWidget( index - getCategoryStartIndex( category ), cardWidget );
+    updateSectionLabel( category );
+}
+
+
+void
+CardViewerWidget::removeCard( const CardDataSharedPtr& cardDataSharedPtr )
+{
+    if( !canUpdateSingleCard() )
+    {
+        QList<CardDataSharedPtr> cards = mCardsList;
+        cards.removeOne( cardDataSharedPtr );
+        setCards( cards );
+        return;
+    }
+
+    // Only copies of the same card share a key, so the search within the
+    // equal range is short.
+    const SortedCard sortedCard = createSortedCard( cardDataSharedPtr );
+    auto range = std::equal_range( mSortedCards.begin(), mSortedCards.end(), sortedCard, compareSortedCards );
+    auto iter = std::find_if( range.first, range.second,
+            [&cardDataSharedPtr]( const SortedCard& s ) { return s.cardData == cardDataSharedPtr; } );
+    if( iter == range.second )
+    {
+        mLogger->warn( "card to remove not found: {}", cardDataSharedPtr->getName() );
+        return;
+    }
+
+    const int index = iter - mSortedCards.begin();
+    const int category = sortedCard.category;
+    const int sectionIndex = index - getCategoryStartIndex( category );
+    mSortedCards.erase( iter );
+    mCardsList.removeAt( index );
+
+    CardWidget* cardWidget = mCardWidgetsList.takeAt( index );
+    delete mSections[category].layout->takeAt( sectionIndex );
+    if( cardWidget )
+    {
+        cardWidget->deleteLater();
+    }
+    else
+    {
+        --mPlaceholderCount;
+    }
+    updateSectionLabel( category );
+}
+
+
+bool
+CardViewerWidget::canUpdateSingleCard() const
+{
+    return !mSortedCardsDirty && !mSectionsDirty && (mSections.size() == (int)mFilters.size());
+}
+
 
-        // If nothing got filtered, move on to the next filter.
-        if( filteredCardsList.empty() ) continue;
+int
+CardViewerWidget::getCategoryStartIndex( int category ) const
+{
+    auto iter = std::lower_bound( mSortedCards.begin(), mSortedCards.end(), category,
+            []( const SortedCard& s, int c ) { return s.category < c; } );
+    return iter - mSortedCards.begin();
+}
+
+
+void
+CardViewerWidget::updateSectionLabel( int category )
+{
+    const Section& section = mSections[category];
+    const int count = section.layout->count();
 
-        // Unless we only have a single active filter (the "Other" filter),
-        // show a label for the filtered cards. 
-        if( mFilters.size() > 1 )
+    // Unless we only have a single active filter (the "Other" filter),
+    // show a label for non-empty sections.
+    const bool showLabel = (mFilters.size() > 1) && (count > 0);
+    if( showLabel )
+    {
+        section.label->setText( QString::fromStdString( mFilters[category].name ) +
+                " (" + QString::number( count ) + ")" );
+    }
+    section.label->setVisible( showLabel );
+}
+
+
+CardViewerWidget::SortedCard
+CardViewerWidget::createSortedCard( const CardDataSharedPtr& cardDataSharedPtr ) const
+{
+    SortedCard sortedCard = { cardDataSharedPtr,
+                              createSortKey( *cardDataSharedPtr, mSortCriteria ),
+                              getCategory( cardDataSharedPtr ) };
+    return sortedCard;
+}
+
+
+void
+CardViewerWidget::updateSortedCards( const QList<CardDataSharedPtr>& cards )
+{
+    if( mSortedCardsDirty )
+    {
+        mSortedCardsDirty = false;
+
+        mSortedCards.clear();
+        mSortedCards.reserve( cards.size() );
+        for( const CardDataSharedPtr& cardDataSharedPtr : cards )
         {
-            QLabel* label = new QLabel( QString::fromStdString( filter.name ) + " (" + QString::number( filteredCardsList.size() ) + ")" );
-            label->setStyleSheet( gStyleSheet );
-            label->setProperty( "alert", mAlerted ? "true" : "false" );
-            label->setAlignment( Qt::AlignHCenter | Qt::AlignTop );
-            mFilteredCardsLabels.push_back( label );
-            mLayout->addWidget( label );
+            mSortedCards.push_back( createSortedCard( cardDataSharedPtr ) );
         }
+        std::stable_sort( mSortedCards.begin(), mSortedCards.end(), compareSortedCards );
+        return;
+    }
 
-        FlowLayout* filteredCardsLayout = new FlowLayout();
-        mFilteredCardsLayouts.push_back( filteredCardsLayout );
-        mLayout->addLayout( filteredCardsLayout );
-        for( auto cardDataSharedPtr : filteredCardsList )
-        {
-            // Look for an existing card widget that matches our card data,
-            // and extract it from the list if found.
-            CardWidget* cardWidget = nullptr;
-            cardWidget = takeWidgetFromCardWidgetsList( cardDataSharedPtr );
+    // Count the incoming cards, then keep existing entries that are still
+    // wanted.  Whatever count remains is new.
+    QHash<CardData*,int> wantedCounts;
+    wantedCounts.reserve( cards.size() );
+    for( const CardDataSharedPtr& cardDataSharedPtr : cards )
+    {
+        ++wantedCounts[cardDataSharedPtr.get()];
+    }
 
-            if( !cardWidget )
+    auto removeIter = std::remove_if( mSortedCards.begin(), mSortedCards.end(),
+            [&wantedCounts]( const SortedCard& sortedCard )
             {
-                // The widget doesn't exist.  Create it.
-                cardWidget = createCardWidget( cardDataSharedPtr );
-            }
-            filteredCardsLayout->addWidget( cardWidget );
-            newCardWidgetsList.push_back( cardWidget );
-        }
+                auto iter = wantedCounts.find( sortedCard.cardData.get() );
+                if( (iter == wantedCounts.end()) || (iter.value() == 0) ) return true;
+                --iter.value();
+                return false;
+            } );
+    mSortedCards.erase( removeIter, mSortedCards.end() );
+
+    // Insert new cards after any equal keys, as a stable sort of the
+    // appended card would.
+    for( const CardDataSharedPtr& cardDataSharedPtr : cards )
+    {
+        auto countIter = wantedCounts.find( cardDataSharedPtr.get() );
+        if( countIter.value() == 0 ) continue;
+        --countIter.value();
+
+        const SortedCard sortedCard = createSortedCard( cardDataSharedPtr );
+        auto iter = std::upper_bound( mSortedCards.begin(), mSortedCards.end(), sortedCard, compareSortedCards );
+        mSortedCards.insert( iter, sortedCard );
+    }
+}
+
+
+int
+CardViewerWidget::getCategory( const CardDataSharedPtr& cardDataSharedPtr ) const
+{
+    for( std::size_t f = 0; f < mFilters.size(); ++f )
+    {
+        if( mFilters[f].filterFunc( cardDataSharedPtr ) ) return f;
+    }
+
+    // Unreachable; the last filter catches everything.
+    return mFilters.size() - 1;
+}
+
+
+void
+CardViewerWidget::rebuildSections()
+{
+    mSectionsDirty = false;
+
+    // Take the card widgets out of the old section layouts without
+    // affecting the widgets themselves, then tear down the layouts.
+    for( const Section& section : mSections )
+    {
+        section.layout->setWidgets( QList<QWidget*>() );
+    }
+    mSections.clear();
+    qtutils::clearLayout( mLayout );
+
+    for( const Filter& filter : mFilters )
+    {
+        Section section;
+        section.label = new QLabel();
+        section.label->setStyleSheet( gStyleSheet );
+        section.label->setProperty( "alert", mAlerted ? "true" : "false" );
+        section.label->setAlignment( Qt::AlignHCenter | Qt::AlignTop );
+        section.label->setVisible( false );
+        mLayout->addWidget( section.label );
+
+        section.layout = new FlowLayout();
+        section.layout->setPlaceholderSize( gCardDefaultSize * mZoomFactor );
+        mLayout->addLayout( section.layout );
+
+        mSections.append( section );
     }
 
     if( mFooterSpacing > 0 ) mLayout->addSpacing( mFooterSpacing );
 
     // This keeps everything pushed nicely to the top of the main area.
     mLayout->addStretch();
+}
 
-    // Clean up any cardwidgets remaining in the original list.
-    for( auto w : mCardWidgetsList )
-    {
-        w->deleteLater();
-    }
-    mCardWidgetsList.clear();
 
-    // Old is new.
-    mCardWidgetsList = newCardWidgetsList;
+CardWidget*
+CardViewerWidget::createCardWidget( const CardDataSharedPtr& cardDataSharedPtr )
+{
+    mLogger->debug( "creating CardWidget name={} muid={}", cardDataSharedPtr->getName(), cardDataSharedPtr->getMultiverseId() );
+
+    // The image is loaded when the widget is first painted, i.e. when it
+    // scrolls into view.
+    CardWidget* cardWidget = new CardWidget( cardDataSharedPtr,
+                                             mImageLoaderFactory,
+                                             gCardDefaultSize,
+                                             mLoggingConfig.createChildConfig( "cardwidget" ) );
+    cardWidget->setZoomFactor( mZoomFactor );
+    cardWidget->setPreselectable( mCardsPreselectable );
+    cardWidget->setLoadImageOnPaint( true );
+    connect(cardWidget, SIGNAL(preselectRequested()),
+            this, SLOT(handleCardPreselectRequested()));
+    connect(cardWidget, SIGNAL(selectRequested()),
+            this, SLOT(handleCardSelectRequested()));
+    connect(cardWidget, SIGNAL(moveRequested()),
+            this, SLOT(handleCardMoveRequested()));
+    cardWidget->setContextMenuPolicy( Qt::CustomContextMenu );
+    connect(cardWidget, SIGNAL(customContextMenuRequested(const QPoint&)),
+            this, SLOT(handleCardContextMenu(const QPoint&)));
+    return cardWidget;
 }
 
 
@@ -245,10 +449,14 @@ CardViewerWidget::setZoomFactor( float zoomFactor )
     mLogger->trace( "setting zoom factor: {}", zoomFactor );
     mZoomFactor = zoomFactor;
 
-    // Update the zoom for each CardWidget.
+    // Update the zoom for each CardWidget and placeholder.
     for( auto cardWidget : mCardWidgetsList )
     {
-        cardWidget->setZoomFactor( mZoomFactor );
+        if( cardWidget ) cardWidget->setZoomFactor( mZoomFactor );
+    }
+    for( const Section& section : mSections )
+    {
+        section.layout->setPlaceholderSize( gCardDefaultSize * mZoomFactor );
     }
 }
 
@@ -258,28 +466,17 @@ CardViewerWidget::setSortCriteria( const CardSortCriterionVector& sortCriteria )
 {
     mLogger->trace( "setting sort criteria" );
 
-    mSortFunctions.erase( mSortFunctions.begin(), mSortFunctions.end() );
-
-    // The actual sorting is done in reverse order, so insert functions
-    // in front.
+    mSortCriteria.clear();
     for( CardSortCriterionType criterion : sortCriteria )
     {
         switch( criterion )
         {
             case CARD_SORT_CRITERION_NAME:
-                mSortFunctions.insert( mSortFunctions.begin(), compareCardDataName );
-                break;
             case CARD_SORT_CRITERION_CMC:
-                mSortFunctions.insert( mSortFunctions.begin(), compareCardDataCMCs );
-                break;
             case CARD_SORT_CRITERION_COLOR:
-                mSortFunctions.insert( mSortFunctions.begin(), compareCardDataColors );
-                break;
             case CARD_SORT_CRITERION_RARITY:
-                mSortFunctions.insert( mSortFunctions.begin(), compareCardDataRarity );
-                break;
             case CARD_SORT_CRITERION_TYPE:
-                mSortFunctions.insert( mSortFunctions.begin(), compareCardDataTypes );
+                mSortCriteria.push_back( criterion );
                 break;
             case CARD_SORT_CRITERION_NONE:
                 break;
@@ -289,7 +486,8 @@ CardViewerWidget::setSortCriteria( const CardSortCriterionVector& sortCriteria )
         }
     }
 
-    // Reset the cards list, sorting is done there.
+    // Reset the cards list, keys are recomputed and sorting is done there.
+    mSortedCardsDirty = true;
     setCards( mCardsList );
 }
 
@@ -307,8 +505,9 @@ CardViewerWidget::setAlert( bool alert )
     style()->polish( this );
     update();
 
-    for( auto label : mFilteredCardsLabels )
+    for( const Section& section : mSections )
     {
+        QLabel* label = section.label;
         label->setProperty( "alert", alert ? "true" : "false" );
         label->style()->unpolish( label );
         label->style()->polish( label );
@@ -332,7 +531,7 @@ CardViewerWidget::setCardsPreselectable( bool preselectable )
 
     for( auto w : mCardWidgetsList )
     {
-        w->setPreselectable( preselectable );
+        if( w ) w->setPreselectable( preselectable );
     }
 
     mCardsPreselectable = preselectable;
@@ -374,8 +573,7 @@ CardViewerWidget::setCategorization( const CardCategorizationType& categorizatio
             Filter colorlessFilter( "Colorless",
                     []( const CardDataSharedPtr& cardDataSharedPtr )
                     {
-                        std::set<ColorType> colors = cardDataSharedPtr->getColors();
-                        return colors.empty();
+                        return cardDataSharedPtr->getColorMask() == 0;
                     } );
             filters.push_back( colorlessFilter );
 
@@ -385,8 +583,7 @@ CardViewerWidget::setCategorization( const CardCategorizationType& categorizatio
                 Filter f( stringify( color ),
                         [color]( const CardDataSharedPtr& cardDataSharedPtr )
                         {
-                            std::set<ColorType> colors = cardDataSharedPtr->getColors();
-                            return (colors.size() == 1) && (*colors.begin() == color);
+                            return cardDataSharedPtr->getColorMask() == colorMask( color );
                         } );
                 filters.push_back( f );
             }
@@ -395,8 +592,7 @@ CardViewerWidget::setCategorization( const CardCategorizationType& categorizatio
             Filter multicolorFilter( "Multicolor",
                     []( const CardDataSharedPtr& cardDataSharedPtr )
                     {
-                        std::set<ColorType> colors = cardDataSharedPtr->getColors();
-                        return (colors.size() > 1);
+                        return cardDataSharedPtr->isMulticolor();
                     } );
             filters.push_back( multicolorFilter );
             break;
@@ -425,11 +621,11 @@ CardViewerWidget::setCategorization( const CardCategorizationType& categorizatio
             std::vector<std::string> allTypes = { "Land", "Artifact", "Creature", "Enchantment", "Instant", "Sorcery", "Planeswalker" };
             for( auto type : allTypes )
             {
+                const TypeMask typeMask = CardTypeIds::getMask( type );
                 Filter f( type,
-                        [type]( const CardDataSharedPtr& cardDataSharedPtr )
+                        [typeMask]( const CardDataSharedPtr& cardDataSharedPtr )
                         {
-                            std::set<std::string> cardTypes = cardDataSharedPtr->getTypes();
-                            return (cardTypes.size() == 1) && StringUtil::icompare( type, *cardTypes.begin() );
+                            return cardDataSharedPtr->getTypeMask() == typeMask;
                         } );
                 filters.push_back( f );
             }
@@ -438,8 +634,7 @@ CardViewerWidget::setCategorization( const CardCategorizationType& categorizatio
             Filter f( "Multi-type",
                     []( const CardDataSharedPtr& cardDataSharedPtr )
                     {
-                        std::set<std::string> cardTypes = cardDataSharedPtr->getTypes();
-                        return (cardTypes.size() > 1);
+                        return typeCount( cardDataSharedPtr->getTypeMask() ) > 1;
                     } );
             filters.push_back( f );
 
@@ -463,6 +658,14 @@ CardViewerWidget::setCategorization( const CardCategorizationType& categorizatio
 // an "other" category,
 void
 CardViewerWidget::setFilters( const FilterVectorType& filters )
+{
+    initFilters( filters );
+    setCards( mCardsList );
+}
+
+
+void
+CardViewerWidget::initFilters( const FilterVectorType& filters )
 {
     mFilters = filters;
 
@@ -470,8 +673,8 @@ CardViewerWidget::setFilters( const FilterVectorType& filters )
     // catches everything.
     Filter f( "Other", [](const CardDataSharedPtr&) { return true; } );
     mFilters.push_back( f );
-
-    setCards( mCardsList );
+    mSectionsDirty = true;
+    mSortedCardsDirty = true;
 }
 
 
@@ -481,7 +684,7 @@ CardViewerWidget::setPreselected( CardWidget* cardWidget )
     // Disable preselection for all cards but the one requested.
     for( auto w : mCardWidgetsList )
     {
-        w->setPreselected( w == cardWidget );
+        if( w ) w->setPreselected( w == cardWidget );
     }
 }
 
@@ -512,9 +715,55 @@ CardViewerWidget::paintEvent( QPaintEvent *pe )
     o.initFrom( this );
     QPainter p( this );
     style()->drawPrimitive( QStyle::PE_Widget, &o, &p, this );
+
+    // Inside a scroll area only the part in view is painted, so this is
+    // where placeholders learn they are visible.  Widgets are created
+    // outside of painting.
+    if( mPlaceholderCount > 0 )
+    {
+        mMaterializeRect |= pe->rect();
+        if( !mMaterializePending )
+        {
+            mMaterializePending = true;
+            QTimer::singleShot( 0, this, &CardViewerWidget::materializeVisibleCards );
+        }
+    }
 };
 
 
+void
+CardViewerWidget::materializeVisibleCards()
+{
+    mMaterializePending = false;
+
+    // Include a row above and below so that small scrolls find cards
+    // already in place.
+    const int margin = gCardDefaultSize.height() * mZoomFactor;
+    const QRect rect = mMaterializeRect.adjusted( 0, -margin, 0, margin );
+    mMaterializeRect = QRect();
+
+    for( int f = 0; (f < mSections.size()) && (mPlaceholderCount > 0); ++f )
+    {
+        FlowLayout* layout = mSections[f].layout;
+        if( !layout->geometry().intersects( rect ) ) continue;
+
+        // Placeholders are never basic lands, so section positions map
+        // directly onto the category's run of sorted cards.
+        const int start = getCategoryStartIndex( f );
+        for( int i = 0; i < layout->count(); ++i )
+        {
+            QLayoutItem* item = layout->itemAt( i );
+            if( item->widget() || !item->geometry().intersects( rect ) ) continue;
+
+            CardWidget* cardWidget = createCardWidget( mSortedCards[start + i].cardData );
+            mCardWidgetsList[start + i] = cardWidget;
+            layout->setWidgetAt( i, cardWidget );
+            --mPlaceholderCount;
+        }
+    }
+}
+
+
 void
 CardViewerWidget::handleCardPreselectRequested()
 {
@@ -559,53 +808,55 @@ CardViewerWidget::handleCardContextMenu( const QPoint& pos )
 }
 
 
-bool
-CardViewerWidget::compareCardDataColors( CardDataSharedPtr a, CardDataSharedPtr b )
-{   
-    std::set<ColorType> colorsA = a->getColors();
-    std::set<ColorType> colorsB = b->getColors();
-
-    if( (colorsA.size() > 1) && (colorsB.size() > 1) )
-    {
-        // Both cards are multicolor, order by first color.
-        return *(colorsA.begin()) < *(colorsB.begin());
-    }
-    else if( colorsA.size() == colorsB.size() )
+std::string
+CardViewerWidget::createSortKey( const CardData& cardData, const CardSortCriterionVector& sortCriteria )
+{
+    std::string key;
+    for( CardSortCriterionType criterion : sortCriteria )
     {
-        if( !colorsA.empty() )
-        {
-            // Both cards are single-color, order by first color.
-            return *(colorsA.begin()) < *(colorsB.begin());
-        }
-        else
+        switch( criterion )
         {
-            // Both cards are colorless, no ordering here.
-            return false;
+            case CARD_SORT_CRITERION_NAME:
+            {
+                // Terminated so that a name sorts before its extensions.
+                key += cardData.getName();
+                key += '\0';
+                break;
+            }
+            case CARD_SORT_CRITERION_CMC:
+            {
+                // Big-endian with the sign bit flipped to order bytewise.
+                const uint32_t cmc = uint32_t( cardData.getCMC() ) ^ 0x80000000u;
+                for( int shift = 24; shift >= 0; shift -= 8 )
+                {
+                    key += char( (cmc >> shift) & 0xFF );
+                }
+                break;
+            }
+            case CARD_SORT_CRITERION_COLOR:
+            {
+                // Colorless, then single colors in WUBRG order, then
+                // multicolor by first color.
+                const ColorMask colors = cardData.getColorMask();
+                const int count = std::min( colorCount( colors ), 2 );
+                key += char( (count << 4) | (count > 0 ? firstColor( colors ) : 0) );
+                break;
+            }
+            case CARD_SORT_CRITERION_RARITY:
+                key += char( cardData.getRarity() );
+                break;
+            case CARD_SORT_CRITERION_TYPE:
+            {
+                // Untyped first, then by first type.  Standard type ids
+                // are assigned alphabetically, so this matches ordering
+                // by name for them.
+                const TypeMask types = cardData.getTypeMask();
+                key += char( types ? 1 + firstTypeId( types ) : 0 );
+                break;
+            }
+            default:
+                break;
         }
     }
-    else
-    {
-        // Card are different color quantities and not both multicolor, so
-        // order by quantity, i.e. colorless < single-color < multicolor.
-        return (colorsA.size() < colorsB.size());
-    }
-}   
-
-
-bool
-CardViewerWidget::compareCardDataTypes( CardDataSharedPtr a, CardDataSharedPtr b )
-{   
-    std::set<std::string> typesA = a->getTypes();
-    std::set<std::string> typesB = b->getTypes();
-
-    if( !typesA.empty() && !typesB.empty() )
-    {
-        // Both cards have at least one type, order by first type.
-        return *(typesA.begin()) < *(typesB.begin());
-    }
-    else
-    {
-        // If either type-set is empty then just compare sizes.
-        return typesA.size() < typesB.size();
-    }
-}   
+    return key;
+}
@@ -40,11 +40,16 @@ public:
     void setBasicLandCardDataMap( const BasicLandCardDataMap& val );
 
     // Set additional space below cards.
-    void setFooterSpacing( int spacing ) { mFooterSpacing = spacing; }
+    void setFooterSpacing( int spacing ) { mFooterSpacing = spacing; mSectionsDirty = true; }
 
     // Set card list.  (Does not include basic lands.)
     virtual void setCards( const QList<CardDataSharedPtr>& cards );
 
+    // Add or remove a single card.  Only the widget for that card and the
+    // label of its section are touched.
+    virtual void addCard( const CardDataSharedPtr& cardDataSharedPtr );
+    virtual void removeCard( const CardDataSharedPtr& cardDataSharedPtr );
+
     // Set cards that are selected.  (Use empty map to reset.)
     virtual void setSelectedCards( const QMap<CardDataSharedPtr,SelectedCardData>& selectedCards );
 
@@ -75,8 +80,8 @@ public slots:
 
     void setCategorization( const CardCategorizationType& categorization );
 
-    // Enable/configure sorting.  Cards are stable-sorted in reverse order
-    // of the criteria.
+    // Enable/configure sorting.  Cards are ordered by the first criterion,
+    // with ties broken by each following criterion in turn.
     void setSortCriteria( const CardSortCriterionVector& sortCriteria );
 
     // Alter appearance for an alerted state.
@@ -96,6 +101,8 @@ protected:
     QVBoxLayout* mLayout;
 
     QList<CardDataSharedPtr> mCardsList;
+
+    // Entries may be null for cards not yet scrolled into view.
     QList<CardWidget*>       mCardWidgetsList;
 
     QMap<CardDataSharedPtr,SelectedCardData> mSelectedCards;
@@ -122,9 +129,6 @@ private slots:
 
 private:
 
-    typedef std::function<bool(CardDataSharedPtr,CardDataSharedPtr)> SortFunctionType;
-    typedef std::vector<SortFunctionType> SortFunctionVectorType;
-
     // This filtering functionality could eventually be externally exposed.
     typedef std::function<bool(const CardDataSharedPtr&)> FilterFunctionType;
     struct Filter
@@ -138,27 +142,85 @@ private:
     typedef std::vector<Filter> FilterVectorType;
 
     void setFilters( const FilterVectorType& filters );
+    void initFilters( const FilterVectorType& filters );
+
+    // Recreate the per-filter labels and layouts after a filter change.
+    void rebuildSections();
+
+    CardWidget* createCardWidget( const CardDataSharedPtr& cardDataSharedPtr );
+
+    // Bring mSortedCards in line with a new card list.  Unchanged cards
+    // keep their keys; added cards are inserted by binary search.
+    void updateSortedCards( const QList<CardDataSharedPtr>& cards );
+
+    // Index of the first filter matching the card.
+    int getCategory( const CardDataSharedPtr& cardDataSharedPtr ) const;
+
+    // True if a single card can be added or removed without first
+    // recomputing keys or rebuilding sections.
+    bool canUpdateSingleCard() const;
+
+    // Index into mSortedCards of the first card in a category.
+    int getCategoryStartIndex( int category ) const;
+
+    // Show the name and card count of a section, if needed.
+    void updateSectionLabel( int category );
 
     virtual void selectedCardsUpdateHandler() {};
 
+    // Replace placeholders within the painted area with card widgets.
+    void materializeVisibleCards();
+
 private:
 
-    // Sorting functions for CardDataSharedPtr types.
-    static bool compareCardDataName( CardDataSharedPtr a, CardDataSharedPtr b ) { return a->getName() < b->getName(); }
-    static bool compareCardDataCMCs( CardDataSharedPtr a, CardDataSharedPtr b ) { return a->getCMC() < b->getCMC(); }
-    static bool compareCardDataColors( CardDataSharedPtr a, CardDataSharedPtr b );
-    static bool compareCardDataRarity( CardDataSharedPtr a, CardDataSharedPtr b ) { return a->getRarity() < b->getRarity(); }
-    static bool compareCardDataTypes( CardDataSharedPtr a, CardDataSharedPtr b );
+    // Pack the sort fields of a card into a single key that orders
+    // bytewise according to the sort criteria.
+    static std::string createSortKey( const CardData& cardData, const CardSortCriterionVector& sortCriteria );
+
+    // A card with its precomputed sort key and category (filter index).
+    // Cards are ordered by category first so that each section is a
+    // contiguous run.
+    struct SortedCard
+    {
+        CardDataSharedPtr cardData;
+        std::string       sortKey;
+        int               category;
+    };
+    static bool compareSortedCards( const SortedCard& a, const SortedCard& b )
+    {
+        return (a.category != b.category) ? (a.category < b.category) : (a.sortKey < b.sortKey);
+    }
+
+    SortedCard createSortedCard( const CardDataSharedPtr& cardDataSharedPtr ) const;
 
 private:
 
-    QList<FlowLayout*> mFilteredCardsLayouts;
-    QList<QLabel*> mFilteredCardsLabels;
+    // One section per filter, persistent across setCards() calls so that
+    // only card widgets that moved need to be touched.
+    struct Section
+    {
+        QLabel*     label;
+        FlowLayout* layout;
+    };
+    QList<Section> mSections;
+    bool           mSectionsDirty;
     QWidget *mBasicLandWidget;
 
     FilterVectorType mFilters;
 
-    SortFunctionVectorType mSortFunctions;
+    CardSortCriterionVector mSortCriteria;
+
+    // Cards in display order, parallel to mCardsList and the head of
+    // mCardWidgetsList.  Keys and categories are recomputed for all
+    // cards only when the sort criteria or filters change.
+    std::vector<SortedCard> mSortedCards;
+    bool                    mSortedCardsDirty;
+
+    // Cards in large views get widgets only once painted; until then
+    // mCardWidgetsList holds null and the section layout a placeholder.
+    int                     mPlaceholderCount;
+    QRect                   mMaterializeRect;
+    bool                    mMaterializePending;
 
     QSet<QWidget*>           mAlertableSubwidgets;
 
@@ -2,6 +2,7 @@
 
 #include <QMouseEvent>
 #include <QToolTip>
+#include <QTimer>
 #include <QPainter>   // for Overlay painting
 
 #include "qtutils_widget.h"
@@ -18,6 +19,8 @@ CardWidget::CardWidget( const CardDataSharedPtr& cardDataSharedPtr,
       mCardDataSharedPtr( cardDataSharedPtr ),
       mImageLoaderFactory( imageLoaderFactory ),
       mImageLoader( 0 ),
+      mLoadImageOnPaint( false ),
+      mImageLoadRequested( false ),
       mDefaultSize( defaultSize ),
       mZoomFactor( 1.0f ),
       mPreselectable( false ),
@@ -188,6 +191,8 @@ CardWidget::updateOverlay()
 void
 CardWidget::loadImage()
 {
+    mImageLoadRequested = true;
+
     const int muid = mCardDataSharedPtr->getMultiverseId();
     if( muid < 0 )
     {
@@ -204,6 +209,21 @@ CardWidget::loadImage()
 }
 
 
+void
+CardWidget::paintEvent( QPaintEvent* event )
+{
+    // Load outside of the paint event; a cached image may be delivered
+    // immediately and resize this widget.
+    if( mLoadImageOnPaint && !mImageLoadRequested )
+    {
+        mImageLoadRequested = true;
+        QTimer::singleShot( 0, this, &CardWidget::loadImage );
+    }
+
+    QLabel::paintEvent( event );
+}
+
+
 void
 CardWidget::mousePressEvent( QMouseEvent* event )
 {
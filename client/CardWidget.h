@@ -33,6 +33,11 @@ public:
     void setZoomFactor( float zoomFactor );
     void loadImage();
 
+    // Defer loadImage() until the widget is first painted.  Widgets in a
+    // scroll area are only painted when in view, so offscreen cards don't
+    // load images until scrolled to.
+    void setLoadImageOnPaint( bool enabled ) { mLoadImageOnPaint = enabled; }
+
     void setPreselectable( bool enabled );
     bool isPreselectable() const { return mPreselectable; }
     void setPreselected( bool enabled );
@@ -61,6 +66,7 @@ protected:
     virtual void enterEvent( QEvent* event ) override;
     virtual void leaveEvent( QEvent* event ) override;
     virtual bool event( QEvent* event ) override;
+    virtual void paintEvent( QPaintEvent* event ) override;
 
 private slots:
     void handleImageLoaded( int multiverseId, const QImage &image );
@@ -74,6 +80,8 @@ private:
     ImageLoaderFactory* const mImageLoaderFactory;
 
     ImageLoader*      mImageLoader;
+    bool              mLoadImageOnPaint;
+    bool              mImageLoadRequested;
 
     QSize             mDefaultSize;
     float             mZoomFactor;
@@ -448,6 +448,42 @@ CommanderPane::setCards( const CardZoneType& cardZone, const QList<CardDataShare
 }
 
 
+void
+CommanderPane::addCard( const CardZoneType& cardZone, const CardDataSharedPtr& cardData )
+{
+    auto iter = mCardViewerWidgetMap.find( cardZone );
+    if( iter != mCardViewerWidgetMap.end() )
+    {
+        CardViewerWidget *cardViewerWidget = iter.value();
+        cardViewerWidget->addCard( cardData );
+        updateTabSettings( cardZone );
+    }
+
+    if( mHideIfEmptyCardZoneSet.contains( cardZone ) )
+    {
+        evaluateHiddenTabs();
+    }
+}
+
+
+void
+CommanderPane::removeCard( const CardZoneType& cardZone, const CardDataSharedPtr& cardData )
+{
+    auto iter = mCardViewerWidgetMap.find( cardZone );
+    if( iter != mCardViewerWidgetMap.end() )
+    {
+        CardViewerWidget *cardViewerWidget = iter.value();
+        cardViewerWidget->removeCard( cardData );
+        updateTabSettings( cardZone );
+    }
+
+    if( mHideIfEmptyCardZoneSet.contains( cardZone ) )
+    {
+        evaluateHiddenTabs();
+    }
+}
+
+
 void
 CommanderPane::setSelectedCards( const CardZoneType cardZone, const QMap<CardDataSharedPtr,SelectedCardData>& selectedCards )
 {
@@ -460,6 +496,18 @@ CommanderPane::setSelectedCards( const CardZoneType cardZone, const QMap<CardDat
 }
 
 
+void
+CommanderPane::setGridDimensions( int rows, int cols )
+{
+    auto iter = mCardViewerWidgetMap.find( CARD_ZONE_GRID_DRAFT );
+    if( iter != mCardViewerWidgetMap.end() )
+    {
+        GridCardViewerWidget *gridCardViewerWidget = qobject_cast<GridCardViewerWidget*>( iter.value() );
+        if( gridCardViewerWidget ) gridCardViewerWidget->setGridDimensions( rows, cols );
+    }
+}
+
+
 void
 CommanderPane::setBasicLandQuantities( const CardZoneType& cardZone, const BasicLandQuantities& basicLandQtys )
 {
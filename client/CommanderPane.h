@@ -87,9 +87,16 @@ public slots:
     // Set card list for a zone in this pane.
     void setCards( const CardZoneType& cardZone, const QList<CardDataSharedPtr>& cards );
 
+    // Add or remove a single card for a zone in this pane.
+    void addCard( const CardZoneType& cardZone, const CardDataSharedPtr& cardData );
+    void removeCard( const CardZoneType& cardZone, const CardDataSharedPtr& cardData );
+
     // Set cards that are selected for a [draft] zone.  (Use empty map to reset.)
     void setSelectedCards( const CardZoneType cardZone, const QMap<CardDataSharedPtr,SelectedCardData>& selectedCards );
 
+    // Set dimensions of the grid draft zone layout.
+    void setGridDimensions( int rows, int cols );
+
     // Update basic land quantities for a zone in this pane.
     void setBasicLandQuantities( const CardZoneType& cardZone, const BasicLandQuantities& basicLandQtys );
 
@@ -22,6 +22,7 @@
 #include <QTableWidget>
 #include <QHeaderView>
 #include "qtutils_core.h"
+#include "AllSetsData.h"
 
 const QString CreateRoomDialog::CUBE_SET_CODE = QString( "***" );
 
@@ -519,6 +520,11 @@ CreateRoomDialog::handleImportCubeListButton()
     {
         auto cards = mCubeDecklist.getCards( Decklist::ZONE_MAIN );
 
+        // Check all the names against card data at once.
+        std::vector<CardNameResolution> resolutions;
+        if( mAllSetsData ) resolutions = mAllSetsData->resolveCardNames( cards );
+        int unrecognizedCount = 0;
+
         QTableWidget* cardTable = new QTableWidget( cards.size(), 3, dlg );
         cardTable->setSelectionMode( QAbstractItemView::NoSelection );
         QStringList hdrLabels;
@@ -535,9 +541,40 @@ CreateRoomDialog::handleImportCubeListButton()
                     QString::number( mCubeDecklist.getCardQuantity( cards[i], Decklist::ZONE_MAIN ) ) ) );
             cardTable->setItem( i, 1, new QTableWidgetItem( QString::fromStdString( cards[i].getSetCode() ) ) );
             cardTable->setItem( i, 2, new QTableWidgetItem( QString::fromStdString( cards[i].getName()  ) ) );
+
+            if( (i < resolutions.size()) && (resolutions[i].status == CardNameResolution::STATUS_NOT_FOUND) )
+            {
+                unrecognizedCount++;
+
+                // Suggest corrections for likely misspellings.
+                QString toolTip = tr("Card not recognized");
+                QStringList suggestions;
+                for( const std::string& name : mAllSetsData->findSimilarCardNames( cards[i].getName(), 3 ) )
+                {
+                    suggestions << QString::fromStdString( name );
+                }
+                if( !suggestions.isEmpty() )
+                {
+                    toolTip += tr(" - did you mean %1?").arg( suggestions.join( tr(" or ") ) );
+                    cardTable->item( i, 2 )->setText( tr("%1 (%2?)").arg(
+                            QString::fromStdString( cards[i].getName() ), suggestions.front() ) );
+                }
+
+                for( int col = 0; col < 3; ++col )
+                {
+                    cardTable->item( i, col )->setForeground( Qt::red );
+                    cardTable->item( i, col )->setToolTip( toolTip );
+                }
+            }
         }
         dlgLayout->addWidget( cardTable );
 
+        if( unrecognizedCount > 0 )
+        {
+            mLogger->notice( "{} cube cards not recognized", unrecognizedCount );
+            dlgTotalLabel->setText( dlgTotalLabel->text() + tr("  %1 cards were not recognized.").arg( unrecognizedCount ) );
+        }
+
         // Add a strut 1/4 the width of the screen to make space for the card table.
         QRect rect = QApplication::desktop()->screenGeometry();
         dlgLayout->addStrut( rect.width() / 4 );
@@ -36,6 +36,9 @@ public:
 
     void setRoomCapabilitySets( const std::vector<RoomCapabilitySetItem>& sets );
 
+    // Used to check card names on cube import.  May be null.
+    void setAllSetsData( const AllSetsDataSharedPtr& allSetsData ) { mAllSetsData = allSetsData; }
+
     DraftType getDraftType() const;
     QStringList getSetCodes() const;
     QString getCubeName() const { return mCubeName; }
@@ -90,6 +93,8 @@ private:
     QString   mCubeName;
     Decklist  mCubeDecklist;
 
+    AllSetsDataSharedPtr mAllSetsData;
+
     std::shared_ptr<spdlog::logger> mLogger;
 };
 
@@ -109,6 +109,74 @@ QLayoutItem *FlowLayout::takeAt(int index)
     else
         return 0;
 }
+
+void FlowLayout::setWidgets(const QList<QWidget *> &widgets)
+{
+    QHash<QWidget *, QLayoutItem *> existingItems;
+    QList<QLayoutItem *> placeholderItems;
+    existingItems.reserve(itemList.size());
+    for (QLayoutItem *item : itemList) {
+        if (item->widget())
+            existingItems.insert(item->widget(), item);
+        else
+            placeholderItems.append(item);
+    }
+
+    QList<QLayoutItem *> newItemList;
+    newItemList.reserve(widgets.size());
+    for (QWidget *widget : widgets) {
+        QLayoutItem *item = widget ? existingItems.take(widget) : nullptr;
+        if (!item)
+            item = (!widget && !placeholderItems.isEmpty()) ? placeholderItems.takeLast()
+                                                              : createItem(widget);
+        newItemList.append(item);
+    }
+
+    for (QLayoutItem *item : existingItems)
+        delete item;
+    qDeleteAll(placeholderItems);
+
+    itemList = newItemList;
+    invalidate();
+}
+
+void FlowLayout::insertWidget(int index, QWidget *widget)
+{
+    itemList.insert(index, createItem(widget));
+    invalidate();
+}
+
+void FlowLayout::setWidgetAt(int index, QWidget *widget)
+{
+    delete itemList[index];
+    itemList[index] = createItem(widget);
+    invalidate();
+}
+
+void FlowLayout::setPlaceholderSize(const QSize &size)
+{
+    if (size == m_placeholderSize)
+        return;
+    m_placeholderSize = size;
+    for (QLayoutItem *item : itemList) {
+        if (QSpacerItem *spacer = item->spacerItem())
+            spacer->changeSize(size.width(), size.height(), QSizePolicy::Fixed, QSizePolicy::Fixed);
+    }
+    invalidate();
+}
+
+QLayoutItem *FlowLayout::createItem(QWidget *widget)
+{
+    if (!widget)
+        return new QSpacerItem(m_placeholderSize.width(), m_placeholderSize.height(),
+                               QSizePolicy::Fixed, QSizePolicy::Fixed);
+
+    // Widgets moving between layouts of the same parent are already
+    // children; only adopt new widgets.
+    if (widget->parentWidget() != parentWidget())
+        addChildWidget(widget);
+    return new QWidgetItem(widget);
+}
 //! [5]
 
 //! [6]
@@ -169,7 +237,8 @@ int FlowLayout::doLayout(const QRect &rect, bool testOnly) const
 //! [10]
     QLayoutItem *item;
     foreach (item, itemList) {
-        QWidget *wid = item->widget();
+        // Placeholders have no widget; use the layout's for spacing.
+        QWidget *wid = item->widget() ? item->widget() : parentWidget();
         int spaceX = horizontalSpacing();
         if (spaceX == -1)
             spaceX = wid->style()->layoutSpacing(
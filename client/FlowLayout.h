@@ -65,13 +65,30 @@ public:
     QSize sizeHint() const Q_DECL_OVERRIDE;
     QLayoutItem *takeAt(int index) Q_DECL_OVERRIDE;
 
+    // Replace the layout contents with the given widgets, in order.
+    // Items for widgets already in the layout are reused; items for
+    // widgets not in the list are removed without touching the widgets.
+    // A null widget reserves a placeholder-sized space.
+    void setWidgets(const QList<QWidget *> &widgets);
+
+    // Insert a single widget (or placeholder, if null) at a position.
+    void insertWidget(int index, QWidget *widget);
+
+    // Replace the item at a position with a widget.
+    void setWidgetAt(int index, QWidget *widget);
+
+    // Size of the space reserved by placeholders.
+    void setPlaceholderSize(const QSize &size);
+
 private:
     int doLayout(const QRect &rect, bool testOnly) const;
     int smartSpacing(QStyle::PixelMetric pm) const;
+    QLayoutItem *createItem(QWidget *widget);
 
     QList<QLayoutItem *> itemList;
     int m_hSpace;
     int m_vSpace;
+    QSize m_placeholderSize;
 };
 //! [0]
 
@@ -7,26 +7,56 @@
 #include "qtutils_core.h"
 #include "qtutils_widget.h"
 
-static QSet<int> getRowIndices( int row )
+GridCardViewerWidget::GridCardViewerWidget( ImageLoaderFactory*    imageLoaderFactory,
+                                            const Logging::Config& loggingConfig,
+                                            QWidget*               parent )
+  : CardViewerWidget( imageLoaderFactory, loggingConfig, parent ),
+    mRowCount( 3 ),
+    mColCount( 3 ),
+    mGridCardsLayout( nullptr ),
+    mWaitingForTurn( false )
 {
-    return { (row*3), (row*3)+1, (row*3)+2 };
+    createButtons();
 }
+ 
 
-static QSet<int> getColIndices( int col )
+GridCardViewerWidget::~GridCardViewerWidget()
 {
-    return { col, col+3, col+6 };
+    // Buttons are only parented while laid out.
+    deleteButtons();
 }
 
 
-GridCardViewerWidget::GridCardViewerWidget( ImageLoaderFactory*    imageLoaderFactory,
-                                            const Logging::Config& loggingConfig,
-                                            QWidget*               parent )
-  : CardViewerWidget( imageLoaderFactory, loggingConfig, parent ),
-    mGridCardsLayout( nullptr ),
-    mWaitingForTurn( false )
+void
+GridCardViewerWidget::setGridDimensions( int rows, int cols )
+{
+    if( (rows <= 0) || (cols <= 0) )
+    {
+        mLogger->warn( "invalid grid dimensions {}x{}", rows, cols );
+        return;
+    }
+    if( (rows == mRowCount) && (cols == mColCount) ) return;
+
+    mLogger->debug( "grid dimensions {}x{}", rows, cols );
+
+    // Lay the current cards out again with the new buttons.
+    const QList<CardDataSharedPtr> cards = mCardsList;
+    setCards( QList<CardDataSharedPtr>() );
+
+    deleteButtons();
+    mRowCount = rows;
+    mColCount = cols;
+    createButtons();
+
+    setCards( cards );
+}
+
+
+void
+GridCardViewerWidget::createButtons()
 {
     // Create column buttons.
-    for( int col = 0; col < 3; ++col )
+    for( int col = 0; col < mColCount; ++col )
     {
         for( bool top : { true, false } )
         {
@@ -55,17 +85,17 @@ GridCardViewerWidget::GridCardViewerWidget( ImageLoaderFactory*    imageLoaderFa
 
             if( top )
             {
-                mTopColButtons[col] = button;
+                mTopColButtons.append( button );
             }
             else
             {
-                mBottomColButtons[col] = button;
+                mBottomColButtons.append( button );
             }
         }
     }
 
     // Create row buttons.
-    for( int row = 0; row < 3; ++row )
+    for( int row = 0; row < mRowCount; ++row )
     {
         for( bool left : { true, false } )
         {
@@ -94,19 +124,25 @@ GridCardViewerWidget::GridCardViewerWidget( ImageLoaderFactory*    imageLoaderFa
 
             if( left )
             {
-                mLeftRowButtons[row] = button;
+                mLeftRowButtons.append( button );
             }
             else
             {
-                mRightRowButtons[row] = button;
+                mRightRowButtons.append( button );
             }
         }
     }
 }
- 
 
-GridCardViewerWidget::~GridCardViewerWidget()
+
+void
+GridCardViewerWidget::deleteButtons()
 {
+    for( auto buttons : { &mTopColButtons, &mBottomColButtons, &mLeftRowButtons, &mRightRowButtons } )
+    {
+        qDeleteAll( *buttons );
+        buttons->clear();
+    }
 }
 
 
@@ -136,12 +172,12 @@ GridCardViewerWidget::setCards( const QList<CardDataSharedPtr>& cards )
     {
         w->setParent( 0 );
     }
-    for( int col = 0; col < 3; ++col )
+    for( int col = 0; col < mColCount; ++col )
     {
         mTopColButtons[col]->setParent( 0 );
         mBottomColButtons[col]->setParent( 0 );
     }
-    for( int row = 0; row < 3; ++row )
+    for( int row = 0; row < mRowCount; ++row )
     {
         mLeftRowButtons[row]->setParent( 0 );
         mRightRowButtons[row]->setParent( 0 );
@@ -167,13 +203,14 @@ GridCardViewerWidget::setCards( const QList<CardDataSharedPtr>& cards )
         };
 
     // At this point everything is cleared.  Finish cleanup and exit if
-    // there aren't exactly 9 cards in the list.
-    if( mCardsList.size() != 9 )
+    // the cards don't exactly fill the grid.
+    const int gridCardCount = mRowCount * mColCount;
+    if( mCardsList.size() != gridCardCount )
     {
         // Zero is normal, but non-zero is not.
         if( mCardsList.size() > 0 )
         {
-            mLogger->warn( "card list size ({}) != 9, cannot perform grid layout!", cards.size() );
+            mLogger->warn( "card list size ({}) != {}, cannot perform grid layout!", cards.size(), gridCardCount );
         }
 
         // Clean up any cardwidgets remaining in the original list.
@@ -251,23 +288,23 @@ GridCardViewerWidget::setCards( const QList<CardDataSharedPtr>& cards )
     mLayout->addLayout( alignmentLayout );
 
     // Lay out column buttons.
-    for( int col = 0; col < 3; ++col )
+    for( int col = 0; col < mColCount; ++col )
     {
         mGridCardsLayout->addWidget( mTopColButtons[col], 0, 1 + col, Qt::AlignCenter );
-        mGridCardsLayout->addWidget( mBottomColButtons[col], 4, 1 + col, Qt::AlignCenter );
+        mGridCardsLayout->addWidget( mBottomColButtons[col], 1 + mRowCount, 1 + col, Qt::AlignCenter );
     }
 
     // Lay out row buttons.
-    for( int row = 0; row < 3; ++row )
+    for( int row = 0; row < mRowCount; ++row )
     {
         mGridCardsLayout->addWidget( mLeftRowButtons[row],  1 + row, 0, Qt::AlignCenter );
-        mGridCardsLayout->addWidget( mRightRowButtons[row], 1 + row, 4, Qt::AlignCenter );
+        mGridCardsLayout->addWidget( mRightRowButtons[row], 1 + row, 1 + mColCount, Qt::AlignCenter );
     }
 
     updateButtonVisibility();
 
     // Create card widgets and add to layout.
-    for( int i = 0; i < 9; ++i )
+    for( int i = 0; i < gridCardCount; ++i )
     {
         auto cardDataSharedPtr = mCardsList[i];
 
@@ -281,7 +318,7 @@ GridCardViewerWidget::setCards( const QList<CardDataSharedPtr>& cards )
             // The widget doesn't exist.  Create it.
             cardWidget = createCardWidget( cardDataSharedPtr );
         }
-        mGridCardsLayout->addWidget( cardWidget, 1+ i/3, 1 + i%3 );
+        mGridCardsLayout->addWidget( cardWidget, 1 + i/mColCount, 1 + i%mColCount );
         newCardWidgetsList.push_back( cardWidget );
     }
 
@@ -342,6 +379,24 @@ bool GridCardViewerWidget::isIndexSelectable( int i )
 };
 
 
+QSet<int>
+GridCardViewerWidget::getRowIndices( int row ) const
+{
+    QSet<int> indices;
+    for( int col = 0; col < mColCount; ++col ) indices.insert( row*mColCount + col );
+    return indices;
+}
+
+
+QSet<int>
+GridCardViewerWidget::getColIndices( int col ) const
+{
+    QSet<int> indices;
+    for( int row = 0; row < mRowCount; ++row ) indices.insert( row*mColCount + col );
+    return indices;
+}
+
+
 QSet<int>
 GridCardViewerWidget::getRowSelectableIndices( int row )
 {
@@ -376,14 +431,14 @@ void
 GridCardViewerWidget::updateButtonVisibility()
 {
     // Set buttons disabled if there are no selectable cards or waiting for turn.
-    for( int col = 0; col < 3; ++col )
+    for( int col = 0; col < mColCount; ++col )
     {
         const bool colSelectable = !getColSelectableIndices( col ).empty();
         const bool visible = !mWaitingForTurn && colSelectable;
         mTopColButtons[col]->setVisible( visible );
         mBottomColButtons[col]->setVisible( visible );
     }
-    for( int row = 0; row < 3; ++row )
+    for( int row = 0; row < mRowCount; ++row )
     {
         const bool rowSelectable = !getRowSelectableIndices( row ).empty();
         const bool visible = !mWaitingForTurn && rowSelectable;
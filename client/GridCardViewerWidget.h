@@ -25,23 +25,35 @@ public:
 
     virtual void setWaitingForTurn( bool waiting ) override;
 
+    // Set the grid dimensions.  Cards are laid out row-major and the card
+    // list must contain exactly rows x cols cards.
+    void setGridDimensions( int rows, int cols );
+
 private:
 
     virtual void selectedCardsUpdateHandler() override;
 
+    void createButtons();
+    void deleteButtons();
+
     bool isIndexSelectable( int i );
 
+    QSet<int> getRowIndices( int row ) const;
+    QSet<int> getColIndices( int col ) const;
     QSet<int> getRowSelectableIndices( int row );
     QSet<int> getColSelectableIndices( int col );
 
     void updateCardWidgetSelectedAppearance( CardWidget* cardWidget );
     void updateButtonVisibility();
 
+    int mRowCount;
+    int mColCount;
+
     QGridLayout* mGridCardsLayout;
-    GridToolButton* mTopColButtons[3];
-    GridToolButton* mBottomColButtons[3];
-    GridToolButton* mLeftRowButtons[3];
-    GridToolButton* mRightRowButtons[3];
+    QList<GridToolButton*> mTopColButtons;
+    QList<GridToolButton*> mBottomColButtons;
+    QList<GridToolButton*> mLeftRowButtons;
+    QList<GridToolButton*> mRightRowButtons;
 
     bool mWaitingForTurn;
 };
@@ -1,7 +1,11 @@
 #include "ImageCache.h"
 
+#include <algorithm>
+#include <iterator>
+
 #include <QImageReader>
 #include <QFile>
+#include <QSaveFile>
 #include <QSet>
 #include "qtutils_core.h"
 
@@ -9,6 +13,13 @@ static const QString CACHE_INDEX_FILENAME  = ".cacheindex";
 static const quint32 CACHE_INDEX_MAGIC_NUM = 0x000CAC3E;
 static const quint16 CACHE_INDEX_VERSION   = 0x0100;      // 16-bit version: 8 bits major, 8 bits minor
 
+static const QString CACHE_JOURNAL_FILENAME  = ".cacheindex.journal";
+static const quint32 CACHE_JOURNAL_MAGIC_NUM = 0x000CAC3F;
+
+// The journal is folded into the index snapshot once it has at least this
+// many records and is also larger than twice the number of index entries.
+static const unsigned int JOURNAL_COMPACT_MIN_RECORDS = 1000;
+
 
 QDataStream& operator<<( QDataStream &stream, const ImageCache::IndexEntry &entry )
 {
@@ -22,6 +33,7 @@ QDataStream& operator>>( QDataStream &stream, ImageCache::IndexEntry &entry )
 {
     stream >> entry.fileName;
     stream >> entry.fileAccessDateTime;
+    entry.fileSize = 0;
     return stream;
 }
 
@@ -32,32 +44,36 @@ ImageCache::ImageCache( const QDir&     imageCacheDir,
   : mCacheDir( imageCacheDir ),
     mCacheMaxBytes( maxBytes ),
     mCacheCurrentBytes( 0 ),
+    mJournalFile( imageCacheDir.filePath( CACHE_JOURNAL_FILENAME ) ),
+    mJournalRecordCount( 0 ),
     mLogger( loggingConfig.createLogger() )
 {
     deserializeCacheIndex();
-    mLogger->debug( "deserialized image cache index: {} entries", mCacheIndex.size() );
+    mLogger->debug( "deserialized image cache index: {} entries", mCacheIndexMap.size() );
 
-    // Figure out which files are present or not preset by starting with
-    // the index and removing all files that match in the cache.
-    QSet<QString> rollCallFileNamesSet;
-    for( auto entry : mCacheIndex ) rollCallFileNamesSet.insert( entry.fileName );
+    // Apply any changes recorded since the last snapshot.
+    replayJournal();
+    mLogger->debug( "image cache index has {} entries after journal replay", mCacheIndexMap.size() );
 
     // Get the list of all actual files in the cache directory.  If there
     // are files present that aren't in the index, append them to the index.
     // Appending will also maintain the ordering of newest to oldest.
+    QSet<QString> presentFileNamesSet;
     QFileInfoList fileInfoList( mCacheDir.entryInfoList( QStringList(), QDir::Files ) );
     mLogger->debug( "image cache contains {} files", fileInfoList.size() );
     for( QFileInfo info : fileInfoList )
     {
-        // Skip the cache file itself.
-        if( info.fileName() == CACHE_INDEX_FILENAME ) continue;
+        // Skip the index and journal files.
+        if( info.fileName().startsWith( CACHE_INDEX_FILENAME ) ) continue;
 
+        presentFileNamesSet.insert( info.fileName() );
         mCacheCurrentBytes += info.size();
 
-        if( rollCallFileNamesSet.contains( info.fileName() ) )
+        auto mapIter = mCacheIndexMap.find( info.fileName() );
+        if( mapIter != mCacheIndexMap.end() )
         {
             // File is accounted for.
-            rollCallFileNamesSet.remove( info.fileName() );
+            (*mapIter)->fileSize = info.size();
         }
         else
         {
@@ -66,27 +82,31 @@ ImageCache::ImageCache( const QDir&     imageCacheDir,
             IndexEntry entry;
             entry.fileName = info.fileName();
             entry.fileAccessDateTime = QDateTime::fromTime_t( 0 );
-            mCacheIndex.append( entry );
+            entry.fileSize = info.size();
+            mCacheRecencyList.push_back( entry );
+            mCacheIndexMap.insert( entry.fileName, std::prev( mCacheRecencyList.end() ) );
         }
     }
 
     // Remove entries in the index that weren't accounted for.
-    for( auto fileName : rollCallFileNamesSet )
+    for( auto iter = mCacheRecencyList.begin(); iter != mCacheRecencyList.end(); )
     {
-        auto iter = mCacheIndex.begin();
-        while( iter != mCacheIndex.end() )
+        if( presentFileNamesSet.contains( iter->fileName ) )
         {
-            if( fileName == iter->fileName )
-            {
-                mCacheIndex.erase( iter );
-                break;
-            }
             ++iter;
         }
+        else
+        {
+            mCacheIndexMap.remove( iter->fileName );
+            iter = mCacheRecencyList.erase( iter );
+        }
     }
 
     mLogger->debug( "image cache contains {} bytes", mCacheCurrentBytes );
-    mLogger->debug( "image cache index has {} entries after resolving cache", mCacheIndex.size() );
+    mLogger->debug( "image cache index has {} entries after resolving cache", mCacheIndexMap.size() );
+
+    // Start from a fresh snapshot and an empty journal.
+    serializeCacheIndex();
 
     // Ensure the cache is right-sized.
     resizeCache( mCacheMaxBytes );
@@ -95,75 +115,115 @@ ImageCache::ImageCache( const QDir&     imageCacheDir,
 
 ImageCache::~ImageCache()
 {
-    mLogger->debug( "serializing image cache index: {} entries", mCacheIndex.size() );
-    serializeCacheIndex();
+    mLogger->debug( "serializing image cache index: {} entries", mCacheIndexMap.size() );
+    if( serializeCacheIndex() )
+    {
+        // The snapshot is complete; the journal is no longer needed.
+        mJournalFile.remove();
+    }
 }
 
 
 void
 ImageCache::setMaxBytes( quint64 maxBytes )
 {
+    QMutexLocker locker( &mMutex );
     mCacheMaxBytes = maxBytes;
     resizeCache( mCacheMaxBytes );
 }
 
 
+bool
+ImageCache::contains( int multiverseId ) const
+{
+    QMutexLocker locker( &mMutex );
+    return !findIndexedFileName( multiverseId ).isEmpty();
+}
+
+
 bool
 ImageCache::tryReadFromCache( int multiverseId, QImage& image )
 {
     if( !mCacheDir.exists() )
         return false;
 
-    // Construct the filename with no extension.  QImageReader will try all
-    // extensions it knows to read the file.
-    const QString imageReaderFilename = mCacheDir.filePath( QString::number( multiverseId ) );
+    QString fileName;
+    {
+        QMutexLocker locker( &mMutex );
+        fileName = findIndexedFileName( multiverseId );
+    }
+    if( fileName.isEmpty() )
+    {
+        mLogger->debug( "cache miss loading image {}", multiverseId );
+        return false;
+    }
 
+    // Read the indexed file directly rather than letting QImageReader
+    // probe every extension it knows.
+    const QString imageReaderFilename = mCacheDir.filePath( fileName );
     QImageReader reader( imageReaderFilename );
     image = reader.read();
 
     if( image.isNull() )
     {
-        // There was a file error of some kind.
-        if( reader.error() == QImageReader::FileNotFoundError )
-        {
-            mLogger->debug( "cache miss loading image {}", imageReaderFilename );
-        }
-        else
-        {
-            mLogger->warn( "error loading image {} from cache: {}", imageReaderFilename, reader.errorString() );
-        }
+        mLogger->warn( "error loading image {} from cache: {}", imageReaderFilename, reader.errorString() );
         return false;
     }
 
     mLogger->debug( "loaded image file {} from cache", imageReaderFilename );
 
-    // Update the cache access time.
-    QString imageReaderActualFileName = QFileInfo( reader.fileName() ).fileName();
-    for( auto iter = mCacheIndex.begin(); iter != mCacheIndex.end(); ++iter )
+    // Update the cache access time and move to front of index.
+    QMutexLocker locker( &mMutex );
+    auto mapIter = mCacheIndexMap.find( fileName );
+    if( mapIter != mCacheIndexMap.end() )
     {
-        if( iter->fileName == imageReaderActualFileName )
-        {
-            // Update time stamp and move to front of index.
-            IndexEntry entry = *iter;
-            entry.fileAccessDateTime = QDateTime::currentDateTime();
-            mCacheIndex.erase( iter );
-            mCacheIndex.prepend( entry );
-            break;
-        }
+        RecencyList::iterator entryIter = *mapIter;
+        entryIter->fileAccessDateTime = QDateTime::currentDateTime();
+        mCacheRecencyList.splice( mCacheRecencyList.begin(), mCacheRecencyList, entryIter );
+        appendJournal( JOURNAL_OP_TOUCH, *entryIter );
     }
 
     return true;
 }
 
 
+QString
+ImageCache::findIndexedFileName( int multiverseId ) const
+{
+    // Cache files are named by muid with the suffix of the downloaded
+    // image format, which is one of the formats QImageReader supports.
+    static const QStringList sExtensions = []() {
+            QStringList extensions;
+            for( const QByteArray& format : QImageReader::supportedImageFormats() )
+            {
+                extensions.append( "." + QString::fromLatin1( format ) );
+            }
+            return extensions;
+        }();
+
+    const QString baseName = QString::number( multiverseId );
+    for( const QString& extension : sExtensions )
+    {
+        const QString fileName = baseName + extension;
+        if( mCacheIndexMap.contains( fileName ) ) return fileName;
+    }
+    return QString();
+}
+
+
 bool
 ImageCache::tryWriteToCache( int multiverseId, const QString& extension, const QByteArray& imageData )
 {
     if( !mCacheDir.exists() )
         return false;
 
+    QMutexLocker locker( &mMutex );
     const QString cacheFileName = QString::number( multiverseId ) + extension;
     const QString cacheFilePath = mCacheDir.filePath( cacheFileName );
+
+    // If this file is being replaced, drop the old entry first.
+    removeEntry( cacheFileName );
+
     QFile cacheFile( cacheFilePath );
     if( !cacheFile.open( QIODevice::WriteOnly ) )
     {
@@ -172,7 +232,8 @@ ImageCache::tryWriteToCache( int multiverseId, const QString& extension, const Q
     }
 
     // Resize the cache (if necessary) to fit the new file.
-    resizeCache( mCacheMaxBytes - imageData.size() );
+    const quint64 dataSize = imageData.size();
+    resizeCache( (mCacheMaxBytes > dataSize) ? (mCacheMaxBytes - dataSize) : 0 );
 
     // Write the file.
     cacheFile.write( imageData );
@@ -183,13 +244,49 @@ ImageCache::tryWriteToCache( int multiverseId, const QString& extension, const Q
     IndexEntry entry;
     entry.fileName = cacheFileName;
     entry.fileAccessDateTime = QDateTime::currentDateTime();
-    mCacheIndex.prepend( entry );
-    mCacheCurrentBytes += imageData.size();
+    entry.fileSize = dataSize;
+    mCacheRecencyList.push_front( entry );
+    mCacheIndexMap.insert( cacheFileName, mCacheRecencyList.begin() );
+    mCacheCurrentBytes += dataSize;
+    appendJournal( JOURNAL_OP_TOUCH, entry );
 
     return true;
 }
 
 
+void
+ImageCache::touchEntry( const QString& fileName, const QDateTime& dateTime, quint64 fileSize )
+{
+    auto mapIter = mCacheIndexMap.find( fileName );
+    if( mapIter != mCacheIndexMap.end() )
+    {
+        (*mapIter)->fileAccessDateTime = dateTime;
+        mCacheRecencyList.splice( mCacheRecencyList.begin(), mCacheRecencyList, *mapIter );
+    }
+    else
+    {
+        IndexEntry entry;
+        entry.fileName = fileName;
+        entry.fileAccessDateTime = dateTime;
+        entry.fileSize = fileSize;
+        mCacheRecencyList.push_front( entry );
+        mCacheIndexMap.insert( fileName, mCacheRecencyList.begin() );
+    }
+}
+
+
+void
+ImageCache::removeEntry( const QString& fileName )
+{
+    auto mapIter = mCacheIndexMap.find( fileName );
+    if( mapIter == mCacheIndexMap.end() ) return;
+
+    mCacheCurrentBytes -= std::min( mCacheCurrentBytes, (*mapIter)->fileSize );
+    mCacheRecencyList.erase( *mapIter );
+    mCacheIndexMap.erase( mapIter );
+}
+
+
 bool
 ImageCache::deserializeCacheIndex()
 {
@@ -230,8 +327,19 @@ ImageCache::deserializeCacheIndex()
 
     in.setVersion(QDataStream::Qt_5_2);
 
-    // Read the list.
-    in >> mCacheIndex;
+    // Read the list (same layout as a serialized QList).
+    quint32 count;
+    in >> count;
+    for( quint32 i = 0; (i < count) && (in.status() == QDataStream::Ok); ++i )
+    {
+        IndexEntry entry;
+        in >> entry;
+        if( !mCacheIndexMap.contains( entry.fileName ) )
+        {
+            mCacheRecencyList.push_back( entry );
+            mCacheIndexMap.insert( entry.fileName, std::prev( mCacheRecencyList.end() ) );
+        }
+    }
 
     return true;
 }
@@ -240,9 +348,15 @@ ImageCache::deserializeCacheIndex()
 bool
 ImageCache::serializeCacheIndex()
 {
-    QFile file( mCacheDir.filePath( CACHE_INDEX_FILENAME ) );
+    // Write to a temporary file and swap it in so a crash mid-write can't
+    // corrupt the existing snapshot.
+    QSaveFile file( mCacheDir.filePath( CACHE_INDEX_FILENAME ) );
     mLogger->debug( "serializing image cache index file: {}", file.fileName() );
-    file.open( QIODevice::WriteOnly );
+    if( !file.open( QIODevice::WriteOnly ) )
+    {
+        mLogger->warn( "error opening image cache index file for writing" );
+        return false;
+    }
     QDataStream out( &file );
 
     // Write a header with a "magic number" and a version
@@ -251,50 +365,145 @@ ImageCache::serializeCacheIndex()
 
     out.setVersion(QDataStream::Qt_5_2);
 
-    // Write the list.
-    out << mCacheIndex;
+    // Write the list (same layout as a serialized QList).
+    out << (quint32) mCacheRecencyList.size();
+    for( const IndexEntry& entry : mCacheRecencyList )
+    {
+        out << entry;
+    }
+
+    if( !file.commit() )
+    {
+        mLogger->warn( "error committing image cache index file" );
+        return false;
+    }
+
+    // Everything is in the snapshot; restart the journal.
+    mJournalFile.close();
+    if( mJournalFile.open( QIODevice::WriteOnly | QIODevice::Truncate ) )
+    {
+        QDataStream journalOut( &mJournalFile );
+        journalOut << CACHE_JOURNAL_MAGIC_NUM;
+        mJournalFile.flush();
+    }
+    else
+    {
+        mLogger->warn( "error opening image cache journal file" );
+    }
+    mJournalRecordCount = 0;
 
     return true;
 }
 
 
+void
+ImageCache::replayJournal()
+{
+    QFile file( mJournalFile.fileName() );
+    if( !file.open( QIODevice::ReadOnly ) )
+        return;
+
+    QDataStream in( &file );
+    quint32 magic;
+    in >> magic;
+    if( magic != CACHE_JOURNAL_MAGIC_NUM )
+    {
+        mLogger->warn( "bad magic number in image cache journal file" );
+        return;
+    }
+
+    in.setVersion(QDataStream::Qt_5_2);
+
+    unsigned int records = 0;
+    while( !in.atEnd() )
+    {
+        quint8  op;
+        QString fileName;
+        qint64  msecs;
+        in >> op >> fileName >> msecs;
+
+        // A torn record at the tail means we crashed mid-append; stop there.
+        if( in.status() != QDataStream::Ok ) break;
+
+        if( op == JOURNAL_OP_TOUCH )
+        {
+            touchEntry( fileName, QDateTime::fromMSecsSinceEpoch( msecs ), 0 );
+        }
+        else if( op == JOURNAL_OP_REMOVE )
+        {
+            auto mapIter = mCacheIndexMap.find( fileName );
+            if( mapIter != mCacheIndexMap.end() )
+            {
+                mCacheRecencyList.erase( *mapIter );
+                mCacheIndexMap.erase( mapIter );
+            }
+        }
+        ++records;
+    }
+
+    mLogger->debug( "replayed {} image cache journal records", records );
+}
+
+
+void
+ImageCache::appendJournal( JournalOpType op, const IndexEntry& entry )
+{
+    if( !mJournalFile.isOpen() )
+        return;
+
+    QDataStream out( &mJournalFile );
+    out.setVersion(QDataStream::Qt_5_2);
+    out << (quint8) op << entry.fileName << (qint64) entry.fileAccessDateTime.toMSecsSinceEpoch();
+    mJournalFile.flush();
+    ++mJournalRecordCount;
+
+    compactJournalIfNeeded();
+}
+
+
+void
+ImageCache::compactJournalIfNeeded()
+{
+    if( (mJournalRecordCount >= JOURNAL_COMPACT_MIN_RECORDS) &&
+        (mJournalRecordCount > 2 * (unsigned int) mCacheIndexMap.size()) )
+    {
+        mLogger->debug( "compacting image cache journal ({} records)", mJournalRecordCount );
+        serializeCacheIndex();
+    }
+}
+
+
 bool
 ImageCache::resizeCache( quint64 maxSize )
 {
-    const quint32 startTotalBytes = mCacheCurrentBytes;
+    const quint64 startTotalBytes = mCacheCurrentBytes;
 
     //
-    // Iterate backwards through the index, deleting files and index
+    // Work backwards through the recency list, deleting files and index
     // entries until the cache size is under the limit.
     //
 
-    while( !mCacheIndex.isEmpty() && (mCacheCurrentBytes > maxSize) )
+    while( !mCacheRecencyList.empty() && (mCacheCurrentBytes > maxSize) )
     {
         // Remove the oldest index item.
-        IndexEntry oldestIndexEntry = mCacheIndex.takeLast();
+        IndexEntry oldestIndexEntry = mCacheRecencyList.back();
 
         mLogger->debug( "purging cached image file {}", oldestIndexEntry.fileName );
 
-        // Get QFileInfo for the item.
-        QFileInfo oldestFileInfo( mCacheDir.filePath( oldestIndexEntry.fileName ) );
-
-        if( !oldestFileInfo.exists() )
+        if( !mCacheDir.exists( oldestIndexEntry.fileName ) )
         {
             mLogger->notice( "resizeCache: indexed file {} no longer exists", oldestIndexEntry.fileName );
-            continue;
         }
-
-        quint64 oldestFileSize = oldestFileInfo.size();
-
-        // Try to delete the file.
-        if( !mCacheDir.remove( oldestIndexEntry.fileName ) )
+        else if( !mCacheDir.remove( oldestIndexEntry.fileName ) )
         {
+            // Try to delete the file.
             mLogger->warn( "resizeCache: failed to delete file {}", oldestIndexEntry.fileName );
             return false;
         }
 
         // Reduce the overall size by the file just deleted.
-        mCacheCurrentBytes -= oldestFileSize;
+        removeEntry( oldestIndexEntry.fileName );
+        appendJournal( JOURNAL_OP_REMOVE, oldestIndexEntry );
     }
 
     if( mCacheCurrentBytes < startTotalBytes )
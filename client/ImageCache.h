@@ -4,12 +4,23 @@
 #include <QString>
 #include <QDir>
 #include <QDateTime>
+#include <QFile>
+#include <QHash>
+#include <QMutex>
+#include <list>
 #include "Logging.h"
 
 QT_BEGIN_NAMESPACE
 class QImage;
 QT_END_NAMESPACE
 
+// Disk cache of card images.  Reads and writes may be made from worker
+// threads; index state is guarded by an internal mutex.
+//
+// The index is a hash of file names into a recency list (newest first),
+// so lookups, touches and evictions are constant-time.  Index changes
+// are appended to a journal as they happen and periodically compacted
+// into the index snapshot, so recency survives a crash.
 class ImageCache
 {
 public:
@@ -19,11 +30,15 @@ public:
                 Logging::Config loggingConfig = Logging::Config() );
     virtual ~ImageCache();
 
-    unsigned int getCount() const { return mCacheIndex.size(); }
-    quint64 getCurrentBytes() const { return mCacheCurrentBytes; }
+    unsigned int getCount() const { QMutexLocker locker( &mMutex ); return mCacheIndexMap.size(); }
+    quint64 getCurrentBytes() const { QMutexLocker locker( &mMutex ); return mCacheCurrentBytes; }
 
+    quint64 getMaxBytes() const { QMutexLocker locker( &mMutex ); return mCacheMaxBytes; }
     void setMaxBytes( quint64 maxBytes );
 
+    // Returns true if an image for the multiverse ID is in the index.
+    bool contains( int multiverseId ) const;
+
     bool tryReadFromCache( int multiverseId, QImage& image );
     bool tryWriteToCache( int multiverseId, const QString& extension, const QByteArray& byteArray );
 
@@ -32,19 +47,43 @@ public:
     {
         QString   fileName;
         QDateTime fileAccessDateTime;
+        quint64   fileSize;   // not serialized; taken from the directory
     };
 
 private:
 
+    typedef std::list<IndexEntry> RecencyList;
+
+    enum JournalOpType
+    {
+        JOURNAL_OP_TOUCH  = 1,  // entry added or accessed; moves to front
+        JOURNAL_OP_REMOVE = 2
+    };
+
     bool deserializeCacheIndex();
     bool serializeCacheIndex();
+    void replayJournal();
+    void appendJournal( JournalOpType op, const IndexEntry& entry );
+    void compactJournalIfNeeded();
     bool resizeCache( quint64 maxSize );
 
+    // Returns the indexed file name for the muid, or an empty string.
+    // Caller must hold mMutex.
+    QString findIndexedFileName( int multiverseId ) const;
+
+    void touchEntry( const QString& fileName, const QDateTime& dateTime, quint64 fileSize );
+    void removeEntry( const QString& fileName );
+
+    mutable QMutex                  mMutex;
     QDir                            mCacheDir;
     quint64                         mCacheMaxBytes;
-    QList<IndexEntry>               mCacheIndex;
+    RecencyList                     mCacheRecencyList;
+    QHash<QString,RecencyList::iterator> mCacheIndexMap;
     quint64                         mCacheCurrentBytes;
 
+    QFile                           mJournalFile;
+    unsigned int                    mJournalRecordCount;
+
     std::shared_ptr<spdlog::logger> mLogger;
 
 };
@@ -2,43 +2,42 @@
 #define IMAGELOADER_H
 
 #include <QObject>
-#include <QMap>
 
-QT_BEGIN_NAMESPACE
-class QNetworkAccessManager;
-class QNetworkReply;
-QT_END_NAMESPACE
-
-class ImageCache;
+class ImageLoaderFactory;
 
 #include "Logging.h"
 
+// A lightweight per-requester handle for loading card images.  All work
+// is delegated to the client-wide ImageLoaderFactory, which coalesces
+// requests for the same multiverse ID, decodes off the GUI thread and
+// keeps recently decoded images in memory.
 class ImageLoader : public QObject
 {
     Q_OBJECT
 
 public:
-    ImageLoader( ImageCache*     imageCache,
-                 const QString&  cardImageUrlTemplateStr,
-                 Logging::Config loggingConfig = Logging::Config(),
-                 QObject*        parent = 0 );
+    ImageLoader( ImageLoaderFactory* imageLoaderFactory,
+                 Logging::Config     loggingConfig = Logging::Config(),
+                 QObject*            parent = 0 );
 
+    // Requests an image.  The imageLoaded signal is emitted once the image
+    // is available, possibly before this call returns.  A null image is
+    // delivered if the image could not be loaded.
     void loadImage( int multiverseId );
 
 signals:
     void imageLoaded( int multiverseId, const QImage& image );
 
-private slots:
-    void networkAccessFinished( QNetworkReply *reply );
-
 private:
 
-    ImageCache* const        mImageCache;
-    const QString            mCardImageUrlTemplateStr;
-    QNetworkAccessManager*   mNetworkAccessManager;
-    QMap<QNetworkReply*,int> mReplyToMuidMap;
+    // Called by the factory when a requested image is available.
+    void deliverImage( int multiverseId, const QImage& image );
+
+    ImageLoaderFactory* const mImageLoaderFactory;
 
     std::shared_ptr<spdlog::logger> mLogger;
+
+    friend class ImageLoaderFactory;
 };
 
 #endif  // IMAGELOADER_H
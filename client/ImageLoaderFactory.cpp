@@ -1,17 +1,323 @@
 #include "ImageLoaderFactory.h"
 
+#include <QBuffer>
+#include <QFutureWatcher>
+#include <QImageReader>
+#include <QNetworkAccessManager>
+#include <QNetworkReply>
+#include <QNetworkRequest>
+#include <QUrl>
+#include <QtConcurrent>
+
+#include "ImageCache.h"
+#include "qtutils_core.h"
+
+// Number of worker threads for disk reads and image decoding.
+static const int DECODE_THREAD_COUNT = 2;
+
+// Maximum number of simultaneous image downloads.
+static const int MAX_CONCURRENT_DOWNLOADS = 6;
+
+// Prefetches only start when fewer than this many downloads are active.
+static const int MAX_CONCURRENT_PREFETCH_DOWNLOADS = 2;
+
+// Fraction of the disk cache that prefetching may fill.
+static const int PREFETCH_BUDGET_DIVISOR = 2;
+
+// Byte budget for the decoded image cache.  A decoded card image is
+// roughly 300KB, so this keeps a couple of sealed pools' worth in memory.
+static const int DECODED_IMAGE_CACHE_MAX_BYTES = 64 * 1024 * 1024;
+
+
 ImageLoaderFactory::ImageLoaderFactory( ImageCache*     imageCache,
                                         const QString&  cardImageUrlTemplateStr,
+                                        Logging::Config loggingConfig,
                                         QObject*        parent )
   : QObject( parent ),
     mImageCache( imageCache ),
-    mCardImageUrlTemplateStr( cardImageUrlTemplateStr )
-{} 
+    mCardImageUrlTemplateStr( cardImageUrlTemplateStr ),
+    mPrefetchedBytes( 0 ),
+    mDecodedImageCache( DECODED_IMAGE_CACHE_MAX_BYTES ),
+    mLogger( loggingConfig.createLogger() )
+{
+    mThreadPool.setMaxThreadCount( DECODE_THREAD_COUNT );
+
+    mNetworkAccessManager = new QNetworkAccessManager( this );
+    connect( mNetworkAccessManager, SIGNAL(finished(QNetworkReply*)),
+             this, SLOT(networkAccessFinished(QNetworkReply*)) );
+}
+
+
+ImageLoaderFactory::~ImageLoaderFactory()
+{
+    // Workers reference the image cache; make sure they're done with it.
+    mThreadPool.waitForDone();
+}
 
 
 ImageLoader*
 ImageLoaderFactory::createImageLoader( Logging::Config loggingConfig,
                                        QObject*        parent )
 {
-    return new ImageLoader( mImageCache, mCardImageUrlTemplateStr, Logging::Config(), parent );
+    return new ImageLoader( this, loggingConfig, parent );
+}
+
+
+void
+ImageLoaderFactory::requestImage( int multiverseId, ImageLoader* imageLoader )
+{
+    // Deliver straight from memory if possible.
+    QImage* decodedImage = mDecodedImageCache.object( multiverseId );
+    if( decodedImage != nullptr )
+    {
+        mLogger->trace( "decoded image cache hit {}", multiverseId );
+        imageLoader->deliverImage( multiverseId, *decodedImage );
+        return;
+    }
+
+    // If a load is already in flight just wait on it.
+    auto iter = mPendingLoaders.find( multiverseId );
+    if( iter != mPendingLoaders.end() )
+    {
+        mLogger->trace( "coalescing request for {}", multiverseId );
+        iter->append( imageLoader );
+        return;
+    }
+
+    mPendingLoaders[multiverseId].append( imageLoader );
+    startCacheRead( multiverseId );
+}
+
+
+ImageLoaderFactory::PrefetchResult
+ImageLoaderFactory::prefetchImage( int multiverseId )
+{
+    if( mImageCache == 0 ) return PREFETCH_RESULT_BUDGET_EXHAUSTED;
+
+    if( mDecodedImageCache.contains( multiverseId ) ||
+        mPendingLoaders.contains( multiverseId ) ||
+        mImageCache->contains( multiverseId ) )
+    {
+        return PREFETCH_RESULT_NOT_NEEDED;
+    }
+
+    if( mPrefetchedBytes >= mImageCache->getMaxBytes() / PREFETCH_BUDGET_DIVISOR )
+    {
+        return PREFETCH_RESULT_BUDGET_EXHAUSTED;
+    }
+
+    if( !mDownloadQueue.isEmpty() || (mReplyToMuidMap.size() >= MAX_CONCURRENT_PREFETCH_DOWNLOADS) )
+    {
+        return PREFETCH_RESULT_BUSY;
+    }
+
+    mLogger->trace( "prefetching image {}", multiverseId );
+
+    // An empty loader list marks the load in flight so that real requests
+    // coalesce onto it.
+    mPendingLoaders.insert( multiverseId, QList<QPointer<ImageLoader>>() );
+    mPrefetchMuids.insert( multiverseId );
+    startDownload( multiverseId );
+    return PREFETCH_RESULT_STARTED;
+}
+
+
+void
+ImageLoaderFactory::startCacheRead( int multiverseId )
+{
+    if( mImageCache == 0 )
+    {
+        enqueueDownload( multiverseId );
+        return;
+    }
+
+    ImageCache* imageCache = mImageCache;
+    QFutureWatcher<DecodeResult>* watcher = new QFutureWatcher<DecodeResult>( this );
+    connect( watcher, &QFutureWatcher<DecodeResult>::finished, this, [this,watcher]() {
+            handleDecodeResult( watcher->result(), false );
+            watcher->deleteLater();
+        } );
+    watcher->setFuture( QtConcurrent::run( &mThreadPool, [imageCache,multiverseId]() {
+            DecodeResult result;
+            result.multiverseId = multiverseId;
+            result.decoded = true;
+            imageCache->tryReadFromCache( multiverseId, result.image );
+            return result;
+        } ) );
+}
+
+
+void
+ImageLoaderFactory::enqueueDownload( int multiverseId )
+{
+    mDownloadQueue.enqueue( multiverseId );
+    startQueuedDownloads();
+}
+
+
+void
+ImageLoaderFactory::startQueuedDownloads()
+{
+    while( !mDownloadQueue.isEmpty() && (mReplyToMuidMap.size() < MAX_CONCURRENT_DOWNLOADS) )
+    {
+        startDownload( mDownloadQueue.dequeue() );
+    }
+}
+
+
+void
+ImageLoaderFactory::startDownload( int multiverseId )
+{
+    // Start a load from the web.  Use the URL template from settings and
+    // substitute in the multiverse ID.
+    QString imageUrlStr( mCardImageUrlTemplateStr );
+    imageUrlStr.replace( "%muid%", QString::number( multiverseId ) );
+    QUrl url( imageUrlStr );
+    QNetworkRequest req( url );
+    mLogger->debug( "starting picture download: {}", req.url().toString() );
+    QNetworkReply* replyPtr = mNetworkAccessManager->get( req );
+    mReplyToMuidMap.insert( replyPtr, multiverseId );
+}
+
+
+void
+ImageLoaderFactory::networkAccessFinished( QNetworkReply *reply )
+{
+    // From the Qt docs:
+    // Note: After the request has finished, it is the responsibility of the
+    // user to delete the QNetworkReply object at an appropriate time. Do not
+    // directly delete it inside the slot connected to finished(). You can use
+    // the deleteLater() function.
+    QScopedPointer<QNetworkReply, QScopedPointerDeleteLater> replyScopedPtr( reply );
+
+    // Get the multiverse id for this reply and remove the association.
+    if( !mReplyToMuidMap.contains( reply ) )
+    {
+        mLogger->warn( "no muid entry for reply!" );
+        return;
+    }
+    int multiverseId = mReplyToMuidMap.take( reply );
+
+    mLogger->debug( "reply for picture download: {}", reply->url().toString() );
+
+    // Detect errors in the reply.
+    if (reply->error())
+    {
+        mLogger->warn( "Download failed: {}", reply->errorString() );
+        mPrefetchMuids.remove( multiverseId );
+        completeRequest( multiverseId, QImage() );
+        startQueuedDownloads();
+        return;
+    }
+
+    // If this is a redirect, then make a new request.  The redirect takes
+    // over the original's download slot.
+    int statusCode = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+    if (statusCode == 301 || statusCode == 302)
+    {
+        QUrl redirectUrl = reply->attribute(QNetworkRequest::RedirectionTargetAttribute).toUrl();
+        QNetworkRequest req(redirectUrl);
+        mLogger->debug( "following redirect url: {}", req.url().toString() );
+        // Need to put the new reply->muid in the map.
+        QNetworkReply* newReplyPtr = mNetworkAccessManager->get(req);
+        mReplyToMuidMap.insert( newReplyPtr, multiverseId );
+        return;
+    }
+
+    const QByteArray imageData = reply->readAll();
+    if( mPrefetchMuids.remove( multiverseId ) )
+    {
+        mPrefetchedBytes += imageData.size();
+    }
+
+    // Prefetches nobody has asked for yet only need to reach the disk
+    // cache, so skip decoding them.
+    startNetworkDecode( multiverseId, imageData, !mPendingLoaders.value( multiverseId ).isEmpty() );
+    startQueuedDownloads();
+}
+
+
+void
+ImageLoaderFactory::startNetworkDecode( int multiverseId, const QByteArray& imageData, bool decode )
+{
+    ImageCache* imageCache = mImageCache;
+    QFutureWatcher<DecodeResult>* watcher = new QFutureWatcher<DecodeResult>( this );
+    connect( watcher, &QFutureWatcher<DecodeResult>::finished, this, [this,watcher]() {
+            handleDecodeResult( watcher->result(), true );
+            watcher->deleteLater();
+        } );
+    watcher->setFuture( QtConcurrent::run( &mThreadPool, [imageCache,multiverseId,imageData,decode]() {
+            DecodeResult result;
+            result.multiverseId = multiverseId;
+            result.decoded = decode;
+
+            // The format comes from the header alone; the pixels are only
+            // decoded if someone is waiting for the image.
+            QByteArray data( imageData );
+            QBuffer buffer( &data );
+            buffer.open( QIODevice::ReadOnly );
+            QImageReader imgReader( &buffer );
+            imgReader.setDecideFormatFromContent( true );
+            const QByteArray format = imgReader.format();
+            if( format.isEmpty() ) return result;
+
+            QString extension = "." + QString::fromLatin1( format );
+            if( extension == ".jpeg" )
+                extension = ".jpg";
+
+            if( decode && !imgReader.read( &result.image ) ) return result;
+
+            if( imageCache != 0 )
+            {
+                imageCache->tryWriteToCache( multiverseId, extension, imageData );
+            }
+            return result;
+        } ) );
+}
+
+
+void
+ImageLoaderFactory::handleDecodeResult( const DecodeResult& result, bool fromNetwork )
+{
+    if( !result.decoded )
+    {
+        // A prefetch that a request coalesced onto after the download
+        // finished; the image is now on disk.
+        if( !mPendingLoaders.value( result.multiverseId ).isEmpty() )
+        {
+            startCacheRead( result.multiverseId );
+            return;
+        }
+    }
+    else if( result.image.isNull() )
+    {
+        if( !fromNetwork )
+        {
+            // Cache miss; go to the network.
+            enqueueDownload( result.multiverseId );
+            return;
+        }
+        mLogger->warn( "Failed to read image {} from network data", result.multiverseId );
+    }
+
+    completeRequest( result.multiverseId, result.image );
+}
+
+
+void
+ImageLoaderFactory::completeRequest( int multiverseId, const QImage& image )
+{
+    const QList<QPointer<ImageLoader>> loaders = mPendingLoaders.take( multiverseId );
+
+    // Prefetched images nobody has asked for yet stay on disk only.
+    if( !image.isNull() && !loaders.isEmpty() )
+    {
+        mDecodedImageCache.insert( multiverseId, new QImage( image ), image.byteCount() );
+    }
+
+    mLogger->debug( "image {} loaded for {} requester(s)", multiverseId, loaders.size() );
+    for( const QPointer<ImageLoader>& loader : loaders )
+    {
+        if( loader ) loader->deliverImage( multiverseId, image );
+    }
 }
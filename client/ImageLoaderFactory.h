@@ -2,29 +2,108 @@
 #define IMAGELOADERFACTORY_H
 
 #include <QObject>
+#include <QCache>
+#include <QHash>
+#include <QImage>
+#include <QList>
+#include <QPointer>
+#include <QQueue>
+#include <QSet>
+#include <QThreadPool>
 #include "ImageLoader.h"
 #include "Logging.h"
 
+QT_BEGIN_NAMESPACE
+class QNetworkAccessManager;
+class QNetworkReply;
+QT_END_NAMESPACE
+
 class ImageCache;
 
 
+// Client-wide image service.  Creates lightweight ImageLoader handles
+// and services their requests:
+//   - requests for the same multiverse ID are coalesced into one load
+//   - disk reads and image decoding run on a worker thread pool
+//   - network downloads share one access manager and are capped
+//   - decoded images are kept in an in-memory LRU with a byte budget
+//   - background prefetches use spare download capacity only
 class ImageLoaderFactory : public QObject
 {
     Q_OBJECT
 
 public:
 
+    enum PrefetchResult
+    {
+        PREFETCH_RESULT_STARTED,           // download started
+        PREFETCH_RESULT_NOT_NEEDED,        // already cached or in flight
+        PREFETCH_RESULT_BUSY,              // no spare capacity; retry later
+        PREFETCH_RESULT_BUDGET_EXHAUSTED   // prefetch byte budget used up
+    };
+
     explicit ImageLoaderFactory( ImageCache*     imageCache,
                                  const QString&  cardImageUrlTemplateStr,
+                                 Logging::Config loggingConfig = Logging::Config(),
                                  QObject*        parent = 0 );
 
+    virtual ~ImageLoaderFactory();
+
     ImageLoader* createImageLoader( Logging::Config loggingConfig = Logging::Config(),
                                     QObject*        parent = 0 );
 
+    // Service a request from a loader.  The loader is notified via
+    // ImageLoader::deliverImage() if it still exists when the load completes.
+    void requestImage( int multiverseId, ImageLoader* imageLoader );
+
+    // Download an image into the disk cache if it isn't already there.
+    // Prefetches yield to foreground requests and are limited in total to
+    // a fraction of the disk cache size.
+    PrefetchResult prefetchImage( int multiverseId );
+
+    // Start a fresh prefetch byte budget, e.g. for a new room.
+    void resetPrefetchBudget() { mPrefetchedBytes = 0; }
+
+private slots:
+    void networkAccessFinished( QNetworkReply *reply );
+
 private:
 
+    struct DecodeResult
+    {
+        int    multiverseId;
+        bool   decoded;  // false if only the format was checked
+        QImage image;
+    };
+
+    void startCacheRead( int multiverseId );
+    void enqueueDownload( int multiverseId );
+    void startQueuedDownloads();
+    void startDownload( int multiverseId );
+    void startNetworkDecode( int multiverseId, const QByteArray& imageData, bool decode );
+    void handleDecodeResult( const DecodeResult& result, bool fromNetwork );
+    void completeRequest( int multiverseId, const QImage& image );
+
     ImageCache* const        mImageCache;
     const QString            mCardImageUrlTemplateStr;
+    QNetworkAccessManager*   mNetworkAccessManager;
+    QThreadPool              mThreadPool;
+
+    // Loaders waiting on each in-flight multiverse ID.
+    QHash<int,QList<QPointer<ImageLoader>>> mPendingLoaders;
+
+    // Downloads not yet started due to the concurrency limit.
+    QQueue<int>              mDownloadQueue;
+    QHash<QNetworkReply*,int> mReplyToMuidMap;
+
+    // In-flight prefetch downloads and total bytes prefetched.
+    QSet<int>                mPrefetchMuids;
+    quint64                  mPrefetchedBytes;
+
+    // Decoded images; cost is in bytes.
+    QCache<int,QImage>       mDecodedImageCache;
+
+    std::shared_ptr<spdlog::logger> mLogger;
 };
 
 #endif  // IMAGELOADERFACTORY_H
@@ -0,0 +1,198 @@
+#include "ImagePrefetcher.h"
+
+#include <QTimer>
+#include <algorithm>
+#include <map>
+#include <set>
+
+#include "AllSetsData.h"
+#include "CardData.h"
+#include "ImageLoaderFactory.h"
+
+// Interval between prefetch attempts.  Together with the image service's
+// prefetch download cap this throttles background bandwidth.
+static const int PREFETCH_INTERVAL_MILLIS = 250;
+
+// Limit on card lookups per tick when candidates are already cached.
+static const int MAX_LOOKUPS_PER_TICK = 20;
+
+// Cards per pack assumed for custom card lists.
+static const float CUSTOM_LIST_PACK_SIZE = 15.0f;
+
+
+ImagePrefetcher::ImagePrefetcher( ImageLoaderFactory*    imageLoaderFactory,
+                                  const Logging::Config& loggingConfig,
+                                  QObject*               parent )
+  : QObject( parent ),
+    mImageLoaderFactory( imageLoaderFactory ),
+    mNextCandidateIndex( 0 ),
+    mPaused( false ),
+    mLogger( loggingConfig.createLogger() )
+{
+    mTimer = new QTimer( this );
+    mTimer->setInterval( PREFETCH_INTERVAL_MILLIS );
+    connect( mTimer, &QTimer::timeout, this, &ImagePrefetcher::handleTimerTick );
+}
+
+
+void
+ImagePrefetcher::start( const proto::DraftConfig&   draftConfig,
+                        const AllSetsDataSharedPtr& allSetsData )
+{
+    stop();
+    mImageLoaderFactory->resetPrefetchBudget();
+    if( !allSetsData ) return;
+    mAllSetsData = allSetsData;
+
+    std::set<std::string> boosterSetCodes;
+    std::set<uint32_t> customCardListIndices;
+    for( const proto::DraftConfig::CardDispenser& dispenser : draftConfig.dispensers() )
+    {
+        for( const std::string& setCode : dispenser.source_booster_set_codes() )
+        {
+            boosterSetCodes.insert( setCode );
+        }
+        if( dispenser.has_source_custom_card_list_index() )
+        {
+            customCardListIndices.insert( dispenser.source_custom_card_list_index() );
+        }
+    }
+
+    for( const std::string& setCode : boosterSetCodes )
+    {
+        addBoosterSetCandidates( setCode );
+    }
+    for( uint32_t idx : customCardListIndices )
+    {
+        if( idx < (uint32_t) draftConfig.custom_card_lists_size() )
+        {
+            addCustomCardListCandidates( draftConfig.custom_card_lists( idx ) );
+        }
+    }
+
+    std::stable_sort( mCandidates.begin(), mCandidates.end(),
+            []( const Candidate& a, const Candidate& b ) { return a.weight > b.weight; } );
+
+    mLogger->debug( "prefetching {} card images", mCandidates.size() );
+    if( !mCandidates.empty() ) mTimer->start();
+}
+
+
+void
+ImagePrefetcher::stop()
+{
+    mTimer->stop();
+    mCandidates.clear();
+    mNextCandidateIndex = 0;
+    mAllSetsData.reset();
+}
+
+
+void
+ImagePrefetcher::setPaused( bool paused )
+{
+    if( paused != mPaused )
+    {
+        mLogger->trace( "prefetch paused={}", paused );
+        mPaused = paused;
+    }
+}
+
+
+void
+ImagePrefetcher::addBoosterSetCandidates( const std::string& setCode )
+{
+    // Weight each card by its expected copies per pack: the number of
+    // booster slots for its rarity divided by the cards of that rarity.
+    std::map<RarityType,float> slotsPerRarity;
+    for( SlotType slot : mAllSetsData->getBoosterSlots( setCode ) )
+    {
+        switch( slot )
+        {
+            case SLOT_COMMON:   slotsPerRarity[RARITY_COMMON]   += 1.0f; break;
+            case SLOT_UNCOMMON: slotsPerRarity[RARITY_UNCOMMON] += 1.0f; break;
+            case SLOT_RARE:     slotsPerRarity[RARITY_RARE]     += 1.0f; break;
+            case SLOT_RARE_OR_MYTHIC_RARE:
+                slotsPerRarity[RARITY_RARE]        += 7.0f / 8.0f;
+                slotsPerRarity[RARITY_MYTHIC_RARE] += 1.0f / 8.0f;
+                break;
+            default: break;
+        }
+    }
+
+    const std::multimap<RarityType,std::string> cardPool = mAllSetsData->getCardPool( setCode );
+    for( auto& kv : slotsPerRarity )
+    {
+        const std::size_t rarityCount = cardPool.count( kv.first );
+        if( rarityCount == 0 ) continue;
+        const float weight = kv.second / rarityCount;
+        auto range = cardPool.equal_range( kv.first );
+        for( auto iter = range.first; iter != range.second; ++iter )
+        {
+            mCandidates.push_back( Candidate{ setCode, iter->second, weight } );
+        }
+    }
+}
+
+
+void
+ImagePrefetcher::addCustomCardListCandidates( const proto::DraftConfig::CustomCardList& cardList )
+{
+    unsigned int totalQuantity = 0;
+    for( const auto& cardQty : cardList.card_quantities() ) totalQuantity += cardQty.quantity();
+    if( totalQuantity == 0 ) return;
+
+    for( const auto& cardQty : cardList.card_quantities() )
+    {
+        const float weight = CUSTOM_LIST_PACK_SIZE * cardQty.quantity() / totalQuantity;
+        mCandidates.push_back( Candidate{ cardQty.set_code(), cardQty.name(), weight } );
+    }
+}
+
+
+void
+ImagePrefetcher::handleTimerTick()
+{
+    if( mPaused ) return;
+
+    // Card data lookups are done here rather than up front to spread
+    // their cost over time.
+    for( int lookups = 0; lookups < MAX_LOOKUPS_PER_TICK; ++lookups )
+    {
+        if( mNextCandidateIndex >= mCandidates.size() )
+        {
+            mLogger->debug( "prefetch complete" );
+            stop();
+            return;
+        }
+
+        const Candidate& candidate = mCandidates[mNextCandidateIndex];
+        std::unique_ptr<CardData> cardData( mAllSetsData->createCardData( candidate.setCode, candidate.name ) );
+        const int muid = cardData ? cardData->getMultiverseId() : -1;
+        if( muid < 0 )
+        {
+            ++mNextCandidateIndex;
+            continue;
+        }
+
+        ImageLoaderFactory::PrefetchResult result = mImageLoaderFactory->prefetchImage( muid );
+        if( result == ImageLoaderFactory::PREFETCH_RESULT_BUSY )
+        {
+            // Try this candidate again next tick.
+            return;
+        }
+        if( result == ImageLoaderFactory::PREFETCH_RESULT_BUDGET_EXHAUSTED )
+        {
+            mLogger->debug( "prefetch budget exhausted after {} candidates", mNextCandidateIndex );
+            stop();
+            return;
+        }
+
+        ++mNextCandidateIndex;
+        if( result == ImageLoaderFactory::PREFETCH_RESULT_STARTED )
+        {
+            // One download per tick.
+            return;
+        }
+    }
+}
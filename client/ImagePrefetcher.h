@@ -0,0 +1,68 @@
+#ifndef IMAGEPREFETCHER_H
+#define IMAGEPREFETCHER_H
+
+#include <QObject>
+#include <vector>
+
+#include "DraftConfig.pb.h"
+#include "clienttypes.h"
+#include "Logging.h"
+
+QT_BEGIN_NAMESPACE
+class QTimer;
+QT_END_NAMESPACE
+
+class ImageLoaderFactory;
+
+// Warms the image cache in the background with the card universe of a
+// room.  Cards are ordered by how likely they are to appear in a pack,
+// fed to the image service at a throttled pace, and paused while the
+// user is picking so prefetching never competes with visible cards.
+class ImagePrefetcher : public QObject
+{
+    Q_OBJECT
+
+public:
+
+    ImagePrefetcher( ImageLoaderFactory*    imageLoaderFactory,
+                     const Logging::Config& loggingConfig = Logging::Config(),
+                     QObject*               parent = 0 );
+
+    // Replace any current prefetching with the cards of a draft.
+    void start( const proto::DraftConfig&   draftConfig,
+                const AllSetsDataSharedPtr& allSetsData );
+
+    void stop();
+
+    void setPaused( bool paused );
+
+private slots:
+
+    void handleTimerTick();
+
+private:
+
+    struct Candidate
+    {
+        std::string setCode;
+        std::string name;
+        float       weight;  // expected copies per pack
+    };
+
+    void addBoosterSetCandidates( const std::string& setCode );
+    void addCustomCardListCandidates( const proto::DraftConfig::CustomCardList& cardList );
+
+    ImageLoaderFactory* const mImageLoaderFactory;
+    AllSetsDataSharedPtr      mAllSetsData;
+
+    // Sorted most-likely first; consumed from mNextCandidateIndex.
+    std::vector<Candidate>    mCandidates;
+    std::size_t               mNextCandidateIndex;
+
+    bool                      mPaused;
+    QTimer*                   mTimer;
+
+    std::shared_ptr<spdlog::logger> mLogger;
+};
+
+#endif  // IMAGEPREFETCHER_H
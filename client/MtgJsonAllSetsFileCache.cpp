@@ -1,12 +1,31 @@
 #include "MtgJsonAllSetsFileCache.h"
 
+#include <QCryptographicHash>
+#include <QDataStream>
 #include <QFile>
 #include <QTextStream>
+#include <cstring>
 #include "qtutils_core.h"
 
 static const QString ALLSETS_FILENAME( "AllSets.json" );
 static const QString ALLSETS_VERSION_FILENAME( ".allsets_version" );
 
+// Delta format, as published by the web service (all integers big-endian):
+//   magic "TDL1", base SHA-256 (32 bytes), result SHA-256 (32 bytes),
+//   result size (u64), then operations until DELTA_OP_END:
+//     DELTA_OP_COPY: offset (u64), length (u32) - copy from base
+//     DELTA_OP_DATA: length (u32), bytes         - literal data
+static const char      DELTA_MAGIC[] = "TDL1";
+static const int       DELTA_HASH_SIZE = 32;
+static const quint8    DELTA_OP_END = 0;
+static const quint8    DELTA_OP_COPY = 1;
+static const quint8    DELTA_OP_DATA = 2;
+
+// Sanity limit for the size of a delta's result.
+static const quint64   DELTA_RESULT_SIZE_MAX = Q_UINT64_C( 1 ) << 30;
+
+const int MtgJsonAllSetsFileCache::DELTA_CHAIN_MAX;
+
 QString
 MtgJsonAllSetsFileCache::getCachedFilePath( const AllSetsUpdateChannel::ChannelType& channel ) const
 {
@@ -136,6 +155,140 @@ recover_allsets_file:
 }
 
 
+bool
+MtgJsonAllSetsFileCache::applyDeltas( const AllSetsUpdateChannel::ChannelType& channel,
+                                      const QList<QByteArray>&                 deltas,
+                                      QByteArray*                              result ) const
+{
+    if( deltas.size() > DELTA_CHAIN_MAX )
+    {
+        mLogger->notice( "delta chain too long ({})", deltas.size() );
+        return false;
+    }
+
+    const QString allSetsFilePath = getCachedFilePath( channel );
+    QFile file( allSetsFilePath );
+    if( !file.open( QIODevice::ReadOnly ) )
+    {
+        mLogger->notice( "unable to read {} to apply deltas", allSetsFilePath );
+        return false;
+    }
+    QByteArray data = file.readAll();
+    file.close();
+
+    for( int i = 0; i < deltas.size(); ++i )
+    {
+        QByteArray next;
+        if( !applyDelta( data, deltas[i], &next ) )
+        {
+            mLogger->notice( "failed to apply delta {} of {}", i + 1, deltas.size() );
+            return false;
+        }
+        data.swap( next );
+    }
+
+    mLogger->debug( "applied {} deltas, result size {}", deltas.size(), data.size() );
+    result->swap( data );
+    return true;
+}
+
+
+bool
+MtgJsonAllSetsFileCache::applyDelta( const QByteArray& base, const QByteArray& delta, QByteArray* result ) const
+{
+    QDataStream in( delta );
+
+    char magic[sizeof(DELTA_MAGIC) - 1];
+    if( (in.readRawData( magic, sizeof(magic) ) != sizeof(magic)) ||
+        (memcmp( magic, DELTA_MAGIC, sizeof(magic) ) != 0) )
+    {
+        mLogger->notice( "delta has bad magic" );
+        return false;
+    }
+
+    QByteArray baseHash( DELTA_HASH_SIZE, '\0' );
+    QByteArray resultHash( DELTA_HASH_SIZE, '\0' );
+    quint64 resultSize;
+    in.readRawData( baseHash.data(), DELTA_HASH_SIZE );
+    in.readRawData( resultHash.data(), DELTA_HASH_SIZE );
+    in >> resultSize;
+    if( (in.status() != QDataStream::Ok) || (resultSize > DELTA_RESULT_SIZE_MAX) )
+    {
+        mLogger->notice( "delta has bad header" );
+        return false;
+    }
+
+    if( QCryptographicHash::hash( base, QCryptographicHash::Sha256 ) != baseHash )
+    {
+        mLogger->notice( "delta base checksum mismatch" );
+        return false;
+    }
+
+    result->clear();
+    result->reserve( resultSize );
+    for( ;; )
+    {
+        quint8 op;
+        in >> op;
+        if( in.status() != QDataStream::Ok ) break;
+        if( op == DELTA_OP_END ) break;
+
+        if( op == DELTA_OP_COPY )
+        {
+            quint64 offset;
+            quint32 length;
+            in >> offset >> length;
+            // Written so a huge offset can't wrap around.
+            const quint64 baseSize = static_cast<quint64>( base.size() );
+            if( (in.status() != QDataStream::Ok) || (offset > baseSize) || (length > baseSize - offset) )
+            {
+                mLogger->notice( "delta copy out of range" );
+                return false;
+            }
+            result->append( base.constData() + offset, length );
+        }
+        else if( op == DELTA_OP_DATA )
+        {
+            quint32 length;
+            in >> length;
+            if( (in.status() != QDataStream::Ok) || (length > static_cast<quint32>( delta.size() )) )
+            {
+                mLogger->notice( "delta data out of range" );
+                return false;
+            }
+            const int oldSize = result->size();
+            result->resize( oldSize + length );
+            if( in.readRawData( result->data() + oldSize, length ) != static_cast<int>( length ) )
+            {
+                mLogger->notice( "delta data truncated" );
+                return false;
+            }
+        }
+        else
+        {
+            mLogger->notice( "delta has unknown operation {}", static_cast<int>( op ) );
+            return false;
+        }
+
+        if( static_cast<quint64>( result->size() ) > resultSize )
+        {
+            mLogger->notice( "delta result too large" );
+            return false;
+        }
+    }
+
+    if( (in.status() != QDataStream::Ok) ||
+        (static_cast<quint64>( result->size() ) != resultSize) ||
+        (QCryptographicHash::hash( *result, QCryptographicHash::Sha256 ) != resultHash) )
+    {
+        mLogger->notice( "delta result checksum mismatch" );
+        return false;
+    }
+
+    return true;
+}
+
+
 QDir
 MtgJsonAllSetsFileCache::getChannelDir( const AllSetsUpdateChannel::ChannelType& channel ) const
 {
@@ -1,7 +1,9 @@
 #ifndef MTGJSONALLSETSFILECACHE_H
 #define MTGJSONALLSETSFILECACHE_H
 
+#include <QByteArray>
 #include <QDir>
+#include <QList>
 #include "Logging.h"
 #include "AllSetsUpdateChannel.h"
 
@@ -10,6 +12,9 @@ class MtgJsonAllSetsFileCache
 
 public:
 
+    // Longer chains of deltas are refused in favor of the full file.
+    static const int DELTA_CHAIN_MAX = 5;
+
     MtgJsonAllSetsFileCache( const QDir&     cacheDir,
                              Logging::Config loggingConfig = Logging::Config() )
       : mCacheDir( cacheDir ),
@@ -22,10 +27,20 @@ public:
     // Commit file and version info to the application's storage area.
     bool commit( const AllSetsUpdateChannel::ChannelType& channel, const QString& filePath, const QString& version );
 
+    // Apply a chain of deltas, oldest first, to the cached file.  Each
+    // delta's checksums must match the data before and after applying it.
+    // Returns false if the chain can't be applied; the caller should fall
+    // back to the full file.  Safe to call from a worker thread.
+    bool applyDeltas( const AllSetsUpdateChannel::ChannelType& channel,
+                      const QList<QByteArray>&                 deltas,
+                      QByteArray*                              result ) const;
+
 private:
 
     QDir getChannelDir( const AllSetsUpdateChannel::ChannelType& channel ) const;
 
+    bool applyDelta( const QByteArray& base, const QByteArray& delta, QByteArray* result ) const;
+
     QDir                            mCacheDir;
     std::shared_ptr<spdlog::logger> mLogger;
 
@@ -16,9 +16,13 @@
 #include "WebServerInterface.h"
 #include "MtgJsonAllSetsFileCache.h"
 #include "MtgJsonAllSetsData.h"
+#include "ChunkedReadStream.h"
 
 #include "rapidjson/error/en.h"
 
+// Times a failed download is resumed before giving up.
+static const int DOWNLOAD_RETRIES_MAX = 3;
+
 static const QString CHANNEL_STABLE  = "stable";
 static const QString CHANNEL_MTGJSON = "mtgjson";
 
@@ -36,12 +40,20 @@ MtgJsonAllSetsUpdater::MtgJsonAllSetsUpdater( ClientSettings*          clientSet
     mTmpFile( nullptr ),
     mDownloadNetworkReply( nullptr ),
     mDownloadAborted( false ),
+    mDownloadOffset( 0 ),
+    mDownloadRequestOffset( 0 ),
+    mDownloadRetries( 0 ),
+    mDownloadDone( false ),
+    mParseAllSetsDataPtr( nullptr ),
+    mParseStream( nullptr ),
+    mParseFile( NULL ),
     mLoggingConfig( loggingConfig ),
     mLogger( loggingConfig.createLogger() )
 {
     mNetworkAccessManager = new QNetworkAccessManager( this );
 
     connect( &mParseFutureWatcher, SIGNAL(finished()), this, SLOT(parsingFinished()) );
+    connect( &mDeltaFutureWatcher, SIGNAL(finished()), this, SLOT(deltaApplyFinished()) );
 }
 
 
@@ -49,6 +61,9 @@ MtgJsonAllSetsUpdater::~MtgJsonAllSetsUpdater()
 {
     // Possible that progress dialog was created without a parent.
     if( mCheckProgressDialog ) mCheckProgressDialog->deleteLater();
+
+    mDeltaFuture.waitForFinished();
+    stopParse();
 }
 
 
@@ -119,6 +134,8 @@ MtgJsonAllSetsUpdater::finishAndReset()
         mDownloadNetworkReply = nullptr;
     }
 
+    stopParse();
+
     if( mUpdateProgressDialog )
     {
         mUpdateProgressDialog->close();
@@ -178,7 +195,7 @@ MtgJsonAllSetsUpdater::checkFinished()
                 if( answer == QMessageBox::Yes )
                 {
                     // User wants to update.  Start the download process.
-                    startDownload( updateInfo.downloadUrl );
+                    startUpdate( updateInfo );
                     mUpdateVersion = updateInfo.updateVersion;
                     downloadStarted = true;
                 }
@@ -287,6 +304,7 @@ MtgJsonAllSetsUpdater::processStableChannelResponse( const rapidjson::Document&
                     updateInfo->updateAvailable = true;
                     updateInfo->updateVersion = version;
                     updateInfo->downloadUrl = QUrl( QString::fromStdString( downloadUrlVal.GetString() ) );
+                    processDeltas( doc, updateInfo );
                     return true;
                 }
                 else
@@ -383,7 +401,36 @@ MtgJsonAllSetsUpdater::processMtgJsonChannelResponse( const rapidjson::Document&
 
 
 void
-MtgJsonAllSetsUpdater::startDownload( QUrl& url )
+MtgJsonAllSetsUpdater::processDeltas( const rapidjson::Document& doc, UpdateInfo* updateInfo )
+{
+    // Deltas are optional; anything unexpected means the full download.
+    updateInfo->deltaUrls.clear();
+    if( !doc.HasMember( "deltas" ) ) return;
+
+    const rapidjson::Value& deltasVal = doc["deltas"];
+    if( !deltasVal.IsArray() )
+    {
+        mLogger->notice( "JSON reply from server has invalid 'deltas' key" );
+        return;
+    }
+
+    QList<QUrl> deltaUrls;
+    for( rapidjson::Value::ConstValueIterator iter = deltasVal.Begin(); iter != deltasVal.End(); ++iter )
+    {
+        if( !iter->IsObject() || !iter->HasMember( "url" ) || !(*iter)["url"].IsString() )
+        {
+            mLogger->notice( "JSON reply from server has invalid delta" );
+            return;
+        }
+        deltaUrls.append( QUrl( QString::fromStdString( (*iter)["url"].GetString() ) ) );
+    }
+    mLogger->debug( "{} deltas available", deltaUrls.size() );
+    updateInfo->deltaUrls = deltaUrls;
+}
+
+
+void
+MtgJsonAllSetsUpdater::startUpdate( const UpdateInfo& updateInfo )
 {
     mTmpFile = new QTemporaryFile( this );
     if( !mTmpFile->open() )
@@ -392,15 +439,9 @@ MtgJsonAllSetsUpdater::startDownload( QUrl& url )
                 tr("Unable to save to file %1: %2.")
                 .arg( mTmpFile->fileName() ).arg( mTmpFile->errorString() ) );
         finishAndReset();
+        return;
     };
 
-    QNetworkRequest req( url );
-    mLogger->debug( "starting AllSets download: {}", req.url().toString() );
-    mDownloadNetworkReply = mNetworkAccessManager->get( req );
-    connect( mDownloadNetworkReply, &QNetworkReply::readyRead, this, &MtgJsonAllSetsUpdater::downloadReadyRead );
-    connect( mDownloadNetworkReply, &QNetworkReply::downloadProgress, this, &MtgJsonAllSetsUpdater::downloadProgress );
-    connect( mDownloadNetworkReply, &QNetworkReply::finished, this, &MtgJsonAllSetsUpdater::downloadFinished );
-
     // If parent is a widget, progress dialog will be modal to it.  If not
     // then dialog will be constructed with a null parent.
     QWidget* parentWidget = qobject_cast<QWidget*>( parent() );
@@ -415,6 +456,199 @@ MtgJsonAllSetsUpdater::startDownload( QUrl& url )
     mUpdateProgressDialog->setMaximum( 0 );
     connect( mUpdateProgressDialog, SIGNAL(canceled()), this, SLOT(downloadCanceled()) );
     mUpdateProgressDialog->show();
+
+    // Small updates can be patched onto the cached file; anything else
+    // is a full download.
+    mFullDownloadUrl = updateInfo.downloadUrl;
+    mDeltaUrls = updateInfo.deltaUrls;
+    mDeltas.clear();
+    if( !mDeltaUrls.isEmpty() && (mDeltaUrls.size() <= MtgJsonAllSetsFileCache::DELTA_CHAIN_MAX) &&
+        (mMtgJsonAllSetsFileCache != nullptr) )
+    {
+        mUpdateProgressDialog->setLabelText( tr("Downloading updates...") );
+        requestNextDelta();
+    }
+    else
+    {
+        startDownload();
+    }
+}
+
+
+void
+MtgJsonAllSetsUpdater::startDownload()
+{
+    mUpdateProgressDialog->setLabelText( tr("Downloading...") );
+    mDownloadOffset = 0;
+    mDownloadRetries = 0;
+    mDownloadDone = false;
+    startParse();
+    requestDownload( mFullDownloadUrl );
+}
+
+
+void
+MtgJsonAllSetsUpdater::requestNextDelta()
+{
+    const QUrl url = mDeltaUrls[mDeltas.size()];
+    mLogger->debug( "requesting delta {} of {}: {}", mDeltas.size() + 1, mDeltaUrls.size(), url.toString() );
+    requestDelta( url );
+}
+
+
+void
+MtgJsonAllSetsUpdater::requestDelta( const QUrl& url )
+{
+    mDownloadNetworkReply = mNetworkAccessManager->get( QNetworkRequest( url ) );
+    connect( mDownloadNetworkReply, &QNetworkReply::finished, this, &MtgJsonAllSetsUpdater::deltaDownloadFinished );
+}
+
+
+void
+MtgJsonAllSetsUpdater::deltaDownloadFinished()
+{
+    // deleteLater the reply (required by Qt) when this method exits.
+    QScopedPointer<QNetworkReply, QScopedPointerDeleteLater> replyScopedPtr( mDownloadNetworkReply );
+    mDownloadNetworkReply = nullptr;
+
+    if( mDownloadAborted )
+    {
+        mLogger->debug( "deltaDownloadFinished: aborted" );
+        finishAndReset();
+        return;
+    }
+
+    if( replyScopedPtr->error() )
+    {
+        mLogger->notice( "delta download error: {}, falling back to full download", replyScopedPtr->errorString() );
+        startDownload();
+        return;
+    }
+
+    QVariant redirectionTarget = replyScopedPtr->attribute( QNetworkRequest::RedirectionTargetAttribute );
+    if( !redirectionTarget.isNull() )
+    {
+        QUrl newUrl = replyScopedPtr->url().resolved( redirectionTarget.toUrl() );
+        mLogger->debug( "deltaDownloadFinished: redirecting to : {}", newUrl.toString() );
+        requestDelta( newUrl );
+        return;
+    }
+
+    mDeltas.append( replyScopedPtr->readAll() );
+    if( mDeltas.size() < mDeltaUrls.size() )
+    {
+        mUpdateProgressDialog->setMaximum( mDeltaUrls.size() );
+        mUpdateProgressDialog->setValue( mDeltas.size() );
+        requestNextDelta();
+        return;
+    }
+
+    // Patch the cached file on another thread to keep UI responsive.
+    mUpdateProgressDialog->setLabelText( tr("Applying updates...") );
+    mUpdateProgressDialog->setMinimum( 0 );
+    mUpdateProgressDialog->setMaximum( 0 );
+    MtgJsonAllSetsFileCache* fileCache = mMtgJsonAllSetsFileCache;
+    const AllSetsUpdateChannel::ChannelType channel = mUpdateChannel;
+    const QList<QByteArray> deltas = mDeltas;
+    QByteArray* result = &mDeltaResult;
+    mDeltaFuture = QtConcurrent::run( [fileCache, channel, deltas, result]() {
+            return fileCache->applyDeltas( channel, deltas, result );
+        } );
+    mDeltaFutureWatcher.setFuture( mDeltaFuture );
+}
+
+
+void
+MtgJsonAllSetsUpdater::deltaApplyFinished()
+{
+    mDeltas.clear();
+    if( !mDeltaFuture.result() )
+    {
+        mLogger->notice( "failed to apply deltas, falling back to full download" );
+        mDeltaResult.clear();
+        startDownload();
+        return;
+    }
+
+    mTmpFile->write( mDeltaResult );
+    mTmpFile->flush();
+    mTmpFile->close();
+    mDeltaResult.clear();
+
+    // Parse the patched file as if it had just been downloaded.
+    const std::string allSetsFilePath = mTmpFile->fileName().toStdString();
+    mParseFile = fopen( allSetsFilePath.c_str(), "r" );
+    if( mParseFile == NULL )
+    {
+        mLogger->warn( "failed to open AllSets file at {}", mTmpFile->fileName() );
+        QMessageBox::warning( 0, tr("Error"),
+                tr("Unable to open file %1").arg( mTmpFile->fileName() ) );
+        finishAndReset();
+        return;
+    }
+
+    mUpdateProgressDialog->setLabelText( tr("Parsing...") );
+    mDownloadDone = true;
+    mParseAllSetsDataPtr = new MtgJsonAllSetsData( mLoggingConfig.createChildConfig( "mtgjson" ) );
+    MtgJsonAllSetsData* allSetsDataPtr = mParseAllSetsDataPtr;
+    FILE* fp = mParseFile;
+    mParseFuture = QtConcurrent::run( [allSetsDataPtr, fp]() {
+            return allSetsDataPtr->parse( fp );
+        } );
+    mParseFutureWatcher.setFuture( mParseFuture );
+}
+
+
+void
+MtgJsonAllSetsUpdater::requestDownload( const QUrl& url )
+{
+    // Resume where the last request left off if any data has arrived.
+    QNetworkRequest req( url );
+    if( mDownloadOffset > 0 )
+    {
+        req.setRawHeader( "Range", QByteArray( "bytes=" ) + QByteArray::number( mDownloadOffset ) + "-" );
+    }
+    mLogger->debug( "starting AllSets download: {} (offset {})", req.url().toString(), mDownloadOffset );
+    mDownloadUrl = url;
+    mDownloadRequestOffset = mDownloadOffset;
+    mDownloadNetworkReply = mNetworkAccessManager->get( req );
+    connect( mDownloadNetworkReply, &QNetworkReply::readyRead, this, &MtgJsonAllSetsUpdater::downloadReadyRead );
+    connect( mDownloadNetworkReply, &QNetworkReply::downloadProgress, this, &MtgJsonAllSetsUpdater::downloadProgress );
+    connect( mDownloadNetworkReply, &QNetworkReply::finished, this, &MtgJsonAllSetsUpdater::downloadFinished );
+}
+
+
+void
+MtgJsonAllSetsUpdater::startParse()
+{
+    // Parse on another thread, fed with data as the download progresses,
+    // so the update completes about when the transfer does.
+    mParseStream = new ChunkedReadStream();
+    mParseAllSetsDataPtr = new MtgJsonAllSetsData( mLoggingConfig.createChildConfig( "mtgjson" ) );
+    MtgJsonAllSetsData* allSetsDataPtr = mParseAllSetsDataPtr;
+    ChunkedReadStream* parseStream = mParseStream;
+    mParseFuture = QtConcurrent::run( [allSetsDataPtr, parseStream]() {
+            return allSetsDataPtr->parse( *parseStream );
+        } );
+    mParseFutureWatcher.setFuture( mParseFuture );
+}
+
+
+void
+MtgJsonAllSetsUpdater::stopParse()
+{
+    // Ending the stream makes the parser give up promptly.
+    if( mParseStream ) mParseStream->cancel();
+    mParseFuture.waitForFinished();
+    delete mParseAllSetsDataPtr;
+    mParseAllSetsDataPtr = nullptr;
+    delete mParseStream;
+    mParseStream = nullptr;
+    if( mParseFile != NULL )
+    {
+        fclose( mParseFile );
+        mParseFile = NULL;
+    }
 }
 
 
@@ -432,18 +666,37 @@ MtgJsonAllSetsUpdater::downloadCanceled()
 void
 MtgJsonAllSetsUpdater::downloadReadyRead()
 {
-    // Read data into the file.  Done here rather than at the
-    // networkAccessFinished() to avoid big RAM usage since the file can
-    // get large.
-    if( mDownloadNetworkReply )
+    // Data goes to the file for caching and to the parser at once.  Done
+    // here rather than at downloadFinished() to avoid big RAM usage since
+    // the file can get large.
+    if( !mDownloadNetworkReply || !mTmpFile || !mParseStream ) return;
+
+    // Bodies of redirects and the like aren't card data.
+    const int status = mDownloadNetworkReply->attribute( QNetworkRequest::HttpStatusCodeAttribute ).toInt();
+    if( (status != 200) && (status != 206) )
     {
-        mLogger->trace( "downloadReadyRead: {} bytes ready", mDownloadNetworkReply->size() );
-        if( mTmpFile )
-        {
-            mLogger->trace( "downloadReadyRead: writing to file", mDownloadNetworkReply->size() );
-            mTmpFile->write( mDownloadNetworkReply->readAll() );
-        }
+        mDownloadNetworkReply->readAll();
+        return;
+    }
+
+    // If the server ignored a resume request the data starts over, and so
+    // must the parse.
+    if( (status == 200) && (mDownloadOffset > 0) && (mDownloadRequestOffset > 0) )
+    {
+        mLogger->notice( "server did not resume download, restarting" );
+        stopParse();
+        mTmpFile->resize( 0 );
+        mTmpFile->seek( 0 );
+        mDownloadOffset = 0;
+        mDownloadRequestOffset = 0;
+        startParse();
     }
+
+    const QByteArray data = mDownloadNetworkReply->readAll();
+    mLogger->trace( "downloadReadyRead: {} bytes", data.size() );
+    mTmpFile->write( data );
+    mParseStream->append( data.constData(), data.size() );
+    mDownloadOffset += data.size();
 }
 
 
@@ -452,6 +705,13 @@ MtgJsonAllSetsUpdater::downloadProgress( qint64 bytesReceived, qint64 bytesTotal
 {
     mLogger->trace( "downloadProgress: {}/{}", bytesReceived, bytesTotal );
 
+    // Progress is per request; account for data from earlier requests.
+    if( mDownloadRequestOffset > 0 )
+    {
+        bytesReceived += mDownloadRequestOffset;
+        if( bytesTotal >= 0 ) bytesTotal += mDownloadRequestOffset;
+    }
+
     if( mUpdateProgressDialog )
     {
         if( bytesTotal < 0 )
@@ -489,38 +749,42 @@ MtgJsonAllSetsUpdater::downloadFinished()
     // the deleteLater() function.
     QScopedPointer<QNetworkReply, QScopedPointerDeleteLater> replyScopedPtr( mDownloadNetworkReply );
 
-    mTmpFile->flush();
-    mTmpFile->close();
-
     // Handle cancellation during download.
     if( mDownloadAborted )
     {
         mLogger->debug( "downloadFinished: aborted" );
+        mDownloadNetworkReply = nullptr;
         finishAndReset();
         return;
     }
 
-    // Handle network error.
+    // Handle network error.  Transfers that were making progress are
+    // resumed from where they left off.
     if( mDownloadNetworkReply->error() ) {
         mLogger->debug( "downloadFinished: error: {}", mDownloadNetworkReply->errorString() );
+        mDownloadNetworkReply = nullptr;
+        if( (mDownloadOffset > mDownloadRequestOffset) && (mDownloadRetries < DOWNLOAD_RETRIES_MAX) )
+        {
+            ++mDownloadRetries;
+            mLogger->notice( "resuming download at offset {} (retry {})", mDownloadOffset, mDownloadRetries );
+            requestDownload( mDownloadUrl );
+            return;
+        }
         QMessageBox::critical( 0, tr("Error"),
-                tr("Download error: %1").arg( mDownloadNetworkReply->errorString() ) );
+                tr("Download error: %1").arg( replyScopedPtr->errorString() ) );
         finishAndReset();
         return;
     }
 
-    // Handle network redirect.
+    // Handle network redirect.  Nothing from the redirect reply was
+    // passed along, so the transfer continues as it was.
     QVariant redirectionTarget = mDownloadNetworkReply->attribute( QNetworkRequest::RedirectionTargetAttribute );
     if( !redirectionTarget.isNull() )
     {
         QUrl newUrl = mDownloadNetworkReply->url().resolved( redirectionTarget.toUrl() );
         mLogger->debug( "replyFinished: redirecting to : {}", newUrl.toString() );
-
-        // Erase and re-open the file.
-        mTmpFile->resize( 0 );
-        mTmpFile->open();
-
-        startDownload( newUrl );
+        mDownloadNetworkReply = nullptr;
+        requestDownload( newUrl );
         return;
     }
 
@@ -528,38 +792,54 @@ MtgJsonAllSetsUpdater::downloadFinished()
     // a bad pointer when the actual object is deleted later by the QScopedPointer.
     mDownloadNetworkReply = nullptr;
 
+    mTmpFile->flush();
+    mTmpFile->close();
+
+    // The parser has seen all but the tail of the data by now.
+    mDownloadDone = true;
+    mParseStream->finish();
+
     // Reset dialog for new stage with "busy" look.
     mUpdateProgressDialog->setLabelText( tr("Parsing...") );
     mUpdateProgressDialog->setValue( 0 );
     mUpdateProgressDialog->setMinimum( 0 );
     mUpdateProgressDialog->setMaximum( 0 );
 
-    const std::string allSetsFilePath = mTmpFile->fileName().toStdString();
-    mLogger->debug( "parsing AllSets file at {}", allSetsFilePath );
-    mParseFile = fopen( allSetsFilePath.c_str(), "r" );
-    if( mParseFile == NULL )
+    if( mParseFuture.isFinished() )
     {
-        mLogger->warn( "failed to open AllSets file at {}", mTmpFile->fileName() );
-        QMessageBox::warning( 0, tr("Error"),
-                tr("Unable to open file %1").arg( mTmpFile->fileName() ) );
-        finishAndReset();
-        return;
+        completeUpdate();
     }
-
-    // Kick off the parsing in another thread to keep UI responsive.
-    mParseAllSetsDataPtr = new MtgJsonAllSetsData( mLoggingConfig.createChildConfig( "mtgjson" ) );
-    mParseFuture = QtConcurrent::run( mParseAllSetsDataPtr, &MtgJsonAllSetsData::parse, mParseFile );
-    mParseFutureWatcher.setFuture( mParseFuture );
 }
 
 
 void
 MtgJsonAllSetsUpdater::parsingFinished()
+{
+    mLogger->trace( "parsingFinished" );
+
+    // Ignore parses that were stopped.
+    if( !mParseAllSetsDataPtr || (mParseStream && mParseStream->isCanceled()) ) return;
+
+    if( mDownloadDone )
+    {
+        completeUpdate();
+    }
+    else if( !mParseFuture.result() )
+    {
+        // The data is bad; no sense in downloading the rest.
+        mLogger->debug( "parsing failed during download" );
+        QMessageBox::warning( 0, tr("Error"),
+                tr("Failed to parse downloaded file!") );
+        downloadCanceled();
+    }
+}
+
+
+void
+MtgJsonAllSetsUpdater::completeUpdate()
 {
     AllSetsDataSharedPtr allSetsDataSptr;
 
-    mLogger->trace( "parsingFinished" );
-    fclose( mParseFile );
     mUpdateProgressDialog->setMaximum( 1 );
     if( mParseFuture.result() )
     {
@@ -567,11 +847,11 @@ MtgJsonAllSetsUpdater::parsingFinished()
         // Set dialog to 100%.
         mUpdateProgressDialog->setValue( 1 );
         allSetsDataSptr.reset( mParseAllSetsDataPtr );
+        mParseAllSetsDataPtr = nullptr;
     }
     else
     {
         mLogger->debug( "parsing failed" );
-        delete mParseAllSetsDataPtr;
 
         QMessageBox::warning( 0, tr("Error"),
                 tr("Failed to parse downloaded file!") );
@@ -2,6 +2,8 @@
 #define MTGJSONALLSETSUPDATECHECKER_H
 
 #include "AllSetsUpdater.h"
+#include <QByteArray>
+#include <QList>
 #include <QUrl>
 #include <QFuture>
 #include <QFutureWatcher>
@@ -17,6 +19,7 @@ QT_END_NAMESPACE
 class ClientSettings;
 class MtgJsonAllSetsFileCache;
 class MtgJsonAllSetsData;
+class ChunkedReadStream;
 
 #include "clienttypes.h"
 #include "AllSetsUpdateChannel.h"
@@ -60,6 +63,9 @@ private slots:
     void downloadProgress( qint64 bytesReceived, qint64 bytesTotal );
     void downloadFinished();
 
+    void deltaDownloadFinished();
+    void deltaApplyFinished();
+
     void parsingFinished();
 
 private:
@@ -69,6 +75,10 @@ private:
         bool    updateAvailable;
         QString updateVersion;
         QUrl    downloadUrl;
+
+        // Deltas from the current version to the update, oldest first.
+        // Empty if the full download is required.
+        QList<QUrl> deltaUrls;
     };
 
     // Returns download URL if data OK and user chooses to update
@@ -76,8 +86,16 @@ private:
 
     bool processStableChannelResponse( const rapidjson::Document& doc, UpdateInfo* updateInfo );
     bool processMtgJsonChannelResponse( const rapidjson::Document& doc, UpdateInfo* updateInfo );
-
-    void startDownload( QUrl& url );
+    void processDeltas( const rapidjson::Document& doc, UpdateInfo* updateInfo );
+
+    void startUpdate( const UpdateInfo& updateInfo );
+    void startDownload();
+    void requestNextDelta();
+    void requestDelta( const QUrl& url );
+    void requestDownload( const QUrl& url );
+    void startParse();
+    void stopParse();
+    void completeUpdate();
     void finishAndReset();
 
     ClientSettings*          mClientSettings;
@@ -102,10 +120,26 @@ private:
     QTemporaryFile*   mTmpFile;
     QNetworkReply*    mDownloadNetworkReply;
     bool              mDownloadAborted;
+    QUrl              mDownloadUrl;
+    qint64            mDownloadOffset;          // bytes received overall
+    qint64            mDownloadRequestOffset;   // offset the current request started at
+    int               mDownloadRetries;
+    bool              mDownloadDone;
+    QUrl              mFullDownloadUrl;
+
+    // Delta stage variables.  Deltas are applied to the cached file on a
+    // worker thread, then the result is parsed from the temporary file.
+    //
+    QList<QUrl>          mDeltaUrls;
+    QList<QByteArray>    mDeltas;
+    QByteArray           mDeltaResult;
+    QFuture<bool>        mDeltaFuture;
+    QFutureWatcher<bool> mDeltaFutureWatcher;
 
-    // Parse stage variables.
+    // Parse stage variables.  Parsing runs alongside the download.
     //
     MtgJsonAllSetsData*  mParseAllSetsDataPtr;
+    ChunkedReadStream*   mParseStream;
     FILE*                mParseFile;
     QFuture<bool>        mParseFuture;
     QFutureWatcher<bool> mParseFutureWatcher;
@@ -0,0 +1,125 @@
+#include "PayloadCache.h"
+
+#include <QFile>
+#include <QDateTime>
+#include <QRegularExpression>
+#include "PayloadStore.h"
+
+// Payloads are room configurations and server capabilities; anything
+// unused for this long is unlikely to be seen again.
+static const int PAYLOAD_MAX_AGE_DAYS = 30;
+
+
+PayloadCache::PayloadCache( const QDir&     cacheDir,
+                            Logging::Config loggingConfig )
+  : mCacheDir( cacheDir ),
+    mLogger( loggingConfig.createLogger() )
+{
+    prune();
+}
+
+
+bool
+PayloadCache::get( const QByteArray& hash, QByteArray& payload )
+{
+    auto iter = mMemoryCache.constFind( hash );
+    if( iter != mMemoryCache.constEnd() )
+    {
+        payload = iter.value();
+        return true;
+    }
+
+    QFile file( getFilePath( hash ) );
+    if( !file.open( QIODevice::ReadOnly ) )
+    {
+        mLogger->debug( "payload {} not cached", hash.toHex().toStdString() );
+        return false;
+    }
+    QByteArray filePayload = file.readAll();
+    file.close();
+
+    if( computePayloadHash( filePayload ) != hash )
+    {
+        mLogger->warn( "cached payload {} damaged, removing", hash.toHex().toStdString() );
+        QFile::remove( getFilePath( hash ) );
+        return false;
+    }
+
+    // Keep payloads in use from being pruned.
+    touchFile( hash, filePayload );
+
+    mMemoryCache.insert( hash, filePayload );
+    payload = filePayload;
+    return true;
+}
+
+
+bool
+PayloadCache::put( const QByteArray& hash, const QByteArray& payload )
+{
+    if( computePayloadHash( payload ) != hash )
+    {
+        mLogger->warn( "payload does not match hash {}", hash.toHex().toStdString() );
+        return false;
+    }
+
+    mMemoryCache.insert( hash, payload );
+
+    QFile file( getFilePath( hash ) );
+    if( !file.open( QIODevice::WriteOnly ) || (file.write( payload ) != payload.size()) )
+    {
+        mLogger->warn( "error writing payload {} to cache", hash.toHex().toStdString() );
+        file.remove();
+    }
+    return true;
+}
+
+
+QString
+PayloadCache::getFilePath( const QByteArray& hash ) const
+{
+    return mCacheDir.filePath( QString::fromLatin1( hash.toHex() ) );
+}
+
+
+void
+PayloadCache::touchFile( const QByteArray& hash, const QByteArray& payload )
+{
+#if QT_VERSION >= 0x050A00
+    QFile file( getFilePath( hash ) );
+    if( file.open( QIODevice::ReadWrite ) &&
+        file.setFileTime( QDateTime::currentDateTime(), QFileDevice::FileModificationTime ) )
+    {
+        return;
+    }
+#endif
+
+    // Rewriting the file updates its time too.
+    QFile rewriteFile( getFilePath( hash ) );
+    if( !rewriteFile.open( QIODevice::WriteOnly ) || (rewriteFile.write( payload ) != payload.size()) )
+    {
+        mLogger->warn( "error refreshing cached payload {}", hash.toHex().toStdString() );
+        rewriteFile.remove();
+    }
+}
+
+
+void
+PayloadCache::prune()
+{
+    // Only touch files named like a payload hash in case the cache shares
+    // a directory with other files.
+    static const QRegularExpression fileNameRegex( "^[0-9a-f]{40}$" );
+
+    const QDateTime cutoff = QDateTime::currentDateTime().addDays( -PAYLOAD_MAX_AGE_DAYS );
+    const QFileInfoList fileInfoList( mCacheDir.entryInfoList( QStringList(), QDir::Files ) );
+    for( const QFileInfo& fileInfo : fileInfoList )
+    {
+        if( !fileNameRegex.match( fileInfo.fileName() ).hasMatch() ) continue;
+        if( fileInfo.lastModified() < cutoff )
+        {
+            mLogger->debug( "pruning cached payload {}", fileInfo.fileName() );
+            mCacheDir.remove( fileInfo.fileName() );
+        }
+    }
+}
@@ -0,0 +1,38 @@
+#ifndef PAYLOADCACHE_H
+#define PAYLOADCACHE_H
+
+#include <QByteArray>
+#include <QDir>
+#include <QHash>
+#include "Logging.h"
+
+// Disk cache of payloads the server sends by reference, keyed by the
+// payload hash.  Files not written or read in a while are pruned at
+// startup.
+class PayloadCache
+{
+public:
+
+    PayloadCache( const QDir&     cacheDir,
+                  Logging::Config loggingConfig = Logging::Config() );
+
+    // Returns true and fills in the payload if it is cached intact.
+    bool get( const QByteArray& hash, QByteArray& payload );
+
+    // Caches a payload.  Returns false if the payload doesn't match the
+    // hash.  If it can't be written to disk it's still held in memory
+    // for this session.
+    bool put( const QByteArray& hash, const QByteArray& payload );
+
+private:
+
+    QString getFilePath( const QByteArray& hash ) const;
+    void touchFile( const QByteArray& hash, const QByteArray& payload );
+    void prune();
+
+    QDir                            mCacheDir;
+    QHash<QByteArray,QByteArray>    mMemoryCache;
+    std::shared_ptr<spdlog::logger> mLogger;
+};
+
+#endif
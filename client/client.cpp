@@ -13,7 +13,10 @@
 #include "ClientSettings.h"
 #include "messages.pb.h"
 #include "ImageCache.h"
+#include "PayloadCache.h"
+#include "PayloadStore.h"
 #include "ImageLoaderFactory.h"
+#include "ImagePrefetcher.h"
 #include "AllSetsData.h"
 #include "CommanderPane.h"
 #include "CommanderPaneSettings.h"
@@ -25,6 +28,7 @@
 #include "DraftConfigAdapter.h"
 #include "ProtoHelper.h"
 #include "ClientProtoHelper.h"
+#include "InventoryChecksum.h"
 #include "DeckStatsLauncher.h"
 #include "WebServerInterface.h"
 #include "ClientUpdateChecker.h"
@@ -45,6 +49,9 @@ static const SimpleVersion CLIENT_PROTOVERSION( proto::PROTOCOL_VERSION_MAJOR,
 // Keep-alive timer duration.
 static const int KEEP_ALIVE_TIMER_SECS = 25;
 
+// Inventory changes made within this window are sent as one update.
+static const int INVENTORY_UPDATE_BATCH_MILLIS = 200;
+
 // Helper function for logging protocol-type cards.
 static std::ostream& operator<<( std::ostream& os, const proto::Card& card )
 {
@@ -56,6 +63,7 @@ Client::Client( ClientSettings*             settings,
                 const AllSetsDataSharedPtr& allSetsData,
                 AllSetsUpdater*             allSetsUpdater,
                 ImageCache*                 imageCache,
+                PayloadCache*               payloadCache,
                 const Logging::Config&      loggingConfig,
                 QWidget*                    parent )
 :   QMainWindow( parent ),
@@ -63,6 +71,8 @@ Client::Client( ClientSettings*             settings,
     mAllSetsData( allSetsData ),
     mAllSetsUpdater( allSetsUpdater ),
     mImageCache( imageCache ),
+    mPayloadCache( payloadCache ),
+    mStateMachine( nullptr ),
     mConnectionEstablished( false ),
     mReadySplash( nullptr ),
     mCardServerSetCodeMap( new CardServerSetCodeMap() ),
@@ -72,6 +82,12 @@ Client::Client( ClientSettings*             settings,
     mPostRoundTimerActive( false ),
     mRoomRejoined( false ),
     mAwaitingRoomStateAfterRejoin( false ),
+    mInventoryUpdateSequence( 0 ),
+    mSessionResumeValid( false ),
+    mSessionResumeRoomId( 0 ),
+    mSessionResumeToken( 0 ),
+    mSessionLastSequence( 0 ),
+    mLobbySubscribed( true ),
     mDraftedCardDestZone( CARD_ZONE_MAIN ),
     mUnsavedChanges( false ),
     mLoggingConfig( loggingConfig ),
@@ -87,7 +103,10 @@ Client::Client( ClientSettings*             settings,
         } );
 
     mImageLoaderFactory = new ImageLoaderFactory( imageCache,
-            settings->getCardImageUrlTemplate(), this );
+            settings->getCardImageUrlTemplate(),
+            mLoggingConfig.createChildConfig( "imageloaderfactory" ), this );
+    mImagePrefetcher = new ImagePrefetcher( mImageLoaderFactory,
+            mLoggingConfig.createChildConfig( "imageprefetcher" ), this );
 
     mServerViewWidget = new ServerViewWidget( mLoggingConfig.createChildConfig( "serverview" ), this );
     connect( mServerViewWidget, &ServerViewWidget::joinRoomRequest, this, &Client::handleJoinRoomRequest );
@@ -153,6 +172,12 @@ Client::Client( ClientSettings*             settings,
     mServerAlignedDraftTimer = new QTimer( this );
     connect( mServerAlignedDraftTimer, &QTimer::timeout, this, &Client::handleServerAlignedDraftTimerTimeout );
 
+    // Create inventory update batching timer.
+    mInventoryUpdateTimer = new QTimer( this );
+    mInventoryUpdateTimer->setSingleShot( true );
+    mInventoryUpdateTimer->setInterval( INVENTORY_UPDATE_BATCH_MILLIS );
+    connect( mInventoryUpdateTimer, &QTimer::timeout, this, &Client::handleInventoryUpdateTimerTimeout );
+
     QWidget* draftSidebarHolder = new QWidget();
     QVBoxLayout* draftSidebarLayout = new QVBoxLayout( draftSidebarHolder );
 
@@ -249,6 +274,8 @@ Client::Client( ClientSettings*             settings,
                     mReadySplash->hide();
                 }
             }
+
+            updateLobbySubscription();
         } );
 
     setCentralWidget( mCentralTabWidget );
@@ -418,9 +445,53 @@ Client::updateAllSetsData( const AllSetsDataSharedPtr& allSetsDataSharedPtr )
 {
     mLogger->debug( "updating AllSetsData" );
     mAllSetsData = allSetsDataSharedPtr;
+    mCreateRoomDialog->setAllSetsData( mAllSetsData );
 
     // Basic land images are conjured from allsets data, so update those.
     updateBasicLandCardDataMap();
+
+    // Cards created before now may be placeholders or reference old data,
+    // so recreate them in place.  The server's set codes are kept.
+    for( auto zone : gCardZoneTypeArray )
+    {
+        if( mCardsList[zone].isEmpty() ) continue;
+        for( CardDataSharedPtr& cardData : mCardsList[zone] )
+        {
+            cardData = createCardData( getServerSetCode( cardData ), cardData->getName() );
+        }
+        processCardListChanged( zone );
+    }
+
+    // Prefetching needs card data, so restart it if in a room.
+    if( mStateMachine && mStateMachine->configuration().contains( mStateInRoom ) && mRoomConfigAdapter )
+    {
+        mImagePrefetcher->start( mRoomConfigAdapter->getDraftConfig(), mAllSetsData );
+    }
+}
+
+
+void
+Client::handleAllSetsLoadProgress( int percent )
+{
+    statusBar()->showMessage( tr("Loading card data... %1%").arg( percent ) );
+}
+
+
+void
+Client::handleAllSetsLoaded( const AllSetsDataSharedPtr& allSetsDataSharedPtr )
+{
+    statusBar()->clearMessage();
+
+    // An update may have arrived while loading; it's newer, so keep it.
+    if( mAllSetsData )
+    {
+        mLogger->debug( "ignoring loaded AllSetsData, already updated" );
+        return;
+    }
+    if( allSetsDataSharedPtr )
+    {
+        updateAllSetsData( allSetsDataSharedPtr );
+    }
 }
 
 
@@ -552,6 +623,9 @@ Client::initStateMachine()
              {
                  mLogger->debug( "entered Connected" );
                  mConnectionEstablished = true;
+                 mDeferredServerMsgs.clear();
+                 mRequestedPayloadHash.clear();
+                 mFailedPayloadHashes.clear();
                  mConnectionStatusLabel->setText( tr("Connected") );
                  mConnectAction->setEnabled( false );
                  mDisconnectAction->setEnabled( true );
@@ -575,6 +649,7 @@ Client::initStateMachine()
 
                  // Go to the server tab.
                  mCentralTabWidget->setCurrentWidget( mServerViewWidget );
+                 updateLobbySubscription();
              });
     connect( mStateNotInRoom, &QState::entered,
              [this]
@@ -632,6 +707,14 @@ Client::initStateMachine()
                  // Stop the server-aligned timer.
                  mServerAlignedDraftTimer->stop();
 
+                 // Nothing more to prefetch for this room.
+                 mImagePrefetcher->stop();
+
+                 // Don't hold inventory changes back for the batching timer.
+                 // If the connection is gone they are kept unacknowledged
+                 // and resent if the session resumes.
+                 sendPlayerInventoryUpdateInd();
+
                  // Update the draft sidebar.
                  mDraftSidebar->addRoomLeaveMessage( mRoomConfigAdapter );
 
@@ -897,9 +980,142 @@ Client::updateBasicLandCardDataMap()
 }
 
 
+// Hash of a payload referred to by a message, or empty if none.
+static QByteArray
+getPayloadRefHash( const proto::ServerToClientMsg& msg )
+{
+    const std::string* hash = nullptr;
+    if( msg.has_room_capabilities_ind() && msg.room_capabilities_ind().has_payload_hash() )
+    {
+        hash = &msg.room_capabilities_ind().payload_hash();
+    }
+    else if( msg.has_join_room_success_rspind() && msg.join_room_success_rspind().has_room_config_hash() )
+    {
+        hash = &msg.join_room_success_rspind().room_config_hash();
+    }
+    return hash ? QByteArray( hash->data(), hash->size() ) : QByteArray();
+}
+
+
 void
 Client::handleMessageFromServer( const proto::ServerToClientMsg& msg )
 {
+    if( msg.has_payload_ind() )
+    {
+        processMessageFromServer( msg.payload_ind() );
+        return;
+    }
+
+    // Typical case - nothing waiting and nothing to resolve.
+    if( mDeferredServerMsgs.isEmpty() && getPayloadRefHash( msg ).isEmpty() )
+    {
+        dispatchMessageFromServer( msg );
+        return;
+    }
+
+    mDeferredServerMsgs.append( msg );
+    processDeferredMessagesFromServer();
+}
+
+
+void
+Client::processDeferredMessagesFromServer()
+{
+    while( !mDeferredServerMsgs.isEmpty() )
+    {
+        const QByteArray hash = getPayloadRefHash( mDeferredServerMsgs.first() );
+        if( !hash.isEmpty() && !resolvePayloadRef( mDeferredServerMsgs.first(), hash ) )
+        {
+            if( mFailedPayloadHashes.contains( hash ) )
+            {
+                mLogger->error( "payload {} unavailable, dropping message", hash.toHex().toStdString() );
+                mDeferredServerMsgs.removeFirst();
+                continue;
+            }
+
+            // Wait for the payload, requesting it if not already done.
+            if( hash != mRequestedPayloadHash )
+            {
+                mLogger->debug( "requesting payload {}", hash.toHex().toStdString() );
+                proto::ClientToServerMsg msg;
+                proto::PayloadFetchReq* req = msg.mutable_payload_fetch_req();
+                req->set_hash( hash.constData(), hash.size() );
+                mServerConn->sendProtoMsg( msg );
+                mRequestedPayloadHash = hash;
+            }
+            return;
+        }
+
+        const proto::ServerToClientMsg msg = mDeferredServerMsgs.takeFirst();
+        dispatchMessageFromServer( msg );
+    }
+}
+
+
+bool
+Client::resolvePayloadRef( proto::ServerToClientMsg& msg, const QByteArray& hash )
+{
+    QByteArray payload;
+    if( !mPayloadCache->get( hash, payload ) ) return false;
+
+    bool parsed = false;
+    if( msg.has_room_capabilities_ind() )
+    {
+        // Parsing replaces the reference with the full message.
+        parsed = msg.mutable_room_capabilities_ind()->ParseFromArray( payload.constData(), payload.size() );
+    }
+    else if( msg.has_join_room_success_rspind() )
+    {
+        proto::JoinRoomSuccessRspInd* rspInd = msg.mutable_join_room_success_rspind();
+        parsed = rspInd->mutable_room_config()->ParseFromArray( payload.constData(), payload.size() );
+        rspInd->clear_room_config_hash();
+    }
+
+    if( !parsed )
+    {
+        mLogger->warn( "failed to parse payload {}", hash.toHex().toStdString() );
+        mFailedPayloadHashes.insert( hash );
+        return false;
+    }
+    return true;
+}
+
+
+void
+Client::processMessageFromServer( const proto::PayloadInd& ind )
+{
+    const QByteArray hash( ind.hash().data(), ind.hash().size() );
+    mLogger->debug( "PayloadInd: hash={} size={}", hash.toHex().toStdString(), ind.payload().size() );
+
+    if( hash == mRequestedPayloadHash )
+    {
+        mRequestedPayloadHash.clear();
+    }
+
+    bool stored = false;
+    if( ind.has_payload() )
+    {
+        const QByteArray payload( ind.payload().data(), ind.payload().size() );
+        stored = mPayloadCache->put( hash, payload );
+    }
+    if( !stored )
+    {
+        mFailedPayloadHashes.insert( hash );
+    }
+
+    processDeferredMessagesFromServer();
+}
+
+
+void
+Client::dispatchMessageFromServer( const proto::ServerToClientMsg& msg )
+{
+    // Track the last room message received for session resume.
+    if( msg.has_session_sequence() )
+    {
+        mSessionLastSequence = msg.session_sequence();
+    }
+
     if( msg.has_greeting_ind() )
     {
         const proto::GreetingInd& ind = msg.greeting_ind();
@@ -944,6 +1160,18 @@ Client::handleMessageFromServer( const proto::ServerToClientMsg& msg )
         req->set_protocol_version_major( proto::PROTOCOL_VERSION_MAJOR );
         req->set_protocol_version_minor( proto::PROTOCOL_VERSION_MINOR );
         req->set_client_version( gClientVersion );
+        req->set_payload_refs_supported( true );
+        req->set_stream_compression_version( NET_STREAM_COMPRESSION_VERSION );
+        req->set_chat_batching_supported( true );
+        if( mSessionResumeValid )
+        {
+            mLogger->debug( "requesting session resume, room={} seq={}",
+                    mSessionResumeRoomId, mSessionLastSequence );
+            proto::SessionResume* sessionResume = req->mutable_session_resume();
+            sessionResume->set_room_id( mSessionResumeRoomId );
+            sessionResume->set_resume_token( mSessionResumeToken );
+            sessionResume->set_last_sequence( mSessionLastSequence );
+        }
         mServerConn->sendProtoMsg( msg );
     }
     else if( msg.has_announcements_ind() )
@@ -974,25 +1202,16 @@ Client::handleMessageFromServer( const proto::ServerToClientMsg& msg )
     }
     else if( msg.has_chat_message_delivery_ind() )
     {
-        const proto::ChatMessageDeliveryInd& ind = msg.chat_message_delivery_ind();
-        mLogger->debug( "ChatMessageDeliveryInd: sender={}, scope={}, message={}",
-                ind.sender(), ind.scope(), ind.text() );
-
-        if( ind.scope() == proto::CHAT_SCOPE_ALL )
-        {
-            mServerViewWidget->addChatMessage( QString::fromStdString( ind.sender() ),
-                    QString::fromStdString( ind.text() ) );
-        }
-        else if( ind.scope() == proto::CHAT_SCOPE_ROOM )
-        {
-            mDraftSidebar->addChatMessage( QString::fromStdString( ind.sender() ),
-                    QString::fromStdString( ind.text() ) );
-        }
-        else
+        processMessageFromServer( msg.chat_message_delivery_ind() );
+    }
+    else if( msg.has_chat_message_batch_ind() )
+    {
+        const proto::ChatMessageBatchInd& ind = msg.chat_message_batch_ind();
+        mLogger->debug( "ChatMessageBatchInd: deliveries={}", ind.deliveries_size() );
+        for( const proto::ChatMessageDeliveryInd& deliveryInd : ind.deliveries() )
         {
-            mLogger->warn( "chat scope {} not currently supported", ind.scope() );
+            processMessageFromServer( deliveryInd );
         }
-
     }
     else if( msg.has_room_capabilities_ind() )
     {
@@ -1001,8 +1220,10 @@ Client::handleMessageFromServer( const proto::ServerToClientMsg& msg )
     else if( msg.has_rooms_info_ind() )
     {
         const proto::RoomsInfoInd& ind = msg.rooms_info_ind();
-        mLogger->debug( "RoomsInfoInd: addedRooms={}, deletedRooms={}, playerCounts={}",
-                ind.added_rooms_size(), ind.removed_rooms_size(), ind.player_counts_size() );
+        mLogger->debug( "RoomsInfoInd: addedRooms={}, deletedRooms={}, playerCounts={}, baseline={}",
+                ind.added_rooms_size(), ind.removed_rooms_size(), ind.player_counts_size(), ind.baseline() );
+
+        if( ind.baseline() ) mServerViewWidget->clearRooms();
 
         // Add any rooms in the message.
         for( int i = 0; i < ind.added_rooms_size(); ++i )
@@ -1032,8 +1253,10 @@ Client::handleMessageFromServer( const proto::ServerToClientMsg& msg )
     else if( msg.has_users_info_ind() )
     {
         const proto::UsersInfoInd& ind = msg.users_info_ind();
-        mLogger->debug( "UsersInfoInd: addedUsers={}, deletedUsers={}",
-                ind.added_users_size(), ind.removed_users_size() );
+        mLogger->debug( "UsersInfoInd: addedUsers={}, deletedUsers={}, baseline={}",
+                ind.added_users_size(), ind.removed_users_size(), ind.baseline() );
+
+        if( ind.baseline() ) mServerViewWidget->clearUsers();
 
         // Add any users in the message.
         for( int i = 0; i < ind.added_users_size(); ++i )
@@ -1101,6 +1324,16 @@ Client::handleMessageFromServer( const proto::ServerToClientMsg& msg )
     {
         processMessageFromServer( msg.player_inventory_ind() );
     }
+    else if( msg.has_player_inventory_update_ack_ind() )
+    {
+        const proto::PlayerInventoryUpdateAckInd& ind = msg.player_inventory_update_ack_ind();
+        mLogger->trace( "PlayerInventoryUpdateAckInd: seq={}", ind.sequence() );
+        while( !mUnackedInventoryUpdates.isEmpty() &&
+               (mUnackedInventoryUpdates.first().sequence() <= ind.sequence()) )
+        {
+            mUnackedInventoryUpdates.removeFirst();
+        }
+    }
     else if( msg.has_room_occupants_info_ind() )
     {
         const proto::RoomOccupantsInfoInd& ind = msg.room_occupants_info_ind();
@@ -1143,6 +1376,19 @@ Client::handleMessageFromServer( const proto::ServerToClientMsg& msg )
     {
         processMessageFromServer( msg.room_stage_ind() );
     }
+    else if( msg.has_room_error_ind() )
+    {
+        mLogger->warn( "RoomErrorInd received" );
+        if( mStateMachine->configuration().contains( mStateInRoom ) )
+        {
+            // The room is gone, nothing to resume.
+            mSessionResumeValid = false;
+            emit eventDepartedRoom();
+
+            QMessageBox::warning( this, tr("Room Closed"),
+                    tr("The room was closed by the server.") );
+        }
+    }
     else if( msg.has_player_current_pack_ind() )
     {
         const proto::PlayerCurrentPackInd& ind = msg.player_current_pack_ind();
@@ -1159,6 +1405,9 @@ Client::handleMessageFromServer( const proto::ServerToClientMsg& msg )
         }
         processCardListChanged( CARD_ZONE_BOOSTER_DRAFT );
 
+        // Hold off prefetching while the user picks from this pack.
+        mImagePrefetcher->setPaused( ind.cards_size() > 0 );
+
         if( mSettings->getBeepOnNewPack() )
         {
             mLogger->debug( "beeping on new pack" );
@@ -1223,6 +1472,48 @@ Client::handleMessageFromServer( const proto::ServerToClientMsg& msg )
 }
 
 
+void
+Client::processMessageFromServer( const proto::ChatMessageDeliveryInd& ind )
+{
+    mLogger->debug( "ChatMessageDeliveryInd: sender={}, scope={}, message={}",
+            ind.sender(), ind.scope(), ind.text() );
+
+    if( ind.scope() == proto::CHAT_SCOPE_ALL )
+    {
+        mServerViewWidget->addChatMessage( QString::fromStdString( ind.sender() ),
+                QString::fromStdString( ind.text() ) );
+    }
+    else if( ind.scope() == proto::CHAT_SCOPE_ROOM )
+    {
+        mDraftSidebar->addChatMessage( QString::fromStdString( ind.sender() ),
+                QString::fromStdString( ind.text() ) );
+    }
+    else
+    {
+        mLogger->warn( "chat scope {} not currently supported", ind.scope() );
+    }
+}
+
+
+void
+Client::updateLobbySubscription()
+{
+    if( !mStateMachine->configuration().contains( mStateLoggedIn ) ) return;
+
+    const bool subscribe = (mCentralTabWidget->currentWidget() == mServerViewWidget);
+    if( subscribe == mLobbySubscribed ) return;
+    mLobbySubscribed = subscribe;
+
+    // Resubscribing brings a fresh baseline for the lists.
+    mLogger->debug( "Sending LobbySubscriptionInd, subscribe={}", subscribe );
+    proto::ClientToServerMsg msg;
+    proto::LobbySubscriptionInd* ind = msg.mutable_lobby_subscription_ind();
+    ind->set_rooms( subscribe ? proto::LobbySubscriptionInd::ROOMS_ALL : proto::LobbySubscriptionInd::ROOMS_NONE );
+    ind->set_users( subscribe ? proto::LobbySubscriptionInd::USERS_ALL : proto::LobbySubscriptionInd::USERS_NONE );
+    mServerConn->sendProtoMsg( msg );
+}
+
+
 void
 Client::processMessageFromServer( const proto::LoginRsp& rsp )
 {
@@ -1231,6 +1522,15 @@ Client::processMessageFromServer( const proto::LoginRsp& rsp )
     // Check success/fail and take appropriate action.
     if( rsp.result() == proto::LoginRsp::RESULT_SUCCESS )
     {
+        // Everything after the response is stream-compressed if the
+        // server accepted it.
+        if( rsp.stream_compression_version() == NET_STREAM_COMPRESSION_VERSION )
+        {
+            mLogger->debug( "using stream compression version {}", rsp.stream_compression_version() );
+            mServerConn->enableRxStreamCompression();
+            mServerConn->enableTxStreamCompression();
+        }
+
         // Save successful connection information to settings and update dialog.
         const QString server = mConnectDialog->getServer();
         mSettings->addConnectUserServer( server );
@@ -1238,6 +1538,9 @@ Client::processMessageFromServer( const proto::LoginRsp& rsp )
         mSettings->setConnectLastGoodUsername( mConnectDialog->getUsername() );
         mConnectDialog->addKnownServer( server );
 
+        // The server starts out sending all lobby information.
+        mLobbySubscribed = true;
+
         // Trigger machine state transition.
         emit eventLoggedIn();
     }
@@ -1297,15 +1600,40 @@ Client::processMessageFromServer( const proto::RoomCapabilitiesInd& ind )
 void
 Client::processMessageFromServer( const proto::JoinRoomSuccessRspInd& rspInd )
 {
-    mLogger->debug( "JoinRoomSuccessRspInd: roomId={} rejoin={} chairIdx={}", rspInd.room_id(), rspInd.rejoin(), rspInd.chair_idx() );
+    mLogger->debug( "JoinRoomSuccessRspInd: roomId={} rejoin={} resumed={} chairIdx={}",
+            rspInd.room_id(), rspInd.rejoin(), rspInd.resumed(), rspInd.chair_idx() );
 
-    // Clear out all zones when joining a room.
+    // Clear out all zones when joining a room.  A resumed session keeps
+    // its inventory; the server replays only what was missed.
     for( auto zone : gCardZoneTypeArray )
     {
+        if( rspInd.resumed() && (zone != CARD_ZONE_BOOSTER_DRAFT) && (zone != CARD_ZONE_GRID_DRAFT) )
+        {
+            continue;
+        }
         mCardsList[zone].clear();
         processCardListChanged( zone );
     }
 
+    mSessionResumeValid = rspInd.has_resume_token();
+    mSessionResumeRoomId = rspInd.room_id();
+    mSessionResumeToken = rspInd.resume_token();
+    if( !rspInd.resumed() )
+    {
+        mSessionLastSequence = 0;
+    }
+
+    // Inventory updates are sequenced per room join.  A resumed session
+    // continues the sequence and resends what the server may have missed.
+    if( rspInd.resumed() )
+    {
+        resendUnackedPlayerInventoryUpdates();
+    }
+    else
+    {
+        resetPlayerInventoryUpdates();
+    }
+
     mChairIndex = rspInd.chair_idx();
     mRoomRejoined = rspInd.rejoin();
     mAwaitingRoomStateAfterRejoin = rspInd.rejoin();
@@ -1315,6 +1643,10 @@ Client::processMessageFromServer( const proto::JoinRoomSuccessRspInd& rspInd )
     mRoomStateAccumulator.reset();
     mRoomStateAccumulator.setChairCount( mRoomConfigAdapter->getChairCount() );
 
+    // Start warming the image cache with the room's cards.
+    mImagePrefetcher->setPaused( false );
+    mImagePrefetcher->start( mRoomConfigAdapter->getDraftConfig(), mAllSetsData );
+
     // Trigger state machine update.
     emit eventJoinedRoom();
 }
@@ -1325,6 +1657,17 @@ Client::processMessageFromServer( const proto::PlayerInventoryInd& ind )
 {
     mLogger->debug( "PlayerInventoryInd" );
 
+    // The server's inventory replaces ours, so any changes not yet sent
+    // were made against stale state.
+    if( mPendingInventoryUpdate.drafted_card_moves_size() > 0 ||
+        mPendingInventoryUpdate.basic_land_adjustments_size() > 0 )
+    {
+        mLogger->notice( "discarding unsent inventory changes" );
+    }
+    mPendingInventoryUpdate.Clear();
+    mInventoryUpdateTimer->stop();
+    mUnackedInventoryUpdates.clear();
+
     // Iterate over each zone, processing differences between what is
     // currently in place and the final result in order to reduce load
     // of creating and loading new card data objects.
@@ -1436,6 +1779,19 @@ Client::processMessageFromServer( const proto::PublicStateInd& ind )
     mCardsList[CARD_ZONE_GRID_DRAFT].clear();
     QMap<CardDataSharedPtr,SelectedCardData> selectedCards;
     static QSet<int> selectedIndices;
+
+    // Lay the grid out as configured for this round.
+    if( mRoomConfigAdapter )
+    {
+        DraftConfigAdapter draftConfigAdapter( mRoomConfigAdapter->getDraftConfig() );
+        const int rows = draftConfigAdapter.getGridRoundRowCount( mCurrentRound );
+        const int cols = draftConfigAdapter.getGridRoundColCount( mCurrentRound );
+        if( (rows > 0) && (cols > 0) )
+        {
+            mLeftCommanderPane->setGridDimensions( rows, cols );
+            mRightCommanderPane->setGridDimensions( rows, cols );
+        }
+    }
     for( int i = 0; i < ind.card_states_size(); ++i )
     {
         const proto::PublicStateInd::CardState& state = ind.card_states( i );
@@ -1779,6 +2135,9 @@ Client::processCardSelected( const proto::Card& card, bool autoSelected )
     mCardsList[CARD_ZONE_GRID_DRAFT].clear();
     processCardListChanged( CARD_ZONE_GRID_DRAFT );
 
+    // Picking is done until the next pack arrives; resume prefetching.
+    mImagePrefetcher->setPaused( false );
+
     // Create new card data for the indicated card and add to the
     // destination zone.  Often the card data has already been created
     // and could be reused from the draft card list, but not always.
@@ -1789,7 +2148,7 @@ Client::processCardSelected( const proto::Card& card, bool autoSelected )
 
     mUnsavedChanges = true;
 
-    processCardListChanged( destZone );
+    processCardAdded( destZone, cardDataSharedPtr );
 }
 
 
@@ -1801,6 +2160,22 @@ Client::processCardListChanged( const CardZoneType& cardZone )
 }
 
 
+void
+Client::processCardAdded( const CardZoneType& cardZone, const CardDataSharedPtr& cardData )
+{
+    mLeftCommanderPane->addCard( cardZone, cardData );
+    mRightCommanderPane->addCard( cardZone, cardData );
+}
+
+
+void
+Client::processCardRemoved( const CardZoneType& cardZone, const CardDataSharedPtr& cardData )
+{
+    mLeftCommanderPane->removeCard( cardZone, cardData );
+    mRightCommanderPane->removeCard( cardZone, cardData );
+}
+
+
 void
 Client::processCardZoneMoveRequest( const CardDataSharedPtr& cardData, const CardZoneType& srcCardZone, const CardZoneType& destCardZone )
 {
@@ -1835,16 +2210,6 @@ Client::processCardZoneMoveRequest( const CardDataSharedPtr& cardData, const Car
         return;
     }
 
-    // Send an inventory update message to server.
-    if( mServerConn->state() == QTcpSocket::ConnectedState )
-    {
-        mLogger->trace( "sendPlayerInventoryUpdateInd" );
-        proto::ClientToServerMsg msg;
-        proto::PlayerInventoryUpdateInd* ind = msg.mutable_player_inventory_update_ind();
-        addPlayerInventoryUpdateDraftedCardMove( ind, cardData, srcCardZone, destCardZone );
-        mServerConn->sendProtoMsg( msg );
-    }
-
     // Remove from source if it exists.  If this handler was called by a
     // lingering popup menu, it's possible (but unlikely) that the source
     // item has changed and isn't there anymore.
@@ -1855,13 +2220,16 @@ Client::processCardZoneMoveRequest( const CardDataSharedPtr& cardData, const Car
         return;
     }
 
+    // Queue an inventory update for the server.
+    addPlayerInventoryUpdateDraftedCardMove( cardData, srcCardZone, destCardZone );
+
     mCardsList[destCardZone].push_back( cardData );
 
     mUnsavedChanges = true;
 
     // Update changes to local card lists.
-    processCardListChanged( srcCardZone );
-    processCardListChanged( destCardZone );
+    processCardRemoved( srcCardZone, cardData );
+    processCardAdded( destCardZone, cardData );
 }
 
 
@@ -1886,17 +2254,10 @@ Client::handleCardZoneMoveAllRequest( const CardZoneType& srcCardZone, const Car
     if( srcCardZone == CARD_ZONE_GRID_DRAFT ) return;
     if( destCardZone == CARD_ZONE_GRID_DRAFT ) return;
 
-    // Send an inventory update message to server.
-    if( mServerConn->state() == QTcpSocket::ConnectedState )
+    // Queue inventory updates for the server.
+    for( auto cardData : mCardsList[srcCardZone] )
     {
-        mLogger->trace( "sendPlayerInventoryUpdateInd" );
-        proto::ClientToServerMsg msg;
-        proto::PlayerInventoryUpdateInd* ind = msg.mutable_player_inventory_update_ind();
-        for( auto cardData : mCardsList[srcCardZone] )
-        {
-            addPlayerInventoryUpdateDraftedCardMove( ind, cardData, srcCardZone, destCardZone );
-        }
-        mServerConn->sendProtoMsg( msg );
+        addPlayerInventoryUpdateDraftedCardMove( cardData, srcCardZone, destCardZone );
     }
 
     // Put all source cards onto dest list, then clear source list.
@@ -1978,28 +2339,15 @@ Client::handleBasicLandQuantitiesUpdate( const CardZoneType& cardZone, const Bas
     mLogger->debug( "handleBasicLandQuantitiesUpdate: zone={} totalqty={}",
             cardZone, qtys.getTotalQuantity() );
 
-    // Send an inventory update message to server.
-    // OPTIMIZATION - every time the user clicks a land button one of
-    // these small messages goes out.  These could be bundled and sent
-    // as a single message after a certain amount of time expires.
-    if( mServerConn->state() == QTcpSocket::ConnectedState )
+    // Queue inventory updates for the server.  Clicks on land buttons
+    // within the batching window are summed into one adjustment.
+    for( BasicLandType basic : gBasicLandTypeArray )
     {
-        mLogger->trace( "sendPlayerInventoryUpdateInd" );
-        proto::ClientToServerMsg msg;
-        proto::PlayerInventoryUpdateInd* ind = msg.mutable_player_inventory_update_ind();
-        for( BasicLandType basic : gBasicLandTypeArray )
+        int diff = qtys.getQuantity( basic ) - mBasicLandQtysMap[cardZone].getQuantity( basic );
+        if( diff != 0 )
         {
-            int diff = qtys.getQuantity( basic ) - mBasicLandQtysMap[cardZone].getQuantity( basic );
-            if( diff != 0 )
-            {
-                mLogger->debug( "  {}: {}", stringify( basic ), diff );
-                proto::PlayerInventoryUpdateInd::BasicLandAdjustment* basicLandAdj =
-                        ind->add_basic_land_adjustments();
-                basicLandAdj->set_basic_land( convertBasicLand( basic ) );
-                basicLandAdj->set_zone( convertCardZone( cardZone ) );
-                basicLandAdj->set_adjustment( diff );
-                mServerConn->sendProtoMsg( msg );
-            }
+            mLogger->debug( "  {}: {}", stringify( basic ), diff );
+            addPlayerInventoryUpdateBasicLandAdjustment( basic, cardZone, diff );
         }
     }
 
@@ -2267,12 +2615,18 @@ Client::handleRoomLeave()
                                    QMessageBox::No );
         if( result == QMessageBox::Yes )
         {
+            // Inventory changes still batching belong to this room.
+            sendPlayerInventoryUpdateInd();
+
             mLogger->debug( "Sending RoomDepartInd" );
             proto::ClientToServerMsg msg;
             proto::DepartRoomInd* ind = msg.mutable_depart_room_ind();
             Q_UNUSED( ind );
             mServerConn->sendProtoMsg( msg );
 
+            // Leaving on purpose, nothing to resume.
+            mSessionResumeValid = false;
+
             // Trigger state machine update
             emit eventDepartedRoom();
         }
@@ -2351,21 +2705,188 @@ Client::handleServerAlignedDraftTimerTimeout()
 
 
 void
-Client::addPlayerInventoryUpdateDraftedCardMove( proto::PlayerInventoryUpdateInd* ind,
-                                                 const CardDataSharedPtr&         cardData,
-                                                 const CardZoneType&              srcCardZone,
-                                                 const CardZoneType&              destCardZone )
+Client::addPlayerInventoryUpdateDraftedCardMove( const CardDataSharedPtr& cardData,
+                                                 const CardZoneType&      srcCardZone,
+                                                 const CardZoneType&      destCardZone )
 {
-    proto::PlayerInventoryUpdateInd::DraftedCardMove* move =
-            ind->add_drafted_card_moves();
-
     // Init card data.  Set code must be what the server originally sent.
+    const std::string name = cardData->getName();
+    const std::string setCode = getServerSetCode( cardData );
+    const proto::Zone zoneFrom = convertCardZone( srcCardZone );
+    const proto::Zone zoneTo = convertCardZone( destCardZone );
+
+    // If an unsent move brought this card into the source zone, extend
+    // that move instead; a card moved back and forth cancels out.
+    auto* moves = mPendingInventoryUpdate.mutable_drafted_card_moves();
+    for( int i = moves->size() - 1; i >= 0; --i )
+    {
+        proto::PlayerInventoryUpdateInd::DraftedCardMove* move = moves->Mutable( i );
+        if( (move->zone_to() == zoneFrom) &&
+            (move->card().name() == name) && (move->card().set_code() == setCode) )
+        {
+            if( move->zone_from() == zoneTo )
+            {
+                moves->DeleteSubrange( i, 1 );
+            }
+            else
+            {
+                move->set_zone_to( zoneTo );
+            }
+            mInventoryUpdateTimer->start();
+            return;
+        }
+    }
+
+    proto::PlayerInventoryUpdateInd::DraftedCardMove* move = moves->Add();
     proto::Card* card = move->mutable_card();
-    card->set_name( cardData->getName() );
-    card->set_set_code( mCardServerSetCodeMap->contains( cardData.get() ) ? mCardServerSetCodeMap->value( cardData.get() )
-                                                                          : cardData->getSetCode() );
-    move->set_zone_from( convertCardZone( srcCardZone ) );
-    move->set_zone_to( convertCardZone( destCardZone ) );
+    card->set_name( name );
+    card->set_set_code( setCode );
+    move->set_zone_from( zoneFrom );
+    move->set_zone_to( zoneTo );
+    mInventoryUpdateTimer->start();
+}
+
+
+void
+Client::addPlayerInventoryUpdateBasicLandAdjustment( BasicLandType       basic,
+                                                     const CardZoneType& cardZone,
+                                                     int                 adjustment )
+{
+    const proto::BasicLand protoBasic = convertBasicLand( basic );
+    const proto::Zone zone = convertCardZone( cardZone );
+
+    auto* adjs = mPendingInventoryUpdate.mutable_basic_land_adjustments();
+    proto::PlayerInventoryUpdateInd::BasicLandAdjustment* basicLandAdj = nullptr;
+    for( auto& adj : *adjs )
+    {
+        if( (adj.basic_land() == protoBasic) && (adj.zone() == zone) )
+        {
+            basicLandAdj = &adj;
+            break;
+        }
+    }
+    if( basicLandAdj == nullptr )
+    {
+        basicLandAdj = adjs->Add();
+        basicLandAdj->set_basic_land( protoBasic );
+        basicLandAdj->set_zone( zone );
+        basicLandAdj->set_adjustment( 0 );
+    }
+    basicLandAdj->set_adjustment( basicLandAdj->adjustment() + adjustment );
+    mInventoryUpdateTimer->start();
+}
+
+
+void
+Client::handleInventoryUpdateTimerTimeout()
+{
+    sendPlayerInventoryUpdateInd();
+}
+
+
+void
+Client::sendPlayerInventoryUpdateInd()
+{
+    mInventoryUpdateTimer->stop();
+
+    // Drop basic land adjustments that netted out to nothing.
+    auto* adjs = mPendingInventoryUpdate.mutable_basic_land_adjustments();
+    for( int i = adjs->size() - 1; i >= 0; --i )
+    {
+        if( adjs->Get( i ).adjustment() == 0 )
+        {
+            adjs->DeleteSubrange( i, 1 );
+        }
+    }
+
+    if( (mPendingInventoryUpdate.drafted_card_moves_size() == 0) &&
+        (mPendingInventoryUpdate.basic_land_adjustments_size() == 0) )
+    {
+        return;
+    }
+
+    proto::PlayerInventoryUpdateInd ind;
+    ind.Swap( &mPendingInventoryUpdate );
+    ind.set_sequence( ++mInventoryUpdateSequence );
+    ind.set_checksum( computeInventoryChecksum() );
+    mUnackedInventoryUpdates.append( ind );
+
+    if( mServerConn->state() == QTcpSocket::ConnectedState )
+    {
+        proto::ClientToServerMsg msg;
+        *msg.mutable_player_inventory_update_ind() = ind;
+        mLogger->trace( "sendPlayerInventoryUpdateInd seq={} moves={} adjs={} (unacked {})",
+                ind.sequence(), ind.drafted_card_moves_size(),
+                ind.basic_land_adjustments_size(), mUnackedInventoryUpdates.size() );
+        mServerConn->sendProtoMsg( msg );
+    }
+    else
+    {
+        mLogger->debug( "holding inventory update seq={} until resume", ind.sequence() );
+    }
+
+    mPendingInventoryUpdate.Clear();
+}
+
+
+void
+Client::resendUnackedPlayerInventoryUpdates()
+{
+    // The server ignores any it already applied.
+    for( const proto::PlayerInventoryUpdateInd& ind : mUnackedInventoryUpdates )
+    {
+        mLogger->debug( "resending inventory update seq={}", ind.sequence() );
+        proto::ClientToServerMsg msg;
+        *msg.mutable_player_inventory_update_ind() = ind;
+        mServerConn->sendProtoMsg( msg );
+    }
+
+    // Changes made while disconnected go out right away.
+    sendPlayerInventoryUpdateInd();
+}
+
+
+void
+Client::resetPlayerInventoryUpdates()
+{
+    mInventoryUpdateTimer->stop();
+    mPendingInventoryUpdate.Clear();
+    mInventoryUpdateSequence = 0;
+    mUnackedInventoryUpdates.clear();
+}
+
+
+uint32_t
+Client::computeInventoryChecksum() const
+{
+    InventoryChecksum checksum;
+    for( proto::Zone invZone : gInventoryZoneArray )
+    {
+        const CardZoneType cardZone = convertCardZone( invZone );
+        const PlayerInventory::ZoneType zone = convertZone( invZone );
+        for( const CardDataSharedPtr& cardData : mCardsList[cardZone] )
+        {
+            checksum.addCard( zone, cardData->getName(), getServerSetCode( cardData ) );
+        }
+
+        auto qtysIter = mBasicLandQtysMap.find( cardZone );
+        if( qtysIter != mBasicLandQtysMap.end() )
+        {
+            for( BasicLandType basic : gBasicLandTypeArray )
+            {
+                checksum.addBasicLands( zone, basic, qtysIter->second.getQuantity( basic ) );
+            }
+        }
+    }
+    return checksum.getValue();
+}
+
+
+std::string
+Client::getServerSetCode( const CardDataSharedPtr& cardData ) const
+{
+    return mCardServerSetCodeMap->contains( cardData.get() ) ? mCardServerSetCodeMap->value( cardData.get() )
+                                                             : cardData->getSetCode();
 }
 
 
@@ -4,6 +4,7 @@
 #include <QMainWindow>
 #include <QAbstractSocket>
 #include <QListWidget>
+#include <QSet>
 
 QT_BEGIN_NAMESPACE
 class QTreeWidget;
@@ -25,7 +26,9 @@ class ClientToastOverlay;
 class ClientSettings;
 class AllSetsUpdater;
 class ImageCache;
+class PayloadCache;
 class ImageLoaderFactory;
+class ImagePrefetcher;
 class CommanderPane;
 class TickerWidget;
 class ServerViewWidget;
@@ -60,6 +63,7 @@ public:
             const AllSetsDataSharedPtr& allSetsData,
             AllSetsUpdater*             allSetsUpdater,
             ImageCache*                 mImageCache,
+            PayloadCache*               payloadCache,
             const Logging::Config&      loggingConfig = Logging::Config(),
             QWidget*                    parent = 0 );
 
@@ -69,6 +73,11 @@ public slots:
 
     void updateAllSetsData( const AllSetsDataSharedPtr& allSetsDataSharedPtr );
 
+    // Card data loading at startup.  Until loaded the client runs with
+    // placeholder cards; views are upgraded in place once data arrives.
+    void handleAllSetsLoadProgress( int percent );
+    void handleAllSetsLoaded( const AllSetsDataSharedPtr& allSetsDataSharedPtr );
+
 private slots:
 
     void updateBasicLandCardDataMap();
@@ -104,6 +113,7 @@ private slots:
     void handleRoomChatMessageGenerated( const QString& text );
 
     void handleServerAlignedDraftTimerTimeout();
+    void handleInventoryUpdateTimerTimeout();
 
 protected:
 
@@ -123,6 +133,11 @@ private:
     void disconnectFromServer();
 
     void processMessageFromServer( const proto::LoginRsp& rsp );
+    void processMessageFromServer( const proto::ChatMessageDeliveryInd& ind );
+
+    // Subscribe to lobby information while the server tab is showing and
+    // to nothing otherwise, e.g. while drafting.
+    void updateLobbySubscription();
     void processMessageFromServer( const proto::RoomCapabilitiesInd& ind );
     void processMessageFromServer( const proto::JoinRoomSuccessRspInd& rspInd );
     void processMessageFromServer( const proto::PlayerInventoryInd& ind );
@@ -130,15 +145,37 @@ private:
     void processMessageFromServer( const proto::BoosterDraftStateInd& ind );
     void processMessageFromServer( const proto::RoomChairsDeckInfoInd& ind );
     void processMessageFromServer( const proto::RoomStageInd& ind );
-
-    void addPlayerInventoryUpdateDraftedCardMove( proto::PlayerInventoryUpdateInd* ind,
-                                                  const CardDataSharedPtr&         cardData,
-                                                  const CardZoneType&              srcCardZone,
-                                                  const CardZoneType&              destCardZone );
+    void processMessageFromServer( const proto::PayloadInd& ind );
+
+    // Messages are held back, in order, while a payload one of them
+    // refers to is fetched from the server.
+    void dispatchMessageFromServer( const proto::ServerToClientMsg& msg );
+    void processDeferredMessagesFromServer();
+    bool resolvePayloadRef( proto::ServerToClientMsg& msg, const QByteArray& hash );
+
+    // Inventory changes are accumulated here and sent to the server as a
+    // single sequenced update when the inventory update timer expires.
+    void addPlayerInventoryUpdateDraftedCardMove( const CardDataSharedPtr& cardData,
+                                                  const CardZoneType&      srcCardZone,
+                                                  const CardZoneType&      destCardZone );
+    void addPlayerInventoryUpdateBasicLandAdjustment( BasicLandType       basic,
+                                                      const CardZoneType& cardZone,
+                                                      int                 adjustment );
+    void sendPlayerInventoryUpdateInd();
+    void resendUnackedPlayerInventoryUpdates();
+    void resetPlayerInventoryUpdates();
+
+    // Checksum over the local view of the inventory (see InventoryChecksum).
+    uint32_t computeInventoryChecksum() const;
+
+    // Set code as originally sent by the server.
+    std::string getServerSetCode( const CardDataSharedPtr& cardData ) const;
 
     void processCardSelected( const proto::Card& card, bool autoSelected );
     void processCardZoneMoveRequest( const CardDataSharedPtr& cardData, const CardZoneType& srcCardZone, const CardZoneType& destCardZone );
     void processCardListChanged( const CardZoneType& cardZone );
+    void processCardAdded( const CardZoneType& cardZone, const CardDataSharedPtr& cardData );
+    void processCardRemoved( const CardZoneType& cardZone, const CardDataSharedPtr& cardData );
 
     void clearTicker();
 
@@ -164,7 +201,9 @@ private:
     AllSetsDataSharedPtr mAllSetsData;
     AllSetsUpdater*      mAllSetsUpdater;
     ImageCache*          mImageCache;
+    PayloadCache*        mPayloadCache;
     ImageLoaderFactory*  mImageLoaderFactory;
+    ImagePrefetcher*     mImagePrefetcher;
 
     // Network connection state machine objects.
     QStateMachine* mStateMachine;
@@ -245,6 +284,30 @@ private:
     // synchronization messages.
     QTimer* mServerAlignedDraftTimer;
 
+    // Batches inventory changes made in quick succession.
+    QTimer*                         mInventoryUpdateTimer;
+    proto::PlayerInventoryUpdateInd mPendingInventoryUpdate;
+    uint32_t                        mInventoryUpdateSequence;
+
+    // Updates sent, or made while disconnected, that the server hasn't
+    // acknowledged yet, oldest first.  Resent on session resume.
+    QList<proto::PlayerInventoryUpdateInd> mUnackedInventoryUpdates;
+
+    // Messages waiting on a payload, the payload requested, and any
+    // payloads the server couldn't provide.
+    QList<proto::ServerToClientMsg> mDeferredServerMsgs;
+    QByteArray                      mRequestedPayloadHash;
+    QSet<QByteArray>                mFailedPayloadHashes;
+
+    // Session resume information for the current room.
+    bool     mSessionResumeValid;
+    uint32_t mSessionResumeRoomId;
+    uint64_t mSessionResumeToken;
+    uint32_t mSessionLastSequence;
+
+    // The server sends all lobby information until told otherwise.
+    bool     mLobbySubscribed;
+
     QString mUserName;
     QString mServerName;
     QString mServerVersion;
@@ -9,8 +9,9 @@
 #include "client.h"
 #include "ClientSettings.h"
 #include "ImageCache.h"
-#include "MtgJsonAllSetsData.h"
+#include "AllSetsLoader.h"
 #include "MtgJsonAllSetsFileCache.h"
+#include "PayloadCache.h"
 #include "MtgJsonAllSetsUpdater.h"
 #include "qtutils_core.h"
 
@@ -23,6 +24,9 @@ int main(int argc, char *argv[])
     loggingConfig.setStdoutLogging( true );
     loggingConfig.setLevel( spdlog::level::info );
 
+    // Format and write log output on a background thread.
+    loggingConfig.setAsyncLogging( 8192 );
+
     std::shared_ptr<spdlog::logger> logger = loggingConfig.createLogger();
 
     //
@@ -183,6 +187,28 @@ int main(int argc, char *argv[])
         }
     }
 
+    QString payloadCachePath = cacheDir.path() + "/payloads";
+    QDir payloadCacheDir( payloadCachePath );
+    if( !payloadCacheDir.exists() )
+    {
+        logger->info( "creating payload cache directory: {}", payloadCacheDir.path().toStdString() );
+        if( !payloadCacheDir.mkpath( "." ) )
+        {
+            // On error use a directory of our own under the temp dir; the
+            // cache prunes old files from its directory.
+            logger->warn( "error creating payload cache directory!" );
+            payloadCacheDir = QStandardPaths::writableLocation( QStandardPaths::TempLocation ) + "/thicket-payloads";
+            if( !payloadCacheDir.mkpath( "." ) )
+            {
+                logger->warn( "error creating temp payload cache directory!" );
+            }
+        }
+        else
+        {
+            logger->debug( "created payload cache directory" );
+        }
+    }
+
     //
     // Initialize client settings.
     //
@@ -193,39 +219,8 @@ int main(int argc, char *argv[])
         settings.overrideWebServiceBaseUrl( "http://localhost:53332" );
     }
 
-    //
-    // Initialize set data.  This may fail, but the client can handle
-    // having no set data so log and proceed.
-    //
-
     MtgJsonAllSetsFileCache allSetsFileCache( mtgJsonCacheDir, loggingConfig.createChildConfig( "allsetsfilecache" ) );
 
-    AllSetsDataSharedPtr allSetsDataSptr;
-
-    const std::string allSetsFilePath = allSetsFileCache.getCachedFilePath( settings.getAllSetsUpdateChannel() ).toStdString();
-    FILE* allSetsDataFile = fopen( allSetsFilePath.c_str(), "r" );
-    if( allSetsDataFile != NULL )
-    {
-        // Create the JSON set data instance.
-        MtgJsonAllSetsData* mtgJsonAllSetsDataPtr = new MtgJsonAllSetsData( loggingConfig.createChildConfig( "mtgjson" ) );
-        bool parseResult = mtgJsonAllSetsDataPtr->parse( allSetsDataFile );
-        fclose( allSetsDataFile );
-        if( parseResult )
-        {
-            allSetsDataSptr.reset( mtgJsonAllSetsDataPtr );
-        }
-        else
-        {
-            logger->warn( "failed to parse cached AllSets file at {}", allSetsFilePath );
-            delete mtgJsonAllSetsDataPtr;
-        }
-    }
-    else
-    {
-        // This may be normal, e.g. first session.
-        logger->notice( "failed to open cached AllSets file at {}", allSetsFilePath );
-    }
-
     //
     // Create other client helper objects.
     //
@@ -235,6 +230,8 @@ int main(int argc, char *argv[])
             imageCache.setMaxBytes( size );
         } );
 
+    PayloadCache payloadCache( payloadCacheDir, loggingConfig.createChildConfig( "payloadcache" ) );
+
     MtgJsonAllSetsUpdater* allSetsUpdater = new MtgJsonAllSetsUpdater(
             &settings,
             &allSetsFileCache,
@@ -244,9 +241,23 @@ int main(int argc, char *argv[])
     // Create client main window and start.
     //
 
-    Client client( &settings, allSetsDataSptr, allSetsUpdater, &imageCache, loggingConfig );
+    Client client( &settings, AllSetsDataSharedPtr(), allSetsUpdater, &imageCache, &payloadCache, loggingConfig );
     client.show();
 
+    //
+    // Load set data in the background; the client works without it in the
+    // meantime and upgrades its views when it arrives.  Loading may fail,
+    // but the client can handle having no set data so log and proceed.
+    //
+
+    AllSetsLoader allSetsLoader( loggingConfig.createChildConfig( "allsetsloader" ) );
+    QObject::connect( &allSetsLoader, &AllSetsLoader::progress, &client, &Client::handleAllSetsLoadProgress );
+    QObject::connect( &allSetsLoader, &AllSetsLoader::finished, &client, &Client::handleAllSetsLoaded );
+    if( !allSetsLoader.start( allSetsFileCache.getCachedFilePath( settings.getAllSetsUpdateChannel() ) ) )
+    {
+        client.handleAllSetsLoaded( AllSetsDataSharedPtr() );
+    }
+
     // Run the application event loop.  This blocks until the client quits.
     int returnValue = app.exec();
 
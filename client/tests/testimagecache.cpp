@@ -212,6 +212,9 @@ CATCH_TEST_CASE( "ImageCache - Cache ordering and purging", "[imagecache]" )
         CATCH_REQUIRE( imageCache.getCount() == 3 );
         CATCH_REQUIRE( imageCache.getCurrentBytes() == maxCacheSize );
 
+        CATCH_REQUIRE_FALSE( imageCache.contains( 0 ) );
+        CATCH_REQUIRE( imageCache.contains( 3 ) );
+
         CATCH_REQUIRE_FALSE( imageCache.tryReadFromCache( 0, tmpImage ) );
         CATCH_REQUIRE( imageCache.tryReadFromCache( 1, tmpImage ) );
         CATCH_REQUIRE( imageCache.tryReadFromCache( 2, tmpImage ) );
@@ -235,3 +238,36 @@ CATCH_TEST_CASE( "ImageCache - Cache ordering and purging", "[imagecache]" )
         CATCH_REQUIRE( imageCache.tryReadFromCache( 3, tmpImage ) );
     }
 }
+
+CATCH_TEST_CASE( "ImageCache - Ordering survives without clean shutdown", "[imagecache]" )
+{
+    // Create temporary directory.  This will self-delete at end of scope.
+    QTemporaryDir tempDir;
+    CATCH_REQUIRE( tempDir.isValid() );
+    QDir dir( tempDir.path() );
+
+    // Create a cache sized to fit one of each file.
+    const unsigned int maxCacheSize = TestHelper::getInstance()->getImagePNGSize( TestHelper::IMAGE_SMALL ) +
+                                      TestHelper::getInstance()->getImagePNGSize( TestHelper::IMAGE_MEDIUM ) +
+                                      TestHelper::getInstance()->getImagePNGSize( TestHelper::IMAGE_LARGE );
+
+    // Populate and reorder a cache that is never destroyed, as if the
+    // application had crashed.  Only the journal records the ordering.
+    ImageCache* crashedImageCache = new ImageCache( dir.path(), maxCacheSize, TestHelper::getInstance()->getLoggingConfig() );
+    QImage tmpImage;
+    CATCH_REQUIRE( crashedImageCache->tryWriteToCache( 0, ".png", TestHelper::getInstance()->getImagePNGByteArray( TestHelper::IMAGE_SMALL ) ) );
+    CATCH_REQUIRE( crashedImageCache->tryWriteToCache( 1, ".png", TestHelper::getInstance()->getImagePNGByteArray( TestHelper::IMAGE_MEDIUM ) ) );
+    CATCH_REQUIRE( crashedImageCache->tryWriteToCache( 2, ".png", TestHelper::getInstance()->getImagePNGByteArray( TestHelper::IMAGE_LARGE ) ) );
+    CATCH_REQUIRE( crashedImageCache->tryReadFromCache( 0, tmpImage ) );
+
+    ImageCache imageCache( dir.path(), maxCacheSize, TestHelper::getInstance()->getLoggingConfig() );
+    CATCH_REQUIRE( imageCache.getCount() == 3 );
+    CATCH_REQUIRE( imageCache.getCurrentBytes() == maxCacheSize );
+
+    // The medium image is the least recently used and should be purged.
+    CATCH_REQUIRE( imageCache.tryWriteToCache( 3, ".png", TestHelper::getInstance()->getImagePNGByteArray( TestHelper::IMAGE_SMALL ) ) );
+    CATCH_REQUIRE_FALSE( imageCache.tryReadFromCache( 1, tmpImage ) );
+    CATCH_REQUIRE( imageCache.tryReadFromCache( 0, tmpImage ) );
+    CATCH_REQUIRE( imageCache.tryReadFromCache( 2, tmpImage ) );
+    CATCH_REQUIRE( imageCache.tryReadFromCache( 3, tmpImage ) );
+}
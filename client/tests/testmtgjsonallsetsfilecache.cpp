@@ -0,0 +1,98 @@
+#include "catch.hpp"
+#include "MtgJsonAllSetsFileCache.h"
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QTemporaryDir>
+#include <QFile>
+
+// Build a delta that copies part of the base and appends literal data.
+static QByteArray
+makeDelta( const QByteArray& base, int copyLength, const QByteArray& data, const QByteArray& result,
+           quint64 copyOffset = 0 )
+{
+    QByteArray delta;
+    QDataStream out( &delta, QIODevice::WriteOnly );
+    out.writeRawData( "TDL1", 4 );
+    const QByteArray baseHash = QCryptographicHash::hash( base, QCryptographicHash::Sha256 );
+    const QByteArray resultHash = QCryptographicHash::hash( result, QCryptographicHash::Sha256 );
+    out.writeRawData( baseHash.constData(), baseHash.size() );
+    out.writeRawData( resultHash.constData(), resultHash.size() );
+    out << static_cast<quint64>( result.size() );
+    out << static_cast<quint8>( 1 ) << copyOffset << static_cast<quint32>( copyLength );
+    out << static_cast<quint8>( 2 ) << static_cast<quint32>( data.size() );
+    out.writeRawData( data.constData(), data.size() );
+    out << static_cast<quint8>( 0 );
+    return delta;
+}
+
+CATCH_TEST_CASE( "MtgJsonAllSetsFileCache deltas", "[mtgjsonallsetsfilecache]" )
+{
+    QTemporaryDir tempDir;
+    CATCH_REQUIRE( tempDir.isValid() );
+    QDir dir( tempDir.path() );
+
+    const AllSetsUpdateChannel::ChannelType channel = AllSetsUpdateChannel::CHANNEL_STABLE;
+    const QByteArray v1( "{\"AAA\":{\"name\":\"Alpha\"}}" );
+    const QByteArray v2( "{\"AAA\":{\"name\":\"Alpha\"},\"BBB\":{\"name\":\"Beta\"}}" );
+    const QByteArray v3( "{\"AAA\":{\"name\":\"Alpha\"},\"BBB\":{\"name\":\"Beta\"},\"CCC\":{}}" );
+
+    MtgJsonAllSetsFileCache cache( dir );
+    {
+        QFile file( dir.filePath( "v1.json" ) );
+        CATCH_REQUIRE( file.open( QIODevice::WriteOnly ) );
+        file.write( v1 );
+    }
+    CATCH_REQUIRE( cache.commit( channel, dir.filePath( "v1.json" ), "1.0.0" ) );
+
+    const QByteArray delta12 = makeDelta( v1, v1.size() - 1, v2.mid( v1.size() - 1 ), v2 );
+    const QByteArray delta23 = makeDelta( v2, v2.size() - 1, v3.mid( v2.size() - 1 ), v3 );
+    QByteArray result;
+
+    CATCH_SECTION( "Single delta" )
+    {
+        CATCH_REQUIRE( cache.applyDeltas( channel, QList<QByteArray>() << delta12, &result ) );
+        CATCH_REQUIRE( result == v2 );
+    }
+
+    CATCH_SECTION( "Chain of deltas" )
+    {
+        CATCH_REQUIRE( cache.applyDeltas( channel, QList<QByteArray>() << delta12 << delta23, &result ) );
+        CATCH_REQUIRE( result == v3 );
+    }
+
+    CATCH_SECTION( "Base checksum mismatch" )
+    {
+        CATCH_REQUIRE_FALSE( cache.applyDeltas( channel, QList<QByteArray>() << delta23, &result ) );
+    }
+
+    CATCH_SECTION( "Result checksum mismatch" )
+    {
+        QByteArray damaged = delta12;
+        damaged[damaged.size() - 2] = 'x';
+        CATCH_REQUIRE_FALSE( cache.applyDeltas( channel, QList<QByteArray>() << damaged, &result ) );
+    }
+
+    CATCH_SECTION( "Truncated delta" )
+    {
+        CATCH_REQUIRE_FALSE( cache.applyDeltas( channel, QList<QByteArray>() << delta12.left( 80 ), &result ) );
+    }
+
+    CATCH_SECTION( "Copy out of range" )
+    {
+        const QByteArray outOfRange = makeDelta( v1, 2, QByteArray(), v2, v1.size() - 1 );
+        CATCH_REQUIRE_FALSE( cache.applyDeltas( channel, QList<QByteArray>() << outOfRange, &result ) );
+    }
+
+    CATCH_SECTION( "Copy offset wraps around" )
+    {
+        const QByteArray wrapping = makeDelta( v1, 2, QByteArray(), v2, ~static_cast<quint64>( 0 ) );
+        CATCH_REQUIRE_FALSE( cache.applyDeltas( channel, QList<QByteArray>() << wrapping, &result ) );
+    }
+
+    CATCH_SECTION( "Chain too long" )
+    {
+        QList<QByteArray> deltas;
+        for( int i = 0; i <= MtgJsonAllSetsFileCache::DELTA_CHAIN_MAX; ++i ) deltas << delta12;
+        CATCH_REQUIRE_FALSE( cache.applyDeltas( channel, deltas, &result ) );
+    }
+}
@@ -0,0 +1,110 @@
+#include "catch.hpp"
+#include "PayloadCache.h"
+#include "PayloadStore.h"
+#include <QTemporaryDir>
+#include <QFile>
+#include <QDateTime>
+#include <QFileInfo>
+
+CATCH_TEST_CASE( "PayloadCache", "[payloadcache]" )
+{
+    QTemporaryDir tempDir;
+    CATCH_REQUIRE( tempDir.isValid() );
+    QDir dir( tempDir.path() );
+
+    const QByteArray payload( "room configuration payload" );
+    const QByteArray hash = computePayloadHash( payload );
+    QByteArray result;
+
+    CATCH_SECTION( "Miss" )
+    {
+        PayloadCache cache( dir );
+        CATCH_REQUIRE_FALSE( cache.get( hash, result ) );
+    }
+
+    CATCH_SECTION( "Hash mismatch rejected" )
+    {
+        PayloadCache cache( dir );
+        CATCH_REQUIRE_FALSE( cache.put( computePayloadHash( "other" ), payload ) );
+        CATCH_REQUIRE_FALSE( cache.get( computePayloadHash( "other" ), result ) );
+    }
+
+    CATCH_SECTION( "Persisted across instances" )
+    {
+        {
+            PayloadCache cache( dir );
+            CATCH_REQUIRE( cache.put( hash, payload ) );
+            CATCH_REQUIRE( cache.get( hash, result ) );
+            CATCH_REQUIRE( result == payload );
+        }
+
+        PayloadCache cache( dir );
+        result.clear();
+        CATCH_REQUIRE( cache.get( hash, result ) );
+        CATCH_REQUIRE( result == payload );
+    }
+
+    CATCH_SECTION( "Damaged file ignored" )
+    {
+        {
+            PayloadCache cache( dir );
+            CATCH_REQUIRE( cache.put( hash, payload ) );
+        }
+
+        QFile file( dir.filePath( QString::fromLatin1( hash.toHex() ) ) );
+        CATCH_REQUIRE( file.open( QIODevice::WriteOnly ) );
+        file.write( "garbage" );
+        file.close();
+
+        PayloadCache cache( dir );
+        CATCH_REQUIRE_FALSE( cache.get( hash, result ) );
+        CATCH_REQUIRE_FALSE( file.exists() );
+    }
+
+#if QT_VERSION >= 0x050A00
+    CATCH_SECTION( "Old payloads pruned, other files kept" )
+    {
+        {
+            PayloadCache cache( dir );
+            CATCH_REQUIRE( cache.put( hash, payload ) );
+        }
+
+        QFile otherFile( dir.filePath( "other.txt" ) );
+        CATCH_REQUIRE( otherFile.open( QIODevice::WriteOnly ) );
+        otherFile.close();
+
+        const QDateTime oldTime = QDateTime::currentDateTime().addDays( -60 );
+        QFile payloadFile( dir.filePath( QString::fromLatin1( hash.toHex() ) ) );
+        for( QFile* file : { &payloadFile, &otherFile } )
+        {
+            CATCH_REQUIRE( file->open( QIODevice::ReadWrite ) );
+            CATCH_REQUIRE( file->setFileTime( oldTime, QFileDevice::FileModificationTime ) );
+            file->close();
+        }
+
+        PayloadCache cache( dir );
+        CATCH_REQUIRE_FALSE( payloadFile.exists() );
+        CATCH_REQUIRE( otherFile.exists() );
+    }
+
+    CATCH_SECTION( "Reading refreshes age" )
+    {
+        {
+            PayloadCache cache( dir );
+            CATCH_REQUIRE( cache.put( hash, payload ) );
+        }
+
+        QFile payloadFile( dir.filePath( QString::fromLatin1( hash.toHex() ) ) );
+        CATCH_REQUIRE( payloadFile.open( QIODevice::ReadWrite ) );
+        CATCH_REQUIRE( payloadFile.setFileTime( QDateTime::currentDateTime().addDays( -20 ),
+                                                QFileDevice::FileModificationTime ) );
+        payloadFile.close();
+
+        {
+            PayloadCache cache( dir );
+            CATCH_REQUIRE( cache.get( hash, result ) );
+        }
+        CATCH_REQUIRE( QFileInfo( payloadFile ).lastModified() > QDateTime::currentDateTime().addDays( -1 ) );
+    }
+#endif
+}
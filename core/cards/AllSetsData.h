@@ -4,10 +4,26 @@
 #include "SetDataTypes.h"
 #include "CardDataTypes.h"
 #include "CardData.h"
+#include "SimpleCardData.h"
 #include <string>
 #include <vector>
 #include <map>
 
+// Outcome of resolving a card name, optionally hinted with a set code.
+struct CardNameResolution
+{
+    enum Status
+    {
+        STATUS_RESOLVED,            // found (in the hinted set, if any)
+        STATUS_RESOLVED_OTHER_SET,  // found, but not in the hinted set
+        STATUS_NOT_FOUND
+    };
+
+    Status      status;
+    std::string name;       // canonical name; empty if not found
+    std::string setCode;    // set the card was found in; empty if not found
+};
+
 class AllSetsData
 {
 public:
@@ -28,6 +44,18 @@ public:
     virtual CardData* createCardData( int multiverseId ) const = 0;
 
     virtual std::string findSetCode( const std::string& name ) const = 0;
+
+    virtual bool hasSetCode( const std::string& code ) const = 0;
+
+    // Resolve many card names in one pass; the set code of each card is a
+    // hint and may be empty.  Results are in the same order as the input.
+    virtual std::vector<CardNameResolution> resolveCardNames( const std::vector<SimpleCardData>& cards ) const = 0;
+
+    // Card names starting with a prefix, for autocomplete.
+    virtual std::vector<std::string> findCardNamesWithPrefix( const std::string& prefix, std::size_t maxCount ) const = 0;
+
+    // Card names similar to a possibly misspelled name, best first.
+    virtual std::vector<std::string> findSimilarCardNames( const std::string& name, std::size_t maxCount ) const = 0;
 };
 
 #endif  // ALLSETSDATA_H
@@ -15,11 +15,32 @@ public:
     virtual RarityType getRarity() const = 0;
     virtual bool isSplit() const = 0;
     virtual std::set<ColorType> getColors() const = 0;
-    virtual bool isMulticolor() const { return getColors().size() > 1; }
     virtual std::set<std::string> getTypes() const = 0;
     virtual size_t getHashValue() const;
+
+    // Allocation-free forms of getColors() and getTypes().  The defaults
+    // derive from the sets; implementations should return precomputed
+    // values.
+    virtual ColorMask getColorMask() const;
+    virtual TypeMask getTypeMask() const;
+
+    bool isMulticolor() const { return colorCount( getColorMask() ) > 1; }
 };
 
+inline ColorMask CardData::getColorMask() const
+{
+    ColorMask mask = 0;
+    for( ColorType color : getColors() ) mask |= colorMask( color );
+    return mask;
+}
+
+inline TypeMask CardData::getTypeMask() const
+{
+    TypeMask mask = 0;
+    for( const std::string& type : getTypes() ) mask |= CardTypeIds::getMask( type );
+    return mask;
+}
+
 inline size_t CardData::getHashValue() const
 {
     // Not perfect, but good enough.
@@ -3,6 +3,9 @@
 
 #include <string>
 #include <array>
+#include <atomic>
+#include <mutex>
+#include <cstdint>
 
 // Colors in WUBRG order.
 enum ColorType
@@ -30,6 +33,133 @@ inline std::string stringify( const ColorType& color )
     }
 }
 
+// Bitmask of ColorType values; bit N is set for the color with value N.
+typedef uint8_t ColorMask;
+
+inline ColorMask colorMask( const ColorType& color )
+{
+    return ColorMask( 1u << color );
+}
+
+inline int colorCount( ColorMask mask )
+{
+    int count = 0;
+    for( ; mask; mask &= mask - 1 ) ++count;
+    return count;
+}
+
+// Returns the first color of the mask in WUBRG order.  Mask must be nonzero.
+inline ColorType firstColor( ColorMask mask )
+{
+    int color = 0;
+    while( !(mask & 1u) ) { mask >>= 1; ++color; }
+    return static_cast<ColorType>( color );
+}
+
+// Card types ("Creature", "Land", ...) interned to small ids so type
+// queries can be answered with a bitmask rather than a set of strings.
+// The standard types are registered up front in alphabetical order, so
+// id order matches string order for them; other types are registered as
+// AllSets data is parsed.  Lookups never register, so they take no lock:
+// slots are written once and the count of used slots is published after
+// the slot is written.
+typedef uint32_t TypeMask;
+
+class CardTypeIds
+{
+public:
+
+    static const int MAX_TYPE_IDS = 32;
+
+    // Returns the id for a type name, registering it if new.  Returns -1
+    // if the id space is exhausted.
+    static int registerName( const std::string& name )
+    {
+        Table& table = getTable();
+        std::lock_guard<std::mutex> lock( table.registerMutex );
+        const int existingId = findId( table, name );
+        if( existingId >= 0 ) return existingId;
+        const int id = table.count.load( std::memory_order_relaxed );
+        if( id >= MAX_TYPE_IDS ) return -1;
+        table.names[id] = name;
+        table.count.store( id + 1, std::memory_order_release );
+        return id;
+    }
+
+    // Returns the id for a registered type name, or -1.
+    static int getId( const std::string& name )
+    {
+        return findId( getTable(), name );
+    }
+
+    static std::string getName( int id )
+    {
+        const Table& table = getTable();
+        return (id >= 0 && id < table.count.load( std::memory_order_acquire )) ? table.names[id] : std::string();
+    }
+
+    // Types that were never registered match no card, so map to no bits.
+    static TypeMask getMask( const std::string& name )
+    {
+        const int id = getId( name );
+        return (id >= 0) ? (TypeMask( 1u ) << id) : 0;
+    }
+
+private:
+
+    struct Table
+    {
+        std::mutex                             registerMutex;
+        std::array<std::string,MAX_TYPE_IDS>   names;
+        std::atomic<int>                       count;
+    };
+
+    static int findId( const Table& table, const std::string& name )
+    {
+        const int count = table.count.load( std::memory_order_acquire );
+        for( int id = 0; id < count; ++id )
+        {
+            if( table.names[id] == name ) return id;
+        }
+        return -1;
+    }
+
+    static Table& getTable()
+    {
+        static Table* sTable = createTable();
+        return *sTable;
+    }
+
+    static Table* createTable()
+    {
+        Table* table = new Table();
+        int count = 0;
+        for( const char* name : { "Artifact", "Conspiracy", "Creature", "Enchantment", "Instant",
+                                  "Land", "Phenomenon", "Plane", "Planeswalker", "Scheme",
+                                  "Sorcery", "Tribal", "Vanguard" } )
+        {
+            table->names[count++] = name;
+        }
+        table->count.store( count, std::memory_order_release );
+        return table;
+    }
+};
+
+inline int typeCount( TypeMask mask )
+{
+    int count = 0;
+    for( ; mask; mask &= mask - 1 ) ++count;
+    return count;
+}
+
+// Returns the lowest type id in the mask.  Mask must be nonzero.
+inline int firstTypeId( TypeMask mask )
+{
+    int id = 0;
+    while( !(mask & 1u) ) { mask >>= 1; ++id; }
+    return id;
+}
+
 enum RarityType
 {
     RARITY_BASIC_LAND,
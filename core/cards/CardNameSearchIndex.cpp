@@ -0,0 +1,183 @@
+#include "CardNameSearchIndex.h"
+
+#include <algorithm>
+#include <cctype>
+
+// Fuzzy matching ranks at least this many trigram candidates by edit
+// distance.  Short names share few trigrams with their misspellings, so
+// the best trigram scores alone aren't reliable.
+static const std::size_t FUZZY_CANDIDATES_MIN = 50;
+
+// Fuzzy matches may be this far from the name, per character of the name.
+static const std::size_t FUZZY_CHARS_PER_EDIT = 3;
+
+
+void
+CardNameSearchIndex::build( const std::vector<std::string>& names )
+{
+    clear();
+
+    mNames.reserve( names.size() );
+    for( const std::string& name : names )
+    {
+        std::string folded = foldName( name );
+        if( !folded.empty() ) mNames.push_back( Entry{ folded, name } );
+    }
+
+    // Stable so that the first of several names folding alike is kept.
+    std::stable_sort( mNames.begin(), mNames.end(),
+            []( const Entry& a, const Entry& b ) { return a.folded < b.folded; } );
+    mNames.erase( std::unique( mNames.begin(), mNames.end(),
+            []( const Entry& a, const Entry& b ) { return a.folded == b.folded; } ),
+            mNames.end() );
+
+    mTrigramCounts.reserve( mNames.size() );
+    for( std::size_t i = 0; i < mNames.size(); ++i )
+    {
+        const std::vector<uint32_t> trigrams = getTrigrams( mNames[i].folded );
+        for( uint32_t trigram : trigrams )
+        {
+            mTrigramPostings[trigram].push_back( static_cast<uint32_t>( i ) );
+        }
+        mTrigramCounts.push_back( static_cast<uint16_t>( std::min<std::size_t>( trigrams.size(), UINT16_MAX ) ) );
+    }
+}
+
+
+void
+CardNameSearchIndex::clear()
+{
+    mNames.clear();
+    mTrigramPostings.clear();
+    mTrigramCounts.clear();
+}
+
+
+std::vector<std::string>
+CardNameSearchIndex::findPrefixMatches( const std::string& prefix, std::size_t maxCount ) const
+{
+    std::vector<std::string> matches;
+    const std::string folded = foldName( prefix );
+    if( folded.empty() ) return matches;
+
+    auto iter = std::lower_bound( mNames.begin(), mNames.end(), folded,
+            []( const Entry& entry, const std::string& s ) { return entry.folded < s; } );
+    for( ; (iter != mNames.end()) && (matches.size() < maxCount); ++iter )
+    {
+        if( iter->folded.compare( 0, folded.size(), folded ) != 0 ) break;
+        matches.push_back( iter->name );
+    }
+    return matches;
+}
+
+
+std::vector<std::string>
+CardNameSearchIndex::findFuzzyMatches( const std::string& name, std::size_t maxCount ) const
+{
+    std::vector<std::string> matches;
+    const std::string folded = foldName( name );
+    if( folded.empty() || (maxCount == 0) ) return matches;
+
+    // Count trigrams shared with each indexed name.
+    const std::vector<uint32_t> trigrams = getTrigrams( folded );
+    std::vector<uint16_t> sharedCounts( mNames.size(), 0 );
+    std::vector<uint32_t> candidates;
+    for( uint32_t trigram : trigrams )
+    {
+        auto postingsIter = mTrigramPostings.find( trigram );
+        if( postingsIter == mTrigramPostings.end() ) continue;
+        for( uint32_t i : postingsIter->second )
+        {
+            if( sharedCounts[i]++ == 0 ) candidates.push_back( i );
+        }
+    }
+
+    // Keep the candidates with the best trigram similarity (Dice
+    // coefficient), compared by cross-multiplying to stay in integers.
+    auto similarityGreater = [&]( uint32_t a, uint32_t b ) {
+            const std::size_t lhs = sharedCounts[a] * (trigrams.size() + mTrigramCounts[b]);
+            const std::size_t rhs = sharedCounts[b] * (trigrams.size() + mTrigramCounts[a]);
+            return (lhs != rhs) ? (lhs > rhs) : (a < b);
+        };
+    const std::size_t candidateCount = std::min( candidates.size(), std::max( FUZZY_CANDIDATES_MIN, maxCount * 4 ) );
+    std::partial_sort( candidates.begin(), candidates.begin() + candidateCount, candidates.end(), similarityGreater );
+    candidates.resize( candidateCount );
+
+    // Rank the survivors by edit distance.
+    const std::size_t limit = std::max<std::size_t>( 1, folded.size() / FUZZY_CHARS_PER_EDIT );
+    std::vector<std::pair<std::size_t,uint32_t>> ranked;
+    for( uint32_t i : candidates )
+    {
+        const std::size_t distance = getEditDistance( folded, mNames[i].folded, limit );
+        if( distance <= limit ) ranked.push_back( std::make_pair( distance, i ) );
+    }
+    std::stable_sort( ranked.begin(), ranked.end(),
+            []( const std::pair<std::size_t,uint32_t>& a, const std::pair<std::size_t,uint32_t>& b ) {
+                return a.first < b.first;
+            } );
+
+    for( std::size_t i = 0; (i < ranked.size()) && (i < maxCount); ++i )
+    {
+        matches.push_back( mNames[ranked[i].second].name );
+    }
+    return matches;
+}
+
+
+std::string
+CardNameSearchIndex::foldName( const std::string& name )
+{
+    std::string folded;
+    folded.reserve( name.size() );
+    for( unsigned char c : name )
+    {
+        if( std::isalnum( c ) ) folded.push_back( static_cast<char>( std::tolower( c ) ) );
+    }
+    return folded;
+}
+
+
+std::vector<uint32_t>
+CardNameSearchIndex::getTrigrams( const std::string& folded )
+{
+    const std::string padded = "  " + folded + " ";
+    std::vector<uint32_t> trigrams;
+    trigrams.reserve( padded.size() - 2 );
+    for( std::size_t i = 0; i + 2 < padded.size(); ++i )
+    {
+        trigrams.push_back( (static_cast<uint32_t>( static_cast<unsigned char>( padded[i] ) ) << 16) |
+                            (static_cast<uint32_t>( static_cast<unsigned char>( padded[i+1] ) ) << 8) |
+                             static_cast<uint32_t>( static_cast<unsigned char>( padded[i+2] ) ) );
+    }
+    std::sort( trigrams.begin(), trigrams.end() );
+    trigrams.erase( std::unique( trigrams.begin(), trigrams.end() ), trigrams.end() );
+    return trigrams;
+}
+
+
+std::size_t
+CardNameSearchIndex::getEditDistance( const std::string& a, const std::string& b, std::size_t limit )
+{
+    // Levenshtein distance, giving up with limit+1 once it's exceeded.
+    const std::size_t lengthDiff = (a.size() > b.size()) ? (a.size() - b.size()) : (b.size() - a.size());
+    if( lengthDiff > limit ) return limit + 1;
+
+    std::vector<std::size_t> prevRow( b.size() + 1 );
+    std::vector<std::size_t> row( b.size() + 1 );
+    for( std::size_t j = 0; j <= b.size(); ++j ) prevRow[j] = j;
+
+    for( std::size_t i = 1; i <= a.size(); ++i )
+    {
+        row[0] = i;
+        std::size_t rowMin = row[0];
+        for( std::size_t j = 1; j <= b.size(); ++j )
+        {
+            const std::size_t substitution = prevRow[j-1] + ((a[i-1] == b[j-1]) ? 0 : 1);
+            row[j] = std::min( substitution, std::min( prevRow[j], row[j-1] ) + 1 );
+            rowMin = std::min( rowMin, row[j] );
+        }
+        if( rowMin > limit ) return limit + 1;
+        std::swap( row, prevRow );
+    }
+    return prevRow[b.size()];
+}
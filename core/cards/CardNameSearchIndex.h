@@ -0,0 +1,57 @@
+#ifndef CARDNAMESEARCHINDEX_H
+#define CARDNAMESEARCHINDEX_H
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Precomputed search index over a fixed list of card names for
+// autocomplete (prefix matches) and typo-tolerant lookup (fuzzy matches).
+// Matching ignores case, spaces and punctuation.  Fuzzy candidates are
+// gathered from shared trigrams, then ranked by edit distance.
+// Read-only once built, so safe to query from multiple threads.
+class CardNameSearchIndex
+{
+public:
+
+    // Replace the indexed names.  Duplicates (after folding) are dropped.
+    void build( const std::vector<std::string>& names );
+
+    void clear();
+
+    std::size_t size() const { return mNames.size(); }
+
+    // Names starting with the prefix, alphabetically, up to maxCount.
+    std::vector<std::string> findPrefixMatches( const std::string& prefix, std::size_t maxCount ) const;
+
+    // Names similar to the given name, best first, up to maxCount.  An
+    // exact match, if any, comes first.
+    std::vector<std::string> findFuzzyMatches( const std::string& name, std::size_t maxCount ) const;
+
+    // Lowercase alphanumerics only.
+    static std::string foldName( const std::string& name );
+
+private:
+
+    struct Entry
+    {
+        std::string folded;
+        std::string name;
+    };
+
+    // Trigrams of a folded name padded at the start and end, so short
+    // names and their first letters carry weight.
+    static std::vector<uint32_t> getTrigrams( const std::string& folded );
+
+    static std::size_t getEditDistance( const std::string& a, const std::string& b, std::size_t limit );
+
+    // Sorted by folded name for prefix searches.
+    std::vector<Entry> mNames;
+
+    // Trigram -> indices into mNames, ascending.
+    std::unordered_map<uint32_t,std::vector<uint32_t>> mTrigramPostings;
+    std::vector<uint16_t> mTrigramCounts;
+};
+
+#endif  // CARDNAMESEARCHINDEX_H
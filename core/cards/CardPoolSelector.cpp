@@ -93,3 +93,17 @@ CardPoolSelector::getRarityForSlot( const SlotType& slot, RarityType& rarity ) c
 
     return true;
 }
+
+
+std::size_t
+CardPoolSelector::getApproximateMemoryBytes() const
+{
+    // Map nodes carry a parent, two children and a color beyond the value.
+    const std::size_t nodeBytes = sizeof( SetRarityToCardMap::value_type ) + 4 * sizeof( void* );
+    std::size_t bytes = sizeof( *this );
+    for( const SetRarityToCardMap* pool : { &mCardPool, &mCardsRemovedFromPool } )
+    {
+        for( const auto& item : *pool ) bytes += nodeBytes + item.second.capacity();
+    }
+    return bytes;
+}
@@ -32,6 +32,9 @@ public:
 
     int getPoolSize() { return mCardPool.size(); }
 
+    // Approximate memory held by the pool, including removed cards.
+    std::size_t getApproximateMemoryBytes() const;
+
 private:
 
     bool getRarityForSlot( const SlotType& slot, RarityType& rarity ) const;
@@ -0,0 +1,64 @@
+#ifndef INVENTORYCHECKSUM_H
+#define INVENTORYCHECKSUM_H
+
+#include <string>
+#include <cstdint>
+#include "BasicLand.h"
+
+// Order-independent checksum over the contents of a player inventory.
+// Client and server each compute it over their own view so that drift
+// can be detected without exchanging the whole inventory.  The per-item
+// hash is fixed (FNV-1a) so both sides agree regardless of platform.
+class InventoryChecksum
+{
+public:
+
+    InventoryChecksum() : mValue( 0 ) {}
+
+    // Zones are identified by PlayerInventory::ZoneType values.
+    void addCard( int zone, const std::string& name, const std::string& setCode )
+    {
+        uint32_t h = hashBytes( FNV_OFFSET_BASIS, "C", 1 );
+        h = hashInt( h, zone );
+        h = hashBytes( h, name.data(), name.size() + 1 );
+        h = hashBytes( h, setCode.data(), setCode.size() + 1 );
+        mValue += h;
+    }
+
+    void addBasicLands( int zone, BasicLandType basic, int qty )
+    {
+        if( qty == 0 ) return;
+        uint32_t h = hashBytes( FNV_OFFSET_BASIS, "B", 1 );
+        h = hashInt( h, zone );
+        h = hashInt( h, basic );
+        mValue += h * uint32_t( qty );
+    }
+
+    uint32_t getValue() const { return mValue; }
+
+private:
+
+    static const uint32_t FNV_OFFSET_BASIS = 2166136261u;
+    static const uint32_t FNV_PRIME        = 16777619u;
+
+    static uint32_t hashBytes( uint32_t h, const char* data, std::size_t len )
+    {
+        for( std::size_t i = 0; i < len; ++i )
+        {
+            h ^= (unsigned char) data[i];
+            h *= FNV_PRIME;
+        }
+        return h;
+    }
+
+    static uint32_t hashInt( uint32_t h, int val )
+    {
+        const uint32_t v = val;
+        const char bytes[4] = { char( v >> 24 ), char( v >> 16 ), char( v >> 8 ), char( v ) };
+        return hashBytes( h, bytes, 4 );
+    }
+
+    uint32_t mValue;
+};
+
+#endif  // INVENTORYCHECKSUM_H
@@ -2,15 +2,23 @@
 #include "MtgJsonCardData.h"
 
 #include "StringUtil.h"
+#include "ChunkedReadStream.h"
 
 #include "rapidjson/document.h"
 #include "rapidjson/filereadstream.h"
 #include "rapidjson/error/en.h"
 
+#include <algorithm>
+#include <cctype>
 #include <map>
+#include <thread>
 
 using namespace rapidjson;
 
+// Bulk name resolution uses a thread per this many names, up to the
+// number of cores.
+static const std::size_t BULK_RESOLVE_NAMES_PER_THREAD = 2000;
+
 MtgJsonAllSetsData::MtgJsonAllSetsData( unsigned int    cacheSize,
                                         Logging::Config loggingConfig )
   : mCardLookupLRUCache( cacheSize ),
@@ -23,14 +31,80 @@ MtgJsonAllSetsData::MtgJsonAllSetsData( unsigned int    cacheSize,
 {}
 
 
+// Bytes read between progress callbacks.
+static const std::size_t PROGRESS_INTERVAL_BYTES = 1 << 20;
+
+// Read-only rapidjson stream that passes reads through to another stream
+// and reports the byte count every so often.
+template<typename InputStream>
+class ProgressReadStream
+{
+public:
+    typedef typename InputStream::Ch Ch;
+
+    ProgressReadStream( InputStream& is, const MtgJsonAllSetsData::ProgressCallback& callback )
+      : mIs( is ), mCallback( callback ), mNextReport( PROGRESS_INTERVAL_BYTES ) {}
+
+    Ch Peek() const { return mIs.Peek(); }
+    Ch Take()
+    {
+        Ch c = mIs.Take();
+        if( mCallback && (mIs.Tell() >= mNextReport) )
+        {
+            mCallback( mIs.Tell() );
+            mNextReport += PROGRESS_INTERVAL_BYTES;
+        }
+        return c;
+    }
+    std::size_t Tell() const { return mIs.Tell(); }
+
+    Ch* PutBegin() { RAPIDJSON_ASSERT( false ); return 0; }
+    void Put( Ch ) { RAPIDJSON_ASSERT( false ); }
+    void Flush() { RAPIDJSON_ASSERT( false ); }
+    std::size_t PutEnd( Ch* ) { RAPIDJSON_ASSERT( false ); return 0; }
+
+private:
+    InputStream&                                mIs;
+    const MtgJsonAllSetsData::ProgressCallback& mCallback;
+    std::size_t                                 mNextReport;
+};
+
+
 bool
-MtgJsonAllSetsData::parse( FILE* fp )
+MtgJsonAllSetsData::parse( FILE* fp, const ProgressCallback& progressCallback )
 {
     char readBuffer[65536];
-    FileReadStream is( fp, readBuffer, sizeof(readBuffer) );
+    FileReadStream fis( fp, readBuffer, sizeof(readBuffer) );
+    ProgressReadStream<FileReadStream> is( fis, progressCallback );
     mLogger->debug( "parsing mtgjson file" );
     mDoc.ParseStream( is );
+    if( progressCallback ) progressCallback( fis.Tell() );
+
+    return indexDoc();
+}
+
+
+bool
+MtgJsonAllSetsData::parse( ChunkedReadStream& cs, const ProgressCallback& progressCallback )
+{
+    ProgressReadStream<ChunkedReadStream> is( cs, progressCallback );
+    mLogger->debug( "parsing mtgjson stream" );
+    mDoc.ParseStream( is );
+    if( progressCallback ) progressCallback( cs.Tell() );
 
+    if( cs.isCanceled() )
+    {
+        mLogger->debug( "mtgjson stream canceled" );
+        return false;
+    }
+
+    return indexDoc();
+}
+
+
+bool
+MtgJsonAllSetsData::indexDoc()
+{
     if( mDoc.HasParseError() )
     {
         mLogger->error( "json parsing error (offset {}): {}",
@@ -148,10 +222,116 @@ MtgJsonAllSetsData::parse( FILE* fp )
         mSearchPrioritizedAllSetCodes.push_back( sc );
     }
 
+    buildNameIndex();
+
     return true;
 }
 
 
+void
+MtgJsonAllSetsData::buildNameIndex()
+{
+    // Sets are indexed in search priority order, so the first entry for a
+    // name is the preferred printing.  Cards with multiple names (split
+    // cards, etc.) are also indexed under their combined name.  Card types
+    // are registered along the way so card data lookups never need to.
+    mNameIndex.clear();
+    std::vector<std::string> searchNames;
+    for( const std::string& setCode : mSearchPrioritizedAllSetCodes )
+    {
+        const std::string* setCodePtr = &(*mAllSetCodes.find( setCode ));
+
+        // In parse() this was vetted to be safe and yield an Array-type value.
+        const Value& cardsValue = mDoc[setCode]["cards"];
+        for( Value::ConstValueIterator iter = cardsValue.Begin(); iter != cardsValue.End(); ++iter )
+        {
+            if( !iter->IsObject() ) continue;
+            Value::ConstMemberIterator nameIter = iter->FindMember( "name" );
+            if( (nameIter == iter->MemberEnd()) || !nameIter->value.IsString() ) continue;
+
+            registerCardTypes( *iter );
+
+            const std::string name( nameIter->value.GetString() );
+            const std::string nameKey = normalizeName( name );
+            if( mNameIndex.count( nameKey ) == 0 ) searchNames.push_back( name );
+            addNameIndexEntry( nameKey, setCodePtr, iter );
+
+            Value::ConstMemberIterator namesIter = iter->FindMember( "names" );
+            if( namesIter != iter->MemberEnd() )
+            {
+                const std::string splitName = MtgJson::createSplitCardName( namesIter->value );
+                const std::string namesKey = normalizeName( splitName );
+                if( !namesKey.empty() && (namesKey != nameKey) )
+                {
+                    if( mNameIndex.count( namesKey ) == 0 ) searchNames.push_back( splitName );
+                    addNameIndexEntry( namesKey, setCodePtr, iter );
+                }
+            }
+        }
+    }
+    mNameSearchIndex.build( searchNames );
+    mLogger->debug( "indexed {} card names, {} searchable", mNameIndex.size(), mNameSearchIndex.size() );
+}
+
+
+void
+MtgJsonAllSetsData::registerCardTypes( const Value& cardValue )
+{
+    Value::ConstMemberIterator typesIter = cardValue.FindMember( "types" );
+    if( (typesIter == cardValue.MemberEnd()) || !typesIter->value.IsArray() ) return;
+
+    for( Value::ConstValueIterator iter = typesIter->value.Begin(); iter != typesIter->value.End(); ++iter )
+    {
+        if( iter->IsString() && (CardTypeIds::registerName( iter->GetString() ) < 0) )
+        {
+            mLogger->warn( "too many card types, ignoring {}", iter->GetString() );
+        }
+    }
+}
+
+
+void
+MtgJsonAllSetsData::addNameIndexEntry( const std::string&        key,
+                                       const std::string*        setCode,
+                                       Value::ConstValueIterator cardIter )
+{
+    // Only the first card of a given name in a set is of interest.
+    std::vector<NameIndexEntry>& entries = mNameIndex[key];
+    for( const NameIndexEntry& entry : entries )
+    {
+        if( entry.setCode == setCode ) return;
+    }
+    entries.push_back( NameIndexEntry{ setCode, cardIter } );
+}
+
+
+std::string
+MtgJsonAllSetsData::normalizeName( const std::string& name )
+{
+    std::string key = MtgJson::normalizeSplitCardName( name );
+    std::transform( key.begin(), key.end(), key.begin(),
+            []( unsigned char c ) { return static_cast<char>( std::tolower( c ) ); } );
+    return key;
+}
+
+
+const MtgJsonAllSetsData::NameIndexEntry*
+MtgJsonAllSetsData::findNameIndexEntry( const std::string& code, const std::string& name ) const
+{
+    auto iter = mNameIndex.find( normalizeName( name ) );
+    if( iter == mNameIndex.end() ) return nullptr;
+
+    // Without a set code the preferred printing is first.
+    if( code.empty() ) return &(iter->second.front());
+
+    for( const NameIndexEntry& entry : iter->second )
+    {
+        if( *entry.setCode == code ) return &entry;
+    }
+    return nullptr;
+}
+
+
 std::vector<std::string>
 MtgJsonAllSetsData::getSetCodes() const
 {
@@ -350,16 +530,12 @@ MtgJsonAllSetsData::createCardData( const std::string& code, const std::string&
         return nullptr;
     }
 
-    // In parse() this was vetted to be safe and yield an Array-type value.
-    const Value& cardsValue = mDoc[code]["cards"];
-
-    Value::ConstValueIterator iter = findCardValueByName(
-            cardsValue.Begin(), cardsValue.End(), name );
-    if( iter != cardsValue.End() )
+    const NameIndexEntry* entry = findNameIndexEntry( code, name );
+    if( entry )
     {
         mLogger->debug( "found name {}", name );
-        mCardLookupLRUCache.put( cardLookupCacheKey, iter );
-        return new MtgJsonCardData( code, *iter );
+        mCardLookupLRUCache.put( cardLookupCacheKey, entry->cardIter );
+        return new MtgJsonCardData( code, *(entry->cardIter) );
     }
 
     mLogger->debug( "unable to find card name {}", name );
@@ -412,20 +588,8 @@ MtgJsonAllSetsData::findSetCode( const std::string& name ) const
     }
     mSetCodeLookupLRUCacheMisses++;
 
-    std::string retSetCode;
-    for( const std::string& setCode : mSearchPrioritizedAllSetCodes )
-    {
-        // In parse() this was vetted to be safe and yield an Array-type value.
-        const Value& cardsValue = mDoc[setCode]["cards"];
-
-        Value::ConstValueIterator iter = findCardValueByName(
-                cardsValue.Begin(), cardsValue.End(), name );
-        if( iter != cardsValue.End() )
-        {
-            retSetCode = setCode;
-            break;
-        }
-    }
+    const NameIndexEntry* entry = findNameIndexEntry( std::string(), name );
+    const std::string retSetCode = entry ? *(entry->setCode) : std::string();
 
     // Cache the search result and return.
     mSetCodeLookupLRUCache.put( name, retSetCode );
@@ -433,37 +597,98 @@ MtgJsonAllSetsData::findSetCode( const std::string& name ) const
 }
 
 
-Value::ConstValueIterator
-MtgJsonAllSetsData::findCardValueByName( Value::ConstValueIterator first,
-                                         Value::ConstValueIterator last,
-                                         const std::string&        name ) const
+bool
+MtgJsonAllSetsData::hasSetCode( const std::string& code ) const
+{
+    return (mAllSetCodes.count( code ) > 0);
+}
+
+
+std::vector<CardNameResolution>
+MtgJsonAllSetsData::resolveCardNames( const std::vector<SimpleCardData>& cards ) const
 {
-    Value::ConstValueIterator iter = first;
+    std::vector<CardNameResolution> results( cards.size() );
+
+    // The index is read-only here, so big lists are split across threads.
+    auto resolveRange = [this,&cards,&results]( std::size_t first, std::size_t last ) {
+            for( std::size_t i = first; i < last; ++i )
+            {
+                results[i] = resolveCardName( cards[i] );
+            }
+        };
 
-    for( Value::ConstValueIterator iter = first; iter != last; ++iter )
+    const std::size_t threadCount = std::min<std::size_t>(
+            std::max( 1u, std::thread::hardware_concurrency() ),
+            cards.size() / BULK_RESOLVE_NAMES_PER_THREAD );
+    if( threadCount <= 1 )
     {
-        std::string nameStr( (*iter)["name"].GetString() );
-        if( StringUtil::icompare( nameStr, name ) )
+        resolveRange( 0, cards.size() );
+    }
+    else
+    {
+        std::vector<std::thread> threads;
+        const std::size_t perThread = (cards.size() + threadCount - 1) / threadCount;
+        for( std::size_t first = 0; first < cards.size(); first += perThread )
         {
-            mLogger->debug( "found name {}", name );
-            return iter;
+            threads.emplace_back( resolveRange, first, std::min( first + perThread, cards.size() ) );
         }
-        else if( iter->HasMember("names") )
-        {
-            // Here we check if the card has multiple names, i.e. split
-            // cards.  If so, create a split card name and normalize the
-            // name parameter and see if they match.
+        for( std::thread& t : threads ) t.join();
+    }
+
+    return results;
+}
 
-            std::string splitCardName = MtgJson::createSplitCardName( (*iter)["names"] );
-            std::string nameNormalized = MtgJson::normalizeSplitCardName( name );
 
-            if( StringUtil::icompare( nameNormalized, splitCardName ) )
+CardNameResolution
+MtgJsonAllSetsData::resolveCardName( const SimpleCardData& card ) const
+{
+    CardNameResolution result;
+    result.status = CardNameResolution::STATUS_NOT_FOUND;
+
+    auto iter = mNameIndex.find( normalizeName( card.getName() ) );
+    if( iter == mNameIndex.end() ) return result;
+
+    // Prefer the hinted set, else the preferred printing.
+    const std::string& hint = card.getSetCode();
+    const NameIndexEntry* found = &(iter->second.front());
+    result.status = hint.empty() ? CardNameResolution::STATUS_RESOLVED
+                                 : CardNameResolution::STATUS_RESOLVED_OTHER_SET;
+    if( !hint.empty() )
+    {
+        for( const NameIndexEntry& entry : iter->second )
+        {
+            if( *entry.setCode == hint )
             {
-                mLogger->debug( "found split name {}", name );
-                return iter;
+                found = &entry;
+                result.status = CardNameResolution::STATUS_RESOLVED;
+                break;
             }
         }
     }
 
-    return last;
+    result.setCode = *(found->setCode);
+    result.name = (*found->cardIter)["name"].GetString();
+
+    // Cards with multiple names resolve to the combined name if that's
+    // what was asked for.
+    if( found->cardIter->HasMember( "names" ) && MtgJson::isSplitCard( *found->cardIter ) &&
+        (normalizeName( card.getName() ) != normalizeName( result.name )) )
+    {
+        result.name = MtgJson::createSplitCardName( (*found->cardIter)["names"] );
+    }
+    return result;
+}
+
+
+std::vector<std::string>
+MtgJsonAllSetsData::findCardNamesWithPrefix( const std::string& prefix, std::size_t maxCount ) const
+{
+    return mNameSearchIndex.findPrefixMatches( prefix, maxCount );
+}
+
+
+std::vector<std::string>
+MtgJsonAllSetsData::findSimilarCardNames( const std::string& name, std::size_t maxCount ) const
+{
+    return mNameSearchIndex.findFuzzyMatches( name, maxCount );
 }
@@ -3,13 +3,18 @@
 
 #include "AllSetsData.h"
 #include "SimpleCardData.h"
+#include "CardNameSearchIndex.h"
 #include "rapidjson/document.h"
 #include "lrucache.hpp"
+#include <functional>
 #include <string>
 #include <set>
+#include <unordered_map>
 #include <vector>
 #include "Logging.h"
 
+class ChunkedReadStream;
+
 class MtgJsonAllSetsData : public AllSetsData
 {
 public:
@@ -24,7 +29,14 @@ public:
 
     virtual ~MtgJsonAllSetsData() {}
 
-    bool parse( FILE* fp );
+    // Called periodically during parse() with the number of bytes read.
+    typedef std::function<void(std::size_t)> ProgressCallback;
+
+    bool parse( FILE* fp, const ProgressCallback& progressCallback = ProgressCallback() );
+
+    // Parse data as it arrives, e.g. during a download.  Blocks until the
+    // stream is finished or canceled, so call from a worker thread.
+    bool parse( ChunkedReadStream& cs, const ProgressCallback& progressCallback = ProgressCallback() );
 
     virtual std::vector<std::string> getSetCodes() const override;
     virtual std::string getSetName( const std::string& code, const std::string& defaultName = "") const override;
@@ -42,7 +54,17 @@ public:
     // Given a card name, find a set code for it if possible.  Set codes are prioritized by
     // being an expansion or core set first, then by release date in reverse-chron order.
     // Returns empty string if no set code found.
-    virtual std::string findSetCode( const std::string& name ) const;
+    virtual std::string findSetCode( const std::string& name ) const override;
+
+    virtual bool hasSetCode( const std::string& code ) const override;
+
+    // Resolved against an index of normalized names built at parse time.
+    virtual std::vector<CardNameResolution> resolveCardNames( const std::vector<SimpleCardData>& cards ) const override;
+
+    // Both served by a trigram/prefix index of canonical names built at
+    // parse time.  Names are ignored for case, spaces and punctuation.
+    virtual std::vector<std::string> findCardNamesWithPrefix( const std::string& prefix, std::size_t maxCount ) const override;
+    virtual std::vector<std::string> findSimilarCardNames( const std::string& name, std::size_t maxCount ) const override;
 
     unsigned int getCardLookupCacheHits() const { return mCardLookupLRUCacheHits; }
     unsigned int getCardLookupCacheMisses() const { return mCardLookupLRUCacheMisses; }
@@ -52,24 +74,48 @@ public:
 
 private:
 
+    // Verify and index the parsed document.
+    bool indexDoc();
+
     // Cache for card lookup by set and name: [set/name] -> [json card value iterator]
     using CardLookupLRUCache = cache::lru_cache<SimpleCardData,rapidjson::Value::ConstValueIterator>;
 
     // Cache for set code lookup by name: [card name] -> [set code]
     using SetCodeLookupLRUCache = cache::lru_cache<std::string,std::string>;
 
-    // Find a card name given a range of rapidjson value iterators.  Returns
-    // iterator to found element or last if not found.
-    rapidjson::Value::ConstValueIterator findCardValueByName(
-                           rapidjson::Value::ConstValueIterator first,
-                           rapidjson::Value::ConstValueIterator last,
-                           const std::string&                   name ) const;
+    // Name index entry: a card and the set it's in.
+    struct NameIndexEntry
+    {
+        const std::string*                   setCode;
+        rapidjson::Value::ConstValueIterator cardIter;
+    };
+
+    void buildNameIndex();
+    void registerCardTypes( const rapidjson::Value& cardValue );
+    void addNameIndexEntry( const std::string&                   key,
+                            const std::string*                   setCode,
+                            rapidjson::Value::ConstValueIterator cardIter );
+
+    // Case-folded name with split card names normalized.
+    static std::string normalizeName( const std::string& name );
+
+    // Find a card by name in a set, or in the highest priority set if the
+    // set code is empty.  Returns nullptr if not found.
+    const NameIndexEntry* findNameIndexEntry( const std::string& code, const std::string& name ) const;
+
+    CardNameResolution resolveCardName( const SimpleCardData& card ) const;
 
     rapidjson::Document mDoc;
     std::set<std::string> mAllSetCodes;
     std::vector<std::string> mSearchPrioritizedAllSetCodes;
     std::set<std::string> mBoosterSetCodes;
 
+    // Normalized card name -> cards by set, in search priority order.
+    std::unordered_map<std::string,std::vector<NameIndexEntry>> mNameIndex;
+
+    // Canonical card names for autocomplete and fuzzy matching.
+    CardNameSearchIndex mNameSearchIndex;
+
     mutable CardLookupLRUCache mCardLookupLRUCache;
     mutable unsigned int mCardLookupLRUCacheHits;
     mutable unsigned int mCardLookupLRUCacheMisses;
@@ -8,12 +8,36 @@ MtgJsonCardData::MtgJsonCardData( const std::string&      setCode,
     mCMC( parseCMC( cardValue ) ),
     mRarity( parseRarity( cardValue ) ),
     mSplit( parseSplit( cardValue ) ),
-    mColorSet( parseColors( cardValue ) ),
-    mTypesSet( parseTypes( cardValue ) )
+    mColorMask( parseColors( cardValue ) ),
+    mTypeMask( parseTypes( cardValue ) )
 {
 }
 
 
+std::set<ColorType>
+MtgJsonCardData::getColors() const
+{
+    std::set<ColorType> colors;
+    for( ColorType color : gColorTypeArray )
+    {
+        if( mColorMask & colorMask( color ) ) colors.insert( color );
+    }
+    return colors;
+}
+
+
+std::set<std::string>
+MtgJsonCardData::getTypes() const
+{
+    std::set<std::string> types;
+    for( int id = 0; id < CardTypeIds::MAX_TYPE_IDS; ++id )
+    {
+        if( mTypeMask & (TypeMask( 1u ) << id) ) types.insert( CardTypeIds::getName( id ) );
+    }
+    return types;
+}
+
+
 std::string
 MtgJsonCardData::parseName( const rapidjson::Value& cardValue )
 {
@@ -85,10 +109,10 @@ MtgJsonCardData::parseSplit( const rapidjson::Value& cardValue )
 }
 
 
-std::set<ColorType>
+ColorMask
 MtgJsonCardData::parseColors( const rapidjson::Value& cardValue )
 {
-    std::set<ColorType> colors;
+    ColorMask colors = 0;
 
     // Return empty set if no "colors" member.
     if( !cardValue.HasMember("colors") ) return colors;
@@ -104,15 +128,15 @@ MtgJsonCardData::parseColors( const rapidjson::Value& cardValue )
             {
                 std::string colorStr( iter->GetString() );
                 if( colorStr == "White" )
-                    colors.insert( COLOR_WHITE );
+                    colors |= colorMask( COLOR_WHITE );
                 if( colorStr == "Blue" )
-                    colors.insert( COLOR_BLUE );
+                    colors |= colorMask( COLOR_BLUE );
                 if( colorStr == "Black" )
-                    colors.insert( COLOR_BLACK );
+                    colors |= colorMask( COLOR_BLACK );
                 if( colorStr == "Red" )
-                    colors.insert( COLOR_RED );
+                    colors |= colorMask( COLOR_RED );
                 if( colorStr == "Green" )
-                    colors.insert( COLOR_GREEN );
+                    colors |= colorMask( COLOR_GREEN );
                 else
                 {
                     // Unrecognized color string
@@ -129,10 +153,10 @@ MtgJsonCardData::parseColors( const rapidjson::Value& cardValue )
 }
 
 
-std::set<std::string>
+TypeMask
 MtgJsonCardData::parseTypes( const rapidjson::Value& cardValue )
 {
-    std::set<std::string> types;
+    TypeMask types = 0;
 
     // Return empty set if no "types" member.
     if( !cardValue.HasMember("types") ) return types;
@@ -146,7 +170,7 @@ MtgJsonCardData::parseTypes( const rapidjson::Value& cardValue )
         {
             if( iter->IsString() )
             {
-                types.insert( iter->GetString() );
+                types |= CardTypeIds::getMask( iter->GetString() );
             }
             else
             {
@@ -24,9 +24,13 @@ public:
 
     virtual bool isSplit() const override { return mSplit; }
 
-    virtual std::set<ColorType> getColors() const override { return mColorSet; }
+    virtual std::set<ColorType> getColors() const override;
 
-    virtual std::set<std::string> getTypes() const override { return mTypesSet; }
+    virtual std::set<std::string> getTypes() const override;
+
+    virtual ColorMask getColorMask() const override { return mColorMask; }
+
+    virtual TypeMask getTypeMask() const override { return mTypeMask; }
 
 private:
 
@@ -35,8 +39,8 @@ private:
     static int parseCMC( const rapidjson::Value& cardValue );
     static RarityType parseRarity( const rapidjson::Value& cardValue );
     static bool parseSplit( const rapidjson::Value& cardValue );
-    static std::set<ColorType> parseColors( const rapidjson::Value& cardValue );
-    static std::set<std::string> parseTypes( const rapidjson::Value& cardValue );
+    static ColorMask parseColors( const rapidjson::Value& cardValue );
+    static TypeMask parseTypes( const rapidjson::Value& cardValue );
 
     const std::string           mSetCode;
     const std::string           mName;
@@ -44,8 +48,8 @@ private:
     const int                   mCMC;
     const RarityType            mRarity;
     const bool                  mSplit;
-    const std::set<ColorType>   mColorSet;
-    const std::set<std::string> mTypesSet;
+    const ColorMask             mColorMask;
+    const TypeMask              mTypeMask;
 };
 
 #endif // MTGJSONCARDDATA_H
@@ -1,6 +1,7 @@
 #include "PlayerInventory.h"
 
 #include <algorithm>
+#include "InventoryChecksum.h"
 
 const std::array<PlayerInventory::ZoneType,PlayerInventory::ZONE_TYPE_COUNT>
 PlayerInventory::gZoneTypeArray = { PlayerInventory::ZONE_AUTO,
@@ -109,6 +110,25 @@ PlayerInventory::getCards( ZoneType zone ) const
 }
 
 
+uint32_t
+PlayerInventory::getChecksum() const
+{
+    InventoryChecksum checksum;
+    for( ZoneType zone : gZoneTypeArray )
+    {
+        for( const CardDataSharedPtr& card : mCardData[zone] )
+        {
+            checksum.addCard( zone, card->getName(), card->getSetCode() );
+        }
+        for( BasicLandType basic : gBasicLandTypeArray )
+        {
+            checksum.addBasicLands( zone, basic, mBasicLandQtys[zone].getQuantity( basic ) );
+        }
+    }
+    return checksum.getValue();
+}
+
+
 void
 PlayerInventory::clear()
 {
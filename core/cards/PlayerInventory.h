@@ -38,6 +38,9 @@ public:
     unsigned int size() const;
     unsigned int size( ZoneType zone ) const;
 
+    // Order-independent checksum of all zones (see InventoryChecksum).
+    uint32_t getChecksum() const;
+
     void clear();
 
 private:
@@ -24,6 +24,8 @@ public:
     virtual bool isSplit() const override { return false; };
     virtual std::set<ColorType> getColors() const override { return std::set<ColorType>(); } // empty set
     virtual std::set<std::string> getTypes() const override { return std::set<std::string>(); } // empty set
+    virtual ColorMask getColorMask() const override { return 0; }
+    virtual TypeMask getTypeMask() const override { return 0; }
 
 private:
     std::string mName;
@@ -0,0 +1,101 @@
+#include "catch.hpp"
+#include "MtgJsonAllSetsData.h"
+#include "ChunkedReadStream.h"
+#include <vector>
+
+// A tiny AllSets document: an old core set and a newer expansion that
+// reprints one card and has a split card.
+static const std::string ALLSETS_JSON = R"({
+    "OLD": { "name": "Old Core", "type": "core", "releaseDate": "2000-01-01",
+             "cards": [ { "name": "Lightning Bolt", "rarity": "Common" },
+                        { "name": "Giant Growth", "rarity": "Common" } ] },
+    "NEW": { "name": "New Expansion", "type": "expansion", "releaseDate": "2010-01-01",
+             "cards": [ { "name": "Lightning Bolt", "rarity": "Common" },
+                        { "name": "Fire", "names": [ "Fire", "Ice" ], "layout": "split", "rarity": "Uncommon" },
+                        { "name": "Ice", "names": [ "Fire", "Ice" ], "layout": "split", "rarity": "Uncommon" } ] }
+})";
+
+static void initAllSetsData( MtgJsonAllSetsData& allSets )
+{
+    ChunkedReadStream is;
+    is.append( ALLSETS_JSON.data(), ALLSETS_JSON.size() );
+    is.finish();
+    CATCH_REQUIRE( allSets.parse( is ) );
+}
+
+
+CATCH_TEST_CASE( "Bulk card name resolution", "[cardnameresolution]" )
+{
+    MtgJsonAllSetsData allSets;
+    initAllSetsData( allSets );
+
+    CATCH_REQUIRE( allSets.hasSetCode( "OLD" ) );
+    CATCH_REQUIRE_FALSE( allSets.hasSetCode( "XYZ" ) );
+
+    std::vector<SimpleCardData> cards;
+    cards.push_back( SimpleCardData( "lightning bolt" ) );
+    cards.push_back( SimpleCardData( "Lightning Bolt", "OLD" ) );
+    cards.push_back( SimpleCardData( "Giant Growth", "NEW" ) );
+    cards.push_back( SimpleCardData( "fire/ice" ) );
+    cards.push_back( SimpleCardData( "Ice", "NEW" ) );
+    cards.push_back( SimpleCardData( "Black Lotus" ) );
+
+    std::vector<CardNameResolution> results = allSets.resolveCardNames( cards );
+    CATCH_REQUIRE( results.size() == cards.size() );
+
+    // No hint: newest expansion first, canonical capitalization.
+    CATCH_REQUIRE( results[0].status == CardNameResolution::STATUS_RESOLVED );
+    CATCH_REQUIRE( results[0].setCode == "NEW" );
+    CATCH_REQUIRE( results[0].name == "Lightning Bolt" );
+
+    // Hinted set honored.
+    CATCH_REQUIRE( results[1].status == CardNameResolution::STATUS_RESOLVED );
+    CATCH_REQUIRE( results[1].setCode == "OLD" );
+
+    // Hinted set doesn't have the card.
+    CATCH_REQUIRE( results[2].status == CardNameResolution::STATUS_RESOLVED_OTHER_SET );
+    CATCH_REQUIRE( results[2].setCode == "OLD" );
+
+    // Split card by combined name, and by half name.
+    CATCH_REQUIRE( results[3].status == CardNameResolution::STATUS_RESOLVED );
+    CATCH_REQUIRE( results[3].name == "Fire // Ice" );
+    CATCH_REQUIRE( results[4].status == CardNameResolution::STATUS_RESOLVED );
+    CATCH_REQUIRE( results[4].name == "Ice" );
+
+    CATCH_REQUIRE( results[5].status == CardNameResolution::STATUS_NOT_FOUND );
+    CATCH_REQUIRE( results[5].setCode.empty() );
+
+    // Single lookups agree with the index.
+    CATCH_REQUIRE( allSets.findSetCode( "Giant Growth" ) == "OLD" );
+    CATCH_REQUIRE( allSets.findSetCode( "Fire // Ice" ) == "NEW" );
+    CATCH_REQUIRE( allSets.findSetCode( "Black Lotus" ).empty() );
+
+    // Search over canonical names, each name once.
+    CATCH_REQUIRE( allSets.findCardNamesWithPrefix( "fi", 5 ) == std::vector<std::string>( { "Fire", "Fire // Ice" } ) );
+    CATCH_REQUIRE( allSets.findSimilarCardNames( "Lightnig Bolt", 5 ) == std::vector<std::string>( { "Lightning Bolt" } ) );
+}
+
+
+CATCH_TEST_CASE( "Bulk card name resolution of a large list", "[cardnameresolution]" )
+{
+    MtgJsonAllSetsData allSets;
+    initAllSetsData( allSets );
+
+    // Big enough to be split across threads.
+    std::vector<SimpleCardData> cards;
+    for( int i = 0; i < 20000; ++i )
+    {
+        cards.push_back( SimpleCardData( (i % 2) ? "Giant Growth" : "No Such Card" ) );
+    }
+
+    std::vector<CardNameResolution> results = allSets.resolveCardNames( cards );
+    CATCH_REQUIRE( results.size() == cards.size() );
+    bool allOk = true;
+    for( std::size_t i = 0; i < results.size(); ++i )
+    {
+        const bool expectFound = (i % 2);
+        if( (results[i].status == CardNameResolution::STATUS_RESOLVED) != expectFound ) allOk = false;
+        if( expectFound && (results[i].setCode != "OLD") ) allOk = false;
+    }
+    CATCH_REQUIRE( allOk );
+}
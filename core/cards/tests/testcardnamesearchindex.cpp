@@ -0,0 +1,67 @@
+#include "catch.hpp"
+#include "CardNameSearchIndex.h"
+#include <vector>
+
+static std::vector<std::string> getNames()
+{
+    return std::vector<std::string> {
+        "Lightning Bolt", "Lightning Helix", "Lightning Greaves", "Lightning Axe",
+        "Llanowar Elves", "Elvish Mystic", "Fire // Ice", "Ice Cave", "Icy Manipulator",
+        "Jace, the Mind Sculptor", "Jace Beleren", "Black Lotus", "Ancestral Recall",
+        "Swords to Plowshares", "Sword of Fire and Ice", "Counterspell", "Island",
+        "Lightning bolt" };
+}
+
+
+CATCH_TEST_CASE( "Card name prefix search", "[cardnamesearchindex]" )
+{
+    CardNameSearchIndex index;
+    index.build( getNames() );
+
+    // The duplicate differing only by case was dropped, keeping the first.
+    CATCH_REQUIRE( index.size() == getNames().size() - 1 );
+
+    std::vector<std::string> matches = index.findPrefixMatches( "light", 10 );
+    CATCH_REQUIRE( matches == std::vector<std::string>( { "Lightning Axe", "Lightning Bolt", "Lightning Greaves", "Lightning Helix" } ) );
+
+    // Limited, and ignoring case, spaces and punctuation.
+    matches = index.findPrefixMatches( "LIGHTNING-B", 10 );
+    CATCH_REQUIRE( matches == std::vector<std::string>( { "Lightning Bolt" } ) );
+    CATCH_REQUIRE( index.findPrefixMatches( "l", 2 ).size() == 2 );
+    CATCH_REQUIRE( index.findPrefixMatches( "jace the", 10 ) == std::vector<std::string>( { "Jace, the Mind Sculptor" } ) );
+    CATCH_REQUIRE( index.findPrefixMatches( "fire/", 10 ) == std::vector<std::string>( { "Fire // Ice" } ) );
+
+    CATCH_REQUIRE( index.findPrefixMatches( "zzz", 10 ).empty() );
+    CATCH_REQUIRE( index.findPrefixMatches( "", 10 ).empty() );
+}
+
+
+CATCH_TEST_CASE( "Card name fuzzy search", "[cardnamesearchindex]" )
+{
+    CardNameSearchIndex index;
+    index.build( getNames() );
+
+    // Exact match first.
+    std::vector<std::string> matches = index.findFuzzyMatches( "lightning bolt", 3 );
+    CATCH_REQUIRE( !matches.empty() );
+    CATCH_REQUIRE( matches[0] == "Lightning Bolt" );
+
+    // Dropped, swapped and substituted letters.
+    CATCH_REQUIRE( index.findFuzzyMatches( "Lightnig Bolt", 1 ) == std::vector<std::string>( { "Lightning Bolt" } ) );
+    CATCH_REQUIRE( index.findFuzzyMatches( "Counterpsell", 1 ) == std::vector<std::string>( { "Counterspell" } ) );
+    CATCH_REQUIRE( index.findFuzzyMatches( "Lanowar Elfs", 1 ) == std::vector<std::string>( { "Llanowar Elves" } ) );
+    CATCH_REQUIRE( index.findFuzzyMatches( "Jace the Mind Sculpter", 1 ) == std::vector<std::string>( { "Jace, the Mind Sculptor" } ) );
+    CATCH_REQUIRE( index.findFuzzyMatches( "Swords to Plowshare", 1 ) == std::vector<std::string>( { "Swords to Plowshares" } ) );
+
+    // Short names.
+    CATCH_REQUIRE( index.findFuzzyMatches( "Islnd", 1 ) == std::vector<std::string>( { "Island" } ) );
+
+    // Nothing close.
+    CATCH_REQUIRE( index.findFuzzyMatches( "Tarmogoyf", 5 ).empty() );
+    CATCH_REQUIRE( index.findFuzzyMatches( "Lightnig Bolt", 0 ).empty() );
+
+    // Cleared.
+    index.clear();
+    CATCH_REQUIRE( index.findFuzzyMatches( "Lightning Bolt", 1 ).empty() );
+    CATCH_REQUIRE( index.findPrefixMatches( "Lightning", 1 ).empty() );
+}
@@ -281,9 +281,11 @@ CATCH_TEST_CASE( "Spot-check CardData created from set and name", "[mtgjson]" )
         CATCH_REQUIRE( colors.size() == 2 );
         CATCH_REQUIRE( colors.count( COLOR_BLACK ) );
         CATCH_REQUIRE( colors.count( COLOR_GREEN ) );
+        CATCH_REQUIRE( c->getColorMask() == (colorMask( COLOR_BLACK ) | colorMask( COLOR_GREEN )) );
         types = c->getTypes();
         CATCH_REQUIRE( types.size() == 1 );
         CATCH_REQUIRE( types.count( "Instant" ) );
+        CATCH_REQUIRE( c->getTypeMask() == CardTypeIds::getMask( "Instant" ) );
         delete c;
 
         c = allSets.createCardData( "LEA", "Black Lotus" );
@@ -562,3 +564,22 @@ CATCH_TEST_CASE( "Spot-check CardCata created from multiverse id", "[mtgjson]" )
     delete c;
 }
 
+
+
+CATCH_TEST_CASE( "Card type ids", "[mtgjson]" )
+{
+    // Standard types are registered up front in alphabetical order.
+    CATCH_REQUIRE( CardTypeIds::getId( "Artifact" ) == 0 );
+    CATCH_REQUIRE( CardTypeIds::getId( "Artifact" ) < CardTypeIds::getId( "Creature" ) );
+
+    // Lookups don't register new types.
+    CATCH_REQUIRE( CardTypeIds::getId( "Testtype" ) == -1 );
+    CATCH_REQUIRE( CardTypeIds::getMask( "Testtype" ) == 0 );
+
+    const int id = CardTypeIds::registerName( "Testtype" );
+    CATCH_REQUIRE( id >= 0 );
+    CATCH_REQUIRE( CardTypeIds::registerName( "Testtype" ) == id );
+    CATCH_REQUIRE( CardTypeIds::getId( "Testtype" ) == id );
+    CATCH_REQUIRE( CardTypeIds::getName( id ) == "Testtype" );
+    CATCH_REQUIRE( CardTypeIds::getMask( "Testtype" ) == (TypeMask( 1u ) << id) );
+}
@@ -239,6 +239,40 @@ CATCH_TEST_CASE( "Player Inventory", "[playerinventory]" )
                 PlayerInventory::ZONE_JUNK, PlayerInventory::ZONE_JUNK ) );
     }
 
+    CATCH_SECTION( "Checksum" )
+    {
+        const uint32_t checksum = inv.getChecksum();
+
+        // A move changes the checksum, moving back restores it.
+        auto card = std::make_shared<SimpleCardData>( "Fireball", "4ED" );
+        CATCH_REQUIRE( inv.move( card, PlayerInventory::ZONE_MAIN, PlayerInventory::ZONE_JUNK ) );
+        CATCH_REQUIRE( inv.getChecksum() != checksum );
+        CATCH_REQUIRE( inv.move( card, PlayerInventory::ZONE_JUNK, PlayerInventory::ZONE_MAIN ) );
+        CATCH_REQUIRE( inv.getChecksum() == checksum );
+
+        // Same contents in a different order match.
+        PlayerInventory other;
+        for( auto zone : { PlayerInventory::ZONE_JUNK, PlayerInventory::ZONE_SIDEBOARD,
+                           PlayerInventory::ZONE_MAIN, PlayerInventory::ZONE_AUTO } )
+        {
+            auto cards = inv.getCards( zone );
+            for( auto iter = cards.rbegin(); iter != cards.rend(); ++iter )
+            {
+                other.add( *iter, zone );
+            }
+        }
+        CATCH_REQUIRE( other.getChecksum() == checksum );
+
+        // Basic lands count.
+        other.adjustBasicLand( BASIC_LAND_ISLAND, PlayerInventory::ZONE_MAIN, 2 );
+        CATCH_REQUIRE( other.getChecksum() != checksum );
+        other.adjustBasicLand( BASIC_LAND_ISLAND, PlayerInventory::ZONE_MAIN, -2 );
+        CATCH_REQUIRE( other.getChecksum() == checksum );
+
+        inv.clear();
+        CATCH_REQUIRE( inv.getChecksum() == PlayerInventory().getChecksum() );
+    }
+
     CATCH_SECTION( "Clear" )
     {
         inv.clear();
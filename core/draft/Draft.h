@@ -9,6 +9,7 @@
 #include "DraftCardDispenser.h"
 #include "DraftConfigAdapter.h"
 #include "DraftConfig.pb.h"
+#include "GridHelper.h"
 
 
 template< typename TCardDescriptor = std::string >
@@ -143,6 +144,11 @@ public:
     bool isSealedRound() const;
     bool isGridRound() const;
 
+    // Grid helper for the current round, built from the round's grid
+    // dimensions when the draft is configured.  Not valid outside of
+    // grid rounds.
+    const GridHelper& getGridHelper() const;
+
     int getTicksRemaining( int chairIndex ) const;
     int getPackQueueSize( int chairIndex ) const;
 
@@ -155,6 +161,11 @@ public:
     // Get unselected cards in top pack for a chair.
     std::vector<TCardDescriptor> getTopPackUnselectedCards( int chairIndex ) const;
 
+    // Approximate memory held by the draft: its configuration, chairs, and
+    // every pack and card dealt so far.  Card descriptors count by their
+    // size only.  Dispensers are accounted for separately.
+    std::size_t getApproximateMemoryBytes() const;
+
 private:
 
     enum MessageType
@@ -237,6 +248,9 @@ private:
     const DraftConfigAdapter mDraftConfigAdapter;
     const DraftCardDispenserSharedPtrVector<TCardDescriptor> mCardDispensers;
 
+    // Grid helpers indexed by round; invalid for non-grid rounds.
+    std::vector<GridHelper> mGridHelpers;
+
     StateType                     mState;
     int                           mCurrentRound;
     bool                          mPostRoundTimerStarted;
@@ -247,6 +261,7 @@ private:
     std::vector<Observer*>        mObservers;
     std::queue<MessageSharedPtr>  mMessageQueue;
     uint32_t                      mNextPackId;
+    std::size_t                   mCardCount;
     bool                          mProcessingMessageQueue;
 
     std::shared_ptr<spdlog::logger> mLogger;
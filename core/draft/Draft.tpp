@@ -1,5 +1,4 @@
 #include <algorithm>
-#include "GridHelper.h"
 #include "StringUtil.h"
 
 //------------------------------------------------------------------------
@@ -19,6 +18,7 @@ Draft<C>::Draft( const proto::DraftConfig&                   draftConfig,
     mPostRoundTimerTicksRemaining( 0 ),
     mPublicActiveChair( nullptr ),
     mNextPackId( 0 ),
+    mCardCount( 0 ),
     mProcessingMessageQueue( false ),
     mLogger( loggingConfig.createLogger() )
 {
@@ -30,6 +30,26 @@ Draft<C>::Draft( const proto::DraftConfig&                   draftConfig,
         mState = STATE_ERROR;
     }
 
+    // Precompute grid slice tables for every grid round.
+    for( int r = 0; r < mDraftConfig.rounds_size(); ++r )
+    {
+        if( mDraftConfigAdapter.isGridRound( r ) )
+        {
+            const unsigned int rows = mDraftConfigAdapter.getGridRoundRowCount( r );
+            const unsigned int cols = mDraftConfigAdapter.getGridRoundColCount( r );
+            if( !GridHelper::isValidSize( rows, cols ) )
+            {
+                mLogger->error( "invalid grid size {}x{} in round {}!", rows, cols, r );
+                mState = STATE_ERROR;
+            }
+            mGridHelpers.push_back( GridHelper( rows, cols ) );
+        }
+        else
+        {
+            mGridHelpers.push_back( GridHelper( 0, 0 ) );
+        }
+    }
+
     // Create chairs.
     for( uint32_t i = 0; i < mDraftConfig.chair_count(); ++i )
     {
@@ -139,6 +159,16 @@ Draft<C>::isGridRound() const
 }
 
 
+template<typename C>
+const GridHelper&
+Draft<C>::getGridHelper() const
+{
+    static const GridHelper sInvalidGridHelper( 0, 0 );
+    if( (mCurrentRound < 0) || (mCurrentRound >= static_cast<int>( mGridHelpers.size() )) ) return sInvalidGridHelper;
+    return mGridHelpers[mCurrentRound];
+}
+
+
 template<typename C>
 void
 Draft<C>::tick()
@@ -199,6 +229,22 @@ Draft<C>::getTopPackUnselectedCards( int chairIndex ) const
 }
 
 
+template<typename C>
+std::size_t
+Draft<C>::getApproximateMemoryBytes() const
+{
+    // Each card is a shared allocation (card plus control block) held by
+    // its pack and, once selected, by a chair.
+    const std::size_t cardBytes = sizeof( Card ) + 2 * sizeof( void* ) + 2 * sizeof( CardSharedPtr );
+
+    return sizeof( *this ) +
+           mDraftConfig.ByteSize() +
+           mChairs.size() * sizeof( Chair ) +
+           mNextPackId * sizeof( Pack ) +
+           mCardCount * cardBytes;
+}
+
+
 template<typename C>
 void
 Draft<C>::processMessageQueue()
@@ -473,11 +519,15 @@ Draft<C>::processIndexedCardSelection( int chairIndex, uint32_t packId, const st
         return;
     }
 
-    // Convert selection indices vector to set.
-    GridHelper::IndexSet selectedIndicesSet( selectionIndices.begin(), selectionIndices.end() );
+    const GridHelper& gridHelper = getGridHelper();
 
-    // Build set of unavailable indices and vector of selected cards.
-    GridHelper::IndexSet unavailableIndices;
+    // Convert selection indices vector to a mask.  Out-of-range or
+    // repeated indices can never match a slice.
+    GridHelper::IndexMask selectionMask = 0;
+    const bool selectionIndicesValid = gridHelper.getIndexMask( selectionIndices, selectionMask );
+
+    // Build mask of unavailable indices and vector of selected cards.
+    GridHelper::IndexMask unavailableMask = 0;
     std::vector<CardSharedPtr> selectedCards;
     for( std::size_t i = 0; i < mPublicPack->getCardCount(); ++i )
     {
@@ -489,15 +539,14 @@ Draft<C>::processIndexedCardSelection( int chairIndex, uint32_t packId, const st
             return;
         }
 
-        if( card->isSelected() ) unavailableIndices.insert( i );
+        const GridHelper::IndexMask bit = GridHelper::IndexMask( 1 ) << i;
+        if( card->isSelected() ) unavailableMask |= bit;
 
-        if( selectedIndicesSet.count( i ) > 0 ) selectedCards.push_back( card );
+        if( selectionMask & bit ) selectedCards.push_back( card );
     }
 
-    GridHelper gridHelper;
-    auto availableSelectionsMap = gridHelper.getAvailableSelectionsMap( unavailableIndices );
-    auto iter = availableSelectionsMap.find( selectedIndicesSet );
-    if( iter == availableSelectionsMap.end() )
+    const int slice = selectionIndicesValid ? gridHelper.getSelectionSlice( selectionMask, unavailableMask ) : -1;
+    if( slice < 0 )
     {
         for( auto obs : mObservers ) 
         {
@@ -507,7 +556,7 @@ Draft<C>::processIndexedCardSelection( int chairIndex, uint32_t packId, const st
         return;
     }
 
-    mLogger->info( "valid grid selection: slice {}", iter->second );
+    mLogger->info( "valid grid selection: slice {}", slice );
 
     // Mark the cards as selected in the pack and create desc vector
     std::vector<C> selectedCardDescs;
@@ -799,6 +848,7 @@ Draft<C>::createPackFromDispensations( int                                     c
             {
                 CardSharedPtr c = std::make_shared<Card>( cardDesc );
                 pack->addCard( c );
+                mCardCount++;
             }
         }
     }
@@ -811,7 +861,7 @@ template<typename C>
 typename Draft<C>::PackSharedPtr
 Draft<C>::createGridPackFromDispenser( uint32_t cardDispenserIndex )
 {
-    const uint32_t GRID_CARD_COUNT = 9;
+    const uint32_t gridCardCount = getGridHelper().getIndexCount();
 
     PackSharedPtr pack = std::make_shared<Pack>( mNextPackId++ );
 
@@ -824,11 +874,12 @@ Draft<C>::createGridPackFromDispenser( uint32_t cardDispenserIndex )
     }
 
     // Generate cards for the grid.
-    const std::vector<C> cardDescs = mCardDispensers[cardDispenserIndex]->dispense( GRID_CARD_COUNT );
+    const std::vector<C> cardDescs = mCardDispensers[cardDispenserIndex]->dispense( gridCardCount );
     for( auto& cardDesc : cardDescs )
     {
         CardSharedPtr c = std::make_shared<Card>( cardDesc );
         pack->addCard( c );
+        mCardCount++;
     }
 
     return pack;
@@ -850,11 +901,13 @@ Draft<C>::isSelectionComplete()
 
     if( isGridRound() )
     {
-        // Grid rounds are incomplete if any chair has yet to select a card.
-        std::set<const Chair*> allChairs( mChairs.begin(), mChairs.end() );
-        std::set<const Chair*> selectedChairs;
+        // Grid rounds are incomplete if any chair has yet to select a card,
+        // unless every card in the grid has already been taken.
+        std::vector<bool> chairSelected( mChairs.size(), false );
+        std::size_t selectedChairCount = 0;
+        GridHelper::IndexMask unavailableMask = 0;
 
-        // Go through every card and add its owner to a set.
+        // Go through every card and mark its owner.
         for( std::size_t i = 0; i < mPublicPack->getCardCount(); ++i )
         {
             CardSharedPtr c = mPublicPack->getCard( i );
@@ -863,12 +916,19 @@ Draft<C>::isSelectionComplete()
                 const Chair* selectedChair = c->getSelectedChair();
                 if( selectedChair != nullptr )
                 {
-                    selectedChairs.insert( selectedChair );
+                    unavailableMask |= GridHelper::IndexMask( 1 ) << i;
+                    const int idx = selectedChair->getIndex();
+                    if( !chairSelected[idx] )
+                    {
+                        chairSelected[idx] = true;
+                        ++selectedChairCount;
+                    }
                 }
             }
         }
 
-        if( allChairs != selectedChairs ) return false;
+        if( (selectedChairCount < mChairs.size()) &&
+            !getGridHelper().getAvailableSlices( unavailableMask ).empty() ) return false;
     }
 
     return true;
@@ -11,6 +11,9 @@ class DraftCardDispenser
 public:
     virtual std::vector<TCardDescriptor> dispense( unsigned int qty ) = 0;
     virtual std::vector<TCardDescriptor> dispenseAll() = 0;
+
+    // Approximate memory held by the dispenser, for room accounting.
+    virtual std::size_t getApproximateMemoryBytes() const { return 0; }
 };
 
 //
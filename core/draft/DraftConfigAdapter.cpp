@@ -71,3 +71,17 @@ DraftConfigAdapter::getGridRoundSelectionTime( unsigned int round,
 }
 
 
+unsigned int
+DraftConfigAdapter::getGridRoundRowCount( unsigned int round ) const
+{
+    if( !isGridRound( round ) ) return 0;
+    return mDraftConfig.rounds( round ).grid_round().rows();
+}
+
+
+unsigned int
+DraftConfigAdapter::getGridRoundColCount( unsigned int round ) const
+{
+    if( !isGridRound( round ) ) return 0;
+    return mDraftConfig.rounds( round ).grid_round().cols();
+}
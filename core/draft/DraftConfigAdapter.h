@@ -23,6 +23,10 @@ public:
     unsigned int getGridRoundSelectionTime( unsigned int round,
                                             unsigned int defaultVal = 0 ) const;
 
+    // Grid dimensions.  Returns zero for non-grid rounds.
+    unsigned int getGridRoundRowCount( unsigned int round ) const;
+    unsigned int getGridRoundColCount( unsigned int round ) const;
+
 private:
     const proto::DraftConfig& mDraftConfig;
 };
@@ -1,35 +1,113 @@
 #include "GridHelper.h"
 
-#include <vector>
-#include <algorithm>
-#include <iterator>
-
-static std::vector< GridHelper::IndexSet > sGridSlices = { { 0, 1, 2 }, // row 0
-                                                           { 3, 4, 5 }, // row 1
-                                                           { 6, 7, 8 }, // row 2
-                                                           { 0, 3, 6 }, // col 0
-                                                           { 1, 4, 7 }, // col 1
-                                                           { 2, 5, 8 }  // col 2
-                                                         };
+const unsigned int GridHelper::DEFAULT_ROW_COUNT;
+const unsigned int GridHelper::DEFAULT_COL_COUNT;
+const unsigned int GridHelper::MAX_INDEX_COUNT;
 
-std::map<GridHelper::IndexSet,unsigned int>
-GridHelper::getAvailableSelectionsMap( const IndexSet& unavailableIndices ) const
+
+GridHelper::GridHelper( unsigned int rowCount, unsigned int colCount )
+  : mRowCount( 0 ),
+    mColCount( 0 ),
+    mGridMask( 0 )
 {
-    std::map<IndexSet,unsigned int> selectionsMap;
+    if( !isValidSize( rowCount, colCount ) ) return;
 
-    for( unsigned int i = 0; i < sGridSlices.size(); ++i )
-    {
-        // Selection is valid if it contains exactly all indices in a row that are available.
-        IndexSet indices;
-        std::set_difference( sGridSlices[i].begin(), sGridSlices[i].end(),
-                             unavailableIndices.begin(), unavailableIndices.end(),
-                             std::inserter( indices, indices.begin() ) );
+    mRowCount = rowCount;
+    mColCount = colCount;
 
-        if( !indices.empty() )
+    // Build the slice table: rows first, then columns.
+    mSliceMasks.resize( mRowCount + mColCount, 0 );
+    for( unsigned int row = 0; row < mRowCount; ++row )
+    {
+        for( unsigned int col = 0; col < mColCount; ++col )
         {
-            selectionsMap.insert( std::make_pair( indices, i ) );
+            const IndexMask bit = IndexMask( 1 ) << (row * mColCount + col);
+            mSliceMasks[getRowSlice( row )] |= bit;
+            mSliceMasks[getColSlice( col )] |= bit;
+            mGridMask |= bit;
         }
     }
+}
+
+
+bool
+GridHelper::isValidSize( unsigned int rowCount, unsigned int colCount )
+{
+    return (rowCount > 0) && (colCount > 0) &&
+           (rowCount <= MAX_INDEX_COUNT) && (colCount <= MAX_INDEX_COUNT) &&
+           (rowCount * colCount <= MAX_INDEX_COUNT);
+}
+
+
+bool
+GridHelper::getIndexMask( const std::vector<int>& indices, IndexMask& mask ) const
+{
+    mask = 0;
+    for( int i : indices )
+    {
+        if( (i < 0) || (static_cast<unsigned int>( i ) >= getIndexCount()) ) return false;
+
+        const IndexMask bit = IndexMask( 1 ) << i;
+        if( mask & bit ) return false;
+        mask |= bit;
+    }
+    return true;
+}
+
+
+std::vector<int>
+GridHelper::getIndices( IndexMask mask )
+{
+    std::vector<int> indices;
+    for( int i = 0; mask != 0; ++i, mask >>= 1 )
+    {
+        if( mask & 1 ) indices.push_back( i );
+    }
+    return indices;
+}
+
+
+int
+GridHelper::getSelectionSlice( IndexMask selectionMask, IndexMask unavailableMask ) const
+{
+    if( selectionMask == 0 ) return -1;
+
+    // Selection is valid if it contains exactly all indices in a slice that are available.
+    for( unsigned int i = 0; i < mSliceMasks.size(); ++i )
+    {
+        if( (mSliceMasks[i] & ~unavailableMask) == selectionMask ) return i;
+    }
+    return -1;
+}
+
+
+std::vector<unsigned int>
+GridHelper::getAvailableSlices( IndexMask unavailableMask ) const
+{
+    std::vector<unsigned int> slices;
+    for( unsigned int i = 0; i < mSliceMasks.size(); ++i )
+    {
+        if( mSliceMasks[i] & ~unavailableMask ) slices.push_back( i );
+    }
+    return slices;
+}
+
+
+std::map<GridHelper::IndexSet,unsigned int>
+GridHelper::getAvailableSelectionsMap( const IndexSet& unavailableIndices ) const
+{
+    IndexMask unavailableMask = 0;
+    for( unsigned int i : unavailableIndices )
+    {
+        if( i < MAX_INDEX_COUNT ) unavailableMask |= IndexMask( 1 ) << i;
+    }
+
+    std::map<IndexSet,unsigned int> selectionsMap;
+    for( unsigned int slice : getAvailableSlices( unavailableMask ) )
+    {
+        const std::vector<int> indices = getIndices( mSliceMasks[slice] & ~unavailableMask );
+        selectionsMap.insert( std::make_pair( IndexSet( indices.begin(), indices.end() ), slice ) );
+    }
 
     return selectionsMap;
 }
@@ -3,31 +3,73 @@
 
 #include <set>
 #include <map>
+#include <vector>
+#include <cstdint>
 
-class GridHelper 
+// Helper for grid rounds.  Cards in a grid are indexed row-major, and a
+// "slice" is a single index to specify rows and columns: rows come first,
+// then columns.  Every slice is precomputed as a bitmask of card indices
+// at construction so availability checks are just mask operations.
+class GridHelper
 {
 public:
 
     typedef std::set<unsigned int> IndexSet;
+    typedef uint64_t               IndexMask;
 
-    const unsigned int ROW_COUNT = 3;
-    const unsigned int COL_COUNT = 3;
+    static const unsigned int DEFAULT_ROW_COUNT = 3;
+    static const unsigned int DEFAULT_COL_COUNT = 3;
 
-    GridHelper() {}
+    // Grids must fit within a mask.
+    static const unsigned int MAX_INDEX_COUNT = 64;
+
+    GridHelper( unsigned int rowCount = DEFAULT_ROW_COUNT,
+                unsigned int colCount = DEFAULT_COL_COUNT );
+
+    // Returns true if the dimensions describe a usable grid.  An invalid
+    // helper has no slices.
+    static bool isValidSize( unsigned int rowCount, unsigned int colCount );
+    bool isValid() const { return !mSliceMasks.empty(); }
+
+    unsigned int getRowCount() const { return mRowCount; }
+    unsigned int getColCount() const { return mColCount; }
 
-    // A "slice" is a single index to specify rows and columns.
     unsigned int getRowSlice( unsigned int row ) const { return row; }
-    unsigned int getColSlice( unsigned int col ) const { return col + ROW_COUNT; }
-    unsigned int getSliceCount() const { return ROW_COUNT + COL_COUNT; }
-    bool isSliceRow( unsigned int slice ) const { return slice < ROW_COUNT; }
-    bool isSliceCol( unsigned int slice ) const { return (slice >= ROW_COUNT) && (slice < ROW_COUNT + COL_COUNT); }
-    unsigned int getIndexCount() const { return ROW_COUNT * COL_COUNT; }
+    unsigned int getColSlice( unsigned int col ) const { return col + mRowCount; }
+    unsigned int getSliceCount() const { return mSliceMasks.size(); }
+    bool isSliceRow( unsigned int slice ) const { return slice < mRowCount; }
+    bool isSliceCol( unsigned int slice ) const { return (slice >= mRowCount) && (slice < getSliceCount()); }
+    unsigned int getIndexCount() const { return mRowCount * mColCount; }
+
+    // Mask of all indices in a slice, or zero if the slice is out of range.
+    IndexMask getSliceMask( unsigned int slice ) const { return (slice < mSliceMasks.size()) ? mSliceMasks[slice] : 0; }
+
+    // Mask of all indices in the grid.
+    IndexMask getGridMask() const { return mGridMask; }
+
+    // Convert indices to a mask.  Returns false if any index is outside
+    // the grid or repeated.
+    bool getIndexMask( const std::vector<int>& indices, IndexMask& mask /* output */ ) const;
+
+    // Indices set in a mask, in ascending order.
+    static std::vector<int> getIndices( IndexMask mask );
+
+    // Get the slice matching a selection, i.e. the slice whose available
+    // indices are exactly the selection.  Returns -1 if there is none.
+    int getSelectionSlice( IndexMask selectionMask, IndexMask unavailableMask ) const;
+
+    // Get slices that still have at least one available index.
+    std::vector<unsigned int> getAvailableSlices( IndexMask unavailableMask ) const;
 
     // Get all available selections in the grid, mapped to the slice index to which it corresponds.
     std::map<IndexSet,unsigned int> getAvailableSelectionsMap( const IndexSet& unavailableIndices ) const;
 
 private:
 
+    unsigned int           mRowCount;
+    unsigned int           mColCount;
+    IndexMask              mGridMask;
+    std::vector<IndexMask> mSliceMasks;
 };
 
 #endif
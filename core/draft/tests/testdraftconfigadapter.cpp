@@ -69,8 +69,13 @@ CATCH_TEST_CASE( "Draft config adapter: simple grid", "[draft][draftconfigadapte
         // should return default values for non-booster
         CATCH_REQUIRE( adapter.getBoosterRoundSelectionTime( r ) == 0 );
         CATCH_REQUIRE( adapter.getBoosterRoundPassDirection( r ) == proto::DraftConfig::DIRECTION_CLOCKWISE );
+
+        // grid dimensions default to 3x3
+        CATCH_REQUIRE( adapter.getGridRoundRowCount( r ) == 3 );
+        CATCH_REQUIRE( adapter.getGridRoundColCount( r ) == 3 );
     }
 
     // past-the-end check
     CATCH_REQUIRE_FALSE( adapter.isGridRound( dc.rounds_size() ) );
+    CATCH_REQUIRE( adapter.getGridRoundRowCount( dc.rounds_size() ) == 0 );
 }
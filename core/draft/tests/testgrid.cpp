@@ -279,3 +279,54 @@ CATCH_TEST_CASE( "Grid draft", "[draft][grid]" )
         }
     }
 }
+
+
+CATCH_TEST_CASE( "Grid draft - non-square grid", "[draft][grid]" )
+{
+    DraftConfig dc = TestDefaults::getSimpleGridDraftConfig( 1 );
+    dc.mutable_rounds( 0 )->mutable_grid_round()->set_rows( 4 );
+    dc.mutable_rounds( 0 )->mutable_grid_round()->set_cols( 5 );
+    auto dispensers = TestDefaults::getDispensers( 1 );
+    Draft<> d( dc, dispensers, getLoggingConfig() );
+
+    GridTestDraftObserver obs;
+    d.addObserver( &obs );
+
+    d.start();
+
+    CATCH_REQUIRE( d.getGridHelper().getIndexCount() == 20 );
+    CATCH_REQUIRE( obs.mCardStates.size() == 20 );
+
+    std::vector<int> picks;
+
+    // 3x3 slices are not valid here.
+    picks = { 0, 1, 2 };
+    d.makeIndexedCardSelection( 0, obs.mPackId, picks );
+    CATCH_REQUIRE( obs.mPublicSelectionErrors == 1 );
+
+    picks = { 5, 6, 7, 8, 9 }; // player0: row1
+    d.makeIndexedCardSelection( 0, obs.mPackId, picks );
+    CATCH_REQUIRE( obs.mPublicSelectionErrors == 1 );
+
+    picks = { 4, 9, 14, 19 }; // player1: overlaps row1
+    d.makeIndexedCardSelection( 1, obs.mPackId, picks );
+    CATCH_REQUIRE( obs.mPublicSelectionErrors == 2 );
+
+    picks = { 4, 14, 19 }; // player1: col4
+    d.makeIndexedCardSelection( 1, obs.mPackId, picks );
+    CATCH_REQUIRE( obs.mPublicSelectionErrors == 2 );
+
+    CATCH_REQUIRE( d.getState() == Draft<>::STATE_COMPLETE );
+}
+
+
+CATCH_TEST_CASE( "Grid draft - invalid grid size", "[draft][grid]" )
+{
+    DraftConfig dc = TestDefaults::getSimpleGridDraftConfig( 1 );
+    dc.mutable_rounds( 0 )->mutable_grid_round()->set_rows( 10 );
+    dc.mutable_rounds( 0 )->mutable_grid_round()->set_cols( 10 );
+    auto dispensers = TestDefaults::getDispensers( 1 );
+    Draft<> d( dc, dispensers, getLoggingConfig() );
+
+    CATCH_REQUIRE( d.getState() == Draft<>::STATE_ERROR );
+}
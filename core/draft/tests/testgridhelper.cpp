@@ -133,3 +133,72 @@ CATCH_TEST_CASE( "Grid Helper - available selections with slices unavailable", "
     }
 }
 
+
+CATCH_TEST_CASE( "Grid Helper - sizes", "[draft][gridhelper]" )
+{
+    CATCH_REQUIRE( GridHelper::isValidSize( 3, 3 ) );
+    CATCH_REQUIRE( GridHelper::isValidSize( 8, 8 ) );
+    CATCH_REQUIRE( GridHelper::isValidSize( 1, 64 ) );
+    CATCH_REQUIRE_FALSE( GridHelper::isValidSize( 0, 3 ) );
+    CATCH_REQUIRE_FALSE( GridHelper::isValidSize( 3, 0 ) );
+    CATCH_REQUIRE_FALSE( GridHelper::isValidSize( 5, 13 ) );
+
+    GridHelper invalid( 9, 9 );
+    CATCH_REQUIRE_FALSE( invalid.isValid() );
+    CATCH_REQUIRE( invalid.getSliceCount() == 0 );
+    CATCH_REQUIRE( invalid.getAvailableSlices( 0 ).empty() );
+    CATCH_REQUIRE( invalid.getSelectionSlice( 1, 0 ) == -1 );
+}
+
+
+CATCH_TEST_CASE( "Grid Helper - 3x5 grid", "[draft][gridhelper]" )
+{
+    GridHelper gh( 3, 5 );
+
+    CATCH_REQUIRE( gh.isValid() );
+    CATCH_REQUIRE( gh.getIndexCount() == 15 );
+    CATCH_REQUIRE( gh.getSliceCount() == 8 );
+    CATCH_REQUIRE( gh.isSliceRow( 2 ) );
+    CATCH_REQUIRE( gh.isSliceCol( 3 ) );
+    CATCH_REQUIRE( gh.isSliceCol( 7 ) );
+    CATCH_REQUIRE_FALSE( gh.isSliceCol( 8 ) );
+    CATCH_REQUIRE( gh.getGridMask() == 0x7fff );
+
+    CATCH_REQUIRE( GridHelper::getIndices( gh.getSliceMask( gh.getRowSlice( 1 ) ) ) == std::vector<int>( { 5, 6, 7, 8, 9 } ) );
+    CATCH_REQUIRE( GridHelper::getIndices( gh.getSliceMask( gh.getColSlice( 4 ) ) ) == std::vector<int>( { 4, 9, 14 } ) );
+
+    GridHelper::IndexMask selection;
+    CATCH_REQUIRE( gh.getIndexMask( { 4, 9, 14 }, selection ) );
+    CATCH_REQUIRE( gh.getSelectionSlice( selection, 0 ) == 7 );
+    CATCH_REQUIRE_FALSE( gh.getIndexMask( { 4, 9, 15 }, selection ) );
+    CATCH_REQUIRE_FALSE( gh.getIndexMask( { 4, 4 }, selection ) );
+    CATCH_REQUIRE_FALSE( gh.getIndexMask( { -1 }, selection ) );
+
+    // With row 1 taken, column 4 is only selectable without index 9.
+    GridHelper::IndexMask unavailable = gh.getSliceMask( gh.getRowSlice( 1 ) );
+    CATCH_REQUIRE( gh.getIndexMask( { 4, 14 }, selection ) );
+    CATCH_REQUIRE( gh.getSelectionSlice( selection, unavailable ) == 7 );
+    CATCH_REQUIRE( gh.getIndexMask( { 4, 9, 14 }, selection ) );
+    CATCH_REQUIRE( gh.getSelectionSlice( selection, unavailable ) == -1 );
+    CATCH_REQUIRE( gh.getAvailableSlices( unavailable ) == std::vector<unsigned int>( { 0, 2, 3, 4, 5, 6, 7 } ) );
+    CATCH_REQUIRE( gh.getAvailableSlices( gh.getGridMask() ).empty() );
+}
+
+
+CATCH_TEST_CASE( "Grid Helper - 4x4 grid selections map", "[draft][gridhelper]" )
+{
+    GridHelper gh( 4, 4 );
+
+    const std::map<GridHelper::IndexSet,unsigned int> expected = { {  { 4, 5, 6, 7 },    1 },
+                                                                   {  { 8, 9, 10, 11 },  2 },
+                                                                   { { 12, 13, 14, 15 }, 3 },
+                                                                   {     { 4, 8, 12 },   4 },
+                                                                   {     { 5, 9, 13 },   5 },
+                                                                   {    { 6, 10, 14 },   6 },
+                                                                   {    { 7, 11, 15 },   7 },
+                                                                 };
+
+    auto availableSelectionsMap = gh.getAvailableSelectionsMap( { 0, 1, 2, 3 } );
+
+    CATCH_REQUIRE( availableSelectionsMap == expected );
+}
@@ -314,3 +314,23 @@ CATCH_TEST_CASE( "Booster draft with varying dispensation qty", "[draft][misc]"
     }
 }
 
+
+
+CATCH_TEST_CASE( "Draft memory accounting", "[draft][misc]" )
+{
+    DraftConfig dc = TestDefaults::getSimpleBoosterDraftConfig( 3, 8, 60 );
+    auto dispensers = TestDefaults::getDispensers();
+    Draft<> d( dc, dispensers );
+
+    // Grows as packs are dealt for each round.
+    const std::size_t initialBytes = d.getApproximateMemoryBytes();
+    CATCH_REQUIRE( initialBytes > 0 );
+
+    d.start();
+    const std::size_t firstRoundBytes = d.getApproximateMemoryBytes();
+    CATCH_REQUIRE( firstRoundBytes > initialBytes );
+
+    // Stable while nothing is dealt.
+    d.tick();
+    CATCH_REQUIRE( d.getApproximateMemoryBytes() == firstRoundBytes );
+}
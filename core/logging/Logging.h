@@ -1,18 +1,80 @@
 #ifndef LOGGING_H
 #define LOGGING_H
 
+#include <map>
+#include <mutex>
+
 #include "spdlog/spdlog.h"
+#include "spdlog/async_logger.h"
 #include "spdlog/sinks/null_sink.h"
 
 namespace Logging
 {
+    // Returns the process-wide null logger.  Its level is 'off' so log
+    // calls against it return before any message formatting takes place.
     inline std::shared_ptr<spdlog::logger> createNullLogger()
     {
-        auto sink = std::make_shared<spdlog::sinks::null_sink_st>();
-        auto logger = std::make_shared<spdlog::logger>( "", sink );
-        return logger;
+        static std::shared_ptr<spdlog::logger> sNullLogger;
+        static std::once_flag sOnceFlag;
+        std::call_once( sOnceFlag, [] {
+                auto sink = std::make_shared<spdlog::sinks::null_sink_st>();
+                sNullLogger = std::make_shared<spdlog::logger>( "", sink );
+                sNullLogger->set_level( spdlog::level::off );
+            } );
+        return sNullLogger;
     }
 
+    // An async logger that owns the real sinks and a single writer thread.
+    // Frontend loggers hand their raw messages to this queue; formatting
+    // and I/O happen on the writer thread.
+    class AsyncBackend : public spdlog::async_logger
+    {
+    public:
+        AsyncBackend( const std::vector<spdlog::sink_ptr>& sinks, size_t queueSize )
+          : spdlog::async_logger( "", sinks.begin(), sinks.end(), queueSize ) {}
+
+        void dispatch( spdlog::details::log_msg& msg ) { _log_msg( msg ); }
+    };
+
+    // A lightweight named logger with no sinks of its own.  Messages
+    // that pass the level check are forwarded unformatted to a shared
+    // AsyncBackend.
+    class AsyncFrontendLogger : public spdlog::logger
+    {
+    public:
+        AsyncFrontendLogger( const std::string& name, const std::shared_ptr<AsyncBackend>& backend )
+          : spdlog::logger( name, spdlog::sinks_init_list() ),
+            mBackend( backend )
+        {}
+
+        virtual void flush() override { mBackend->flush(); }
+
+    protected:
+        virtual void _log_msg( spdlog::details::log_msg& msg ) override { mBackend->dispatch( msg ); }
+
+    private:
+        const std::shared_ptr<AsyncBackend> mBackend;
+    };
+
+    // Shared state behind Config::createLogger().  Sinks and async
+    // backends live for the life of the process; loggers are held weakly
+    // so that identically-configured objects share a single instance
+    // without the registry keeping per-object loggers alive.
+    struct Registry
+    {
+        std::mutex                                          mutex;
+        std::map<std::string,spdlog::sink_ptr>              sinkMap;
+        std::map<std::string,std::shared_ptr<AsyncBackend>> backendMap;
+        std::map<std::string,std::weak_ptr<spdlog::logger>> loggerMap;
+        unsigned int                                        loggersCreatedSincePrune = 0;
+
+        static Registry& instance()
+        {
+            static Registry sRegistry;
+            return sRegistry;
+        }
+    };
+
     class Config
     {
     public:
@@ -26,6 +88,7 @@ namespace Logging
             mRotatingFileSizeLimit( 0 ),
             mRotatingFileCount( 0 ),
             mAppendThisAddr( false ),
+            mAsyncQueueSize( 0 ),
             mLevel( spdlog::level::off )
         {}
 
@@ -49,37 +112,56 @@ namespace Logging
 
         void setAppendThisAddr( bool enabled ) { mAppendThisAddr = enabled; }
 
-        // create a logger that complies with this policy
-        // return a null logger if no logger needed
+        // Route output through a bounded queue serviced by a writer thread.
+        // The queue size must be a power of two; 0 disables async logging.
+        void setAsyncLogging( size_t queueSize ) { mAsyncQueueSize = queueSize; }
+
+        // Returns a logger that complies with this policy.  Loggers are
+        // shared between configs with identical names and policies, so
+        // this is cheap to call per-object.  Returns a null logger if no
+        // logger needed.
         std::shared_ptr<spdlog::logger> createLogger() const
         {
-            if( !mStdoutLogging && mSimpleFileName.empty() && mRotatingFileBaseName.empty() )
+            if( (mLevel == spdlog::level::off) ||
+                (!mStdoutLogging && mSimpleFileName.empty() && mRotatingFileBaseName.empty()) )
             {
                 return createNullLogger();
             }
-            else
+
+            Registry& registry = Registry::instance();
+            std::lock_guard<std::mutex> lock( registry.mutex );
+
+            const std::string sinksKey = getSinksKey();
+            const std::string loggerKey = mName + '\n' + std::to_string( mLevel ) + '\n' + sinksKey;
+            auto iter = registry.loggerMap.find( loggerKey );
+            if( iter != registry.loggerMap.end() )
             {
-                std::vector<spdlog::sink_ptr> sinks;
-                if( mStdoutLogging )
-                {
-                    sinks.push_back( std::make_shared<spdlog::sinks::stdout_sink_st>() );
-                }
-                if( !mSimpleFileName.empty() )
-                {
-                    sinks.push_back( getSimpleFileSink( mSimpleFileName ) );
-                }
-                if( !mRotatingFileBaseName.empty() )
+                std::shared_ptr<spdlog::logger> logger = iter->second.lock();
+                if( logger ) return logger;
+            }
+
+            std::shared_ptr<spdlog::logger> logger;
+            if( mAsyncQueueSize > 0 )
+            {
+                std::shared_ptr<AsyncBackend>& backend = registry.backendMap[sinksKey];
+                if( !backend )
                 {
-                    sinks.push_back( getRotatingFileSink(
-                            mRotatingFileBaseName, mRotatingFileExtension,
-                            mRotatingFileSizeLimit, mRotatingFileCount ) );
+                    backend = std::make_shared<AsyncBackend>( getSinks( registry ), mAsyncQueueSize );
+                    backend->set_pattern( "[%L %n] %v" );
                 }
-                auto logger = std::make_shared<spdlog::logger>( mName, begin(sinks), end(sinks) );
-                logger->set_level( mLevel );
+                logger = std::make_shared<AsyncFrontendLogger>( mName, backend );
+            }
+            else
+            {
+                std::vector<spdlog::sink_ptr> sinks = getSinks( registry );
+                logger = std::make_shared<spdlog::logger>( mName, begin(sinks), end(sinks) );
                 logger->set_pattern( "[%L %n] %v" );
-                return logger;
             }
+            logger->set_level( mLevel );
 
+            registry.loggerMap[loggerKey] = logger;
+            pruneExpiredLoggers( registry );
+            return logger;
         }
 
         // copies config but adds child name to this name
@@ -92,29 +174,71 @@ namespace Logging
 
     private:
 
-        static spdlog::sink_ptr getSimpleFileSink( const std::string& fileName )
+        // Identifies the set of sinks (and threading model) this config writes to.
+        std::string getSinksKey() const
+        {
+            return std::string( mAsyncQueueSize > 0 ? "async" : "sync" ) + '\n' +
+                   (mStdoutLogging ? "stdout" : "") + '\n' +
+                   mSimpleFileName + '\n' + mRotatingFileBaseName;
+        }
+
+        // Must be called with the registry mutex held.
+        std::vector<spdlog::sink_ptr> getSinks( Registry& registry ) const
         {
-            static std::map<std::string,spdlog::sink_ptr> sinkMap;
-            if( sinkMap.count( fileName ) == 0 )
+            // Async sinks are only written by a backend's writer thread but
+            // may be shared by several backends, so they get the _mt variants.
+            const bool mt = (mAsyncQueueSize > 0);
+            const std::string prefix = mt ? "mt:" : "st:";
+
+            std::vector<spdlog::sink_ptr> sinks;
+            if( mStdoutLogging )
             {
-                sinkMap[fileName] = std::make_shared<spdlog::sinks::simple_file_sink_st>(
-                        fileName, true );
+                spdlog::sink_ptr& sink = registry.sinkMap[prefix + "stdout"];
+                if( !sink )
+                {
+                    if( mt ) sink = std::make_shared<spdlog::sinks::stdout_sink_mt>();
+                    else     sink = std::make_shared<spdlog::sinks::stdout_sink_st>();
+                }
+                sinks.push_back( sink );
+            }
+            if( !mSimpleFileName.empty() )
+            {
+                spdlog::sink_ptr& sink = registry.sinkMap[prefix + "file:" + mSimpleFileName];
+                if( !sink )
+                {
+                    if( mt ) sink = std::make_shared<spdlog::sinks::simple_file_sink_mt>( mSimpleFileName, true );
+                    else     sink = std::make_shared<spdlog::sinks::simple_file_sink_st>( mSimpleFileName, true );
+                }
+                sinks.push_back( sink );
+            }
+            if( !mRotatingFileBaseName.empty() )
+            {
+                spdlog::sink_ptr& sink = registry.sinkMap[prefix + "rotating:" + mRotatingFileBaseName];
+                if( !sink )
+                {
+                    if( mt ) sink = std::make_shared<spdlog::sinks::rotating_file_sink_mt>(
+                            mRotatingFileBaseName, mRotatingFileExtension,
+                            mRotatingFileSizeLimit, mRotatingFileCount, true );
+                    else     sink = std::make_shared<spdlog::sinks::rotating_file_sink_st>(
+                            mRotatingFileBaseName, mRotatingFileExtension,
+                            mRotatingFileSizeLimit, mRotatingFileCount, true );
+                }
+                sinks.push_back( sink );
             }
-            return sinkMap[fileName];
+            return sinks;
         }
 
-        static spdlog::sink_ptr getRotatingFileSink( const std::string& fileBaseName,
-                                                     const std::string& fileExtension,
-                                                     unsigned int       fileSizeLimit,
-                                                     unsigned int       fileCount )
+        // Must be called with the registry mutex held.  Amortizes the
+        // cost of dropping map entries for loggers no longer in use.
+        static void pruneExpiredLoggers( Registry& registry )
         {
-            static std::map<std::string,spdlog::sink_ptr> sinkMap;
-            if( sinkMap.count( fileBaseName ) == 0 )
+            if( ++registry.loggersCreatedSincePrune < 64 ) return;
+            registry.loggersCreatedSincePrune = 0;
+            for( auto iter = registry.loggerMap.begin(); iter != registry.loggerMap.end(); )
             {
-                sinkMap[fileBaseName] = std::make_shared<spdlog::sinks::rotating_file_sink_st>(
-                        fileBaseName, fileExtension, fileSizeLimit, fileCount, true );
+                if( iter->second.expired() ) iter = registry.loggerMap.erase( iter );
+                else ++iter;
             }
-            return sinkMap[fileBaseName];
         }
 
         std::string mName;
@@ -125,6 +249,7 @@ namespace Logging
         unsigned int mRotatingFileSizeLimit;
         unsigned int mRotatingFileCount;
         bool mAppendThisAddr;
+        size_t mAsyncQueueSize;
         spdlog::level::level_enum mLevel;
     };
 
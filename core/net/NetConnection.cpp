@@ -1,8 +1,13 @@
 #include "NetConnection.h"
 #include <QDataStream>
 #include <QTimer>
+#include <QtEndian>
 #include "qtutils_core.h"
 
+// Default limit on received messages.  Well above anything the protocol
+// sends, but keeps a hostile peer from exhausting memory.
+static const int DEFAULT_MAX_RX_MSG_SIZE = 32 * 1024 * 1024;
+
 
 NetConnection::NetConnection( const Logging::Config &loggingConfig, QObject* parent )
     : QTcpSocket( parent ),
@@ -10,6 +15,7 @@ NetConnection::NetConnection( const Logging::Config &loggingConfig, QObject* par
       mRxInactivityAbortTimeMillis( 0 ),
       mCompressionMode( COMPRESSION_MODE_AUTO ),
       mHeaderMode( HEADER_MODE_AUTO ),
+      mMaxRxMsgSize( DEFAULT_MAX_RX_MSG_SIZE ),
       mIncomingMsgHeader( 0 ),
       mExtendedLength( 0 ),
       mBytesSent( 0 ),
@@ -17,12 +23,24 @@ NetConnection::NetConnection( const Logging::Config &loggingConfig, QObject* par
 {
     QObject::connect(this, SIGNAL(readyRead()), this, SLOT(handleReadyRead()));
 
+    // Compression streams only live as long as a connection; the socket
+    // may be reused.
+    QObject::connect( this, &QAbstractSocket::stateChanged, this,
+        [this]( QAbstractSocket::SocketState socketState ) {
+            if( socketState == QAbstractSocket::UnconnectedState )
+            {
+                mTxStream.reset();
+                mRxStream.reset();
+            }
+        } );
+
     // Init and start abort connection timer.
     mRxInactivityAbortTimer = new QTimer( this );
     connect( mRxInactivityAbortTimer, &QTimer::timeout,
              this,                    &NetConnection::handleRxInactivityAbortTimerTimeout );
     mRxInactivityAbortTimer->setSingleShot( true );
     restartRxInactivityAbortTimer();
+    mSinceRx.start();
 }
 
 
@@ -34,17 +52,57 @@ NetConnection::setRxInactivityAbortTime( int inactivityMillis )
 }
 
 
+void
+NetConnection::enableTxStreamCompression()
+{
+    if( !mTxStream )
+    {
+        mLogger->debug( "enabling tx stream compression" );
+        mTxStream.reset( new NetStreamDeflater() );
+    }
+}
+
+
+void
+NetConnection::enableRxStreamCompression()
+{
+    if( !mRxStream )
+    {
+        mLogger->debug( "enabling rx stream compression" );
+        mRxStream.reset( new NetStreamInflater() );
+    }
+}
+
+
 bool
 NetConnection::sendMsg( const QByteArray& byteArray )
 {
-    mLogger->trace( "sendmsg: [{}] {}", byteArray.size(), hexStringify( byteArray, 10 ) );
+    // Level checks guard the hex dumps so they cost nothing when disabled.
+    const bool traceEnabled = mLogger->should_log( spdlog::level::trace );
+    if( traceEnabled )
+    {
+        mLogger->trace( "sendmsg: [{}] {}", byteArray.size(), hexStringify( byteArray, 10 ) );
+    }
 
     // 16-bit header: 1 bit compression flag, 1 bit extended flag, 14 bits size.
     quint16 header = 0x0000;
     const QByteArray* payloadMsgByteArrayPtr;
 
     QByteArray compressedMsgByteArray;
-    if( mCompressionMode == COMPRESSION_MODE_UNCOMPRESSED )
+    if( mTxStream && !byteArray.isEmpty() )
+    {
+        if( !mTxStream->deflate( byteArray, compressedMsgByteArray ) )
+        {
+            mLogger->error( "stream compression failed, aborting connection" );
+            abort();
+            return false;
+        }
+        mLogger->debug( "stream compressed {} bytes to {} bytes",
+                byteArray.size(), compressedMsgByteArray.size() );
+        header |= 0x8000;
+        payloadMsgByteArrayPtr = &compressedMsgByteArray;
+    }
+    else if( mTxStream || (mCompressionMode == COMPRESSION_MODE_UNCOMPRESSED) )
     {
         payloadMsgByteArrayPtr = &byteArray;
     }
@@ -80,6 +138,9 @@ NetConnection::sendMsg( const QByteArray& byteArray )
     if( (mHeaderMode == HEADER_MODE_BRIEF) && (payloadSize > 0x3FFF) )
     {
         mLogger->error( "payload too large ({} bytes) to send!", payloadSize );
+
+        // The peer will never see what the compressor has already taken in.
+        if( mTxStream && (header & 0x8000) ) abort();
         return false;
     }
 
@@ -103,8 +164,11 @@ NetConnection::sendMsg( const QByteArray& byteArray )
     out << (quint16) header;
     if( extended ) out << (quint32) payloadSize;
     out.writeRawData( payloadMsgByteArrayPtr->data(), payloadSize );
-    mLogger->trace( "sendmsg: wrote [{}] {}", payloadMsgByteArrayPtr->size(),
-            hexStringify( *payloadMsgByteArrayPtr, 10 ) );
+    if( traceEnabled )
+    {
+        mLogger->trace( "sendmsg: wrote [{}] {}", payloadMsgByteArrayPtr->size(),
+                hexStringify( *payloadMsgByteArrayPtr, 10 ) );
+    }
 
     bool writeOk = write( block );
 
@@ -148,6 +212,13 @@ NetConnection::handleReadyRead()
         const quint32 msgSize = msgExtendedHeader ? mExtendedLength
                                                   : mIncomingMsgHeader & 0x3FFF;
 
+        if( msgSize > static_cast<quint32>( mMaxRxMsgSize ) )
+        {
+            mLogger->error( "message size {} over limit, aborting connection", msgSize );
+            abort();
+            return;
+        }
+
         if( bytesAvailable() < msgSize )
             return;
 
@@ -161,8 +232,31 @@ NetConnection::handleReadyRead()
         mIncomingMsgHeader = 0;
         mExtendedLength = 0;
 
-        if( msgCompressed )
+        if( msgCompressed && mRxStream )
         {
+            QByteArray inflatedMsgByteArray;
+            if( !mRxStream->inflate( msgByteArray, inflatedMsgByteArray, mMaxRxMsgSize ) )
+            {
+                mLogger->error( "stream decompression failed or over size limit, aborting connection" );
+                abort();
+                return;
+            }
+            mLogger->debug( "deserialized {} bytes, stream uncompressed to {} bytes",
+                    msgSize, inflatedMsgByteArray.size() );
+            msgByteArray = inflatedMsgByteArray;
+        }
+        else if( msgCompressed )
+        {
+            // qCompress data leads with its uncompressed size, and
+            // qUncompress allocates that much up front.
+            if( (msgByteArray.size() >= 4) &&
+                (qFromBigEndian<quint32>( reinterpret_cast<const uchar*>( msgByteArray.constData() ) ) >
+                        static_cast<quint32>( mMaxRxMsgSize )) )
+            {
+                mLogger->error( "uncompressed message size over limit, aborting connection" );
+                abort();
+                return;
+            }
             msgByteArray = qUncompress( msgByteArray );
             mLogger->debug( "deserialized {} bytes, uncompressed to {} bytes",
                     msgSize, msgByteArray.size() );
@@ -172,13 +266,17 @@ NetConnection::handleReadyRead()
             mLogger->debug( "deserialized {} bytes, not compressed", msgSize );
         }
 
-        mLogger->trace( "emit: [{}] {}", msgByteArray.size(),
-                hexStringify( msgByteArray, 10 ) );
+        if( mLogger->should_log( spdlog::level::trace ) )
+        {
+            mLogger->trace( "emit: [{}] {}", msgByteArray.size(),
+                    hexStringify( msgByteArray, 10 ) );
+        }
         emit msgReceived( msgByteArray );
     }
 
     // The other side is alive - reset monitoring timer.
     restartRxInactivityAbortTimer();
+    mSinceRx.restart();
 }
 
 
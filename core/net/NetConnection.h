@@ -1,8 +1,11 @@
 #ifndef NETCONNECTION_H
 #define NETCONNECTION_H
 
+#include <QElapsedTimer>
 #include <QTcpSocket>
+#include <memory>
 #include "Logging.h"
+#include "NetStreamCodec.h"
 
 QT_BEGIN_NAMESPACE
 class QTimer;
@@ -43,12 +46,29 @@ public:
     // Set header mode (for testing).  Default mode is HEADER_AUTO.
     void setHeaderMode( HeaderMode headerMode ) { mHeaderMode = headerMode; }
 
+    // Largest message accepted, before or after decompression.  Larger
+    // messages abort the connection.
+    void setMaxRxMsgSize( int maxRxMsgSize ) { mMaxRxMsgSize = maxRxMsgSize; }
+
+    // Enable stream compression (see NetStreamCodec) for sending or
+    // receiving.  Once enabled, every non-empty message in that direction
+    // is stream-compressed and the compression mode is ignored.  The
+    // receiving side must enable at exactly the message boundary where
+    // the sending side did, which the login exchange arranges.
+    void enableTxStreamCompression();
+    void enableRxStreamCompression();
+    bool isTxStreamCompressionEnabled() const { return mTxStream != nullptr; }
+    bool isRxStreamCompressionEnabled() const { return mRxStream != nullptr; }
+
     // Send message.  Returns true if message was sent entirely.
     bool sendMsg( const QByteArray& byteArray );
 
     uint64_t getBytesSent() const { return mBytesSent; }
     uint64_t getBytesReceived() const { return mBytesReceived; }
 
+    // Time since anything was last received.
+    qint64 getRxIdleMillis() const { return mSinceRx.elapsed(); }
+
 signals:
 
     void msgReceived( const QByteArray& byteArray );
@@ -71,9 +91,14 @@ private:
 
     QTimer* mRxInactivityAbortTimer;
     int mRxInactivityAbortTimeMillis;
+    QElapsedTimer mSinceRx;
 
     CompressionMode mCompressionMode;
     HeaderMode      mHeaderMode;
+    int             mMaxRxMsgSize;
+
+    std::unique_ptr<NetStreamDeflater> mTxStream;
+    std::unique_ptr<NetStreamInflater> mRxStream;
 
     quint16 mIncomingMsgHeader;
     quint32 mExtendedLength;
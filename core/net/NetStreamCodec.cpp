@@ -0,0 +1,166 @@
+#include "NetStreamCodec.h"
+
+#include <zlib.h>
+
+// Pre-shared dictionary.  It must be byte-identical on both ends, so it
+// is fixed here rather than derived from each side's card database
+// (which may differ in version).  The content is common card name
+// words and set codes; deflate reaches the end of the dictionary most
+// cheaply, so the most frequent strings come last.
+static const char NET_STREAM_DICTIONARY[] =
+    "Aether Ancestral Ancient Archangel Armor Assault Avatar Banisher Barrier "
+    "Behemoth Blast Blessing Blood Bolt Bond Bringer Call Captain Champion "
+    "Charm Chosen Cleric Command Crusader Cultist Curse Dawn Death Defender "
+    "Demon Desecration Destiny Devil Djinn Dragon Drake Dream Druid Duress "
+    "Eidolon Elder Elemental Elf Elixir Emissary Empyrial Eternal Exile Faith "
+    "Familiar Fiend Fire Flame Flight Forge Fury Gargoyle Geist Giant Glory "
+    "Goblin Golem Grace Griffin Growth Guardian Guide Harbinger Hatchling Hero "
+    "Horror Hound Hunter Hydra Inferno Initiate Insight Invoker Kavu Keeper "
+    "Knight Lancer Legion Lightning Lord Mage Master Merfolk Might Mind Monk "
+    "Mystic Nightmare Ogre Oracle Paladin Pegasus Phantom Phoenix Predator "
+    "Priest Prophet Rage Ranger Reclamation Revenant Rider Ritual Rogue Sage "
+    "Salvage Scout Seer Sentinel Serpent Shade Shaman Shield Skeleton Slayer "
+    "Soldier Sorcerer Specter Sphinx Spider Spirit Storm Strike Summoner "
+    "Survivor Sword Tempest Thopter Thrull Titan Tower Troll Vampire Vanguard "
+    "Vision Walker Wall Warrior Wizard Wolf Wraith Wurm Zombie "
+    "10E 2ED 3ED 4ED 5ED 6ED 7ED 8ED 9ED M10 M11 M12 M13 M14 M15 ORI "
+    "ALA ARB AVR BFZ BNG CON DGM DKA DTK EMN FRF GTC ISD JOU KLD KTK "
+    "LRW MBS MOR NPH OGW RTR ROE SHM SOI SOM THS WWK ZEN "
+    "INV PLS APC ODY TOR JUD ONS LGN SCG MRD DST 5DN CHK BOK SOK "
+    "RAV GPT DIS CSP TSP PLC FUT ICE ALL MIR VIS WTH TMP STH EXO USG ULG UDS "
+    "MMQ NMS PCY LEA LEB ARN ATQ LEG DRK FEM HML "
+    "Plains Island Swamp Mountain Forest "
+    " of the of  the ";
+
+static const uInt NET_STREAM_DICTIONARY_SIZE = sizeof( NET_STREAM_DICTIONARY ) - 1;
+
+static const char SYNC_FLUSH_TAIL[] = { '\x00', '\x00', '\xff', '\xff' };
+
+static const int STREAM_WINDOW_BITS = -15;  // raw deflate, 32K window
+static const int STREAM_MEM_LEVEL   = 8;
+static const int STREAM_CHUNK_SIZE  = 16 * 1024;
+
+
+NetStreamDeflater::NetStreamDeflater()
+  : mStream( new z_stream() ),
+    mOk( false )
+{
+    mStream->zalloc = Z_NULL;
+    mStream->zfree = Z_NULL;
+    mStream->opaque = Z_NULL;
+    if( deflateInit2( mStream, Z_DEFAULT_COMPRESSION, Z_DEFLATED,
+                      STREAM_WINDOW_BITS, STREAM_MEM_LEVEL, Z_DEFAULT_STRATEGY ) == Z_OK )
+    {
+        mOk = (deflateSetDictionary( mStream, (const Bytef*)NET_STREAM_DICTIONARY,
+                                     NET_STREAM_DICTIONARY_SIZE ) == Z_OK);
+    }
+}
+
+
+NetStreamDeflater::~NetStreamDeflater()
+{
+    deflateEnd( mStream );
+    delete mStream;
+}
+
+
+bool
+NetStreamDeflater::deflate( const QByteArray& in, QByteArray& out )
+{
+    if( !mOk ) return false;
+
+    // Nothing to flush; an empty message leaves the stream untouched.
+    out.clear();
+    if( in.isEmpty() ) return true;
+
+    char chunk[STREAM_CHUNK_SIZE];
+    mStream->next_in = (Bytef*)in.constData();
+    mStream->avail_in = in.size();
+    do
+    {
+        mStream->next_out = (Bytef*)chunk;
+        mStream->avail_out = sizeof( chunk );
+        const int result = ::deflate( mStream, Z_SYNC_FLUSH );
+        if( (result != Z_OK) && (result != Z_BUF_ERROR) )
+        {
+            mOk = false;
+            return false;
+        }
+        out.append( chunk, sizeof( chunk ) - mStream->avail_out );
+    } while( mStream->avail_out == 0 );
+
+    if( out.endsWith( QByteArray::fromRawData( SYNC_FLUSH_TAIL, sizeof( SYNC_FLUSH_TAIL ) ) ) )
+    {
+        out.chop( sizeof( SYNC_FLUSH_TAIL ) );
+    }
+    return true;
+}
+
+
+NetStreamInflater::NetStreamInflater()
+  : mStream( new z_stream() ),
+    mOk( false )
+{
+    mStream->zalloc = Z_NULL;
+    mStream->zfree = Z_NULL;
+    mStream->opaque = Z_NULL;
+    mStream->next_in = Z_NULL;
+    mStream->avail_in = 0;
+    if( inflateInit2( mStream, STREAM_WINDOW_BITS ) == Z_OK )
+    {
+        mOk = (inflateSetDictionary( mStream, (const Bytef*)NET_STREAM_DICTIONARY,
+                                     NET_STREAM_DICTIONARY_SIZE ) == Z_OK);
+    }
+}
+
+
+NetStreamInflater::~NetStreamInflater()
+{
+    inflateEnd( mStream );
+    delete mStream;
+}
+
+
+bool
+NetStreamInflater::inflate( const QByteArray& in, QByteArray& out, int maxSize )
+{
+    if( !mOk ) return false;
+
+    out.clear();
+    if( in.isEmpty() ) return true;
+
+    QByteArray input( in );
+    input.append( SYNC_FLUSH_TAIL, sizeof( SYNC_FLUSH_TAIL ) );
+
+    char chunk[STREAM_CHUNK_SIZE];
+    mStream->next_in = (Bytef*)input.data();
+    mStream->avail_in = input.size();
+    do
+    {
+        mStream->next_out = (Bytef*)chunk;
+        mStream->avail_out = sizeof( chunk );
+        const int result = ::inflate( mStream, Z_SYNC_FLUSH );
+        if( (result != Z_OK) && (result != Z_BUF_ERROR) )
+        {
+            mOk = false;
+            return false;
+        }
+        out.append( chunk, sizeof( chunk ) - mStream->avail_out );
+
+        // Stop before a small message can expand without bound.
+        if( out.size() > maxSize )
+        {
+            out.clear();
+            mOk = false;
+            return false;
+        }
+    } while( mStream->avail_out == 0 );
+
+    // With output space to spare all input should have been consumed.
+    if( mStream->avail_in > 0 )
+    {
+        mOk = false;
+        return false;
+    }
+    return true;
+}
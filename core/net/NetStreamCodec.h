@@ -0,0 +1,60 @@
+#ifndef NETSTREAMCODEC_H
+#define NETSTREAMCODEC_H
+
+#include <QByteArray>
+
+struct z_stream_s;
+
+// Stream compression for one direction of a connection.  Unlike
+// qCompress, which starts fresh for every message, a single raw deflate
+// context persists for the life of the connection so that later
+// messages can refer back to card names and set codes in earlier ones.
+// The context is primed with a pre-shared dictionary of common card
+// name fragments and set codes.
+//
+// Each message is flushed with Z_SYNC_FLUSH and the trailing empty
+// block marker (00 00 FF FF) is dropped from the output; the inflater
+// restores it.  Every message fed to a deflater must be delivered to
+// the peer's inflater, in order.
+
+// Version of the stream compression format and dictionary.  Roll this
+// whenever the dictionary changes.
+static const unsigned int NET_STREAM_COMPRESSION_VERSION = 1;
+
+class NetStreamDeflater
+{
+public:
+    NetStreamDeflater();
+    ~NetStreamDeflater();
+
+    // Returns false if the stream is broken.
+    bool deflate( const QByteArray& in, QByteArray& out );
+
+private:
+    NetStreamDeflater( const NetStreamDeflater& );
+    NetStreamDeflater& operator=( const NetStreamDeflater& );
+
+    z_stream_s* mStream;
+    bool        mOk;
+};
+
+
+class NetStreamInflater
+{
+public:
+    NetStreamInflater();
+    ~NetStreamInflater();
+
+    // Returns false if the stream is broken or the message would inflate
+    // to more than maxSize bytes, which also breaks the stream.
+    bool inflate( const QByteArray& in, QByteArray& out, int maxSize );
+
+private:
+    NetStreamInflater( const NetStreamInflater& );
+    NetStreamInflater& operator=( const NetStreamInflater& );
+
+    z_stream_s* mStream;
+    bool        mOk;
+};
+
+#endif
@@ -200,6 +200,34 @@ TxRxNetTester::run( NetConnection* server, NetConnection* client )
             testTxRx( server, client, largePayload, sendFailExpected );
         }
     }
+
+    /* Stream compression - repeat to exercise the persistent contexts. */
+
+    CATCH_INFO( "stream compression" );
+
+    client->setHeaderMode( NetConnection::HEADER_MODE_AUTO );
+    server->setHeaderMode( NetConnection::HEADER_MODE_AUTO );
+    client->enableTxStreamCompression();
+    client->enableRxStreamCompression();
+    server->enableTxStreamCompression();
+    server->enableRxStreamCompression();
+
+    QByteArray cardPayload( "Lightning Bolt M10 Serra Angel 10E Plains Island" );
+
+    for( int i = 0; i < 3; ++i )
+    {
+        testTxRx( server, client, zeroPayload );
+        testTxRx( client, server, zeroPayload );
+
+        testTxRx( server, client, smallPayload );
+        testTxRx( client, server, smallPayload );
+
+        testTxRx( server, client, cardPayload );
+        testTxRx( client, server, cardPayload );
+
+        testTxRx( server, client, largePayload );
+        testTxRx( client, server, largePayload );
+    }
 }
 
 
@@ -263,6 +291,52 @@ RxInactivityNetTester::run( NetConnection* server, NetConnection* client )
 }
 
 
+void
+RxSizeLimitNetTester::run( NetConnection* server, NetConnection* client )
+{
+    QTimer watchdogTimer;
+    watchdogTimer.setSingleShot( true );
+    QEventLoop loop;
+
+    bool msgReceived = false;
+    connect( server, &NetConnection::msgReceived, this, [&]( const QByteArray& ) {
+            msgReceived = true;
+        }, Qt::QueuedConnection ); // QueuedConnection avoids any direct call before event loop
+    connect( server, &NetConnection::disconnected, this, [&]() {
+            loop.quit();
+        }, Qt::QueuedConnection ); // QueuedConnection avoids any direct call before event loop
+    connect( &watchdogTimer, &QTimer::timeout, &loop, &QEventLoop::quit );
+
+    if( mStreamCompression )
+    {
+        client->enableTxStreamCompression();
+        server->enableRxStreamCompression();
+    }
+    else
+    {
+        client->setCompressionMode( NetConnection::COMPRESSION_MODE_COMPRESSED );
+    }
+    server->setMaxRxMsgSize( 50000 );
+
+    // Compresses to a few hundred bytes.
+    QByteArray largePayload;
+    largePayload.fill( 'X', 100000 );
+    CATCH_REQUIRE( client->sendMsg( largePayload ) );
+    mLogger->debug( "waiting for oversized message abort..." );
+
+    watchdogTimer.start( 200 );
+    loop.exec();
+    CATCH_REQUIRE( watchdogTimer.isActive() );  // ensure no timeout
+    CATCH_REQUIRE_FALSE( msgReceived );
+
+    disconnect( &watchdogTimer, 0, 0, 0 );
+    disconnect( server, &NetConnection::disconnected, 0, 0 );
+    disconnect( server, &NetConnection::msgReceived, 0, 0 );
+
+    mSkipDisconnect = true;
+}
+
+
 CATCH_TEST_CASE( "NetConnection", "[netconn]" )
 {
 #ifdef Q_OS_WIN
@@ -293,4 +367,18 @@ CATCH_TEST_CASE( "NetConnection", "[netconn]" )
         QTimer::singleShot( 0, &tester, SLOT(start()) );
         app.exec();
     }
+
+    CATCH_SECTION( "Rx Size Limit Abort - stream compression" )
+    {
+        RxSizeLimitNetTester tester( true, &app );
+        QTimer::singleShot( 0, &tester, SLOT(start()) );
+        app.exec();
+    }
+
+    CATCH_SECTION( "Rx Size Limit Abort - qCompress" )
+    {
+        RxSizeLimitNetTester tester( false, &app );
+        QTimer::singleShot( 0, &tester, SLOT(start()) );
+        app.exec();
+    }
 }
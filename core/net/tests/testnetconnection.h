@@ -94,3 +94,20 @@ protected:
     virtual void run( NetConnection* server, NetConnection* client );
 };
 
+
+// Sends a small compressed message that inflates past the receiver's
+// size limit, either with stream compression or qCompress.
+class RxSizeLimitNetTester : public NetTestHarness
+{
+public:
+    RxSizeLimitNetTester( bool streamCompression, QObject* parent = nullptr )
+      : NetTestHarness( parent ),
+        mStreamCompression( streamCompression )
+    {}
+    virtual ~RxSizeLimitNetTester() {}
+protected:
+    virtual void run( NetConnection* server, NetConnection* client );
+private:
+    const bool mStreamCompression;
+};
+
@@ -0,0 +1,69 @@
+#ifndef PAYLOADSTORE_H
+#define PAYLOADSTORE_H
+
+#include <QByteArray>
+#include <QHash>
+#include <QCryptographicHash>
+
+// Hash identifying a serialized payload.
+inline QByteArray
+computePayloadHash( const QByteArray& payload )
+{
+    return QCryptographicHash::hash( payload, QCryptographicHash::Sha1 );
+}
+
+
+// Serialize a protobuf message into a payload.
+template<typename T>
+inline QByteArray
+serializePayload( const T& protoMsg )
+{
+    const int protoSize = protoMsg.ByteSize();
+    QByteArray payload;
+    payload.resize( protoSize );
+    protoMsg.SerializeToArray( payload.data(), protoSize );
+    return payload;
+}
+
+
+// Reference-counted, content-addressed store of serialized payloads.
+// Adding the same payload twice stores it once.
+class PayloadStore
+{
+public:
+
+    // Add a reference to a payload, returning its hash.
+    QByteArray add( const QByteArray& payload )
+    {
+        const QByteArray hash = computePayloadHash( payload );
+        Entry& entry = mEntries[hash];
+        if( entry.refs++ == 0 ) entry.payload = payload;
+        return hash;
+    }
+
+    // Release a reference to a payload, removing it if it was the last.
+    void release( const QByteArray& hash )
+    {
+        auto iter = mEntries.find( hash );
+        if( iter == mEntries.end() ) return;
+        if( --iter->refs <= 0 ) mEntries.erase( iter );
+    }
+
+    bool contains( const QByteArray& hash ) const { return mEntries.contains( hash ); }
+
+    // Returns an empty array if the payload isn't present.
+    QByteArray get( const QByteArray& hash ) const { return mEntries.value( hash ).payload; }
+
+private:
+
+    struct Entry
+    {
+        Entry() : refs( 0 ) {}
+        QByteArray payload;
+        int        refs;
+    };
+
+    QHash<QByteArray,Entry> mEntries;
+};
+
+#endif
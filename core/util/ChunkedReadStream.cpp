@@ -0,0 +1,67 @@
+#include "ChunkedReadStream.h"
+
+
+ChunkedReadStream::ChunkedReadStream()
+  : mPos( 0 ),
+    mCount( 0 ),
+    mFinished( false ),
+    mCanceled( false )
+{}
+
+
+void
+ChunkedReadStream::append( const char* data, std::size_t size )
+{
+    if( size == 0 ) return;
+    {
+        std::lock_guard<std::mutex> lock( mMutex );
+        if( mFinished || mCanceled ) return;
+        mChunks.emplace_back( data, size );
+    }
+    mCondition.notify_one();
+}
+
+
+void
+ChunkedReadStream::finish()
+{
+    {
+        std::lock_guard<std::mutex> lock( mMutex );
+        mFinished = true;
+    }
+    mCondition.notify_one();
+}
+
+
+void
+ChunkedReadStream::cancel()
+{
+    {
+        std::lock_guard<std::mutex> lock( mMutex );
+        mCanceled = true;
+        mChunks.clear();
+    }
+    mCondition.notify_one();
+}
+
+
+bool
+ChunkedReadStream::isCanceled() const
+{
+    std::lock_guard<std::mutex> lock( mMutex );
+    return mCanceled;
+}
+
+
+bool
+ChunkedReadStream::fetch()
+{
+    std::unique_lock<std::mutex> lock( mMutex );
+    mCondition.wait( lock, [this] { return !mChunks.empty() || mFinished || mCanceled; } );
+    if( mCanceled || mChunks.empty() ) return false;
+
+    mChunk.swap( mChunks.front() );
+    mChunks.pop_front();
+    mPos = 0;
+    return true;
+}
@@ -0,0 +1,72 @@
+#ifndef CHUNKEDREADSTREAM_H
+#define CHUNKEDREADSTREAM_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <string>
+
+//
+// A read-only rapidjson input stream fed with chunks of data from another
+// thread as they arrive, e.g. from a network transfer.  The reader blocks
+// until more data is appended or the stream is finished.  Cancelling the
+// stream ends input early, which the reader sees as a truncated document.
+//
+
+class ChunkedReadStream
+{
+public:
+
+    typedef char Ch;
+
+    ChunkedReadStream();
+
+    // Producer side.
+    void append( const char* data, std::size_t size );
+    void finish();
+    void cancel();
+    bool isCanceled() const;
+
+    // Reader side, per rapidjson's stream concept.
+    Ch Peek()
+    {
+        if( (mPos == mChunk.size()) && !fetch() ) return '\0';
+        return mChunk[mPos];
+    }
+    Ch Take()
+    {
+        Ch c = Peek();
+        if( mPos < mChunk.size() )
+        {
+            ++mPos;
+            ++mCount;
+        }
+        return c;
+    }
+    std::size_t Tell() const { return mCount; }
+
+    Ch* PutBegin() { return 0; }
+    void Put( Ch ) {}
+    void Flush() {}
+    std::size_t PutEnd( Ch* ) { return 0; }
+
+private:
+
+    // Wait for the next chunk.  Returns false at the end of input.
+    bool fetch();
+
+    // Reader state, touched only by the reading thread.
+    std::string mChunk;
+    std::size_t mPos;
+    std::size_t mCount;
+
+    // Shared state.
+    mutable std::mutex      mMutex;
+    std::condition_variable mCondition;
+    std::deque<std::string> mChunks;
+    bool                    mFinished;
+    bool                    mCanceled;
+};
+
+#endif
@@ -0,0 +1,51 @@
+#include "catch.hpp"
+#include "ChunkedReadStream.h"
+
+#include <algorithm>
+#include <thread>
+
+#include "rapidjson/document.h"
+
+CATCH_TEST_CASE( "Chunked read stream parses data appended from another thread", "[chunkedreadstream]" )
+{
+    const std::string json = "{ \"name\": \"Thicket\", \"values\": [ 1, 2, 3, 4, 5 ] }";
+
+    ChunkedReadStream is;
+    std::thread producer( [&is, &json] {
+            for( std::size_t pos = 0; pos < json.size(); pos += 7 )
+            {
+                is.append( json.data() + pos, std::min<std::size_t>( 7, json.size() - pos ) );
+            }
+            is.finish();
+        } );
+
+    rapidjson::Document doc;
+    doc.ParseStream( is );
+    producer.join();
+
+    CATCH_REQUIRE_FALSE( doc.HasParseError() );
+    CATCH_REQUIRE( std::string( doc["name"].GetString() ) == "Thicket" );
+    CATCH_REQUIRE( doc["values"].Size() == 5 );
+    CATCH_REQUIRE( doc["values"][4].GetInt() == 5 );
+    CATCH_REQUIRE( is.Tell() == json.size() );
+}
+
+CATCH_TEST_CASE( "Chunked read stream ends input when canceled", "[chunkedreadstream]" )
+{
+    const std::string json = "{ \"name\": \"Thic";
+
+    ChunkedReadStream is;
+    is.append( json.data(), json.size() );
+    std::thread canceler( [&is] { is.cancel(); } );
+
+    rapidjson::Document doc;
+    doc.ParseStream( is );
+    canceler.join();
+
+    CATCH_REQUIRE( doc.HasParseError() );
+    CATCH_REQUIRE( is.isCanceled() );
+
+    // Data after cancellation is dropped.
+    is.append( "x", 1 );
+    CATCH_REQUIRE( is.Peek() == '\0' );
+}
@@ -2,17 +2,40 @@
 
 #include <QLocalServer>
 #include <QLocalSocket>
+#include <QJsonDocument>
+#include <QJsonObject>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <algorithm>
 
 #include "qtutils_core.h"
 #include "ClientNotices.h"
+#include "MtgJsonAllSetsData.h"
+#include "Server.h"
+
+static const QString SERVER_NAME = "admin";
+
+// Further connections are refused.
+static const int MAX_SESSIONS = 8;
+
+// Default number of rooms listed by 'top'.
+static const int TOP_ROOMS_DEFAULT = 10;
 
-AdminShell::AdminShell( const std::shared_ptr<ClientNotices>& clientNotices,
-                        const Logging::Config&                loggingConfig,
-                        QObject*                              parent )
+// How long runCommands() waits on the shell.
+static const int SCRIPT_TIMEOUT_MILLIS = 10000;
+
+AdminShell::AdminShell( const std::shared_ptr<ClientNotices>&            clientNotices,
+                        const Server*                                    server,
+                        const std::shared_ptr<const MtgJsonAllSetsData>& allSetsData,
+                        const Logging::Config&                           loggingConfig,
+                        QObject*                                         parent )
 :   QObject( parent ),
     mClientNotices( clientNotices ),
-    mServer( 0 ),
-    mConnection( 0 ),
+    mServer( server ),
+    mAllSetsData( allSetsData ),
+    mLocalServer( 0 ),
+    mNextSessionId( 1 ),
     mLoggingConfig( loggingConfig ),
     mLogger( mLoggingConfig.createLogger() )
 {
@@ -22,74 +45,81 @@ AdminShell::AdminShell( const std::shared_ptr<ClientNotices>& clientNotices,
 void
 AdminShell::start()
 {
-    mServer = new QLocalServer( this );
+    mLocalServer = new QLocalServer( this );
     mLogger->debug( "starting admin server" );
 
-    const QString SERVER_NAME = "admin";
-
     if( QLocalServer::removeServer( SERVER_NAME ) )
     {
         mLogger->debug( "removed existing admin server" );
     }
 
-    if( !mServer->listen( SERVER_NAME ) )
+    if( !mLocalServer->listen( SERVER_NAME ) )
     {
-        mLogger->error( "Unable to start the admin server: {}", mServer->errorString() );
+        mLogger->error( "Unable to start the admin server: {}", mLocalServer->errorString() );
         emit finished();
         return;
     }
 
-    connect( mServer, &QLocalServer::newConnection, this, &AdminShell::handleNewConnection );
+    connect( mLocalServer, &QLocalServer::newConnection, this, &AdminShell::handleNewConnection );
 
-    mLogger->notice( "The admin shell is running at: {}", mServer->fullServerName() );
+    mLogger->notice( "The admin shell is running at: {}", mLocalServer->fullServerName() );
 }
 
 
 void
 AdminShell::handleNewConnection()
 {
-    QLocalSocket* conn = mServer->nextPendingConnection();
-    if( mConnection == 0 )
+    while( mLocalServer->hasPendingConnections() )
     {
-        mConnection = conn;
-        mLogger->notice( "admin connection established" );
+        QLocalSocket* socket = mLocalServer->nextPendingConnection();
+        if( mSessions.size() >= MAX_SESSIONS )
+        {
+            mLogger->warn( "admin connection refused - {} sessions open", mSessions.size() );
+            socket->abort();
+            socket->deleteLater();
+            continue;
+        }
 
-        connect( mConnection, &QLocalSocket::readyRead,
+        Session& session = mSessions[socket];
+        session.id = mNextSessionId++;
+        session.jsonOutput = false;
+        session.scripted = false;
+        session.commandCount = 0;
+        session.sinceConnected.start();
+        mLogger->notice( "admin session {} established", session.id );
+
+        connect( socket, &QLocalSocket::readyRead,
                  this, &AdminShell::handleSocketReadyRead );
-        connect( mConnection, &QLocalSocket::disconnected,
+        connect( socket, &QLocalSocket::disconnected,
                  this, &AdminShell::handleSocketDisconnected );
-        writeToSocket( "\nThicket Admin Shell\nType 'h' or 'help' for command list.\n\n" );
-        writePrompt();
-    }
-    else
-    {
-        mLogger->warn( "admin connection refused - already in use" );
-        conn->abort();
+        writeToSocket( socket, "\nThicket Admin Shell\nType 'h' or 'help' for command list.\n\n" );
+        writePrompt( socket );
     }
 }
 
 
 bool
-AdminShell::writeToSocket( QString str )
+AdminShell::writeToSocket( QLocalSocket* socket, const QString& str )
 {
-    return (mConnection->write( str.toUtf8()) && mConnection->flush() );
+    return (socket->write( str.toUtf8()) && socket->flush() );
 }
 
 
 void
 AdminShell::handleSocketReadyRead()
 {
-    while( mConnection && mConnection->canReadLine() )
-    {
-        QString line = QString::fromUtf8( mConnection->readLine() ).trimmed();
-        mLogger->info( "admin command rx: '{}'", line );
+    QLocalSocket* socket = qobject_cast<QLocalSocket*>( QObject::sender() );
 
-        processCommand( line );
+    // Checking the session each time because a quit command ends it.
+    while( mSessions.contains( socket ) && socket->canReadLine() )
+    {
+        Session& session = mSessions[socket];
+        QString line = QString::fromUtf8( socket->readLine() ).trimmed();
+        mLogger->info( "admin session {} command rx: '{}'", session.id, line );
 
-        // Checking connection here because a quit command can remove it.
-        if( mConnection )
+        if( processCommand( socket, session, line ) && !session.scripted )
         {
-            writePrompt();
+            writePrompt( socket );
         }
     }
 }
@@ -98,69 +128,401 @@ AdminShell::handleSocketReadyRead()
 void
 AdminShell::handleSocketDisconnected()
 {
-    mLogger->notice( "admin connection disconnected" );
-    mConnection = 0;
+    // Sessions that quit are already gone.
+    QLocalSocket* socket = qobject_cast<QLocalSocket*>( QObject::sender() );
+    auto iter = mSessions.find( socket );
+    if( iter != mSessions.end() )
+    {
+        mLogger->notice( "admin session {} disconnected", iter->id );
+        mSessions.erase( iter );
+    }
+    socket->deleteLater();
 }
 
 
 bool
-AdminShell::writePrompt()
+AdminShell::writePrompt( QLocalSocket* socket )
 {
-    return writeToSocket( "admin> " );
+    return writeToSocket( socket, "admin> " );
 }
 
 
 void
-AdminShell::processCommand( const QString& line )
+AdminShell::writeReply( QLocalSocket* socket, const Session& session, const QString& command, const Reply& reply )
 {
-    QString command = line.section( " ", 0, 0 );
-    if( command.isEmpty() ) return;
+    if( session.jsonOutput )
+    {
+        QJsonObject obj;
+        obj["command"] = command;
+        obj["ok"] = reply.ok;
+        if( !reply.ok )
+        {
+            obj["error"] = reply.error;
+        }
+        else if( !reply.result.isNull() )
+        {
+            obj["result"] = reply.result;
+        }
+        writeToSocket( socket, QString::fromUtf8( QJsonDocument( obj ).toJson( QJsonDocument::Compact ) ) + "\n" );
+    }
+    else
+    {
+        writeToSocket( socket, (reply.ok ? reply.text : reply.error) + "\n\n" );
+    }
+}
+
+
+bool
+AdminShell::processCommand( QLocalSocket* socket, Session& session, const QString& line )
+{
+    const QStringList tokens = line.split( " ", QString::SkipEmptyParts );
+    if( tokens.isEmpty() ) return true;
+    const QString command = tokens.front();
+    session.commandCount++;
 
+    Reply reply;
     if( (command.compare( "h" ) == 0) || (command.compare( "help" ) == 0) )
     {
-        writeToSocket( "Available commands:\n\n" );
-        writeToSocket( " a,  announce         Re-read the announcements file from disk and update\n" );
-        writeToSocket( "                      clients\n" );
-        writeToSocket( " as, alertset [msg]   Set alert message to clients\n" );
-        writeToSocket( " ac, alertclear       Clear alert to clients\n" );
-        writeToSocket( " h,  help             Print this help\n" );
-        writeToSocket( " q,  quit             Quit admin shell\n" );
-        writeToSocket( "\n" );
+        reply = getHelp();
     }
     else if( (command.compare( "a" ) == 0) || (command.compare( "announce" ) == 0) )
     {
         // Re-read the announcements; this will signal the server to send
         // the announcements out to clients.
-        if( mClientNotices->readAnnouncementsFromDisk() )
-        {
-            writeToSocket( "Announcements updated\n\n" );
-        }
-        else
-        {
-            writeToSocket( "Error reading announcements - check announcements file\n\n" );
-        }
+        reply.ok = mClientNotices->readAnnouncementsFromDisk();
+        reply.text = "Announcements updated";
+        reply.error = "Error reading announcements - check announcements file";
     }
     else if( (command.compare( "ac" ) == 0) || (command.compare( "alertclear" ) == 0) )
     {
         // Empty string = no alert
         mClientNotices->setAlert( "" );
-        writeToSocket( "Alert cleared\n\n" );
+        reply.text = "Alert cleared";
     }
     else if( (command.compare( "as" ) == 0) || (command.compare( "alertset" ) == 0) )
     {
         QString alert = line.section( " ", 1, -1 );
-        writeToSocket( "Alert set: " + alert + "\n\n" );
         mClientNotices->setAlert( alert );
-
+        reply.text = "Alert set: " + alert;
+    }
+    else if( (command.compare( "s" ) == 0) || (command.compare( "sessions" ) == 0) )
+    {
+        reply = getSessions();
+    }
+    else if( (command.compare( "c" ) == 0) || (command.compare( "conns" ) == 0) )
+    {
+        reply = getConnections();
+    }
+    else if( (command.compare( "r" ) == 0) || (command.compare( "rooms" ) == 0) )
+    {
+        reply = getRooms( -1, QString() );
+    }
+    else if( (command.compare( "t" ) == 0) || (command.compare( "top" ) == 0) )
+    {
+        int limit = TOP_ROOMS_DEFAULT;
+        QString sortKey = "memory";
+        for( int i = 1; (i < tokens.size()) && reply.ok; ++i )
+        {
+            bool ok = true;
+            const int n = tokens[i].toInt( &ok );
+            if( ok && (n > 0) )
+            {
+                limit = n;
+            }
+            else if( (tokens[i] == "memory") || (tokens[i] == "cpu") )
+            {
+                sortKey = tokens[i];
+            }
+            else
+            {
+                reply.ok = false;
+                reply.error = "Invalid room count or sort key '" + tokens[i] + "'";
+            }
+        }
+        if( reply.ok ) reply = getRooms( limit, sortKey );
+    }
+    else if( (command.compare( "cc" ) == 0) || (command.compare( "cardcache" ) == 0) )
+    {
+        reply = getCardCacheStats();
+    }
+    else if( (command.compare( "f" ) == 0) || (command.compare( "format" ) == 0) )
+    {
+        const QString format = (tokens.size() > 1) ? tokens[1] : QString();
+        if( (format == "text") || (format == "json") )
+        {
+            session.jsonOutput = (format == "json");
+            reply.text = "Output format: " + format;
+        }
+        else
+        {
+            reply.ok = false;
+            reply.error = "Format must be 'text' or 'json'";
+        }
+    }
+    else if( command.compare( "script" ) == 0 )
+    {
+        session.scripted = true;
+        session.jsonOutput = true;
     }
     else if( (command.compare( "q" ) == 0) || (command.compare( "quit" ) == 0) )
     {
-        mConnection->abort();
-        mConnection = 0;
+        // Let any output drain before the socket closes.
+        mLogger->notice( "admin session {} quit", session.id );
+        mSessions.remove( socket );
+        socket->disconnectFromServer();
+        return false;
     }
     else
     {
-        writeToSocket( "Unrecognized command '" + command + "'\n\n" );
+        reply.ok = false;
+        reply.error = "Unrecognized command '" + command + "'";
+    }
+
+    writeReply( socket, session, command, reply );
+    return true;
+}
+
+
+AdminShell::Reply
+AdminShell::getHelp() const
+{
+    Reply reply;
+    reply.text =
+        "Available commands:\n\n"
+        " a,  announce         Re-read the announcements file from disk and update\n"
+        "                      clients\n"
+        " as, alertset [msg]   Set alert message to clients\n"
+        " ac, alertclear       Clear alert to clients\n"
+        " s,  sessions         List admin shell sessions\n"
+        " c,  conns            List client connections: traffic, queued bytes and\n"
+        "                      time since last heard from\n"
+        " r,  rooms            List rooms: phase, players, memory, CPU and draft\n"
+        "                      timer lag\n"
+        " t,  top [n] [memory|cpu]\n"
+        "                      List the n rooms using the most memory or recent\n"
+        "                      CPU (default " + QString::number( TOP_ROOMS_DEFAULT ) + ", memory)\n"
+        " cc, cardcache        Show card lookup cache statistics per process\n"
+        " f,  format text|json Set output format for this session\n"
+        " script               Switch this session to script mode: no prompt,\n"
+        "                      one line of JSON per command\n"
+        " h,  help             Print this help\n"
+        " q,  quit             Quit admin shell";
+    reply.result = QJsonArray::fromStringList( QStringList() << "announce" << "alertset" << "alertclear"
+            << "sessions" << "conns" << "rooms" << "top" << "cardcache" << "format" << "script" << "help" << "quit" );
+    return reply;
+}
+
+
+AdminShell::Reply
+AdminShell::getSessions() const
+{
+    QJsonArray rows;
+    for( const Session& session : mSessions )
+    {
+        QJsonObject row;
+        row["id"] = static_cast<int>( session.id );
+        row["connected_secs"] = session.sinceConnected.elapsed() / 1000;
+        row["commands"] = static_cast<int>( session.commandCount );
+        row["mode"] = session.scripted ? "script" : (session.jsonOutput ? "json" : "text");
+        rows.append( row );
+    }
+
+    Reply reply;
+    reply.result = rows;
+    reply.text = formatTable( rows, QStringList() << "id" << "connected_secs" << "commands" << "mode" );
+    return reply;
+}
+
+
+AdminShell::Reply
+AdminShell::getConnections() const
+{
+    QJsonArray rows;
+    for( const Server::ConnectionDiagnostics& diagnostics : mServer->getConnectionDiagnostics() )
+    {
+        QJsonObject row;
+        row["name"] = QString::fromStdString( diagnostics.name );
+        row["peer"] = QString::fromStdString( diagnostics.peerAddress );
+        row["room"] = diagnostics.roomId;
+        row["bytes_sent"] = static_cast<qint64>( diagnostics.bytesSent );
+        row["bytes_received"] = static_cast<qint64>( diagnostics.bytesReceived );
+        row["backlog_bytes"] = diagnostics.backlogBytes;
+        row["idle_millis"] = diagnostics.idleMillis;
+        rows.append( row );
+    }
+
+    Reply reply;
+    reply.result = rows;
+    reply.text = formatTable( rows, QStringList() << "name" << "peer" << "room" << "bytes_sent"
+            << "bytes_received" << "backlog_bytes" << "idle_millis" );
+    return reply;
+}
+
+
+AdminShell::Reply
+AdminShell::getRooms( int limit, const QString& sortKey ) const
+{
+    QList<RoomDiagnostics> diagnosticsList = mServer->getRoomDiagnostics();
+    if( sortKey == "memory" )
+    {
+        std::stable_sort( diagnosticsList.begin(), diagnosticsList.end(),
+                []( const RoomDiagnostics& a, const RoomDiagnostics& b ) { return a.memoryBytes > b.memoryBytes; } );
+    }
+    else if( sortKey == "cpu" )
+    {
+        std::stable_sort( diagnosticsList.begin(), diagnosticsList.end(),
+                []( const RoomDiagnostics& a, const RoomDiagnostics& b ) {
+                    return (a.cpuPercent != b.cpuPercent) ? (a.cpuPercent > b.cpuPercent) : (a.cpuMillis > b.cpuMillis);
+                } );
+    }
+    if( (limit >= 0) && (diagnosticsList.size() > limit) )
+    {
+        diagnosticsList.erase( diagnosticsList.begin() + limit, diagnosticsList.end() );
+    }
+
+    QJsonArray rows;
+    for( const RoomDiagnostics& diagnostics : diagnosticsList )
+    {
+        QJsonObject row;
+        row["id"] = static_cast<int>( diagnostics.roomId );
+        row["name"] = QString::fromStdString( diagnostics.name );
+        row["worker"] = diagnostics.workerIndex;
+        row["phase"] = QString::fromStdString( diagnostics.phase );
+        row["players"] = static_cast<int>( diagnostics.playerCount );
+        row["chairs"] = static_cast<int>( diagnostics.chairCount );
+        row["memory_bytes"] = static_cast<qint64>( diagnostics.memoryBytes );
+        row["cpu_millis"] = static_cast<qint64>( diagnostics.cpuMillis );
+        row["cpu_percent"] = static_cast<int>( diagnostics.cpuPercent );
+        row["over_budget"] = diagnostics.overBudget;
+        row["tick_lag_millis"] = diagnostics.tickLagMillis;
+        row["max_tick_lag_millis"] = diagnostics.maxTickLagMillis;
+        rows.append( row );
     }
+
+    Reply reply;
+    reply.result = rows;
+    reply.text = formatTable( rows, QStringList() << "id" << "name" << "worker" << "phase" << "players"
+            << "chairs" << "memory_bytes" << "cpu_millis" << "cpu_percent" << "over_budget"
+            << "tick_lag_millis" << "max_tick_lag_millis" );
+    return reply;
 }
 
+
+AdminShell::Reply
+AdminShell::getCardCacheStats() const
+{
+    // With room workers, card lookups for rooms happen in the workers and
+    // the lobby's counters cover only its own lookups.
+    CardCacheStats lobbyStats;
+    lobbyStats.cardLookupHits = mAllSetsData->getCardLookupCacheHits();
+    lobbyStats.cardLookupMisses = mAllSetsData->getCardLookupCacheMisses();
+    lobbyStats.setCodeLookupHits = mAllSetsData->getSetCodeLookupCacheHits();
+    lobbyStats.setCodeLookupMisses = mAllSetsData->getSetCodeLookupCacheMisses();
+
+    QList<CardCacheStats> statsList = mServer->getWorkerCardCacheStats();
+    statsList.prepend( lobbyStats );
+
+    QJsonArray rows;
+    for( const CardCacheStats& stats : statsList )
+    {
+        QJsonObject row;
+        row["process"] = (stats.workerIndex < 0) ? QString( "lobby" )
+                                                 : QString( "worker %1" ).arg( stats.workerIndex );
+        row["card_lookup_hits"] = static_cast<qint64>( stats.cardLookupHits );
+        row["card_lookup_misses"] = static_cast<qint64>( stats.cardLookupMisses );
+        row["set_code_lookup_hits"] = static_cast<qint64>( stats.setCodeLookupHits );
+        row["set_code_lookup_misses"] = static_cast<qint64>( stats.setCodeLookupMisses );
+        rows.append( row );
+    }
+
+    Reply reply;
+    reply.result = rows;
+    reply.text = formatTable( rows, QStringList() << "process" << "card_lookup_hits" << "card_lookup_misses"
+            << "set_code_lookup_hits" << "set_code_lookup_misses" );
+    return reply;
+}
+
+
+QString
+AdminShell::formatTable( const QJsonArray& rows, const QStringList& columns )
+{
+    if( rows.isEmpty() ) return "(none)";
+
+    QList<QStringList> cells;
+    QList<int> widths;
+    for( const QString& column : columns ) widths.append( column.size() );
+    for( const QJsonValue& row : rows )
+    {
+        QStringList rowCells;
+        for( int i = 0; i < columns.size(); ++i )
+        {
+            rowCells.append( row.toObject().value( columns[i] ).toVariant().toString() );
+            widths[i] = std::max( widths[i], rowCells.back().size() );
+        }
+        cells.append( rowCells );
+    }
+
+    // Columns are two spaces apart; the last isn't padded.
+    cells.prepend( columns );
+    QStringList lines;
+    for( const QStringList& rowCells : cells )
+    {
+        QString line;
+        for( int i = 0; i + 1 < rowCells.size(); ++i ) line += rowCells[i].leftJustified( widths[i] + 2 );
+        lines.append( line + rowCells.back() );
+    }
+    return lines.join( "\n" );
+}
+
+
+int
+AdminShell::runCommands( const QStringList& commands )
+{
+    QLocalSocket socket;
+    socket.connectToServer( SERVER_NAME );
+    if( !socket.waitForConnected( SCRIPT_TIMEOUT_MILLIS ) )
+    {
+        fprintf( stderr, "Unable to reach the admin shell: %s\n", qPrintable( socket.errorString() ) );
+        return EXIT_FAILURE;
+    }
+
+    QByteArray request = "script\n";
+    for( const QString& command : commands ) request += command.toUtf8() + "\n";
+    request += "quit\n";
+    socket.write( request );
+    socket.waitForBytesWritten( SCRIPT_TIMEOUT_MILLIS );
+
+    // The shell closes the session after the last command.
+    QByteArray response;
+    while( socket.waitForReadyRead( SCRIPT_TIMEOUT_MILLIS ) ) response += socket.readAll();
+    response += socket.readAll();
+    if( socket.state() != QLocalSocket::UnconnectedState )
+    {
+        fprintf( stderr, "Timed out waiting for the admin shell\n" );
+        return EXIT_FAILURE;
+    }
+
+    // The session's banner and prompt came before script mode took
+    // effect, and have no JSON in them.
+    const int jsonStart = response.indexOf( '{' );
+    const QList<QByteArray> lines = (jsonStart >= 0) ? response.mid( jsonStart ).split( '\n' ) : QList<QByteArray>();
+
+    // The first line acknowledges script mode.
+    int exitCode = EXIT_SUCCESS;
+    int resultCount = 0;
+    for( int i = 1; i < lines.size(); ++i )
+    {
+        const QByteArray& line = lines[i];
+        if( line.trimmed().isEmpty() ) continue;
+        const QJsonObject obj = QJsonDocument::fromJson( line ).object();
+        if( !obj.value( "ok" ).toBool() ) exitCode = EXIT_FAILURE;
+        fprintf( stdout, "%s\n", line.constData() );
+        resultCount++;
+    }
+    if( resultCount != commands.size() )
+    {
+        fprintf( stderr, "Expected %d results from the admin shell, got %d\n", commands.size(), resultCount );
+        exitCode = EXIT_FAILURE;
+    }
+    return exitCode;
+}
@@ -8,18 +8,38 @@ class QLocalServer;
 class QLocalSocket;
 QT_END_NAMESPACE
 
+#include <QElapsedTimer>
+#include <QJsonArray>
+#include <QJsonValue>
+#include <QMap>
+#include <QStringList>
+
 class ClientNotices;
+class MtgJsonAllSetsData;
+class Server;
 
 #include "Logging.h"
 
+// Line-oriented admin shell on a local socket.  Several sessions may be
+// open at once.  Sessions start out interactive with a prompt and text
+// output; the 'script' command switches a session to script mode, with no
+// prompt and one line of JSON per command.  runCommands() uses script
+// mode to run commands from the command line.
 class AdminShell : public QObject
 {
     Q_OBJECT
 
 public:
-    AdminShell( const std::shared_ptr<ClientNotices>& clientNotices,
-                const Logging::Config&                loggingConfig = Logging::Config(),
-                QObject*                              parent = 0 );
+    AdminShell( const std::shared_ptr<ClientNotices>&            clientNotices,
+                const Server*                                    server,
+                const std::shared_ptr<const MtgJsonAllSetsData>& allSetsData,
+                const Logging::Config&                           loggingConfig = Logging::Config(),
+                QObject*                                         parent = 0 );
+
+    // Run commands against the admin shell of a running server and write
+    // each command's JSON result line to stdout.  Returns an exit code;
+    // nonzero if the shell couldn't be reached or any command failed.
+    static int runCommands( const QStringList& commands );
 
 public slots:
 
@@ -37,13 +57,50 @@ private slots:
 
 private:
 
-    bool writeToSocket( QString str );
-    bool writePrompt();
-    void processCommand( const QString& tokens );
-
-    const std::shared_ptr<ClientNotices> mClientNotices;
-    QLocalServer*                        mServer;
-    QLocalSocket*                        mConnection;
+    struct Session
+    {
+        unsigned int  id;
+        bool          jsonOutput;
+        bool          scripted;
+        unsigned int  commandCount;
+        QElapsedTimer sinceConnected;
+    };
+
+    // Result of a command.  Text is for interactive output, the result
+    // value for JSON output.  Commands that fail set an error instead.
+    struct Reply
+    {
+        Reply() : ok( true ) {}
+        bool       ok;
+        QString    error;
+        QString    text;
+        QJsonValue result;
+    };
+
+    bool writeToSocket( QLocalSocket* socket, const QString& str );
+    bool writePrompt( QLocalSocket* socket );
+    void writeReply( QLocalSocket* socket, const Session& session, const QString& command, const Reply& reply );
+
+    // Returns false if the session ended.
+    bool processCommand( QLocalSocket* socket, Session& session, const QString& line );
+
+    Reply getHelp() const;
+    Reply getSessions() const;
+    Reply getConnections() const;
+    // Sort key is "memory", "cpu" or empty for room order.
+    Reply getRooms( int limit, const QString& sortKey ) const;
+    Reply getCardCacheStats() const;
+
+    // Align rows of flat JSON objects into columns.
+    static QString formatTable( const QJsonArray& rows, const QStringList& columns );
+
+    const std::shared_ptr<ClientNotices>            mClientNotices;
+    const Server*                                   mServer;
+    const std::shared_ptr<const MtgJsonAllSetsData> mAllSetsData;
+    QLocalServer*                                   mLocalServer;
+
+    QMap<QLocalSocket*,Session>          mSessions;
+    unsigned int                         mNextSessionId;
 
     const Logging::Config                mLoggingConfig;
     std::shared_ptr<spdlog::logger>      mLogger;
@@ -99,3 +99,13 @@ BoosterDispenser::dispenseAll()
     reset();
     return cards;
 }
+
+
+std::size_t
+BoosterDispenser::getApproximateMemoryBytes() const
+{
+    std::size_t bytes = sizeof( *this );
+    for( const DraftCard& card : mCards ) bytes += ::getApproximateMemoryBytes( card );
+    if( mCardPoolSelector ) bytes += mCardPoolSelector->getApproximateMemoryBytes();
+    return bytes;
+}
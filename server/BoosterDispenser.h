@@ -18,6 +18,7 @@ public:
 
     virtual std::vector<DraftCard> dispenseAll() override;
     virtual std::vector<DraftCard> dispense( unsigned int quantity ) override;
+    virtual std::size_t getApproximateMemoryBytes() const override;
 
 private:
 
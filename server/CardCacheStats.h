@@ -0,0 +1,27 @@
+#ifndef CARDCACHESTATS_H
+#define CARDCACHESTATS_H
+
+#include <cstdint>
+
+// Card data lookup cache counters of one server process, for the admin
+// shell.
+struct CardCacheStats
+{
+    CardCacheStats()
+      : workerIndex( -1 ),
+        cardLookupHits( 0 ),
+        cardLookupMisses( 0 ),
+        setCodeLookupHits( 0 ),
+        setCodeLookupMisses( 0 )
+    {}
+
+    // Worker process the counters are from, or -1 for the lobby.
+    int          workerIndex;
+
+    uint64_t     cardLookupHits;
+    uint64_t     cardLookupMisses;
+    uint64_t     setCodeLookupHits;
+    uint64_t     setCodeLookupMisses;
+};
+
+#endif
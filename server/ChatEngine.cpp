@@ -0,0 +1,273 @@
+#include "ChatEngine.h"
+
+#include <QTimer>
+#include <algorithm>
+
+#include "ClientConnection.h"
+#include "PayloadStore.h"
+
+// Messages posted within this window go out together.
+static const int FLUSH_WINDOW_MILLIS = 100;
+
+// Each user may send a burst of messages, then a steady trickle.
+static const double RATE_LIMIT_BURST = 5.0;
+static const double RATE_LIMIT_PER_SECOND = 1.0;
+
+// Messages kept per channel for users who join.
+static const std::size_t HISTORY_MESSAGE_COUNT = 50;
+
+// Longer message text is truncated.  Length is in bytes of UTF-8.
+static const std::size_t MAX_TEXT_LENGTH = 1024;
+
+const int ChatEngine::LOBBY_CHANNEL_KEY;
+
+
+ChatEngine::ChatEngine( const Logging::Config& loggingConfig,
+                        QObject*               parent )
+:   QObject( parent ),
+    mLoggingConfig( loggingConfig ),
+    mLogger( mLoggingConfig.createLogger() )
+{
+    mChannelMap.insert( LOBBY_CHANNEL_KEY, Channel() );
+
+    mFlushTimer = new QTimer( this );
+    mFlushTimer->setSingleShot( true );
+    connect( mFlushTimer, &QTimer::timeout, this, &ChatEngine::handleFlushTimerTimeout );
+}
+
+
+void
+ChatEngine::addUser( ClientConnection* clientConnection, const std::string& name, bool batchingSupported )
+{
+    User& user = mUserMap[clientConnection];
+    user.name = name;
+    user.batchingSupported = batchingSupported;
+    user.roomId = -1;
+    user.tokens = RATE_LIMIT_BURST;
+    user.sinceRefill.start();
+
+    Channel& lobby = mChannelMap[LOBBY_CHANNEL_KEY];
+    lobby.members.insert( clientConnection );
+    sendHistory( clientConnection, user, lobby );
+}
+
+
+void
+ChatEngine::removeUser( ClientConnection* clientConnection )
+{
+    auto iter = mUserMap.find( clientConnection );
+    if( iter == mUserMap.end() ) return;
+
+    mChannelMap[LOBBY_CHANNEL_KEY].members.remove( clientConnection );
+    leaveRoomChannel( clientConnection, iter.value() );
+    mUserMap.erase( iter );
+}
+
+
+void
+ChatEngine::setUserRoom( ClientConnection* clientConnection, int roomId )
+{
+    auto iter = mUserMap.find( clientConnection );
+    if( iter == mUserMap.end() ) return;
+
+    User& user = iter.value();
+    if( user.roomId == roomId ) return;
+
+    leaveRoomChannel( clientConnection, user );
+
+    user.roomId = roomId;
+    if( roomId >= 0 )
+    {
+        Channel& channel = mChannelMap[roomId];
+        channel.members.insert( clientConnection );
+
+        // A returning user's client still shows what it was sent before.
+        auto departedIter = channel.departedSerials.find( user.name );
+        const uint64_t afterSerial = (departedIter != channel.departedSerials.end()) ? departedIter->second : 0;
+        sendHistory( clientConnection, user, channel, afterSerial );
+    }
+    mLogger->debug( "{} chat room channel: {}", user.name, roomId );
+}
+
+
+void
+ChatEngine::removeRoomChannel( int roomId )
+{
+    auto channelIter = mChannelMap.find( roomId );
+    if( (roomId < 0) || (channelIter == mChannelMap.end()) ) return;
+
+    for( ClientConnection* clientConnection : channelIter->members )
+    {
+        mUserMap[clientConnection].roomId = -1;
+    }
+    mChannelMap.erase( channelIter );
+    mPendingChannelKeys.remove( roomId );
+}
+
+
+bool
+ChatEngine::post( ClientConnection* clientConnection, const proto::ChatMessageInd& ind )
+{
+    auto iter = mUserMap.find( clientConnection );
+    if( iter == mUserMap.end() ) return false;
+    User& user = iter.value();
+
+    int channelKey;
+    if( ind.scope() == proto::CHAT_SCOPE_ALL )
+    {
+        channelKey = LOBBY_CHANNEL_KEY;
+    }
+    else if( (ind.scope() == proto::CHAT_SCOPE_ROOM) && (user.roomId >= 0) )
+    {
+        channelKey = user.roomId;
+    }
+    else
+    {
+        mLogger->warn( "chat scope {} not currently supported", ind.scope() );
+        return false;
+    }
+
+    if( !takeToken( user ) )
+    {
+        mLogger->notice( "chat rate limit exceeded by {}", user.name );
+        return false;
+    }
+
+    // Truncate without splitting a UTF-8 sequence: back up over
+    // continuation bytes to the start of the character that doesn't fit.
+    std::size_t textLength = ind.text().size();
+    if( textLength > MAX_TEXT_LENGTH )
+    {
+        textLength = MAX_TEXT_LENGTH;
+        while( (textLength > 0) && ((static_cast<unsigned char>( ind.text()[textLength] ) & 0xC0) == 0x80) )
+        {
+            --textLength;
+        }
+        mLogger->notice( "truncating chat text from {} ({} bytes)", user.name, ind.text().size() );
+    }
+
+    Channel& channel = mChannelMap[channelKey];
+
+    // Serialize the standalone message now, once for all recipients.
+    std::shared_ptr<Delivery> delivery = std::make_shared<Delivery>();
+    delivery->serial = ++channel.lastSerial;
+    delivery->ind.set_sender( user.name );
+    delivery->ind.set_scope( ind.scope() );
+    delivery->ind.set_text( ind.text().substr( 0, textLength ) );
+    proto::ServerToClientMsg msg;
+    *msg.mutable_chat_message_delivery_ind() = delivery->ind;
+    delivery->msg = serializePayload( msg );
+
+    channel.history.push_back( delivery );
+    if( channel.history.size() > HISTORY_MESSAGE_COUNT ) channel.history.pop_front();
+    channel.pending.append( delivery );
+    mPendingChannelKeys.insert( channelKey );
+
+    if( !mFlushTimer->isActive() ) mFlushTimer->start( FLUSH_WINDOW_MILLIS );
+    return true;
+}
+
+
+bool
+ChatEngine::takeToken( User& user )
+{
+    const double elapsedSeconds = user.sinceRefill.restart() / 1000.0;
+    user.tokens = std::min( RATE_LIMIT_BURST, user.tokens + elapsedSeconds * RATE_LIMIT_PER_SECOND );
+    if( user.tokens < 1.0 ) return false;
+    user.tokens -= 1.0;
+    return true;
+}
+
+
+void
+ChatEngine::sendHistory( ClientConnection* clientConnection, const User& user, const Channel& channel, uint64_t afterSerial )
+{
+    // Pending messages go to the user with the next flush.
+    QList<DeliverySharedPtr> deliveries;
+    for( const DeliverySharedPtr& delivery : channel.history )
+    {
+        if( (delivery->serial > afterSerial) && (delivery->serial <= channel.deliveredSerial) )
+        {
+            deliveries.append( delivery );
+        }
+    }
+    if( deliveries.isEmpty() ) return;
+
+    if( user.batchingSupported )
+    {
+        clientConnection->sendSerializedMsg( serializeBatch( deliveries ), proto::ServerToClientMsg::kChatMessageBatchInd );
+    }
+    else
+    {
+        for( const DeliverySharedPtr& delivery : deliveries )
+        {
+            clientConnection->sendSerializedMsg( delivery->msg, proto::ServerToClientMsg::kChatMessageDeliveryInd );
+        }
+    }
+}
+
+
+void
+ChatEngine::leaveRoomChannel( ClientConnection* clientConnection, const User& user )
+{
+    if( user.roomId < 0 ) return;
+
+    auto channelIter = mChannelMap.find( user.roomId );
+    if( channelIter == mChannelMap.end() ) return;
+
+    channelIter->members.remove( clientConnection );
+    channelIter->departedSerials[user.name] = channelIter->deliveredSerial;
+}
+
+
+void
+ChatEngine::deliver( const Channel& channel, const QList<DeliverySharedPtr>& deliveries )
+{
+    // A lone message goes out as is; several are batched for clients that
+    // support it.  Either way, serialization happens once per channel.
+    QByteArray batchMsg;
+    if( deliveries.size() > 1 ) batchMsg = serializeBatch( deliveries );
+
+    mLogger->debug( "delivering {} chat messages to {} members", deliveries.size(), channel.members.size() );
+    for( ClientConnection* clientConnection : channel.members )
+    {
+        if( !batchMsg.isEmpty() && mUserMap.value( clientConnection ).batchingSupported )
+        {
+            clientConnection->sendSerializedMsg( batchMsg, proto::ServerToClientMsg::kChatMessageBatchInd );
+            continue;
+        }
+        for( const DeliverySharedPtr& delivery : deliveries )
+        {
+            clientConnection->sendSerializedMsg( delivery->msg, proto::ServerToClientMsg::kChatMessageDeliveryInd );
+        }
+    }
+}
+
+
+QByteArray
+ChatEngine::serializeBatch( const QList<DeliverySharedPtr>& deliveries )
+{
+    proto::ServerToClientMsg msg;
+    proto::ChatMessageBatchInd* batchInd = msg.mutable_chat_message_batch_ind();
+    for( const DeliverySharedPtr& delivery : deliveries )
+    {
+        *batchInd->add_deliveries() = delivery->ind;
+    }
+    return serializePayload( msg );
+}
+
+
+void
+ChatEngine::handleFlushTimerTimeout()
+{
+    for( int channelKey : mPendingChannelKeys )
+    {
+        auto channelIter = mChannelMap.find( channelKey );
+        if( (channelIter == mChannelMap.end()) || channelIter->pending.isEmpty() ) continue;
+
+        deliver( channelIter.value(), channelIter->pending );
+        channelIter->deliveredSerial = channelIter->pending.last()->serial;
+        channelIter->pending.clear();
+    }
+    mPendingChannelKeys.clear();
+}
@@ -0,0 +1,132 @@
+#ifndef CHATENGINE_H
+#define CHATENGINE_H
+
+#include <QObject>
+
+QT_BEGIN_NAMESPACE
+class QTimer;
+QT_END_NAMESPACE
+
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QList>
+#include <QSet>
+#include <deque>
+#include <map>
+#include <memory>
+
+#include "messages.pb.h"
+
+#include "Logging.h"
+
+class ClientConnection;
+
+// Delivers chat for the lobby and for rooms.  Every logged-in user is a
+// member of the lobby channel and of at most one room channel, so finding
+// a sender's audience is a lookup.  Messages posted within a short window
+// are delivered together, and each delivery is serialized once for all
+// of a channel's members.  Senders are rate limited by a token bucket,
+// and each channel keeps its most recent messages for users who join.
+// A user returning to a room channel, e.g. after reconnecting, is only
+// sent the history it missed while away.
+class ChatEngine : public QObject
+{
+    Q_OBJECT
+
+public:
+    ChatEngine( const Logging::Config& loggingConfig = Logging::Config(),
+                QObject*               parent = 0 );
+
+    // Add a logged-in user to the lobby channel.  The user is sent the
+    // lobby's recent history.
+    void addUser( ClientConnection* clientConnection, const std::string& name, bool batchingSupported );
+
+    void removeUser( ClientConnection* clientConnection );
+
+    // Move a user into a room's channel, sending the room's recent
+    // history the user hasn't already been sent, or out of any room
+    // channel if roomId is negative.
+    void setUserRoom( ClientConnection* clientConnection, int roomId );
+
+    // Drop a room's channel and its history.
+    void removeRoomChannel( int roomId );
+
+    // Queue a chat message from a user for delivery.  Returns false if
+    // the message was dropped.  Text over 1024 bytes is truncated at a
+    // UTF-8 character boundary rather than dropped.
+    bool post( ClientConnection* clientConnection, const proto::ChatMessageInd& ind );
+
+private slots:
+
+    void handleFlushTimerTimeout();
+
+private:  // Types
+
+    // A delivery and its serialized standalone message.  Serials increase
+    // by one with each message posted to a channel.
+    struct Delivery
+    {
+        uint64_t                      serial;
+        proto::ChatMessageDeliveryInd ind;
+        QByteArray                    msg;
+    };
+    typedef std::shared_ptr<const Delivery> DeliverySharedPtr;
+
+    struct Channel
+    {
+        Channel() : lastSerial( 0 ), deliveredSerial( 0 ) {}
+
+        QSet<ClientConnection*>       members;
+        std::deque<DeliverySharedPtr> history;
+        QList<DeliverySharedPtr>      pending;
+        uint64_t                      lastSerial;
+        uint64_t                      deliveredSerial;
+
+        // Serial delivered up to when each user last left the channel.
+        std::map<std::string,uint64_t> departedSerials;
+    };
+
+    struct User
+    {
+        std::string   name;
+        bool          batchingSupported;
+        int           roomId;
+        double        tokens;
+        QElapsedTimer sinceRefill;
+    };
+
+private:  // Methods
+
+    // Take a token from the user's bucket.  Returns false if empty.
+    bool takeToken( User& user );
+
+    // Send delivered history with serials after 'afterSerial'.
+    void sendHistory( ClientConnection* clientConnection, const User& user, const Channel& channel, uint64_t afterSerial = 0 );
+
+    // Remove a user from a room channel, remembering what it was sent.
+    void leaveRoomChannel( ClientConnection* clientConnection, const User& user );
+
+    // Send deliveries to every member of a channel.
+    void deliver( const Channel& channel, const QList<DeliverySharedPtr>& deliveries );
+
+    // Serialize a batch of deliveries into a single message.
+    static QByteArray serializeBatch( const QList<DeliverySharedPtr>& deliveries );
+
+private:  // Data
+
+    // The lobby channel uses this key, rooms use their room ID.
+    static const int LOBBY_CHANNEL_KEY = -1;
+
+    QHash<int,Channel>             mChannelMap;
+    QHash<ClientConnection*,User>  mUserMap;
+
+    // Channels with pending deliveries.
+    QSet<int>                      mPendingChannelKeys;
+    QTimer*                        mFlushTimer;
+
+    Logging::Config                 mLoggingConfig;
+    std::shared_ptr<spdlog::logger> mLogger;
+};
+
+#endif
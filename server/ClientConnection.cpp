@@ -1,11 +1,38 @@
 #include "ClientConnection.h"
 
+#include <QTimer>
+
+// Bytes allowed into the socket's write buffer before queueing.
+static const qint64 SOCKET_WRITE_LIMIT_BYTES = 64 * 1024;
+
+// A client with a backlog over this size for longer than the grace time
+// is disconnected, or immediately if the backlog reaches the hard limit.
+static const qint64 BACKLOG_HIGH_WATER_BYTES = 1024 * 1024;
+static const qint64 BACKLOG_HARD_LIMIT_BYTES = 4 * BACKLOG_HIGH_WATER_BYTES;
+static const int    SLOW_CONSUMER_GRACE_MILLIS = 15000;
+
 
 ClientConnection::ClientConnection( const Logging::Config& loggingConfig, QObject* parent )
-  : NetConnection( loggingConfig, parent )
+  : NetConnection( loggingConfig, parent ),
+    mPayloadRefsSupported( false )
 {
     QObject::connect( this, &NetConnection::msgReceived, this, &ClientConnection::handleMsgReceived );
+    QObject::connect( this, &QIODevice::bytesWritten, this, &ClientConnection::handleBytesWritten );
     setRxInactivityAbortTime( 30000 );
+
+    mSlowConsumerTimer = new QTimer( this );
+    mSlowConsumerTimer->setSingleShot( true );
+    QObject::connect( mSlowConsumerTimer, &QTimer::timeout, this, &ClientConnection::handleSlowConsumerTimerTimeout );
+}
+
+
+void
+ClientConnection::setRelay( const RelayFn& relayFn )
+{
+    mRelayFn = relayFn;
+
+    // There's no socket to go quiet; the lobby watches the real one.
+    setRxInactivityAbortTime( 0 );
 }
 
 
@@ -18,7 +45,99 @@ ClientConnection::sendProtoMsg( const proto::ServerToClientMsg& protoMsg )
     msgByteArray.resize( protoSize );
     protoMsg.SerializeToArray( msgByteArray.data(), protoSize );
 
-    return sendMsg( msgByteArray );
+    return sendSerializedMsg( msgByteArray, protoMsg.msg_case(), protoMsg.has_session_sequence() );
+}
+
+
+bool
+ClientConnection::sendSerializedMsg( const QByteArray&                 msg,
+                                     proto::ServerToClientMsg::MsgCase msgCase,
+                                     bool                              sequenced )
+{
+    if( mRelayFn )
+    {
+        mRelayFn( msg, msgCase, sequenced );
+        return true;
+    }
+
+    if( state() != QAbstractSocket::ConnectedState )
+    {
+        mLogger->debug( "dropping message - not connected" );
+        return false;
+    }
+
+    // Fast path: nothing backed up.
+    if( isSendingDirect() )
+    {
+        return sendMsg( msg );
+    }
+
+    mOutboundQueue.push( msg, msgCase, sequenced );
+
+    checkBacklog();
+    return true;
+}
+
+
+bool
+ClientConnection::isSendingDirect() const
+{
+    return mOutboundQueue.empty() && (bytesToWrite() < SOCKET_WRITE_LIMIT_BYTES);
+}
+
+
+void
+ClientConnection::handleBytesWritten()
+{
+    drainQueues();
+    checkBacklog();
+}
+
+
+void
+ClientConnection::drainQueues()
+{
+    while( !mOutboundQueue.empty() && (bytesToWrite() < SOCKET_WRITE_LIMIT_BYTES) )
+    {
+        sendMsg( mOutboundQueue.pop() );
+    }
+}
+
+
+void
+ClientConnection::checkBacklog()
+{
+    const qint64 backlogBytes = getBacklogBytes();
+    if( backlogBytes >= BACKLOG_HARD_LIMIT_BYTES )
+    {
+        // Disconnect from the event loop; callers may be iterating over
+        // connections.
+        mLogger->warn( "client backlog {} bytes over hard limit", backlogBytes );
+        mSlowConsumerTimer->start( 0 );
+    }
+    else if( backlogBytes >= BACKLOG_HIGH_WATER_BYTES )
+    {
+        if( !mSlowConsumerTimer->isActive() )
+        {
+            mLogger->notice( "client backlog {} bytes over high-water mark", backlogBytes );
+            mSlowConsumerTimer->start( SLOW_CONSUMER_GRACE_MILLIS );
+        }
+    }
+    else if( mSlowConsumerTimer->isActive() )
+    {
+        mLogger->debug( "client backlog back under high-water mark" );
+        mSlowConsumerTimer->stop();
+    }
+}
+
+
+void
+ClientConnection::handleSlowConsumerTimerTimeout()
+{
+    mLogger->warn( "disconnecting slow client, backlog={} bytes", getBacklogBytes() );
+    mSlowConsumerTimer->stop();
+    mOutboundQueue.clear();
+    abort();
 }
 
 
@@ -45,4 +164,3 @@ ClientConnection::handleMsgReceived( const QByteArray& msg )
     mLogger->trace( "emitting msgReceived signal" );
     emit protoMsgReceived( protoMsg );
 }
-
@@ -1,25 +1,81 @@
 #ifndef CLIENTCONNECTION_H
 #define CLIENTCONNECTION_H
 
+#include <functional>
 #include <NetConnection.h>
 #include "messages.pb.h"
 #include "Logging.h"
+#include "OutboundMsgQueue.h"
 
+QT_BEGIN_NAMESPACE
+class QTimer;
+QT_END_NAMESPACE
+
+// Server side of a client connection.  Outbound messages are written
+// straight to the socket while the client keeps up.  Once the socket has
+// a backlog, messages are queued here instead (see OutboundMsgQueue), and
+// a client whose backlog stays over the high-water mark is dropped.
+//
+// In a room worker process a connection stands in for a client whose
+// socket is held by the lobby process.  Such a relayed connection has no
+// socket of its own: outbound messages go to the relay function and
+// inbound messages arrive through deliverRelayedMsg().  Queueing happens
+// on the lobby's side.
 class ClientConnection : public NetConnection
 {
     Q_OBJECT
 
 public:
 
+    typedef std::function<void(const QByteArray&,proto::ServerToClientMsg::MsgCase,bool)> RelayFn;
+
     ClientConnection( const Logging::Config& loggingConfig = Logging::Config(), QObject* parent = 0 );
 
+    // Make this a relayed connection.
+    void setRelay( const RelayFn& relayFn );
+    bool isRelayed() const { return static_cast<bool>( mRelayFn ); }
+
+    // Process a serialized message relayed from the client.
+    void deliverRelayedMsg( const QByteArray& msg ) { handleMsgReceived( msg ); }
+
+    // Send or queue a message.  Returns false if the message was dropped.
     bool sendProtoMsg( const proto::ServerToClientMsg& protoMsg );
 
+    // As above for a message that is already serialized.  Sequenced
+    // messages carry a session sequence and are never reordered.
+    bool sendSerializedMsg( const QByteArray&                        msg,
+                            proto::ServerToClientMsg::MsgCase        msgCase,
+                            bool                                     sequenced = false );
+
+    // True if the client resolves payload references by hash.
+    bool getPayloadRefsSupported() const { return mPayloadRefsSupported; }
+    void setPayloadRefsSupported( bool supported ) { mPayloadRefsSupported = supported; }
+
+    // Bytes queued here and in the socket.
+    qint64 getBacklogBytes() const { return mOutboundQueue.getBytes() + bytesToWrite(); }
+
+    // True if the next message sent will be written to the socket
+    // immediately rather than queued.
+    bool isSendingDirect() const;
+
 signals:
     void protoMsgReceived( const proto::ClientToServerMsg& protoMsg );
 
 private slots:
     void handleMsgReceived( const QByteArray& msg );
+    void handleBytesWritten();
+    void handleSlowConsumerTimerTimeout();
+
+private:
+
+    void drainQueues();
+    void checkBacklog();
+
+    bool    mPayloadRefsSupported;
+    RelayFn mRelayFn;
+
+    OutboundMsgQueue mOutboundQueue;
+    QTimer*          mSlowConsumerTimer;
 };
 
 #endif
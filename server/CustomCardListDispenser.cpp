@@ -71,3 +71,13 @@ CustomCardListDispenser::dispenseAll()
     reset();
     return cards;
 }
+
+
+std::size_t
+CustomCardListDispenser::getApproximateMemoryBytes() const
+{
+    std::size_t bytes = sizeof( *this );
+    for( const DraftCard& card : mCards ) bytes += ::getApproximateMemoryBytes( card );
+    for( const DraftCard& card : mCardsDispensed ) bytes += ::getApproximateMemoryBytes( card );
+    return bytes;
+}
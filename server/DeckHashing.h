@@ -2,59 +2,149 @@
 #define DECKHASHING_H
 
 #include <QString>
-#include <QStringList>
+#include <QMap>
+#include <QHash>
 #include <QRegularExpression>
 #include <QCryptographicHash>
 #include "PlayerInventory.h"
 
+// Normalize a card name as Cockatrice does for its deck hash.
 inline QString
-computeCockatriceHash( const PlayerInventory& inv )
+normalizeCockatriceCardName( const QString& cardName )
 {
-    QStringList deck;
+    static const QRegularExpression sSplitCardRegex( "\\s*/+\\s*" );
 
-    for( auto zone : { PlayerInventory::ZONE_MAIN, PlayerInventory::ZONE_SIDEBOARD } )
+    QString name = cardName;
+
+    // Replace UTF-8 chars as Cockatrice does (see Cockatrice/common/decklist.cpp).
+    name.replace( "Æ", "AE" );
+    name.replace( "’", "'" );
+
+    // Fix slashes for split cards as Cockatrice does.
+    name.replace( sSplitCardRegex, " // " );
+
+    return name.toLower();
+}
+
+
+// Maintains a Cockatrice deck hash as cards come and go.  The deck is
+// kept as a sorted multiset of normalized card lines, and the digest is
+// only computed when it's asked for after a change.
+class CockatriceDeckHash
+{
+public:
+
+    CockatriceDeckHash() : mHashValid( false ) {}
+
+    // Adjust the quantity of a card (negative to remove).
+    void adjustCard( const std::string& name, bool sideboard, int adj = 1 )
     {
-        for( auto card : inv.getCards( zone ) )
-        {
-            QString name = QString::fromStdString( card->getName() );
+        adjustLine( getCardLine( name, sideboard ), adj );
+    }
 
-            // Replace UTF-8 chars as Cockatrice does (see Cockatrice/common/decklist.cpp).
-            name.replace( "Æ", "AE" );
-            name.replace( "’", "'" );
+    void adjustBasicLand( BasicLandType basic, bool sideboard, int adj = 1 )
+    {
+        adjustLine( getCardLine( stringify( basic ), sideboard ), adj );
+    }
 
-            // Fix slashes for split cards as Cockatrice does.
-            name.replace( QRegularExpression( "\\s*/+\\s*" ), " // " );
+    void clear()
+    {
+        mLineCounts.clear();
+        mHashValid = false;
+    }
 
-            name = name.toLower();
-            if( zone == PlayerInventory::ZONE_SIDEBOARD ) name.prepend( "SB:" );
-            deck.push_back( name );
+    QString getHash() const
+    {
+        if( !mHashValid )
+        {
+            mHash = computeHash();
+            mHashValid = true;
         }
+        return mHash;
+    }
 
-        BasicLandQuantities basics = inv.getBasicLandQuantities( zone );
-        for( auto basic : gBasicLandTypeArray )
+private:
+
+    // Card names are normalized once and remembered; decks revisit the
+    // same few dozen names constantly.
+    const QString& getCardLine( const std::string& name, bool sideboard )
+    {
+        QHash<QString,QString>& lines = sideboard ? mSideboardLines : mMainLines;
+        const QString cardName = QString::fromStdString( name );
+        auto iter = lines.find( cardName );
+        if( iter == lines.end() )
         {
-            for( int i = 0; i < basics.getQuantity( basic ); ++i )
+            QString line = normalizeCockatriceCardName( cardName );
+            if( sideboard ) line.prepend( "SB:" );
+            iter = lines.insert( cardName, line );
+        }
+        return iter.value();
+    }
+
+    void adjustLine( const QString& line, int adj )
+    {
+        if( adj == 0 ) return;
+        int& count = mLineCounts[line];
+        count += adj;
+        if( count <= 0 ) mLineCounts.remove( line );
+        mHashValid = false;
+    }
+
+    QString computeHash() const
+    {
+        // Lines come out of the map sorted, as Cockatrice sorts them.
+        QString joinedDeck;
+        bool first = true;
+        for( auto iter = mLineCounts.constBegin(); iter != mLineCounts.constEnd(); ++iter )
+        {
+            for( int i = 0; i < iter.value(); ++i )
             {
-                QString name = QString::fromStdString( stringify( basic ) ).toLower();
-                if( zone == PlayerInventory::ZONE_SIDEBOARD ) name.prepend( "SB:" );
-                deck.push_back( name );
+                if( !first ) joinedDeck += ';';
+                joinedDeck += iter.key();
+                first = false;
             }
         }
+
+        QByteArray rawHash = QCryptographicHash::hash( joinedDeck.toUtf8(),
+                QCryptographicHash::Sha1 );
+        quint64 number =  (((quint64) (unsigned char) rawHash[0]) << 32)
+                        + (((quint64) (unsigned char) rawHash[1]) << 24)
+                        + (((quint64) (unsigned char) rawHash[2]) << 16)
+                        + (((quint64) (unsigned char) rawHash[3]) << 8)
+                        +   (quint64) (unsigned char) rawHash[4];
+        return QString::number( number, 32 ).rightJustified( 8, '0' );
     }
 
-    deck.sort();
-    QString joinedDeck = deck.join( ';' );
+    QMap<QString,int>      mLineCounts;
+    QHash<QString,QString> mMainLines;
+    QHash<QString,QString> mSideboardLines;
+
+    mutable QString mHash;
+    mutable bool    mHashValid;
+};
+
 
-    QByteArray rawHash = QCryptographicHash::hash( joinedDeck.toUtf8(),
-            QCryptographicHash::Sha1 );
-    quint64 number =  (((quint64) (unsigned char) rawHash[0]) << 32)
-                    + (((quint64) (unsigned char) rawHash[1]) << 24)
-                    + (((quint64) (unsigned char) rawHash[2]) << 16)
-                    + (((quint64) (unsigned char) rawHash[3]) << 8)
-                    +   (quint64) (unsigned char) rawHash[4];
-    QString hash = QString::number( number, 32 ).rightJustified( 8, '0' );
+inline QString
+computeCockatriceHash( const PlayerInventory& inv )
+{
+    CockatriceDeckHash deckHash;
+
+    for( auto zone : { PlayerInventory::ZONE_MAIN, PlayerInventory::ZONE_SIDEBOARD } )
+    {
+        const bool sideboard = (zone == PlayerInventory::ZONE_SIDEBOARD);
+        for( auto card : inv.getCards( zone ) )
+        {
+            deckHash.adjustCard( card->getName(), sideboard );
+        }
+
+        BasicLandQuantities basics = inv.getBasicLandQuantities( zone );
+        for( auto basic : gBasicLandTypeArray )
+        {
+            deckHash.adjustBasicLand( basic, sideboard, basics.getQuantity( basic ) );
+        }
+    }
 
-    return hash;
+    return deckHash.getHash();
 }
 
 #endif
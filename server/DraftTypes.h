@@ -17,6 +17,12 @@ inline bool operator==( const DraftCard& a, const DraftCard& b )
     return (a.name == b.name) && (a.setCode == b.setCode);
 }
 
+// Approximate memory held by a card, including its strings.
+inline std::size_t getApproximateMemoryBytes( const DraftCard& d )
+{
+    return sizeof( DraftCard ) + d.name.capacity() + d.setCode.capacity();
+}
+
 inline std::ostream& operator<<( std::ostream& os, const DraftCard& d )
 {
     os << '[' << d.setCode << ',' << d.name << ']';
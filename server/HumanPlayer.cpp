@@ -51,13 +51,13 @@ HumanPlayer::notifyNamedCardSelectionResult( DraftType& draft, uint32_t packId,
             // Send autoselect "time expired" indication.
             sendPlayerAutoCardSelectionInd(
                     proto::PlayerAutoCardSelectionInd::AUTO_TIMED_OUT, packId, card );
-            mInventory.add( cardData, PlayerInventory::ZONE_AUTO );
+            addToInventory( cardData, PlayerInventory::ZONE_AUTO );
         }
         else
         {
             // Send affirmative response to request.
             sendPlayerNamedCardSelectionRsp( true, packId, card );
-            mInventory.add( cardData, mNamedSelectionZone );
+            addToInventory( cardData, mNamedSelectionZone );
         }
     }
     else
@@ -94,7 +94,7 @@ HumanPlayer::notifyIndexedCardSelectionResult( DraftType& draft, uint32_t packId
                 sendPlayerAutoCardSelectionInd(
                         proto::PlayerAutoCardSelectionInd::AUTO_TIMED_OUT, packId, card );
                 auto cardData = std::make_shared<SimpleCardData>( card.name, card.setCode );
-                mInventory.add( cardData, PlayerInventory::ZONE_AUTO );
+                addToInventory( cardData, PlayerInventory::ZONE_AUTO );
             }
         }
         else
@@ -104,7 +104,7 @@ HumanPlayer::notifyIndexedCardSelectionResult( DraftType& draft, uint32_t packId
             for( const auto& card : cards )
             {
                 auto cardData = std::make_shared<SimpleCardData>( card.name, card.setCode );
-                mInventory.add( cardData, mIndexedSelectionZone );
+                addToInventory( cardData, mIndexedSelectionZone );
             }
         }
     }
@@ -133,7 +133,7 @@ HumanPlayer::notifyCardAutoselection( DraftType& draft, uint32_t packId, const D
 
     // Send autoselect indication.
     sendPlayerAutoCardSelectionInd( proto::PlayerAutoCardSelectionInd::AUTO_LAST_CARD, packId, card );
-    mInventory.add( cardData, PlayerInventory::ZONE_AUTO );
+    addToInventory( cardData, PlayerInventory::ZONE_AUTO );
 }
 
 
@@ -208,24 +208,23 @@ HumanPlayer::handleTimeExpiredBoosterRound( DraftType& draft, uint32_t packId )
 void
 HumanPlayer::handleTimeExpiredGridRound( DraftType& draft, uint32_t packId )
 {
-    GridHelper gh;
+    const GridHelper& gh = draft.getGridHelper();
     if( mPublicCardStates.size() < gh.getIndexCount() )
     {
         mLogger->warn( "less than {} cards ({}) in grid pack!", gh.getIndexCount(), mPublicCardStates.size() );
         return;
     }
 
-    // Build set of unavailable indices.
-    GridHelper::IndexSet unavailableIndices;
+    // Build mask of unavailable indices.
+    GridHelper::IndexMask unavailableMask = 0;
     for( std::size_t i = 0; i < mPublicCardStates.size(); ++i )
     {
-        if( mPublicCardStates[i].getSelectedChairIndex() != -1 ) unavailableIndices.insert( i );
+        if( mPublicCardStates[i].getSelectedChairIndex() != -1 ) unavailableMask |= GridHelper::IndexMask( 1 ) << i;
     }
 
     // Get available selections.
-    GridHelper gridHelper;
-    auto availableSelectionsMap = gridHelper.getAvailableSelectionsMap( unavailableIndices );
-    if( availableSelectionsMap.empty() )
+    const std::vector<unsigned int> availableSlices = gh.getAvailableSlices( unavailableMask );
+    if( availableSlices.empty() )
     {
         mLogger->error( "no available selections in grid pack!" );
         return;
@@ -233,12 +232,10 @@ HumanPlayer::handleTimeExpiredGridRound( DraftType& draft, uint32_t packId )
 
     // Randomly pick a selection.
     SimpleRandGen rng;
-    const int adv = rng.generateInRange( 0, availableSelectionsMap.size() - 1 );
-    auto iter = availableSelectionsMap.begin();
-    std::advance( iter, adv );
+    const unsigned int slice = availableSlices[rng.generateInRange( 0, availableSlices.size() - 1 )];
 
-    mLogger->debug( "selecting slice {}", iter->second );
-    std::vector<int> indices( iter->first.begin(), iter->first.end() );
+    mLogger->debug( "selecting slice {}", slice );
+    std::vector<int> indices = GridHelper::getIndices( gh.getSliceMask( slice ) & ~unavailableMask );
     bool result = draft.makeIndexedCardSelection( getChairIndex(), packId, indices );
 
     if( !result )
@@ -251,6 +248,10 @@ HumanPlayer::handleTimeExpiredGridRound( DraftType& draft, uint32_t packId )
 void
 HumanPlayer::handleMessageFromClient( const proto::ClientToServerMsg& msg )
 {
+    // Client messages arrive directly rather than through the room, so
+    // are accounted here.
+    RoomCpuMeter::Scope cpuScope( mCpuMeter );
+
     if( msg.has_player_named_card_preselection_ind() )
     {
         const proto::PlayerNamedCardPreselectionInd& ind = msg.player_named_card_preselection_ind();
@@ -263,7 +264,7 @@ HumanPlayer::handleMessageFromClient( const proto::ClientToServerMsg& msg )
         DraftCard card( req.card().name(), req.card().set_code() );
         mLogger->debug( "client requested named selection pack_id={},card={}", req.pack_id(), card );
         mNamedSelectionZone = convertZone( req.zone() );
-        bool result = mDraft->makeNamedCardSelection( getChairIndex(), req.pack_id(), card );
+        bool result = (mDraft != nullptr) && mDraft->makeNamedCardSelection( getChairIndex(), req.pack_id(), card );
         if( !result )
         {
             // Notify of error (currently always saying invalid card)
@@ -280,7 +281,7 @@ HumanPlayer::handleMessageFromClient( const proto::ClientToServerMsg& msg )
         }
         mLogger->debug( "client requested indexed selection pack_id={},indices={}", req.pack_id(), StringUtil::stringify( indices ) );
         mIndexedSelectionZone = convertZone( req.zone() );
-        bool result = mDraft->makeIndexedCardSelection( getChairIndex(), req.pack_id(), indices );
+        bool result = (mDraft != nullptr) && mDraft->makeIndexedCardSelection( getChairIndex(), req.pack_id(), indices );
         if( !result )
         {
             // Notify of error (currently always saying invalid card)
@@ -297,6 +298,17 @@ HumanPlayer::handleMessageFromClient( const proto::ClientToServerMsg& msg )
         const proto::PlayerInventoryUpdateInd& ind = msg.player_inventory_update_ind();
         mLogger->debug( "playerInventoryUpdate" );
 
+        if( ind.has_sequence() )
+        {
+            if( ind.sequence() <= mInventoryUpdateSequence )
+            {
+                mLogger->debug( "inventory update seq {} already applied", ind.sequence() );
+                sendPlayerInventoryUpdateAckInd( ind.sequence() );
+                return;
+            }
+            mInventoryUpdateSequence = ind.sequence();
+        }
+
         bool inSync = true;
 
         // Handle drafted card moves.
@@ -308,7 +320,7 @@ HumanPlayer::handleMessageFromClient( const proto::ClientToServerMsg& msg )
             mLogger->debug( "  {}: {} -> {}", card.name(), move.zone_from(), move.zone_to() );
             auto cardData = std::make_shared<SimpleCardData>( card.name(), card.set_code() );
 
-            bool moveOk = mInventory.move( cardData,
+            bool moveOk = moveInInventory( cardData,
                     convertZone( move.zone_from() ), convertZone( move.zone_to() ) );
             if( !moveOk )
             {
@@ -327,7 +339,7 @@ HumanPlayer::handleMessageFromClient( const proto::ClientToServerMsg& msg )
             mLogger->debug( "  {}: {} -> {}", stringify( adj.basic_land() ),
                     stringify( adj.zone() ), adj.adjustment() );
 
-            bool adjOk = mInventory.adjustBasicLand( convertBasicLand( adj.basic_land() ),
+            bool adjOk = adjustInventoryBasicLand( convertBasicLand( adj.basic_land() ),
                     convertZone( adj.zone() ), adj.adjustment() );
             if( !adjOk )
             {
@@ -338,11 +350,24 @@ HumanPlayer::handleMessageFromClient( const proto::ClientToServerMsg& msg )
             }
         }
 
+        // The client sends its own view of the checksum with sequenced
+        // updates; a mismatch means a resync is needed even though every
+        // change applied.
+        if( inSync && ind.has_checksum() && (ind.checksum() != mInventory.getChecksum()) )
+        {
+            mLogger->warn( "inventory checksum mismatch (seq {}) - client out of sync!", ind.sequence() );
+            inSync = false;
+        }
+
         if( !inSync )
         {
             mLogger->notice( "resyncing client with new inventory" );
             sendPlayerInventoryInd();
         }
+        else if( ind.has_sequence() )
+        {
+            sendPlayerInventoryUpdateAckInd( ind.sequence() );
+        }
 
         emit deckUpdate();
     }
@@ -433,6 +458,17 @@ HumanPlayer::sendPlayerInventoryInd() const
 }
 
 
+void
+HumanPlayer::sendPlayerInventoryUpdateAckInd( uint32_t sequence ) const
+{
+    mLogger->trace( "sendPlayerInventoryUpdateAckInd seq={}", sequence );
+    proto::ServerToClientMsg msg;
+    proto::PlayerInventoryUpdateAckInd* ind = msg.mutable_player_inventory_update_ack_ind();
+    ind->set_sequence( sequence );
+    sendServerToClientMsg( msg );
+}
+
+
 void
 HumanPlayer::sendCurrentPackInd() const
 {
@@ -535,12 +571,112 @@ HumanPlayer::sendPlayerAutoCardSelectionInd( proto::PlayerAutoCardSelectionInd::
 void
 HumanPlayer::sendServerToClientMsg( const proto::ServerToClientMsg& msg ) const
 {
+    // Stamp the message with the session sequence and record it, even
+    // without a connection, so a resuming client can catch up.
+    proto::ServerToClientMsg sequencedMsg( msg );
+    sequencedMsg.set_session_sequence( mReplayRing.getNextSequence() );
+
+    const int protoSize = sequencedMsg.ByteSize();
+    QByteArray msgByteArray;
+    msgByteArray.resize( protoSize );
+    sequencedMsg.SerializeToArray( msgByteArray.data(), protoSize );
+    mReplayRing.record( msgByteArray, msg.msg_case() );
+
     if( mClientConnection != 0 )
     {
-        mClientConnection->sendProtoMsg( msg );
+        mClientConnection->sendSerializedMsg( msgByteArray, msg.msg_case(), true );
     }
     else
     {
-        mLogger->debug( "dropping message - no client connection" );
+        mLogger->debug( "buffering message seq={} - no client connection", sequencedMsg.session_sequence() );
+    }
+}
+
+
+bool
+HumanPlayer::replayAfter( uint32_t lastSequence )
+{
+    if( (mClientConnection == 0) || !mReplayRing.canReplayAfter( lastSequence ) )
+    {
+        return false;
+    }
+
+    const QList<SessionReplayRing::Entry> entries = mReplayRing.getMessagesAfter( lastSequence );
+    mLogger->debug( "replaying {} messages after seq {}", entries.size(), lastSequence );
+    for( const SessionReplayRing::Entry& entry : entries )
+    {
+        mClientConnection->sendSerializedMsg( entry.msg, entry.msgCase, true );
+    }
+    return true;
+}
+
+
+void
+HumanPlayer::addToInventory( const std::shared_ptr<CardData>& cardData, PlayerInventory::ZoneType zone )
+{
+    if( !mInventory.add( cardData, zone ) ) return;
+
+    if( (zone == PlayerInventory::ZONE_MAIN) || (zone == PlayerInventory::ZONE_SIDEBOARD) )
+    {
+        mDeckHash.adjustCard( cardData->getName(), zone == PlayerInventory::ZONE_SIDEBOARD );
+    }
+}
+
+
+bool
+HumanPlayer::moveInInventory( const std::shared_ptr<CardData>& cardData, PlayerInventory::ZoneType zoneFrom, PlayerInventory::ZoneType zoneTo )
+{
+    if( !mInventory.move( cardData, zoneFrom, zoneTo ) ) return false;
+
+    if( (zoneFrom == PlayerInventory::ZONE_MAIN) || (zoneFrom == PlayerInventory::ZONE_SIDEBOARD) )
+    {
+        mDeckHash.adjustCard( cardData->getName(), zoneFrom == PlayerInventory::ZONE_SIDEBOARD, -1 );
+    }
+    if( (zoneTo == PlayerInventory::ZONE_MAIN) || (zoneTo == PlayerInventory::ZONE_SIDEBOARD) )
+    {
+        mDeckHash.adjustCard( cardData->getName(), zoneTo == PlayerInventory::ZONE_SIDEBOARD );
+    }
+    return true;
+}
+
+
+bool
+HumanPlayer::adjustInventoryBasicLand( BasicLandType basic, PlayerInventory::ZoneType zone, int adj )
+{
+    if( !mInventory.adjustBasicLand( basic, zone, adj ) ) return false;
+
+    if( (zone == PlayerInventory::ZONE_MAIN) || (zone == PlayerInventory::ZONE_SIDEBOARD) )
+    {
+        mDeckHash.adjustBasicLand( basic, zone == PlayerInventory::ZONE_SIDEBOARD, adj );
+    }
+    return true;
+}
+
+
+void
+HumanPlayer::releaseDraft()
+{
+    mDraft = nullptr;
+    mCurrentPackPresent = false;
+    mPreselectedCard = nullptr;
+
+    // Swap rather than clear to give back the capacity.
+    std::vector<DraftCard>().swap( mCurrentPackUnselectedCards );
+    std::vector<PublicCardState>().swap( mPublicCardStates );
+}
+
+
+std::size_t
+HumanPlayer::getApproximateMemoryBytes() const
+{
+    // Inventory cards are shared card data objects with control blocks.
+    std::size_t bytes = sizeof( *this ) +
+            mInventory.size() * (sizeof( SimpleCardData ) + sizeof( PlayerInventory::CardDataSharedPtr ) + 2 * sizeof( void* )) +
+            mPublicCardStates.size() * sizeof( PublicCardState ) +
+            mReplayRing.getApproximateMemoryBytes();
+    for( const DraftCard& card : mCurrentPackUnselectedCards )
+    {
+        bytes += ::getApproximateMemoryBytes( card );
     }
+    return bytes;
 }
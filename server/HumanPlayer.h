@@ -2,27 +2,35 @@
 #define HUMANPLAYER_H
 
 #include <QObject>
+#include <random>
 #include "Draft.h"
 #include "DraftTypes.h"
 #include "Player.h"
 #include "ClientConnection.h"
 #include "PlayerInventory.h"
 #include "DeckHashing.h"
+#include "SessionReplayRing.h"
+#include "RoomCpuMeter.h"
 
 // send messages via clientconnection, and register for clientconnection newmsg signal, filtering on what's important
 class HumanPlayer : public QObject, public Player {
     Q_OBJECT
 public:
-    HumanPlayer( int chairIndex, DraftType* draft, Logging::Config loggingConfig = Logging::Config(), QObject* parent = 0 )
+    HumanPlayer( int chairIndex, DraftType* draft, RoomCpuMeter& cpuMeter, Logging::Config loggingConfig = Logging::Config(), QObject* parent = 0 )
       : QObject( parent ),
         Player( chairIndex ),
         mClientConnection( 0 ),
         mDraft( draft ),
+        mCpuMeter( cpuMeter ),
         mTimeExpired( false ),
+        mInventoryUpdateSequence( 0 ),
         mCurrentPackPresent( false ),
         mLogger( loggingConfig.createLogger() )
     {
         setName( "human " + std::to_string( chairIndex ) );
+
+        std::random_device rd;
+        mResumeToken = (static_cast<uint64_t>( rd() ) << 32) | rd();
     }
 
     // Observer callbacks.  Many are no-ops that are handled by a room-wide observer.
@@ -43,9 +51,30 @@ public:
     void removeClientConnection();
 
     void sendInventoryToClient() const { sendPlayerInventoryInd(); }
+
+    // A client joining without resuming starts its inventory update
+    // sequence over.
+    void resetInventoryUpdateSequence() { mInventoryUpdateSequence = 0; }
     void sendCurrentPackToClient() const { sendCurrentPackInd(); }
 
-    QString getCockatriceHash() const { return computeCockatriceHash( mInventory ); }
+    // Hash is maintained incrementally and only digested when asked for.
+    QString getCockatriceHash() const { return mDeckHash.getHash(); }
+
+    // Send a message to the client, sequenced and recorded for replay.
+    void sendServerToClientMsg( const proto::ServerToClientMsg& msg ) const;
+
+    // Session resume support.  The token is handed to the client when it
+    // joins and must be presented to resume.
+    uint64_t getResumeToken() const { return mResumeToken; }
+    bool canReplayAfter( uint32_t lastSequence ) const { return mReplayRing.canReplayAfter( lastSequence ); }
+    bool replayAfter( uint32_t lastSequence );
+
+    // Detach from a completed draft that is about to be destroyed, dropping
+    // pack state.  Card selections are refused from then on.
+    void releaseDraft();
+
+    // Approximate memory held by the player's inventory, pack and replay state.
+    std::size_t getApproximateMemoryBytes() const;
 
 signals:
     void readyUpdate( bool ready );
@@ -58,18 +87,28 @@ private:
     void handleTimeExpiredBoosterRound( DraftType& draft, uint32_t packId );
     void handleTimeExpiredGridRound( DraftType& draft, uint32_t packId );
     void sendPlayerInventoryInd() const;
+    void sendPlayerInventoryUpdateAckInd( uint32_t sequence ) const;
     void sendPlayerNamedCardSelectionRsp( bool result, int packId, const DraftCard& card );
     void sendPlayerIndexedCardSelectionRsp( bool result, int packId, const std::vector<int> selectionIndices, const std::vector<DraftCard>& cards );
     void sendCurrentPackInd() const;
     void sendPlayerAutoCardSelectionInd( proto::PlayerAutoCardSelectionInd::AutoType type, int packId, const DraftCard& card );
 
-    void sendServerToClientMsg( const proto::ServerToClientMsg& msg ) const;
+    // Inventory changes go through these to keep the deck hash current.
+    void addToInventory( const std::shared_ptr<CardData>& cardData, PlayerInventory::ZoneType zone );
+    bool moveInInventory( const std::shared_ptr<CardData>& cardData, PlayerInventory::ZoneType zoneFrom, PlayerInventory::ZoneType zoneTo );
+    bool adjustInventoryBasicLand( BasicLandType basic, PlayerInventory::ZoneType zone, int adj );
 
     ClientConnection* mClientConnection;
     DraftType*        mDraft;
+    RoomCpuMeter&     mCpuMeter;
     PlayerInventory   mInventory;
+    CockatriceDeckHash mDeckHash;
     bool              mTimeExpired;
 
+    // Last inventory update applied.  Updates resent after a session
+    // resume that were already applied are only acknowledged.
+    uint32_t          mInventoryUpdateSequence;
+
     bool                       mCurrentPackPresent;
     uint32_t                   mCurrentPackId;
     std::vector<DraftCard>     mCurrentPackUnselectedCards;
@@ -80,6 +119,9 @@ private:
     PlayerInventory::ZoneType mNamedSelectionZone;
     PlayerInventory::ZoneType mIndexedSelectionZone;
 
+    uint64_t                  mResumeToken;
+    mutable SessionReplayRing mReplayRing;
+
     std::shared_ptr<spdlog::logger> mLogger;
 };
 
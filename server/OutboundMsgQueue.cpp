@@ -0,0 +1,90 @@
+#include "OutboundMsgQueue.h"
+
+enum OutboundMsgClass
+{
+    OUTBOUND_MSG_CLASS_NORMAL,
+    OUTBOUND_MSG_CLASS_PRIORITY,
+    OUTBOUND_MSG_CLASS_SNAPSHOT,
+    OUTBOUND_MSG_CLASS_BARRIER     // priority messages may not overtake
+};
+
+
+static OutboundMsgClass
+getOutboundMsgClass( proto::ServerToClientMsg::MsgCase msgCase )
+{
+    switch( msgCase )
+    {
+        case proto::ServerToClientMsg::kPlayerCurrentPackInd:
+        case proto::ServerToClientMsg::kPlayerNamedCardSelectionRsp:
+        case proto::ServerToClientMsg::kPlayerIndexedCardSelectionRsp:
+        case proto::ServerToClientMsg::kPlayerAutoCardSelectionInd:
+            return OUTBOUND_MSG_CLASS_PRIORITY;
+        case proto::ServerToClientMsg::kPublicStateInd:
+        case proto::ServerToClientMsg::kBoosterDraftStateInd:
+        case proto::ServerToClientMsg::kRoomOccupantsInfoInd:
+            return OUTBOUND_MSG_CLASS_SNAPSHOT;
+        case proto::ServerToClientMsg::kJoinRoomSuccessRspind:
+        case proto::ServerToClientMsg::kRoomStageInd:
+        case proto::ServerToClientMsg::kPlayerInventoryInd:
+            return OUTBOUND_MSG_CLASS_BARRIER;
+        default:
+            return OUTBOUND_MSG_CLASS_NORMAL;
+    }
+}
+
+
+void
+OutboundMsgQueue::push( const QByteArray& msg, proto::ServerToClientMsg::MsgCase msgCase, bool sequenced )
+{
+    const OutboundMsgClass msgClass = getOutboundMsgClass( msgCase );
+    const bool barrier = sequenced || (msgClass == OUTBOUND_MSG_CLASS_BARRIER);
+
+    if( (msgClass == OUTBOUND_MSG_CLASS_PRIORITY) && (mBarrierCount == 0) )
+    {
+        mPriorityQueue.push_back( Entry{ msg, msgCase, barrier } );
+    }
+    else
+    {
+        if( msgClass == OUTBOUND_MSG_CLASS_SNAPSHOT )
+        {
+            // The new snapshot makes any queued one obsolete.  A client
+            // skipping a replaced sequenced snapshot misses nothing, as
+            // the replacement comes later in the sequence.
+            for( auto iter = mNormalQueue.begin(); iter != mNormalQueue.end(); ++iter )
+            {
+                if( iter->msgCase == msgCase )
+                {
+                    mBytes -= iter->msg.size();
+                    if( iter->barrier ) mBarrierCount--;
+                    mNormalQueue.erase( iter );
+                    break;
+                }
+            }
+        }
+        mNormalQueue.push_back( Entry{ msg, msgCase, barrier } );
+        if( barrier ) mBarrierCount++;
+    }
+    mBytes += msg.size();
+}
+
+
+QByteArray
+OutboundMsgQueue::pop()
+{
+    EntryQueue& queue = !mPriorityQueue.empty() ? mPriorityQueue : mNormalQueue;
+    const QByteArray msg = queue.front().msg;
+    if( (&queue == &mNormalQueue) && queue.front().barrier ) mBarrierCount--;
+    mBytes -= msg.size();
+    queue.pop_front();
+    return msg;
+}
+
+
+void
+OutboundMsgQueue::clear()
+{
+    mPriorityQueue.clear();
+    mNormalQueue.clear();
+    mBytes = 0;
+    mBarrierCount = 0;
+}
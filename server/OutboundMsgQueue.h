@@ -0,0 +1,54 @@
+#ifndef OUTBOUNDMSGQUEUE_H
+#define OUTBOUNDMSGQUEUE_H
+
+#include <deque>
+#include <QByteArray>
+#include "messages.pb.h"
+
+// Messages waiting for a client that isn't keeping up.  Messages come
+// out in the order they went in, except that:
+//   - pick-critical messages (current pack, selection results) go ahead
+//     of other queued messages, but never overtake a queued room join,
+//     stage, full inventory or session-sequenced message.  A resuming
+//     client asks for what came after the highest sequence it has seen,
+//     so sequenced messages must arrive in order.
+//   - state snapshots (public state, draft state, occupants) replace any
+//     queued predecessor of the same type.
+class OutboundMsgQueue
+{
+public:
+
+    OutboundMsgQueue() : mBytes( 0 ), mBarrierCount( 0 ) {}
+
+    void push( const QByteArray& msg, proto::ServerToClientMsg::MsgCase msgCase, bool sequenced );
+
+    // Remove and return the next message to send.  The queue must not be
+    // empty.
+    QByteArray pop();
+
+    bool empty() const { return mPriorityQueue.empty() && mNormalQueue.empty(); }
+
+    // Bytes of messages queued.
+    qint64 getBytes() const { return mBytes; }
+
+    void clear();
+
+private:
+
+    struct Entry
+    {
+        QByteArray                        msg;
+        proto::ServerToClientMsg::MsgCase msgCase;
+        bool                              barrier;   // may not be overtaken
+    };
+    typedef std::deque<Entry> EntryQueue;
+
+    EntryQueue mPriorityQueue;
+    EntryQueue mNormalQueue;
+    qint64     mBytes;
+
+    // Barriers in the normal queue.
+    int        mBarrierCount;
+};
+
+#endif
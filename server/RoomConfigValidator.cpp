@@ -1,6 +1,6 @@
 #include "RoomConfigValidator.h"
 #include "DraftConfig.pb.h"
-#include <algorithm>
+#include "GridHelper.h"
 
 
 RoomConfigValidator::RoomConfigValidator(
@@ -67,7 +67,6 @@ RoomConfigValidator::validate( const proto::RoomConfig& roomConfig, ResultType&
     // Custom card list dispensers must have a nonzero amount of cards
     //
 
-    std::vector<std::string> allSetCodes = mAllSetsData->getSetCodes();
     int sources = 0;
     for( int i = 0; i < draftConfig.dispensers_size(); ++i )
     {
@@ -76,9 +75,7 @@ RoomConfigValidator::validate( const proto::RoomConfig& roomConfig, ResultType&
             // Check for valid set code.
             const std::string setCode = draftConfig.dispensers( i ).source_booster_set_codes( j );
 
-            // OPTIMIZATION: Why isn't AllSetsData returning a set instead of
-            // a vector?  Would be a much faster search here.
-            if( std::find( allSetCodes.begin(), allSetCodes.end(), setCode ) == allSetCodes.end() )
+            if( !mAllSetsData->hasSetCode( setCode ) )
             {
                 mLogger->warn( "Card dispenser {} uses invalid set code {}", i, setCode );
                 failureResult = proto::CreateRoomFailureRsp::RESULT_INVALID_SET_CODE;
@@ -205,6 +202,14 @@ RoomConfigValidator::validate( const proto::RoomConfig& roomConfig, ResultType&
                 failureResult = proto::CreateRoomFailureRsp::RESULT_INVALID_ROUND_CONFIG;
                 return false;
             }
+
+            // Grid must fit within the selection masks.
+            if( !GridHelper::isValidSize( round.grid_round().rows(), round.grid_round().cols() ) )
+            {
+                mLogger->warn( "Grid round has an invalid size {}x{}", round.grid_round().rows(), round.grid_round().cols() );
+                failureResult = proto::CreateRoomFailureRsp::RESULT_INVALID_ROUND_CONFIG;
+                return false;
+            }
         }
         else
         {
@@ -0,0 +1,50 @@
+#ifndef ROOMCPUMETER_H
+#define ROOMCPUMETER_H
+
+#include <cstdint>
+#include <QElapsedTimer>
+
+// Accumulates the time a room spends handling events.  Rooms run on a
+// single event loop thread, so time spent inside a room's handlers is
+// time the rest of that thread's rooms are kept waiting.  Handlers open
+// a Scope for the duration of their work; scopes nest (handlers call
+// into draft observers that call back into the room) and only the
+// outermost scope is counted.
+class RoomCpuMeter
+{
+public:
+
+    class Scope
+    {
+    public:
+        explicit Scope( RoomCpuMeter& meter ) : mMeter( meter )
+        {
+            if( mMeter.mDepth++ == 0 ) mTimer.start();
+        }
+
+        ~Scope()
+        {
+            if( --mMeter.mDepth == 0 ) mMeter.mNanos += mTimer.nsecsElapsed();
+        }
+
+        Scope( const Scope& ) = delete;
+        Scope& operator=( const Scope& ) = delete;
+
+    private:
+        RoomCpuMeter& mMeter;
+        QElapsedTimer mTimer;
+    };
+
+    RoomCpuMeter() : mNanos( 0 ), mDepth( 0 ) {}
+
+    // Total time spent in scopes.
+    int64_t getNanos() const { return mNanos; }
+    int64_t getMillis() const { return mNanos / 1000000; }
+
+private:
+
+    int64_t      mNanos;
+    unsigned int mDepth;
+};
+
+#endif
@@ -0,0 +1,53 @@
+#ifndef ROOMDIAGNOSTICS_H
+#define ROOMDIAGNOSTICS_H
+
+#include <cstdint>
+#include <string>
+
+// Snapshot of a room's health for the admin shell.
+struct RoomDiagnostics
+{
+    RoomDiagnostics()
+      : roomId( 0 ),
+        workerIndex( -1 ),
+        playerCount( 0 ),
+        chairCount( 0 ),
+        memoryBytes( 0 ),
+        tickLagMillis( 0 ),
+        maxTickLagMillis( 0 ),
+        cpuMillis( 0 ),
+        cpuPercent( 0 ),
+        overBudget( false )
+    {}
+
+    unsigned int roomId;
+    std::string  name;
+
+    // Worker process hosting the room, or -1 if hosted by the lobby.
+    int          workerIndex;
+
+    // Draft progress, e.g. "waiting", "round 2/3", "complete".  Empty if
+    // not yet reported by the room's worker.
+    std::string  phase;
+
+    unsigned int playerCount;
+    unsigned int chairCount;
+
+    // Approximate memory held by the room.
+    uint64_t     memoryBytes;
+
+    // How late the draft timer's most recent tick was, and the latest
+    // it has been.
+    int          tickLagMillis;
+    int          maxTickLagMillis;
+
+    // Time spent handling the room's events, in total and as a share of
+    // the most recent limit check interval.
+    uint64_t     cpuMillis;
+    unsigned int cpuPercent;
+
+    // Whether the room exceeded its limits at the most recent check.
+    bool         overBudget;
+};
+
+#endif
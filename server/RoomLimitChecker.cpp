@@ -0,0 +1,29 @@
+#include "RoomLimitChecker.h"
+
+
+RoomLimitChecker::Step
+RoomLimitChecker::check( unsigned int cpuPercent, uint64_t memoryBytes )
+{
+    if( mExpired ) return STEP_NONE;
+
+    const bool cpuOver = (mLimits.cpuPercent > 0) && (cpuPercent > mLimits.cpuPercent);
+    const bool memoryOver = (mLimits.memoryBytes > 0) && (memoryBytes > mLimits.memoryBytes);
+
+    // Only act when crossing into or out of budget.
+    const bool overBudget = cpuOver || memoryOver;
+    if( overBudget == mOverBudget ) return STEP_NONE;
+    mOverBudget = overBudget;
+
+    if( !overBudget ) return STEP_RECOVER;
+
+    switch( mLimits.action )
+    {
+        case RoomLimits::ACTION_DEGRADE:
+            return STEP_DEGRADE;
+        case RoomLimits::ACTION_EXPIRE:
+            mExpired = true;
+            return STEP_EXPIRE;
+        default:
+            return STEP_LOG;
+    }
+}
@@ -0,0 +1,41 @@
+#ifndef ROOMLIMITCHECKER_H
+#define ROOMLIMITCHECKER_H
+
+#include <cstdint>
+#include "RoomLimits.h"
+
+// Decides what a room does about its measured resource use.  Steps are
+// only returned when the room crosses into or out of budget, and an
+// expired room gets no further steps.
+class RoomLimitChecker
+{
+public:
+
+    enum Step
+    {
+        STEP_NONE,      // no change
+        STEP_LOG,       // went over budget, log only
+        STEP_DEGRADE,   // went over budget, send fewer updates
+        STEP_EXPIRE,    // went over budget, close the room
+        STEP_RECOVER    // back within budget
+    };
+
+    explicit RoomLimitChecker( const RoomLimits& limits )
+      : mLimits( limits ),
+        mOverBudget( false ),
+        mExpired( false )
+    {}
+
+    Step check( unsigned int cpuPercent, uint64_t memoryBytes );
+
+    const RoomLimits& getLimits() const { return mLimits; }
+    bool isOverBudget() const { return mOverBudget; }
+
+private:
+
+    const RoomLimits mLimits;
+    bool             mOverBudget;
+    bool             mExpired;
+};
+
+#endif
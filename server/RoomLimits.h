@@ -0,0 +1,46 @@
+#ifndef ROOMLIMITS_H
+#define ROOMLIMITS_H
+
+#include <cstdint>
+#include <string>
+
+// Per-room resource budgets.  A limit of 0 is unlimited.
+struct RoomLimits
+{
+    // What happens to a room over budget.
+    enum Action
+    {
+        ACTION_LOG,       // log a warning only
+        ACTION_DEGRADE,   // log, and send the room's clients fewer updates
+        ACTION_EXPIRE     // log, and close the room
+    };
+
+    RoomLimits()
+      : cpuPercent( 0 ),
+        memoryBytes( 0 ),
+        action( ACTION_LOG )
+    {}
+
+    // Share of the event loop thread the room may use, averaged over the
+    // limit check interval.
+    unsigned int cpuPercent;
+
+    // Approximate memory the room may hold.
+    uint64_t     memoryBytes;
+
+    Action       action;
+};
+
+
+inline std::string stringify( const RoomLimits::Action& action )
+{
+    switch( action )
+    {
+        case RoomLimits::ACTION_LOG:     return "log";
+        case RoomLimits::ACTION_DEGRADE: return "degrade";
+        case RoomLimits::ACTION_EXPIRE:  return "expire";
+        default:                         return std::string();
+    }
+}
+
+#endif
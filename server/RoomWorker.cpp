@@ -0,0 +1,441 @@
+#include "RoomWorker.h"
+
+#include <QLocalSocket>
+#include <QCoreApplication>
+#include <QTimer>
+
+#include <ctime>
+
+#include "WorkerLink.h"
+#include "ClientConnection.h"
+#include "ServerRoom.h"
+#include "CardDispenserFactory.h"
+
+// How often load is reported to the lobby.
+static const int LOAD_REPORT_INTERVAL_MILLIS = 2000;
+
+static const int LOBBY_CONNECT_TIMEOUT_MILLIS = 5000;
+
+
+RoomWorker::RoomWorker( const QString&                            lobbyServerName,
+                        unsigned int                              workerIndex,
+                        const QString&                            secret,
+                        const std::shared_ptr<const AllSetsData>& allSetsData,
+                        const Logging::Config&                    loggingConfig,
+                        QObject*                                  parent )
+:   QObject( parent ),
+    mLobbyServerName( lobbyServerName ),
+    mWorkerIndex( workerIndex ),
+    mSecret( secret ),
+    mAllSetsData( allSetsData ),
+    mMtgJsonAllSetsData( std::dynamic_pointer_cast<const MtgJsonAllSetsData>( allSetsData ) ),
+    mLink( nullptr ),
+    mLoggingConfig( loggingConfig ),
+    mLogger( mLoggingConfig.createLogger() )
+{
+    mLoadReportTimer = new QTimer( this );
+    connect( mLoadReportTimer, &QTimer::timeout, this, &RoomWorker::handleLoadReportTimerTimeout );
+}
+
+
+RoomWorker::~RoomWorker()
+{
+    mLogger->trace( "~RoomWorker" );
+
+    // Delete rooms.
+    for( auto iter = mRoomMap.begin(); iter != mRoomMap.end(); ++iter )
+    {
+        ServerRoom* room = iter.value();
+        room->deleteLater();
+    }
+    mRoomMap.clear();
+}
+
+
+void
+RoomWorker::start()
+{
+    QLocalSocket* socket = new QLocalSocket();
+    socket->connectToServer( mLobbyServerName );
+    if( !socket->waitForConnected( LOBBY_CONNECT_TIMEOUT_MILLIS ) )
+    {
+        mLogger->critical( "Unable to connect to lobby at {}: {}", mLobbyServerName, socket->errorString() );
+        delete socket;
+        emit finished();
+        return;
+    }
+
+    mLink = new WorkerLink( socket, mLoggingConfig.createChildConfig( "workerlink" ), this );
+    connect( mLink, &WorkerLink::workerMsgReceived, this, &RoomWorker::handleWorkerMsg );
+    connect( mLink, &WorkerLink::relayedMsgReceived, this, &RoomWorker::handleRelayedMsg );
+    connect( mLink, &WorkerLink::disconnected, this, &RoomWorker::handleLinkDisconnected );
+
+    proto::WorkerMsg msg;
+    proto::WorkerHelloInd* ind = msg.mutable_hello_ind();
+    ind->set_worker_index( mWorkerIndex );
+    ind->set_pid( QCoreApplication::applicationPid() );
+    ind->set_secret( mSecret.toStdString() );
+    mLink->sendWorkerMsg( msg );
+
+    handleLoadReportTimerTimeout();
+    mLoadReportTimer->start( LOAD_REPORT_INTERVAL_MILLIS );
+
+    mLogger->notice( "Room worker {} connected to lobby", mWorkerIndex );
+}
+
+
+void
+RoomWorker::handleLinkDisconnected()
+{
+    // Without the lobby there are no clients to serve.
+    mLogger->critical( "lost connection to lobby" );
+    mLoadReportTimer->stop();
+    emit finished();
+}
+
+
+void
+RoomWorker::handleWorkerMsg( const proto::WorkerMsg& msg )
+{
+    if( msg.has_create_room_req() )
+    {
+        processCreateRoomReq( msg.create_room_req() );
+    }
+    else if( msg.has_attach_client_ind() )
+    {
+        processAttachClientInd( msg.attach_client_ind() );
+    }
+    else if( msg.has_detach_client_ind() )
+    {
+        processDetachClientInd( msg.detach_client_ind() );
+    }
+    else if( msg.has_rejoin_room_req() )
+    {
+        processRejoinRoomReq( msg.rejoin_room_req() );
+    }
+    else
+    {
+        mLogger->warn( "unhandled worker message: {}", msg.msg_case() );
+    }
+}
+
+
+void
+RoomWorker::handleRelayedMsg( quint32 connId, const QByteArray& msg, quint32 tag )
+{
+    ClientConnection* clientConnection = mClientConnectionMap.value( connId, nullptr );
+    if( clientConnection == nullptr )
+    {
+        // Normal if the message crossed paths with a detach.
+        mLogger->debug( "dropping message for unknown connection {}", connId );
+        return;
+    }
+    clientConnection->deliverRelayedMsg( msg );
+}
+
+
+void
+RoomWorker::handleMessageFromClient( const proto::ClientToServerMsg& msg )
+{
+    // Only room membership is handled here; draft messaging goes straight
+    // to the connection's HumanPlayer.
+
+    ClientConnection *clientConnection = qobject_cast<ClientConnection *>(QObject::sender());
+    const quint32 connId = mClientConnectionIdMap.value( clientConnection );
+
+    if( msg.has_join_room_req() )
+    {
+        const proto::JoinRoomReq& req = msg.join_room_req();
+        const unsigned int roomId = req.room_id();
+        const std::string& password = req.has_password() ? req.password() : std::string();
+        const std::string loginName = mClientConnectionLoginMap.value( clientConnection );
+
+        ServerRoom* room = mRoomMap.value( roomId, nullptr );
+        if( room != nullptr )
+        {
+            int chairIndex = -1;
+            const proto::SessionResume* sessionResume =
+                    req.has_session_resume() ? &req.session_resume() : nullptr;
+            bool result = room->join( clientConnection, loginName, password, chairIndex, sessionResume );
+            if( result )
+            {
+                sendClientRoomInd( connId, roomId );
+            }
+            else
+            {
+                // This is normal, e.g. room full or bad password.
+                mLogger->info( "{} failed to join room", loginName );
+            }
+        }
+        else
+        {
+            sendJoinRoomFailureRsp( clientConnection,
+                    proto::JoinRoomFailureRsp::RESULT_INVALID_ROOM, roomId );
+        }
+    }
+    else if( msg.has_depart_room_ind() )
+    {
+        ServerRoom* room = findRoomWithConnection( clientConnection );
+        if( room != nullptr )
+        {
+            room->leave( clientConnection );
+            sendClientRoomInd( connId, -1 );
+        }
+    }
+}
+
+
+void
+RoomWorker::processCreateRoomReq( const proto::WorkerCreateRoomReq& req )
+{
+    const unsigned int roomId = req.room_id();
+    const proto::RoomConfig& roomConfig = req.room_config();
+
+    if( mRoomMap.contains( roomId ) )
+    {
+        mLogger->error( "room {} already exists!", roomId );
+        sendCreateRoomRsp( roomId, false );
+        return;
+    }
+
+    // Create dispensers.
+    CardDispenserFactory factory( mAllSetsData );
+    DraftCardDispenserSharedPtrVector<DraftCard> dispensers =
+            factory.createCardDispensers( roomConfig.draft_config() );
+    if( dispensers.empty() )
+    {
+        mLogger->warn( "error creating configurations" );
+        sendCreateRoomRsp( roomId, false, proto::CreateRoomFailureRsp::RESULT_INVALID_DISPENSER_CONFIG );
+        return;
+    }
+
+    // Create room.
+    const std::string& password = req.has_password() ? req.password() : std::string();
+    RoomLimits limits;
+    limits.cpuPercent = req.limits().cpu_percent();
+    limits.memoryBytes = req.limits().memory_bytes();
+    limits.action = static_cast<RoomLimits::Action>( req.limits().action() );
+    const QString loggingConfigName = "serverroom-" + QString::number( roomId );
+    ServerRoom* room = new ServerRoom( roomId, password, roomConfig, dispensers, limits,
+            mLoggingConfig.createChildConfig( loggingConfigName.toStdString() ), this );
+    mRoomMap[roomId] = room;
+    connect( room, &ServerRoom::playerCountChanged, this, &RoomWorker::handleRoomPlayerCountChanged );
+    connect( room, &ServerRoom::roomExpired, this, &RoomWorker::handleRoomExpired );
+    connect( room, &ServerRoom::roomError, this, &RoomWorker::handleRoomError );
+
+    mLogger->info( "created room {}", roomId );
+    sendCreateRoomRsp( roomId, true );
+}
+
+
+void
+RoomWorker::processAttachClientInd( const proto::WorkerAttachClientInd& ind )
+{
+    const quint32 connId = ind.conn_id();
+    ClientConnection* clientConnection = mClientConnectionMap.value( connId, nullptr );
+    if( clientConnection == nullptr )
+    {
+        clientConnection = new ClientConnection( mLoggingConfig.createChildConfig( "clientconnection" ), this );
+        clientConnection->setRelay(
+            [this,connId]( const QByteArray& msg, proto::ServerToClientMsg::MsgCase msgCase, bool sequenced ) {
+                const quint32 tag = static_cast<quint32>( msgCase ) | (sequenced ? WorkerLink::RELAY_TAG_SEQUENCED : 0);
+                if( mLink != nullptr ) mLink->sendRelayedMsg( connId, msg, tag );
+            } );
+        connect( clientConnection, &ClientConnection::protoMsgReceived,
+                 this,             &RoomWorker::handleMessageFromClient );
+
+        mClientConnectionMap.insert( connId, clientConnection );
+        mClientConnectionIdMap.insert( clientConnection, connId );
+    }
+
+    mLogger->debug( "attached client {} as connection {}", ind.name(), connId );
+    mClientConnectionLoginMap.insert( clientConnection, ind.name() );
+    clientConnection->setPayloadRefsSupported( ind.payload_refs_supported() );
+}
+
+
+void
+RoomWorker::processDetachClientInd( const proto::WorkerDetachClientInd& ind )
+{
+    const quint32 connId = ind.conn_id();
+    ClientConnection* clientConnection = mClientConnectionMap.take( connId );
+    if( clientConnection == nullptr ) return;
+
+    mLogger->debug( "detaching connection {}", connId );
+
+    // If the client is in a room, remove it.
+    ServerRoom* room = findRoomWithConnection( clientConnection );
+    if( room != nullptr )
+    {
+        room->leave( clientConnection );
+    }
+
+    mClientConnectionIdMap.remove( clientConnection );
+    mClientConnectionLoginMap.remove( clientConnection );
+    clientConnection->deleteLater();
+}
+
+
+void
+RoomWorker::processRejoinRoomReq( const proto::WorkerRejoinRoomReq& req )
+{
+    ClientConnection* clientConnection = mClientConnectionMap.value( req.conn_id(), nullptr );
+    ServerRoom* room = mRoomMap.value( req.room_id(), nullptr );
+    if( (clientConnection == nullptr) || (room == nullptr) )
+    {
+        mLogger->warn( "cannot rejoin connection {} to room {}", req.conn_id(), req.room_id() );
+        return;
+    }
+
+    const std::string name = mClientConnectionLoginMap.value( clientConnection );
+    const proto::SessionResume* sessionResume =
+            req.has_session_resume() ? &req.session_resume() : nullptr;
+    if( room->rejoin( clientConnection, name, sessionResume ) )
+    {
+        sendClientRoomInd( req.conn_id(), req.room_id() );
+    }
+    else
+    {
+        // This should never happen but it's not critical, it just means
+        // the user isn't in the room.
+        mLogger->warn( "{} failed to rejoin room!", name );
+    }
+}
+
+
+void
+RoomWorker::sendCreateRoomRsp( unsigned int roomId, bool success, proto::CreateRoomFailureRsp_ResultType failureResult )
+{
+    proto::WorkerMsg msg;
+    proto::WorkerCreateRoomRsp* rsp = msg.mutable_create_room_rsp();
+    rsp->set_room_id( roomId );
+    rsp->set_success( success );
+    if( !success ) rsp->set_failure_result( failureResult );
+    mLink->sendWorkerMsg( msg );
+}
+
+
+void
+RoomWorker::sendRoomStatusInd( ServerRoom* room )
+{
+    proto::WorkerMsg msg;
+    proto::WorkerRoomStatusInd* ind = msg.mutable_room_status_ind();
+    ind->set_room_id( room->getRoomId() );
+    ind->set_player_count( room->getPlayerCount() );
+    for( const std::string& name : room->getHumanPlayerNames() )
+    {
+        ind->add_human_names( name );
+    }
+    mLink->sendWorkerMsg( msg );
+}
+
+
+void
+RoomWorker::sendClientRoomInd( quint32 connId, int roomId )
+{
+    proto::WorkerMsg msg;
+    proto::WorkerClientRoomInd* ind = msg.mutable_client_room_ind();
+    ind->set_conn_id( connId );
+    if( roomId >= 0 ) ind->set_room_id( roomId );
+    mLink->sendWorkerMsg( msg );
+}
+
+
+void
+RoomWorker::sendJoinRoomFailureRsp( ClientConnection* clientConnection, proto::JoinRoomFailureRsp_ResultType result, int roomId )
+{
+    mLogger->trace( "sendJoinRoomFailureRsp, result={}, roomId={}", result, roomId );
+    proto::ServerToClientMsg msg;
+    proto::JoinRoomFailureRsp* joinRoomFailureRsp = msg.mutable_join_room_failure_rsp();
+    joinRoomFailureRsp->set_result( result );
+    joinRoomFailureRsp->set_room_id( roomId );
+    clientConnection->sendProtoMsg( msg );
+}
+
+
+ServerRoom*
+RoomWorker::findRoomWithConnection( ClientConnection* clientConnection ) const
+{
+    for( auto room : mRoomMap )
+    {
+        if( room->containsConnection( clientConnection ) ) return room;
+    }
+    return nullptr;
+}
+
+
+void
+RoomWorker::handleRoomPlayerCountChanged( int playerCount )
+{
+    ServerRoom *room = qobject_cast<ServerRoom*>( QObject::sender() );
+    mLogger->debug( "player count changed: roomId={}, playerCount={}", room->getRoomId(), playerCount );
+    sendRoomStatusInd( room );
+}
+
+
+void
+RoomWorker::handleRoomExpired()
+{
+    ServerRoom* room = qobject_cast<ServerRoom*>( QObject::sender() );
+    mLogger->info( "room expired: roomId={}", room->getRoomId() );
+    teardownRoom( room, false );
+}
+
+
+void
+RoomWorker::handleRoomError()
+{
+    ServerRoom* room = qobject_cast<ServerRoom*>( QObject::sender() );
+    mLogger->error( "room error! roomId={}", room->getRoomId() );
+    teardownRoom( room, true );
+}
+
+
+void
+RoomWorker::teardownRoom( ServerRoom* room, bool error )
+{
+    const unsigned int roomId = room->getRoomId();
+    mRoomMap.remove( roomId );
+
+    proto::WorkerMsg msg;
+    proto::WorkerRoomClosedInd* ind = msg.mutable_room_closed_ind();
+    ind->set_room_id( roomId );
+    ind->set_error( error );
+    mLink->sendWorkerMsg( msg );
+
+    // Destroy the room.
+    room->deleteLater();
+}
+
+
+void
+RoomWorker::handleLoadReportTimerTimeout()
+{
+    proto::WorkerMsg msg;
+    proto::WorkerLoadInd* ind = msg.mutable_load_ind();
+    ind->set_room_count( mRoomMap.size() );
+    ind->set_connection_count( mClientConnectionMap.size() );
+    ind->set_cpu_millis( static_cast<uint64_t>( std::clock() ) * 1000 / CLOCKS_PER_SEC );
+    for( ServerRoom* room : mRoomMap )
+    {
+        const RoomDiagnostics diagnostics = room->getDiagnostics();
+        proto::WorkerRoomDiagnostics* roomDiagnostics = ind->add_room_diagnostics();
+        roomDiagnostics->set_room_id( diagnostics.roomId );
+        roomDiagnostics->set_phase( diagnostics.phase );
+        roomDiagnostics->set_memory_bytes( diagnostics.memoryBytes );
+        roomDiagnostics->set_tick_lag_millis( diagnostics.tickLagMillis );
+        roomDiagnostics->set_max_tick_lag_millis( diagnostics.maxTickLagMillis );
+        roomDiagnostics->set_cpu_millis( diagnostics.cpuMillis );
+        roomDiagnostics->set_cpu_percent( diagnostics.cpuPercent );
+        roomDiagnostics->set_over_budget( diagnostics.overBudget );
+    }
+    if( mMtgJsonAllSetsData )
+    {
+        proto::WorkerCardCacheStats* cardCacheStats = ind->mutable_card_cache_stats();
+        cardCacheStats->set_card_lookup_hits( mMtgJsonAllSetsData->getCardLookupCacheHits() );
+        cardCacheStats->set_card_lookup_misses( mMtgJsonAllSetsData->getCardLookupCacheMisses() );
+        cardCacheStats->set_set_code_lookup_hits( mMtgJsonAllSetsData->getSetCodeLookupCacheHits() );
+        cardCacheStats->set_set_code_lookup_misses( mMtgJsonAllSetsData->getSetCodeLookupCacheMisses() );
+    }
+    mLink->sendWorkerMsg( msg );
+}
@@ -0,0 +1,105 @@
+#ifndef ROOMWORKER_H
+#define ROOMWORKER_H
+
+#include <QObject>
+
+QT_BEGIN_NAMESPACE
+class QTimer;
+QT_END_NAMESPACE
+
+#include <QMap>
+#include <memory>
+
+#include "messages.pb.h"
+#include "WorkerMessages.pb.h"
+#include "AllSetsData.h"
+#include "MtgJsonAllSetsData.h"
+
+#include "Logging.h"
+
+class WorkerLink;
+class ClientConnection;
+class ServerRoom;
+
+// Hosts rooms on behalf of a lobby process (see RoomWorkerPool).  The
+// lobby owns the client sockets; clients in this worker's rooms are
+// represented by relayed connections.
+class RoomWorker : public QObject
+{
+    Q_OBJECT
+
+public:
+    RoomWorker( const QString&                            lobbyServerName,
+                unsigned int                              workerIndex,
+                const QString&                            secret,
+                const std::shared_ptr<const AllSetsData>& allSetsData,
+                const Logging::Config&                    loggingConfig = Logging::Config(),
+                QObject*                                  parent = 0 );
+
+    virtual ~RoomWorker();
+
+public slots:
+
+    void start();
+
+signals:
+
+    void finished();
+
+private slots:
+
+    void handleLinkDisconnected();
+    void handleWorkerMsg( const proto::WorkerMsg& msg );
+    void handleRelayedMsg( quint32 connId, const QByteArray& msg, quint32 tag );
+    void handleMessageFromClient( const proto::ClientToServerMsg& msg );
+
+    void handleRoomPlayerCountChanged( int playerCount );
+    void handleRoomExpired();
+    void handleRoomError();
+
+    void handleLoadReportTimerTimeout();
+
+private:  // Methods
+
+    void processCreateRoomReq( const proto::WorkerCreateRoomReq& req );
+    void processAttachClientInd( const proto::WorkerAttachClientInd& ind );
+    void processDetachClientInd( const proto::WorkerDetachClientInd& ind );
+    void processRejoinRoomReq( const proto::WorkerRejoinRoomReq& req );
+
+    void sendCreateRoomRsp( unsigned int roomId, bool success,
+                            proto::CreateRoomFailureRsp_ResultType failureResult = proto::CreateRoomFailureRsp::RESULT_GENERAL_ERROR );
+    void sendRoomStatusInd( ServerRoom* room );
+    void sendClientRoomInd( quint32 connId, int roomId );
+    void sendJoinRoomFailureRsp( ClientConnection* clientConnection,
+                                 proto::JoinRoomFailureRsp_ResultType result, int roomId );
+
+    ServerRoom* findRoomWithConnection( ClientConnection* clientConnection ) const;
+
+    // Teardown a room after expiration or error.
+    void teardownRoom( ServerRoom* room, bool error );
+
+private:  // Data
+
+    const QString                      mLobbyServerName;
+    const unsigned int                 mWorkerIndex;
+    const QString                      mSecret;
+    std::shared_ptr<const AllSetsData> mAllSetsData;
+
+    // Same data if backed by MTGJSON, which has cache counters to report.
+    std::shared_ptr<const MtgJsonAllSetsData> mMtgJsonAllSetsData;
+
+    WorkerLink*                        mLink;
+    QTimer*                            mLoadReportTimer;
+
+    QMap<unsigned int,ServerRoom*>     mRoomMap;
+
+    // Relayed connections by lobby connection ID, and their login names.
+    QMap<quint32,ClientConnection*>    mClientConnectionMap;
+    QMap<ClientConnection*,quint32>    mClientConnectionIdMap;
+    QMap<ClientConnection*,std::string> mClientConnectionLoginMap;
+
+    Logging::Config                 mLoggingConfig;
+    std::shared_ptr<spdlog::logger> mLogger;
+};
+
+#endif
@@ -0,0 +1,784 @@
+#include "RoomWorkerPool.h"
+
+#include <QCoreApplication>
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QProcess>
+#include <QTimer>
+#include <algorithm>
+#include <random>
+
+#include "WorkerLink.h"
+#include "WorkerHello.h"
+#include "ClientConnection.h"
+#include "PayloadStore.h"
+
+// Workers report load every couple of seconds.  One that goes quiet gets
+// no new rooms, and one that stays quiet is killed and restarted.
+static const int HEALTH_CHECK_INTERVAL_MILLIS = 2000;
+static const int WORKER_UNHEALTHY_MILLIS = 10000;
+static const int WORKER_KILL_MILLIS = 30000;
+
+// Links that haven't identified their worker within this time are dropped.
+static const int WORKER_HELLO_TIMEOUT_MILLIS = 10000;
+
+static const int WORKER_RESPAWN_DELAY_MILLIS = 1000;
+
+
+RoomWorkerPool::RoomWorkerPool( unsigned int           workerCount,
+                                const QStringList&     workerArgs,
+                                const Logging::Config& loggingConfig,
+                                QObject*               parent )
+:   QObject( parent ),
+    mWorkerArgs( workerArgs ),
+    mServer( nullptr ),
+    mStopping( false ),
+    mNextConnId( 1 ),
+    mLoggingConfig( loggingConfig ),
+    mLogger( mLoggingConfig.createLogger() )
+{
+    for( unsigned int i = 0; i < workerCount; ++i )
+    {
+        Worker* worker = new Worker();
+        worker->index = i;
+        worker->process = nullptr;
+        worker->link = nullptr;
+        worker->pid = 0;
+        worker->healthy = false;
+        worker->connectionCount = 0;
+        worker->cpuMillis = 0;
+        mWorkers.append( worker );
+    }
+
+    mHealthTimer = new QTimer( this );
+    connect( mHealthTimer, &QTimer::timeout, this, &RoomWorkerPool::handleHealthTimerTimeout );
+}
+
+
+RoomWorkerPool::~RoomWorkerPool()
+{
+    mLogger->trace( "~RoomWorkerPool" );
+
+    // Workers exit on their own once the link goes away.
+    mStopping = true;
+    for( Worker* worker : mWorkers )
+    {
+        if( worker->process != nullptr )
+        {
+            worker->process->disconnect( this );
+        }
+        delete worker;
+    }
+    mWorkers.clear();
+}
+
+
+bool
+RoomWorkerPool::start()
+{
+    mServer = new QLocalServer( this );
+
+    // The name is unique to this lobby so several servers can share a host.
+    mServerName = "thicket-workers-" + QString::number( QCoreApplication::applicationPid() );
+    QLocalServer::removeServer( mServerName );
+
+    // Only processes of this user may connect; workers must also present
+    // the secret they were spawned with.
+    mServer->setSocketOptions( QLocalServer::UserAccessOption );
+    if( !mServer->listen( mServerName ) )
+    {
+        mLogger->critical( "Unable to start the worker server: {}", mServer->errorString() );
+        return false;
+    }
+    connect( mServer, &QLocalServer::newConnection, this, &RoomWorkerPool::handleNewConnection );
+
+    for( Worker* worker : mWorkers )
+    {
+        spawnWorker( worker );
+    }
+    mHealthTimer->start( HEALTH_CHECK_INTERVAL_MILLIS );
+
+    mLogger->notice( "Room workers listening at: {}", mServer->fullServerName() );
+    return true;
+}
+
+
+void
+RoomWorkerPool::spawnWorker( Worker* worker )
+{
+    if( mStopping ) return;
+
+    QProcess* process = new QProcess( this );
+    process->setProcessChannelMode( QProcess::ForwardedChannels );
+    connect( process, static_cast<void(QProcess::*)(int,QProcess::ExitStatus)>( &QProcess::finished ), this,
+        [this,worker,process]( int exitCode, QProcess::ExitStatus exitStatus ) {
+            mLogger->warn( "worker {} exited (code={}, crashed={})", worker->index, exitCode,
+                    exitStatus == QProcess::CrashExit );
+            if( worker->process == process ) worker->process = nullptr;
+            process->deleteLater();
+            handleWorkerLost( worker );
+            QTimer::singleShot( WORKER_RESPAWN_DELAY_MILLIS, this, [this,worker]() {
+                    if( worker->process == nullptr ) spawnWorker( worker );
+                } );
+        } );
+
+    // A fresh secret for each spawn, so a stale process can't reclaim the slot.
+    std::random_device rd;
+    worker->secret.clear();
+    for( int i = 0; i < 4; ++i )
+    {
+        worker->secret += QString( "%1" ).arg( static_cast<quint32>( rd() ), 8, 16, QChar( '0' ) );
+    }
+
+    QStringList args = mWorkerArgs;
+    args << "--worker" << mServerName << "--worker-index" << QString::number( worker->index )
+         << "--worker-secret" << worker->secret;
+    worker->process = process;
+    worker->healthy = false;
+    worker->sinceLoadReport.start();
+
+    mLogger->info( "starting worker {}", worker->index );
+    process->start( QCoreApplication::applicationFilePath(), args );
+}
+
+
+void
+RoomWorkerPool::handleWorkerLost( Worker* worker )
+{
+    if( worker->link != nullptr )
+    {
+        worker->link->disconnect( this );
+        worker->link->abort();
+        worker->link->deleteLater();
+        worker->link = nullptr;
+    }
+    worker->healthy = false;
+    worker->attachedConnIds.clear();
+    worker->connectionCount = 0;
+
+    // Rooms hosted by the worker are gone.
+    const QList<unsigned int> roomIds = worker->roomIds.toList();
+    for( unsigned int roomId : roomIds )
+    {
+        closeRoom( roomId, true );
+    }
+}
+
+
+RoomWorkerPool::Worker*
+RoomWorkerPool::findWorker( WorkerLink* link ) const
+{
+    for( Worker* worker : mWorkers )
+    {
+        if( worker->link == link ) return worker;
+    }
+    return nullptr;
+}
+
+
+RoomWorkerPool::Worker*
+RoomWorkerPool::pickWorker() const
+{
+    // Least rooms first, then least connections.
+    Worker* best = nullptr;
+    for( Worker* worker : mWorkers )
+    {
+        if( (worker->link == nullptr) || !worker->healthy ) continue;
+        if( (best == nullptr) ||
+            (worker->roomIds.size() < best->roomIds.size()) ||
+            ((worker->roomIds.size() == best->roomIds.size()) && (worker->connectionCount < best->connectionCount)) )
+        {
+            best = worker;
+        }
+    }
+    return best;
+}
+
+
+bool
+RoomWorkerPool::createRoom( ClientConnection*        creator,
+                            unsigned int             roomId,
+                            const std::string&       password,
+                            const proto::RoomConfig& roomConfig,
+                            const RoomLimits&        limits )
+{
+    Worker* worker = pickWorker();
+    if( worker == nullptr )
+    {
+        mLogger->error( "no worker available for room {}", roomId );
+        return false;
+    }
+
+    Room room;
+    room.worker = worker;
+    room.roomConfig = roomConfig;
+    room.roomConfigPayload = serializePayload( roomConfig );
+    room.roomConfigHash = computePayloadHash( room.roomConfigPayload );
+    room.created = false;
+    room.creator = creator;
+    room.playerCount = 0;
+    mRoomMap.insert( roomId, room );
+    worker->roomIds.insert( roomId );
+
+    proto::WorkerMsg msg;
+    proto::WorkerCreateRoomReq* req = msg.mutable_create_room_req();
+    req->set_room_id( roomId );
+    if( !password.empty() ) req->set_password( password );
+    *req->mutable_room_config() = roomConfig;
+    proto::WorkerRoomLimits* reqLimits = req->mutable_limits();
+    reqLimits->set_cpu_percent( limits.cpuPercent );
+    reqLimits->set_memory_bytes( limits.memoryBytes );
+    reqLimits->set_action( static_cast<proto::WorkerRoomLimits::Action>( limits.action ) );
+
+    mLogger->debug( "placing room {} on worker {} ({} rooms)", roomId, worker->index, worker->roomIds.size() );
+    return worker->link->sendWorkerMsg( msg );
+}
+
+
+bool
+RoomWorkerPool::containsRoomName( const std::string& name ) const
+{
+    for( const Room& room : mRoomMap )
+    {
+        if( room.roomConfig.name() == name ) return true;
+    }
+    return false;
+}
+
+
+bool
+RoomWorkerPool::containsRoom( unsigned int roomId ) const
+{
+    auto iter = mRoomMap.constFind( roomId );
+    return (iter != mRoomMap.constEnd()) && iter->created;
+}
+
+
+QList<unsigned int>
+RoomWorkerPool::getRoomIds() const
+{
+    QList<unsigned int> roomIds;
+    for( auto iter = mRoomMap.constBegin(); iter != mRoomMap.constEnd(); ++iter )
+    {
+        if( iter->created ) roomIds.append( iter.key() );
+    }
+    return roomIds;
+}
+
+
+const proto::RoomConfig&
+RoomWorkerPool::getRoomConfig( unsigned int roomId ) const
+{
+    return mRoomMap.constFind( roomId )->roomConfig;
+}
+
+
+const QByteArray&
+RoomWorkerPool::getRoomConfigPayload( unsigned int roomId ) const
+{
+    return mRoomMap.constFind( roomId )->roomConfigPayload;
+}
+
+
+const QByteArray&
+RoomWorkerPool::getRoomConfigHash( unsigned int roomId ) const
+{
+    return mRoomMap.constFind( roomId )->roomConfigHash;
+}
+
+
+unsigned int
+RoomWorkerPool::getRoomPlayerCount( unsigned int roomId ) const
+{
+    auto iter = mRoomMap.constFind( roomId );
+    return (iter != mRoomMap.constEnd()) ? iter->playerCount : 0;
+}
+
+
+int
+RoomWorkerPool::findRoomWithHumanPlayer( const std::string& name ) const
+{
+    for( auto iter = mRoomMap.constBegin(); iter != mRoomMap.constEnd(); ++iter )
+    {
+        const std::vector<std::string>& names = iter->humanNames;
+        if( std::find( names.begin(), names.end(), name ) != names.end() ) return iter.key();
+    }
+    return -1;
+}
+
+
+RoomDiagnostics
+RoomWorkerPool::getRoomDiagnostics( unsigned int roomId ) const
+{
+    RoomDiagnostics diagnostics;
+    auto iter = mRoomMap.constFind( roomId );
+    if( iter == mRoomMap.constEnd() ) return diagnostics;
+
+    diagnostics.roomId = roomId;
+    diagnostics.name = iter->roomConfig.name();
+    diagnostics.workerIndex = iter->worker->index;
+    diagnostics.playerCount = iter->playerCount;
+    diagnostics.chairCount = iter->roomConfig.draft_config().chair_count();
+    if( iter->diagnostics.has_room_id() )
+    {
+        diagnostics.phase = iter->diagnostics.phase();
+        diagnostics.memoryBytes = iter->diagnostics.memory_bytes();
+        diagnostics.tickLagMillis = iter->diagnostics.tick_lag_millis();
+        diagnostics.maxTickLagMillis = iter->diagnostics.max_tick_lag_millis();
+        diagnostics.cpuMillis = iter->diagnostics.cpu_millis();
+        diagnostics.cpuPercent = iter->diagnostics.cpu_percent();
+        diagnostics.overBudget = iter->diagnostics.over_budget();
+    }
+    return diagnostics;
+}
+
+
+QList<CardCacheStats>
+RoomWorkerPool::getCardCacheStats() const
+{
+    QList<CardCacheStats> statsList;
+    for( const Worker* worker : mWorkers )
+    {
+        if( !worker->cardCacheStats.IsInitialized() ) continue;
+
+        CardCacheStats stats;
+        stats.workerIndex = worker->index;
+        stats.cardLookupHits = worker->cardCacheStats.card_lookup_hits();
+        stats.cardLookupMisses = worker->cardCacheStats.card_lookup_misses();
+        stats.setCodeLookupHits = worker->cardCacheStats.set_code_lookup_hits();
+        stats.setCodeLookupMisses = worker->cardCacheStats.set_code_lookup_misses();
+        statsList.append( stats );
+    }
+    return statsList;
+}
+
+
+bool
+RoomWorkerPool::joinRoom( ClientConnection* clientConnection, const std::string& name, const proto::ClientToServerMsg& msg )
+{
+    if( !containsRoom( msg.join_room_req().room_id() ) ) return false;
+
+    Worker* worker = mRoomMap.value( msg.join_room_req().room_id() ).worker;
+    return attachClient( worker, clientConnection, name ) &&
+           relayClientMsg( worker, clientConnection, msg );
+}
+
+
+bool
+RoomWorkerPool::rejoinRoom( ClientConnection*           clientConnection,
+                            const std::string&          name,
+                            unsigned int                roomId,
+                            const proto::SessionResume* sessionResume )
+{
+    if( !containsRoom( roomId ) ) return false;
+
+    Worker* worker = mRoomMap.value( roomId ).worker;
+    if( !attachClient( worker, clientConnection, name ) ) return false;
+
+    proto::WorkerMsg msg;
+    proto::WorkerRejoinRoomReq* req = msg.mutable_rejoin_room_req();
+    req->set_conn_id( getConnId( clientConnection ) );
+    req->set_room_id( roomId );
+    if( sessionResume != nullptr ) *req->mutable_session_resume() = *sessionResume;
+    return worker->link->sendWorkerMsg( msg );
+}
+
+
+int
+RoomWorkerPool::getClientRoomId( ClientConnection* clientConnection ) const
+{
+    auto iter = mClientRoomMap.constFind( clientConnection );
+    return (iter != mClientRoomMap.constEnd()) ? static_cast<int>( iter.value() ) : -1;
+}
+
+
+bool
+RoomWorkerPool::forwardClientMsg( ClientConnection* clientConnection, const proto::ClientToServerMsg& msg )
+{
+    const int roomId = getClientRoomId( clientConnection );
+    if( roomId < 0 ) return false;
+
+    Worker* worker = mRoomMap.value( roomId ).worker;
+    return relayClientMsg( worker, clientConnection, msg );
+}
+
+
+void
+RoomWorkerPool::removeClientConnection( ClientConnection* clientConnection )
+{
+    mClientRoomMap.remove( clientConnection );
+
+    for( Room& room : mRoomMap )
+    {
+        if( room.creator == clientConnection ) room.creator = nullptr;
+    }
+
+    auto iter = mConnIdMap.find( clientConnection );
+    if( iter == mConnIdMap.end() ) return;
+    const quint32 connId = iter.value();
+    mConnIdMap.erase( iter );
+    mClientConnectionMap.remove( connId );
+
+    proto::WorkerMsg msg;
+    msg.mutable_detach_client_ind()->set_conn_id( connId );
+    for( Worker* worker : mWorkers )
+    {
+        if( worker->attachedConnIds.remove( connId ) && (worker->link != nullptr) )
+        {
+            worker->link->sendWorkerMsg( msg );
+        }
+    }
+}
+
+
+quint32
+RoomWorkerPool::getConnId( ClientConnection* clientConnection )
+{
+    auto iter = mConnIdMap.find( clientConnection );
+    if( iter != mConnIdMap.end() ) return iter.value();
+
+    const quint32 connId = mNextConnId++;
+    mConnIdMap.insert( clientConnection, connId );
+    mClientConnectionMap.insert( connId, clientConnection );
+    return connId;
+}
+
+
+bool
+RoomWorkerPool::attachClient( Worker* worker, ClientConnection* clientConnection, const std::string& name )
+{
+    if( worker->link == nullptr ) return false;
+
+    const quint32 connId = getConnId( clientConnection );
+    if( worker->attachedConnIds.contains( connId ) ) return true;
+
+    proto::WorkerMsg msg;
+    proto::WorkerAttachClientInd* ind = msg.mutable_attach_client_ind();
+    ind->set_conn_id( connId );
+    ind->set_name( name );
+    ind->set_payload_refs_supported( clientConnection->getPayloadRefsSupported() );
+    if( !worker->link->sendWorkerMsg( msg ) ) return false;
+
+    worker->attachedConnIds.insert( connId );
+    return true;
+}
+
+
+bool
+RoomWorkerPool::relayClientMsg( Worker* worker, ClientConnection* clientConnection, const proto::ClientToServerMsg& msg )
+{
+    if( (worker == nullptr) || (worker->link == nullptr) ) return false;
+    return worker->link->sendRelayedMsg( getConnId( clientConnection ), serializePayload( msg ) );
+}
+
+
+void
+RoomWorkerPool::handleNewConnection()
+{
+    while( mServer->hasPendingConnections() )
+    {
+        QLocalSocket* socket = mServer->nextPendingConnection();
+        WorkerLink* link = new WorkerLink( socket, mLoggingConfig.createChildConfig( "workerlink" ), this );
+        connect( link, &WorkerLink::workerMsgReceived, this, &RoomWorkerPool::handleWorkerMsg );
+        connect( link, &WorkerLink::relayedMsgReceived, this, &RoomWorkerPool::handleRelayedMsg );
+        connect( link, &WorkerLink::disconnected, this, &RoomWorkerPool::handleLinkDisconnected );
+        QElapsedTimer sinceConnected;
+        sinceConnected.start();
+        mPendingLinks.insert( link, sinceConnected );
+    }
+}
+
+
+void
+RoomWorkerPool::handleWorkerMsg( const proto::WorkerMsg& msg )
+{
+    WorkerLink* link = qobject_cast<WorkerLink*>( QObject::sender() );
+
+    if( msg.has_hello_ind() )
+    {
+        processHelloInd( link, msg.hello_ind() );
+        return;
+    }
+
+    Worker* worker = findWorker( link );
+    if( worker == nullptr )
+    {
+        mLogger->warn( "message {} from unidentified worker link", msg.msg_case() );
+        return;
+    }
+
+    if( msg.has_load_ind() )
+    {
+        const proto::WorkerLoadInd& ind = msg.load_ind();
+        mLogger->trace( "worker {} load: rooms={} connections={} cpuMillis={}",
+                worker->index, ind.room_count(), ind.connection_count(), ind.cpu_millis() );
+        if( !worker->healthy )
+        {
+            mLogger->info( "worker {} healthy", worker->index );
+            worker->healthy = true;
+        }
+        worker->sinceLoadReport.restart();
+        worker->connectionCount = ind.connection_count();
+        worker->cpuMillis = ind.cpu_millis();
+        if( ind.has_card_cache_stats() ) worker->cardCacheStats = ind.card_cache_stats();
+        for( const proto::WorkerRoomDiagnostics& roomDiagnostics : ind.room_diagnostics() )
+        {
+            auto roomIter = mRoomMap.find( roomDiagnostics.room_id() );
+            if( (roomIter != mRoomMap.end()) && (roomIter->worker == worker) )
+            {
+                roomIter->diagnostics = roomDiagnostics;
+            }
+        }
+    }
+    else if( msg.has_create_room_rsp() )
+    {
+        processCreateRoomRsp( worker, msg.create_room_rsp() );
+    }
+    else if( msg.has_room_status_ind() )
+    {
+        processRoomStatusInd( worker, msg.room_status_ind() );
+    }
+    else if( msg.has_room_closed_ind() )
+    {
+        processRoomClosedInd( worker, msg.room_closed_ind() );
+    }
+    else if( msg.has_client_room_ind() )
+    {
+        processClientRoomInd( worker, msg.client_room_ind() );
+    }
+    else
+    {
+        mLogger->warn( "unhandled worker message: {}", msg.msg_case() );
+    }
+}
+
+
+void
+RoomWorkerPool::processHelloInd( WorkerLink* link, const proto::WorkerHelloInd& ind )
+{
+    if( !mPendingLinks.contains( link ) )
+    {
+        mLogger->warn( "unexpected hello from worker {}", ind.worker_index() );
+        link->abort();
+        return;
+    }
+
+    QStringList workerSecrets;
+    for( const Worker* worker : mWorkers )
+    {
+        workerSecrets.append( (worker->process != nullptr) ? worker->secret : QString() );
+    }
+
+    switch( WorkerHello::check( ind.worker_index(), QString::fromStdString( ind.secret() ), workerSecrets ) )
+    {
+        case WorkerHello::RESULT_UNKNOWN_WORKER:
+            mLogger->warn( "hello from unknown worker {} (pid {})", ind.worker_index(), ind.pid() );
+            rejectLink( link );
+            return;
+        case WorkerHello::RESULT_WRONG_SECRET:
+            mLogger->warn( "hello from worker {} with wrong secret (pid {})", ind.worker_index(), ind.pid() );
+            rejectLink( link );
+            return;
+        case WorkerHello::RESULT_OK:
+            break;
+    }
+
+    mPendingLinks.remove( link );
+    Worker* worker = mWorkers[ind.worker_index()];
+    if( worker->link != nullptr )
+    {
+        mLogger->warn( "worker {} reconnected, dropping old link", worker->index );
+        handleWorkerLost( worker );
+    }
+
+    mLogger->info( "worker {} connected (pid {})", worker->index, ind.pid() );
+    worker->link = link;
+    worker->pid = ind.pid();
+    worker->sinceLoadReport.restart();
+}
+
+
+void
+RoomWorkerPool::processCreateRoomRsp( Worker* worker, const proto::WorkerCreateRoomRsp& rsp )
+{
+    auto iter = mRoomMap.find( rsp.room_id() );
+    if( (iter == mRoomMap.end()) || (iter->worker != worker) || iter->created )
+    {
+        mLogger->warn( "unexpected create room response for room {}", rsp.room_id() );
+        return;
+    }
+
+    ClientConnection* creator = iter->creator;
+    iter->creator = nullptr;
+
+    if( rsp.success() )
+    {
+        iter->created = true;
+        emit roomCreated( rsp.room_id(), creator );
+    }
+    else
+    {
+        worker->roomIds.remove( rsp.room_id() );
+        mRoomMap.erase( iter );
+        emit roomCreateFailed( rsp.room_id(), creator, rsp.failure_result() );
+    }
+}
+
+
+void
+RoomWorkerPool::processRoomStatusInd( Worker* worker, const proto::WorkerRoomStatusInd& ind )
+{
+    auto iter = mRoomMap.find( ind.room_id() );
+    if( (iter == mRoomMap.end()) || (iter->worker != worker) ) return;
+
+    iter->humanNames.assign( ind.human_names().begin(), ind.human_names().end() );
+    if( iter->playerCount != ind.player_count() )
+    {
+        iter->playerCount = ind.player_count();
+        if( iter->created ) emit roomPlayerCountChanged( ind.room_id(), iter->playerCount );
+    }
+}
+
+
+void
+RoomWorkerPool::processRoomClosedInd( Worker* worker, const proto::WorkerRoomClosedInd& ind )
+{
+    auto iter = mRoomMap.constFind( ind.room_id() );
+    if( (iter == mRoomMap.constEnd()) || (iter->worker != worker) ) return;
+
+    if( ind.error() )
+    {
+        mLogger->error( "room error on worker {}: roomId={}", worker->index, ind.room_id() );
+    }
+    closeRoom( ind.room_id(), false );
+}
+
+
+void
+RoomWorkerPool::processClientRoomInd( Worker* worker, const proto::WorkerClientRoomInd& ind )
+{
+    ClientConnection* clientConnection = mClientConnectionMap.value( ind.conn_id(), nullptr );
+    if( clientConnection == nullptr ) return;
+
+    if( ind.has_room_id() )
+    {
+        mClientRoomMap.insert( clientConnection, ind.room_id() );
+        emit clientRoomChanged( clientConnection, ind.room_id() );
+    }
+    else
+    {
+        mClientRoomMap.remove( clientConnection );
+        emit clientRoomChanged( clientConnection, -1 );
+    }
+}
+
+
+void
+RoomWorkerPool::closeRoom( unsigned int roomId, bool notifyClients )
+{
+    auto iter = mRoomMap.find( roomId );
+    if( iter == mRoomMap.end() ) return;
+
+    iter->worker->roomIds.remove( roomId );
+    for( ClientConnection* clientConnection : mClientRoomMap.keys( roomId ) )
+    {
+        mClientRoomMap.remove( clientConnection );
+        if( notifyClients )
+        {
+            mLogger->debug( "sending RoomErrorInd for closed room {}", roomId );
+            proto::ServerToClientMsg msg;
+            (void*) msg.mutable_room_error_ind();
+            clientConnection->sendProtoMsg( msg );
+        }
+    }
+
+    // Observers may still look the room up while handling the signal.
+    if( iter->created )
+    {
+        emit roomClosed( roomId );
+    }
+    else
+    {
+        emit roomCreateFailed( roomId, iter->creator, proto::CreateRoomFailureRsp::RESULT_GENERAL_ERROR );
+    }
+    mRoomMap.remove( roomId );
+}
+
+
+void
+RoomWorkerPool::handleRelayedMsg( quint32 connId, const QByteArray& msg, quint32 tag )
+{
+    ClientConnection* clientConnection = mClientConnectionMap.value( connId, nullptr );
+    if( clientConnection == nullptr )
+    {
+        // Normal if the client disconnected while the message was in flight.
+        mLogger->debug( "dropping message for unknown connection {}", connId );
+        return;
+    }
+    const auto msgCase = static_cast<proto::ServerToClientMsg::MsgCase>( tag & ~WorkerLink::RELAY_TAG_SEQUENCED );
+    clientConnection->sendSerializedMsg( msg, msgCase, (tag & WorkerLink::RELAY_TAG_SEQUENCED) != 0 );
+}
+
+
+void
+RoomWorkerPool::rejectLink( WorkerLink* link )
+{
+    // The link is no longer tracked, so it is deleted here rather than
+    // when it disconnects.
+    mPendingLinks.remove( link );
+    link->disconnect( this );
+    link->abort();
+    link->deleteLater();
+}
+
+
+void
+RoomWorkerPool::handleLinkDisconnected()
+{
+    WorkerLink* link = qobject_cast<WorkerLink*>( QObject::sender() );
+    if( mPendingLinks.remove( link ) )
+    {
+        link->deleteLater();
+        return;
+    }
+
+    Worker* worker = findWorker( link );
+    if( worker == nullptr ) return;
+
+    mLogger->warn( "lost link to worker {}", worker->index );
+    handleWorkerLost( worker );
+
+    // The worker exits without its link, and is restarted when it does.
+    if( worker->process != nullptr ) worker->process->kill();
+}
+
+
+void
+RoomWorkerPool::handleHealthTimerTimeout()
+{
+    for( WorkerLink* link : mPendingLinks.keys() )
+    {
+        if( mPendingLinks.value( link ).elapsed() >= WORKER_HELLO_TIMEOUT_MILLIS )
+        {
+            mLogger->warn( "worker link sent no hello, dropping" );
+            rejectLink( link );
+        }
+    }
+
+    for( Worker* worker : mWorkers )
+    {
+        if( worker->process == nullptr ) continue;
+
+        const qint64 quietMillis = worker->sinceLoadReport.elapsed();
+        if( quietMillis >= WORKER_KILL_MILLIS )
+        {
+            mLogger->error( "worker {} unresponsive for {}ms, killing", worker->index, quietMillis );
+            worker->process->kill();
+        }
+        else if( (quietMillis >= WORKER_UNHEALTHY_MILLIS) && worker->healthy )
+        {
+            mLogger->warn( "worker {} unresponsive, not placing rooms", worker->index );
+            worker->healthy = false;
+        }
+    }
+}
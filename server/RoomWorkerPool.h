@@ -0,0 +1,196 @@
+#ifndef ROOMWORKERPOOL_H
+#define ROOMWORKERPOOL_H
+
+#include <QObject>
+
+QT_BEGIN_NAMESPACE
+class QLocalServer;
+class QProcess;
+class QTimer;
+QT_END_NAMESPACE
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QList>
+#include <QMap>
+#include <QSet>
+#include <QStringList>
+#include <memory>
+#include <vector>
+
+#include "messages.pb.h"
+#include "WorkerMessages.pb.h"
+
+#include "Logging.h"
+#include "RoomDiagnostics.h"
+#include "CardCacheStats.h"
+#include "RoomLimits.h"
+
+class WorkerLink;
+class ClientConnection;
+
+// Lobby side of the multi-process topology.  Spawns room worker processes
+// (see RoomWorker), places new rooms on the least-loaded healthy worker,
+// and relays traffic between clients and the worker hosting their room.
+// Workers that exit are restarted; their rooms are lost.
+class RoomWorkerPool : public QObject
+{
+    Q_OBJECT
+
+public:
+    RoomWorkerPool( unsigned int           workerCount,
+                    const QStringList&     workerArgs,
+                    const Logging::Config& loggingConfig = Logging::Config(),
+                    QObject*               parent = 0 );
+
+    virtual ~RoomWorkerPool();
+
+    // Start listening for workers and spawn them.
+    bool start();
+
+    // Request a room from a worker.  The result is signaled later.
+    // Returns false if no worker is available.
+    bool createRoom( ClientConnection*        creator,
+                     unsigned int             roomId,
+                     const std::string&       password,
+                     const proto::RoomConfig& roomConfig,
+                     const RoomLimits&        limits );
+
+    // Rooms being created count toward names in use but are otherwise
+    // not visible until created.
+    bool containsRoomName( const std::string& name ) const;
+    bool containsRoom( unsigned int roomId ) const;
+    QList<unsigned int> getRoomIds() const;
+    const proto::RoomConfig& getRoomConfig( unsigned int roomId ) const;
+    const QByteArray& getRoomConfigPayload( unsigned int roomId ) const;
+    const QByteArray& getRoomConfigHash( unsigned int roomId ) const;
+    unsigned int getRoomPlayerCount( unsigned int roomId ) const;
+
+    // Returns -1 if no room contains the player.
+    int findRoomWithHumanPlayer( const std::string& name ) const;
+
+    // Room diagnostics as of the hosting worker's last load report.
+    RoomDiagnostics getRoomDiagnostics( unsigned int roomId ) const;
+
+    // Card cache counters of each worker that has reported them.
+    QList<CardCacheStats> getCardCacheStats() const;
+
+    // Forward a join request to the worker hosting the room.  Returns
+    // false if the room doesn't exist.
+    bool joinRoom( ClientConnection* clientConnection, const std::string& name, const proto::ClientToServerMsg& msg );
+
+    // Rejoin a client to a room after login.
+    bool rejoinRoom( ClientConnection*           clientConnection,
+                     const std::string&          name,
+                     unsigned int                roomId,
+                     const proto::SessionResume* sessionResume );
+
+    // Room the client is in, or -1.
+    int getClientRoomId( ClientConnection* clientConnection ) const;
+
+    // Forward a message to the worker hosting the client's room.  Returns
+    // false if the client isn't in a room.
+    bool forwardClientMsg( ClientConnection* clientConnection, const proto::ClientToServerMsg& msg );
+
+    // Client disconnected.
+    void removeClientConnection( ClientConnection* clientConnection );
+
+signals:
+
+    void roomCreated( unsigned int roomId, ClientConnection* creator );
+    void roomCreateFailed( unsigned int roomId, ClientConnection* creator, proto::CreateRoomFailureRsp_ResultType result );
+    void roomPlayerCountChanged( unsigned int roomId, int playerCount );
+    void roomClosed( unsigned int roomId );
+
+    // A client entered a room, or left it if roomId is negative.  Not
+    // signaled for clients in a room that closes.
+    void clientRoomChanged( ClientConnection* clientConnection, int roomId );
+
+private slots:
+
+    void handleNewConnection();
+    void handleWorkerMsg( const proto::WorkerMsg& msg );
+    void handleRelayedMsg( quint32 connId, const QByteArray& msg, quint32 tag );
+    void handleLinkDisconnected();
+    void handleHealthTimerTimeout();
+
+private:  // Types
+
+    struct Worker
+    {
+        unsigned int       index;
+        QProcess*          process;
+        WorkerLink*        link;
+        qint64             pid;
+        QString            secret;
+        bool               healthy;
+        QElapsedTimer      sinceLoadReport;
+        unsigned int       connectionCount;
+        uint64_t           cpuMillis;
+        proto::WorkerCardCacheStats cardCacheStats;
+        QSet<unsigned int> roomIds;
+        QSet<quint32>      attachedConnIds;
+    };
+
+    struct Room
+    {
+        Worker*                  worker;
+        proto::RoomConfig        roomConfig;
+        QByteArray               roomConfigPayload;
+        QByteArray               roomConfigHash;
+        bool                     created;
+        ClientConnection*        creator;
+        unsigned int             playerCount;
+        std::vector<std::string> humanNames;
+        proto::WorkerRoomDiagnostics diagnostics;
+    };
+
+private:  // Methods
+
+    void spawnWorker( Worker* worker );
+    void handleWorkerLost( Worker* worker );
+    Worker* findWorker( WorkerLink* link ) const;
+    Worker* pickWorker() const;
+    void rejectLink( WorkerLink* link );
+
+    quint32 getConnId( ClientConnection* clientConnection );
+    bool attachClient( Worker* worker, ClientConnection* clientConnection, const std::string& name );
+    bool relayClientMsg( Worker* worker, ClientConnection* clientConnection, const proto::ClientToServerMsg& msg );
+
+    void processHelloInd( WorkerLink* link, const proto::WorkerHelloInd& ind );
+    void processCreateRoomRsp( Worker* worker, const proto::WorkerCreateRoomRsp& rsp );
+    void processRoomStatusInd( Worker* worker, const proto::WorkerRoomStatusInd& ind );
+    void processRoomClosedInd( Worker* worker, const proto::WorkerRoomClosedInd& ind );
+    void processClientRoomInd( Worker* worker, const proto::WorkerClientRoomInd& ind );
+
+    // Clients still in the room are sent a RoomErrorInd if requested.  A
+    // room closing on its worker tells its own clients, so this is only
+    // needed when the worker is lost.
+    void closeRoom( unsigned int roomId, bool notifyClients );
+
+private:  // Data
+
+    const QStringList  mWorkerArgs;
+    QString            mServerName;
+    QLocalServer*      mServer;
+    QTimer*            mHealthTimer;
+    bool               mStopping;
+
+    QList<Worker*>     mWorkers;
+
+    // Links that connected but have yet to identify their worker, with
+    // the time since they connected.
+    QHash<WorkerLink*,QElapsedTimer> mPendingLinks;
+
+    QMap<unsigned int,Room> mRoomMap;
+
+    quint32                          mNextConnId;
+    QMap<ClientConnection*,quint32>  mConnIdMap;
+    QMap<quint32,ClientConnection*>  mClientConnectionMap;
+    QMap<ClientConnection*,unsigned int> mClientRoomMap;
+
+    Logging::Config                 mLoggingConfig;
+    std::shared_ptr<spdlog::logger> mLogger;
+};
+
+#endif
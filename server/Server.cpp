@@ -3,6 +3,7 @@
 #include <QtNetwork>
 
 #include <stdlib.h>
+#include <algorithm>
 #include <memory>
 #include <sstream>
 #include <iomanip>
@@ -17,8 +18,13 @@
 #include "ClientConnection.h"
 #include "ServerRoom.h"
 #include "RoomConfigValidator.h"
+#include "RoomWorkerPool.h"
+#include "ChatEngine.h"
 #include "CardDispenserFactory.h"
 
+// Largest page of rooms a client may subscribe to.
+static const unsigned int ROOMS_PAGE_SIZE_MAX = 200;
+
 Server::Server( unsigned int                              port,
                 const std::shared_ptr<ServerSettings>&    settings,
                 const std::shared_ptr<const AllSetsData>& allSetsData,
@@ -34,6 +40,7 @@ Server::Server( unsigned int                              port,
     mNetConnectionServer( 0 ),
     mRoomConfigValidator( allSetsData, loggingConfig.createChildConfig( "roomconfigvalidator" ) ),
     mNextRoomId( 0 ),
+    mWorkerPool( nullptr ),
     mTotalDisconnectedClientBytesSent( 0 ),
     mTotalDisconnectedClientBytesReceived( 0 ),
     mLoggingConfig( loggingConfig ),
@@ -42,9 +49,15 @@ Server::Server( unsigned int                              port,
     connect( mClientNotices.get(), &ClientNotices::announcementsUpdate, this, &Server::handleAnnouncementsUpdate );
     connect( mClientNotices.get(), &ClientNotices::alertUpdate, this, &Server::handleAlertUpdate );
 
+    mChatEngine = new ChatEngine( mLoggingConfig.createChildConfig( "chatengine" ), this );
+
     mRoomsInfoDiffBroadcastTimer = new QTimer( this );
     mRoomsInfoDiffBroadcastTimer->setSingleShot( true );
     connect( mRoomsInfoDiffBroadcastTimer, &QTimer::timeout, this, &Server::handleRoomsInfoDiffBroadcastTimerTimeout );
+
+    mUsersInfoDiffBroadcastTimer = new QTimer( this );
+    mUsersInfoDiffBroadcastTimer->setSingleShot( true );
+    connect( mUsersInfoDiffBroadcastTimer, &QTimer::timeout, this, &Server::handleUsersInfoDiffBroadcastTimerTimeout );
 }
 
 
@@ -62,6 +75,18 @@ Server::~Server()
 }
 
 
+void
+Server::setWorkerPool( RoomWorkerPool* workerPool )
+{
+    mWorkerPool = workerPool;
+    connect( mWorkerPool, &RoomWorkerPool::roomCreated, this, &Server::handleWorkerRoomCreated );
+    connect( mWorkerPool, &RoomWorkerPool::roomCreateFailed, this, &Server::handleWorkerRoomCreateFailed );
+    connect( mWorkerPool, &RoomWorkerPool::roomPlayerCountChanged, this, &Server::handleWorkerRoomPlayerCountChanged );
+    connect( mWorkerPool, &RoomWorkerPool::roomClosed, this, &Server::handleWorkerRoomClosed );
+    connect( mWorkerPool, &RoomWorkerPool::clientRoomChanged, this, &Server::handleWorkerClientRoomChanged );
+}
+
+
 void
 Server::start()
 {
@@ -200,27 +225,67 @@ void
 Server::sendRoomCapabilitiesInd( ClientConnection* clientConnection )
 {
     mLogger->trace( "sendRoomCapabilitiesInd" );
+
+    if( mRoomCapabilitiesMsg.isEmpty() )
+    {
+        proto::ServerToClientMsg msg;
+        proto::RoomCapabilitiesInd* capsInd = msg.mutable_room_capabilities_ind();
+        const std::vector<std::string> allSetCodes = mAllSetsData->getSetCodes();
+        for( const std::string& code : allSetCodes )
+        {
+            proto::RoomCapabilitiesInd::SetCapability* addedSet = capsInd->add_sets();
+            addedSet->set_code( code );
+            addedSet->set_name( mAllSetsData->getSetName( code ) );
+            addedSet->set_booster_generation( mAllSetsData->hasBoosterSlots( code ) );
+        }
+        mRoomCapabilitiesMsg = serializePayload( msg );
+
+        // The capabilities payload is held for the life of the server.
+        const QByteArray hash = mPayloadStore.add( serializePayload( *capsInd ) );
+        proto::ServerToClientMsg refMsg;
+        refMsg.mutable_room_capabilities_ind()->set_payload_hash( hash.constData(), hash.size() );
+        mRoomCapabilitiesRefMsg = serializePayload( refMsg );
+
+        mLogger->debug( "room capabilities size={}, by reference={}",
+                mRoomCapabilitiesMsg.size(), mRoomCapabilitiesRefMsg.size() );
+    }
+
+    clientConnection->sendSerializedMsg( clientConnection->getPayloadRefsSupported() ?
+            mRoomCapabilitiesRefMsg : mRoomCapabilitiesMsg, proto::ServerToClientMsg::kRoomCapabilitiesInd );
+}
+
+
+void
+Server::sendPayloadInd( ClientConnection* clientConnection, const QByteArray& hash )
+{
+    mLogger->trace( "sendPayloadInd" );
     proto::ServerToClientMsg msg;
-    proto::RoomCapabilitiesInd* capsInd = msg.mutable_room_capabilities_ind();
-    const std::vector<std::string> allSetCodes = mAllSetsData->getSetCodes();
-    for( const std::string& code : allSetCodes )
+    proto::PayloadInd* ind = msg.mutable_payload_ind();
+    ind->set_hash( hash.constData(), hash.size() );
+    if( mPayloadStore.contains( hash ) )
     {
-        proto::RoomCapabilitiesInd::SetCapability* addedSet = capsInd->add_sets();
-        addedSet->set_code( code );
-        addedSet->set_name( mAllSetsData->getSetName( code ) );
-        addedSet->set_booster_generation( mAllSetsData->hasBoosterSlots( code ) );
+        const QByteArray payload = mPayloadStore.get( hash );
+        ind->set_payload( payload.constData(), payload.size() );
+    }
+    else
+    {
+        mLogger->notice( "payload {} not found", hash.toHex().toStdString() );
     }
     clientConnection->sendProtoMsg( msg );
 }
 
 
 void
-Server::sendLoginRsp( ClientConnection* clientConnection, const proto::LoginRsp::ResultType& result )
+Server::sendLoginRsp( ClientConnection* clientConnection, const proto::LoginRsp::ResultType& result, unsigned int streamCompressionVersion )
 {
     mLogger->trace( "sendLoginRsp" );
     proto::ServerToClientMsg msg;
     proto::LoginRsp* rsp = msg.mutable_login_rsp();
     rsp->set_result( result );
+    if( streamCompressionVersion != 0 )
+    {
+        rsp->set_stream_compression_version( streamCompressionVersion );
+    }
     clientConnection->sendProtoMsg( msg );
 }
 
@@ -248,37 +313,58 @@ Server::sendJoinRoomFailureRsp( ClientConnection* clientConnection, proto::JoinR
 }
 
 
+void
+Server::sendCreateRoomSuccessRsp( ClientConnection* clientConnection, int roomId )
+{
+    mLogger->debug( "sendCreateRoomSuccessRsp: roomId={}", roomId );
+    proto::ServerToClientMsg msg;
+    proto::CreateRoomSuccessRsp* createRoomSuccessRsp = msg.mutable_create_room_success_rsp();
+    createRoomSuccessRsp->set_room_id( roomId );
+    clientConnection->sendProtoMsg( msg );
+}
+
+
+const proto::RoomConfig*
+Server::findRoomConfig( int roomId ) const
+{
+    ServerRoom* room = mRoomMap.value( roomId, nullptr );
+    if( room != nullptr ) return &room->getRoomConfig();
+    if( (mWorkerPool != nullptr) && mWorkerPool->containsRoom( roomId ) ) return &mWorkerPool->getRoomConfig( roomId );
+    return nullptr;
+}
+
+
 void
 Server::sendBaselineRoomsInfo( ClientConnection* clientConnection )
 {
     mLogger->trace( "sendBaselineRoomsInfo" );
 
+    auto subIter = mLobbySubscriptionMap.find( clientConnection );
+    if( (subIter == mLobbySubscriptionMap.end()) ||
+        (subIter->roomsMode == proto::LobbySubscriptionInd::ROOMS_NONE) ) return;
+    LobbySubscription& subscription = subIter.value();
+
     // Assemble the message.
     proto::ServerToClientMsg msg;
     proto::RoomsInfoInd* roomsInfoInd = msg.mutable_rooms_info_ind();
+    roomsInfoInd->set_baseline( true );
 
-    auto iter = mRoomMap.constBegin();
-    while( iter != mRoomMap.constEnd() )
+    if( subscription.roomsMode == proto::LobbySubscriptionInd::ROOMS_PAGE )
     {
-        const ServerRoom * const room = iter.value();
-
-        proto::RoomsInfoInd::RoomInfo* addedRoom = roomsInfoInd->add_added_rooms();
-        addedRoom->set_room_id( iter.key() );
-
-        // Assemble room configuration.
-        proto::RoomConfig* roomConfig = addedRoom->mutable_room_config();
-        *roomConfig = room->getRoomConfig();
-        abridgeRoomConfig( roomConfig );
-        addedRoom->set_abridged( true );
-
-        if( room->getPlayerCount() > 0 )
+        const QList<int> page = getRoomsPage( subscription, subscription.sentTotalRoomCount );
+        for( int roomId : page )
         {
-            proto::RoomsInfoInd::PlayerCount* playerCount = roomsInfoInd->add_player_counts();
-            playerCount->set_room_id( iter.key() );
-            playerCount->set_player_count( room->getPlayerCount() );
+            addRoomInfo( roomsInfoInd, roomId, true );
+        }
+        roomsInfoInd->set_total_room_count( subscription.sentTotalRoomCount );
+        subscription.sentRoomIds = page.toSet();
+    }
+    else
+    {
+        for( int roomId : getRoomIds() )
+        {
+            addRoomInfo( roomsInfoInd, roomId, true );
         }
-
-        ++iter;
     }
 
     mLogger->debug( "sending RoomsInfoInd, size={} to client {}",
@@ -306,48 +392,230 @@ Server::broadcastRoomsInfoDiffs()
         return;
     }
 
+    // Paged subscribers each get their own diff; everyone subscribed to
+    // all rooms gets the same one, serialized once.
+    QList<ClientConnection*> allRoomsClientConnections;
+    for( auto iter = mLobbySubscriptionMap.begin(); iter != mLobbySubscriptionMap.end(); ++iter )
+    {
+        if( iter->roomsMode == proto::LobbySubscriptionInd::ROOMS_ALL )
+        {
+            allRoomsClientConnections.append( iter.key() );
+        }
+        else if( iter->roomsMode == proto::LobbySubscriptionInd::ROOMS_PAGE )
+        {
+            sendRoomsPageDiff( iter.key(), iter.value() );
+        }
+    }
+
+    if( !allRoomsClientConnections.empty() )
+    {
+        proto::ServerToClientMsg msg;
+        proto::RoomsInfoInd* roomsInfoInd = msg.mutable_rooms_info_ind();
+
+        for( int roomId : mRoomsInfoDiffAddedRoomIds )
+        {
+            addRoomInfo( roomsInfoInd, roomId, false );
+        }
+
+        for( int roomId : mRoomsInfoDiffRemovedRoomIds )
+        {
+            roomsInfoInd->add_removed_rooms( roomId );
+        }
+
+        auto iter = mRoomsInfoDiffPlayerCountsMap.constBegin();
+        while( iter != mRoomsInfoDiffPlayerCountsMap.constEnd() )
+        {
+            proto::RoomsInfoInd::PlayerCount* playerCount = roomsInfoInd->add_player_counts();
+            playerCount->set_room_id( iter.key() );
+            playerCount->set_player_count( iter.value() );
+            ++iter;
+        }
+
+        const QByteArray serializedMsg = serializePayload( msg );
+        mLogger->debug( "sending RoomsInfoInd, size={} to {} clients",
+                serializedMsg.size(), allRoomsClientConnections.size() );
+        for( auto clientConn : allRoomsClientConnections )
+        {
+            clientConn->sendSerializedMsg( serializedMsg, proto::ServerToClientMsg::kRoomsInfoInd );
+        }
+    }
+
+    // Clear all differences.
+    mRoomsInfoDiffAddedRoomIds.clear();
+    mRoomsInfoDiffRemovedRoomIds.clear();
+    mRoomsInfoDiffPlayerCountsMap.clear();
+}
+
+
+void
+Server::sendRoomsPageDiff( ClientConnection* clientConnection, LobbySubscription& subscription )
+{
+    unsigned int totalRoomCount = 0;
+    const QList<int> page = getRoomsPage( subscription, totalRoomCount );
+    const QSet<int> pageRoomIds = page.toSet();
+
     proto::ServerToClientMsg msg;
     proto::RoomsInfoInd* roomsInfoInd = msg.mutable_rooms_info_ind();
 
-    for( int roomId : mRoomsInfoDiffAddedRoomIds )
+    for( int roomId : page )
     {
-        proto::RoomsInfoInd::RoomInfo* addedRoom = roomsInfoInd->add_added_rooms();
-        const ServerRoom* const room = mRoomMap[roomId];
+        if( !subscription.sentRoomIds.contains( roomId ) )
+        {
+            addRoomInfo( roomsInfoInd, roomId, true );
+        }
+        else if( mRoomsInfoDiffPlayerCountsMap.contains( roomId ) )
+        {
+            proto::RoomsInfoInd::PlayerCount* playerCount = roomsInfoInd->add_player_counts();
+            playerCount->set_room_id( roomId );
+            playerCount->set_player_count( mRoomsInfoDiffPlayerCountsMap.value( roomId ) );
+        }
+    }
 
-        addedRoom->set_room_id( roomId );
+    for( int roomId : subscription.sentRoomIds )
+    {
+        if( !pageRoomIds.contains( roomId ) ) roomsInfoInd->add_removed_rooms( roomId );
+    }
 
-        // Assemble room configuration.
-        proto::RoomConfig* roomConfig = addedRoom->mutable_room_config();
-        *roomConfig = room->getRoomConfig();
-        abridgeRoomConfig( roomConfig );
-        addedRoom->set_abridged( true );
+    if( totalRoomCount != subscription.sentTotalRoomCount )
+    {
+        roomsInfoInd->set_total_room_count( totalRoomCount );
     }
 
-    for( int roomId : mRoomsInfoDiffRemovedRoomIds )
+    subscription.sentRoomIds = pageRoomIds;
+    subscription.sentTotalRoomCount = totalRoomCount;
+
+    if( (roomsInfoInd->added_rooms_size() > 0) || (roomsInfoInd->removed_rooms_size() > 0) ||
+        (roomsInfoInd->player_counts_size() > 0) || roomsInfoInd->has_total_room_count() )
     {
-        roomsInfoInd->add_removed_rooms( roomId );
+        mLogger->debug( "sending paged RoomsInfoInd, size={} to client {}",
+                msg.ByteSize(), (std::size_t)clientConnection );
+        clientConnection->sendProtoMsg( msg );
     }
+}
 
-    auto iter = mRoomsInfoDiffPlayerCountsMap.constBegin();
-    while( iter != mRoomsInfoDiffPlayerCountsMap.constEnd() )
+
+QList<Server::ConnectionDiagnostics>
+Server::getConnectionDiagnostics() const
+{
+    QList<ConnectionDiagnostics> diagnosticsList;
+    for( ClientConnection* clientConnection : findChildren<ClientConnection*>( QString(), Qt::FindDirectChildrenOnly ) )
     {
-        proto::RoomsInfoInd::PlayerCount* playerCount = roomsInfoInd->add_player_counts();
-        playerCount->set_room_id( iter.key() );
-        playerCount->set_player_count( iter.value() );
-        ++iter;
+        ConnectionDiagnostics diagnostics;
+        diagnostics.name = mClientConnectionLoginMap.value( clientConnection );
+        diagnostics.peerAddress = clientConnection->peerAddress().toString().toStdString() + ":" +
+                std::to_string( clientConnection->peerPort() );
+        diagnostics.bytesSent = clientConnection->getBytesSent();
+        diagnostics.bytesReceived = clientConnection->getBytesReceived();
+        diagnostics.backlogBytes = clientConnection->getBacklogBytes();
+        diagnostics.idleMillis = clientConnection->getRxIdleMillis();
+        diagnostics.roomId = (mWorkerPool != nullptr) ? mWorkerPool->getClientRoomId( clientConnection ) : -1;
+        for( ServerRoom* room : mRoomMap )
+        {
+            if( room->containsConnection( clientConnection ) ) diagnostics.roomId = room->getRoomId();
+        }
+        diagnosticsList.append( diagnostics );
     }
+    return diagnosticsList;
+}
 
-    // Clear all differences.
-    mRoomsInfoDiffAddedRoomIds.clear();
-    mRoomsInfoDiffRemovedRoomIds.clear();
-    mRoomsInfoDiffPlayerCountsMap.clear();
 
-    // Send the message to each client connection.
-    for( auto clientConn : mClientConnectionLoginMap.keys() )
+QList<RoomDiagnostics>
+Server::getRoomDiagnostics() const
+{
+    QList<RoomDiagnostics> diagnosticsList;
+    for( int roomId : getRoomIds() )
+    {
+        ServerRoom* room = mRoomMap.value( roomId, nullptr );
+        diagnosticsList.append( (room != nullptr) ? room->getDiagnostics() : mWorkerPool->getRoomDiagnostics( roomId ) );
+    }
+    return diagnosticsList;
+}
+
+
+QList<CardCacheStats>
+Server::getWorkerCardCacheStats() const
+{
+    return (mWorkerPool != nullptr) ? mWorkerPool->getCardCacheStats() : QList<CardCacheStats>();
+}
+
+
+QList<int>
+Server::getRoomIds() const
+{
+    QList<int> roomIds;
+    for( auto iter = mRoomMap.constBegin(); iter != mRoomMap.constEnd(); ++iter )
+    {
+        roomIds.append( iter.key() );
+    }
+    if( mWorkerPool != nullptr )
+    {
+        for( unsigned int roomId : mWorkerPool->getRoomIds() )
+        {
+            roomIds.append( roomId );
+        }
+        std::sort( roomIds.begin(), roomIds.end() );
+    }
+    return roomIds;
+}
+
+
+unsigned int
+Server::getRoomPlayerCount( int roomId ) const
+{
+    ServerRoom* room = mRoomMap.value( roomId, nullptr );
+    if( room != nullptr ) return room->getPlayerCount();
+    return (mWorkerPool != nullptr) ? mWorkerPool->getRoomPlayerCount( roomId ) : 0;
+}
+
+
+QList<int>
+Server::getRoomsPage( const LobbySubscription& subscription, unsigned int& totalRoomCount ) const
+{
+    QList<int> page;
+    totalRoomCount = 0;
+    for( int roomId : getRoomIds() )
+    {
+        const proto::RoomConfig* roomConfig = findRoomConfig( roomId );
+        if( !subscription.roomsNameFilter.isEmpty() &&
+            !QString::fromStdString( roomConfig->name() ).contains( subscription.roomsNameFilter, Qt::CaseInsensitive ) )
+        {
+            continue;
+        }
+        if( subscription.roomsHideFull &&
+            (getRoomPlayerCount( roomId ) >= roomConfig->draft_config().chair_count()) )
+        {
+            continue;
+        }
+
+        if( (totalRoomCount >= subscription.roomsPageOffset) &&
+            (static_cast<unsigned int>( page.size() ) < subscription.roomsPageSize) )
+        {
+            page.append( roomId );
+        }
+        ++totalRoomCount;
+    }
+    return page;
+}
+
+
+void
+Server::addRoomInfo( proto::RoomsInfoInd* roomsInfoInd, int roomId, bool includePlayerCount ) const
+{
+    proto::RoomsInfoInd::RoomInfo* addedRoom = roomsInfoInd->add_added_rooms();
+    addedRoom->set_room_id( roomId );
+
+    // Assemble room configuration.
+    proto::RoomConfig* roomConfig = addedRoom->mutable_room_config();
+    *roomConfig = *findRoomConfig( roomId );
+    abridgeRoomConfig( roomConfig );
+    addedRoom->set_abridged( true );
+
+    const unsigned int count = includePlayerCount ? getRoomPlayerCount( roomId ) : 0;
+    if( count > 0 )
     {
-        mLogger->debug( "sending RoomsInfoInd, size={} to client {}",
-                msg.ByteSize(), (std::size_t)clientConn );
-        clientConn->sendProtoMsg( msg );
+        proto::RoomsInfoInd::PlayerCount* playerCount = roomsInfoInd->add_player_counts();
+        playerCount->set_room_id( roomId );
+        playerCount->set_player_count( count );
     }
 }
 
@@ -368,17 +636,25 @@ Server::sendBaselineUsersInfo( ClientConnection* clientConnection )
 {
     mLogger->trace( "sendBaselineUsersInfo" );
 
-    // Assemble the message.
+    auto subIter = mLobbySubscriptionMap.find( clientConnection );
+    if( (subIter == mLobbySubscriptionMap.end()) ||
+        (subIter->usersMode == proto::LobbySubscriptionInd::USERS_NONE) ) return;
+
+    // Assemble the message.  The baseline is the users as last broadcast,
+    // so the client stays in sync with the diffs that follow.
     proto::ServerToClientMsg msg;
     proto::UsersInfoInd* usersInfoInd = msg.mutable_users_info_ind();
+    usersInfoInd->set_baseline( true );
+    usersInfoInd->set_user_count( mPublishedUserNames.size() );
+    subIter->sentUserCount = mPublishedUserNames.size();
 
-    auto iter = mClientConnectionLoginMap.constBegin();
-    while( iter != mClientConnectionLoginMap.constEnd() )
+    if( subIter->usersMode == proto::LobbySubscriptionInd::USERS_ALL )
     {
-        proto::UsersInfoInd::UserInfo* addedUser = usersInfoInd->add_added_users();
-        addedUser->set_name( iter.value() );
-
-        ++iter;
+        for( const std::string& name : mPublishedUserNames )
+        {
+            proto::UsersInfoInd::UserInfo* addedUser = usersInfoInd->add_added_users();
+            addedUser->set_name( name );
+        }
     }
 
     mLogger->debug( "sending UsersInfoInd, size={} to client {}",
@@ -393,8 +669,7 @@ Server::broadcastUsersInfoDiffs()
     mLogger->trace( "broadcastUsersInfoDiffs" );
 
     //
-    // Go through the added, removed, and player updates and
-    // assemble a diff message
+    // Go through the added and removed users and assemble a diff message
     //
 
     // First, make sure there is something to send.
@@ -412,23 +687,56 @@ Server::broadcastUsersInfoDiffs()
     {
         proto::UsersInfoInd::UserInfo* addedUser = usersInfoInd->add_added_users();
         addedUser->set_name( name );
+        mPublishedUserNames.insert( name );
     }
 
     for( const std::string& name : mUsersInfoDiffRemovedNames )
     {
         usersInfoInd->add_removed_users( name );
+        mPublishedUserNames.erase( name );
     }
 
+    const unsigned int userCount = mPublishedUserNames.size();
+    usersInfoInd->set_user_count( userCount );
+
     // Clear all differences.
     mUsersInfoDiffAddedNames.clear();
     mUsersInfoDiffRemovedNames.clear();
 
-    // Send the message to each client connection.
-    for( auto clientConn : mClientConnectionLoginMap.keys() )
+    // Each variant is serialized once, and only if someone wants it.
+    QByteArray serializedMsg;
+    QByteArray serializedSummaryMsg;
+    for( auto iter = mLobbySubscriptionMap.begin(); iter != mLobbySubscriptionMap.end(); ++iter )
     {
-        mLogger->debug( "sending UsersInfoInd, size={} to client {}",
-                msg.ByteSize(), (std::size_t)clientConn );
-        clientConn->sendProtoMsg( msg );
+        if( iter->usersMode == proto::LobbySubscriptionInd::USERS_ALL )
+        {
+            if( serializedMsg.isEmpty() ) serializedMsg = serializePayload( msg );
+            iter.key()->sendSerializedMsg( serializedMsg, proto::ServerToClientMsg::kUsersInfoInd );
+        }
+        else if( (iter->usersMode == proto::LobbySubscriptionInd::USERS_SUMMARY) &&
+                 (iter->sentUserCount != userCount) )
+        {
+            if( serializedSummaryMsg.isEmpty() )
+            {
+                proto::ServerToClientMsg summaryMsg;
+                summaryMsg.mutable_users_info_ind()->set_user_count( userCount );
+                serializedSummaryMsg = serializePayload( summaryMsg );
+            }
+            iter.key()->sendSerializedMsg( serializedSummaryMsg, proto::ServerToClientMsg::kUsersInfoInd );
+        }
+        iter->sentUserCount = userCount;
+    }
+    mLogger->debug( "broadcast UsersInfoInd: userCount={}", userCount );
+}
+
+
+void
+Server::armUsersInfoDiffBroadcastTimer()
+{
+    if( !mUsersInfoDiffBroadcastTimer->isActive() )
+    {
+        mLogger->debug( "starting user info diffs broadcast timer" );
+        mUsersInfoDiffBroadcastTimer->start( 1000 );
     }
 }
 
@@ -475,19 +783,36 @@ Server::handleMessageFromClient( const proto::ClientToServerMsg& msg )
             // information.
             broadcastRoomsInfoDiffs();
 
-            // Similarly to rooms, add the user to the users list and
-            // broadcast it out so that all users are in sync when the new
-            // user gets his baseline.
-            mUsersInfoDiffAddedNames.push_back( name );
-            broadcastUsersInfoDiffs();
+            // Users are announced with the next users broadcast.  The new
+            // user's baseline is what was last broadcast, so the new user
+            // is in sync with everyone else from the start.
+            if( !mUsersInfoDiffRemovedNames.removeOne( name ) )
+            {
+                mUsersInfoDiffAddedNames.push_back( name );
+            }
+            armUsersInfoDiffBroadcastTimer();
 
             mLogger->info( "client logged in: name={}", name );
             mClientConnectionLoginMap.insert( clientConnection, name );
-            sendLoginRsp( clientConnection, proto::LoginRsp::RESULT_SUCCESS );
+            mLobbySubscriptionMap.insert( clientConnection, LobbySubscription() );
+            clientConnection->setPayloadRefsSupported( req.payload_refs_supported() );
+
+            // Stream compression starts right after the response, so the
+            // response must not be held in the outbound queue.  The client
+            // sends nothing compressed until it sees the response.
+            const bool streamCompression =
+                    (req.stream_compression_version() == NET_STREAM_COMPRESSION_VERSION) &&
+                    clientConnection->isSendingDirect();
+            sendLoginRsp( clientConnection, proto::LoginRsp::RESULT_SUCCESS,
+                    streamCompression ? NET_STREAM_COMPRESSION_VERSION : 0 );
+            if( streamCompression )
+            {
+                clientConnection->enableTxStreamCompression();
+                clientConnection->enableRxStreamCompression();
+            }
 
-            // OPTIMIZATION: Always send room capabilities at login time
-            // for now, but to save bandwidth this could be sent on request
-            // from client when it's time to create a room.
+            // Room capabilities are always sent at login time, but clients
+            // that support it get only a reference to their cached copy.
             sendRoomCapabilitiesInd( clientConnection );
 
             // Send all current room and user information to client.
@@ -508,6 +833,9 @@ Server::handleMessageFromClient( const proto::ClientToServerMsg& msg )
                 sendAlertsInd( clientConnection, alert.toStdString() );
             }
 
+            // Join the lobby chat, which sends recent lobby history.
+            mChatEngine->addUser( clientConnection, name, req.chat_batching_supported() );
+
             // User has logged in.  Check to see if they should be rejoined to a room
             // they had disconnected from.
             auto end = mRoomMap.cend();
@@ -520,8 +848,14 @@ Server::handleMessageFromClient( const proto::ClientToServerMsg& msg )
                 // been previously disconnected.
                 if( room->containsHumanPlayer( name ) )
                 {
-                    bool result = room->rejoin( clientConnection, name );
-                    if( !result )
+                    const proto::SessionResume* sessionResume =
+                            req.has_session_resume() ? &req.session_resume() : nullptr;
+                    bool result = room->rejoin( clientConnection, name, sessionResume );
+                    if( result )
+                    {
+                        mChatEngine->setUserRoom( clientConnection, room->getRoomId() );
+                    }
+                    else
                     {
                         // This should never happen but it's not critical,
                         // it just means the user isn't in the room.
@@ -530,54 +864,30 @@ Server::handleMessageFromClient( const proto::ClientToServerMsg& msg )
                     break;
                 }
             }
-        }
-    }
-    else if( msg.has_chat_message_ind() && loggedIn )
-    {
-        const proto::ChatMessageInd& ind = msg.chat_message_ind();
-        const std::string loginName = mClientConnectionLoginMap.value( clientConnection );
-        mLogger->debug( "got chat message from {}, scope={}", loginName, ind.scope() );
-
-        // Deliver message to all logged-in users.
-        proto::ServerToClientMsg msg;
-        proto::ChatMessageDeliveryInd* deliveryInd = msg.mutable_chat_message_delivery_ind();
-        deliveryInd->set_sender( loginName );
-        deliveryInd->set_scope( ind.scope() );
-        deliveryInd->set_text( ind.text() );
 
-        QList<ClientConnection*> destClientConnections;
-
-        if( ind.scope() == proto::CHAT_SCOPE_ALL )
-        {
-            // Send the message to each client connection.
-            destClientConnections = mClientConnectionLoginMap.keys();
-        }
-        else if( ind.scope() == proto::CHAT_SCOPE_ROOM )
-        {
-            auto end = mRoomMap.cend();
-            for( auto iter = mRoomMap.cbegin(); iter != end; ++iter )
+            if( mWorkerPool != nullptr )
             {
-                ServerRoom* room = iter.value();
-                if( room->containsHumanPlayer( loginName ) )
+                const int roomId = mWorkerPool->findRoomWithHumanPlayer( name );
+                if( roomId >= 0 )
                 {
-                    // Found the room.  Get all other connections and
-                    // send them the chat message.
-                    destClientConnections = room->getClientConnections();
+                    const proto::SessionResume* sessionResume =
+                            req.has_session_resume() ? &req.session_resume() : nullptr;
+                    if( !mWorkerPool->rejoinRoom( clientConnection, name, roomId, sessionResume ) )
+                    {
+                        mLogger->warn( "{} failed to rejoin worker room!", name );
+                    }
                 }
             }
         }
-        else
-        {
-            mLogger->warn( "chat scope {} not currently supported", ind.scope() );
-        }
+    }
+    else if( msg.has_chat_message_ind() && loggedIn )
+    {
+        const proto::ChatMessageInd& ind = msg.chat_message_ind();
+        mLogger->debug( "got chat message from {}, scope={}",
+                mClientConnectionLoginMap.value( clientConnection ), ind.scope() );
 
-        // Send the message to each destination client connection.
-        for( auto clientConn : destClientConnections )
-        {
-            mLogger->debug( "sending ChatMessageDeliveryInd, size={} to client {}",
-                    msg.ByteSize(), (std::size_t)clientConn );
-            clientConn->sendProtoMsg( msg );
-        }
+        // Rate limiting, audience and delivery are handled by the engine.
+        mChatEngine->post( clientConnection, ind );
     }
     else if( msg.has_create_room_req() && loggedIn )
     {
@@ -595,6 +905,11 @@ Server::handleMessageFromClient( const proto::ClientToServerMsg& msg )
                 return;
             }
         }
+        if( (mWorkerPool != nullptr) && mWorkerPool->containsRoomName( name ) )
+        {
+            sendCreateRoomFailureRsp( clientConnection, proto::CreateRoomFailureRsp::RESULT_NAME_IN_USE );
+            return;
+        }
 
         // Make sure the configuration is valid.
         proto::CreateRoomFailureRsp_ResultType failureResult;
@@ -606,6 +921,19 @@ Server::handleMessageFromClient( const proto::ClientToServerMsg& msg )
             return;
         }
 
+        // With workers, the room is created remotely and the response is
+        // sent once the worker reports back.
+        if( mWorkerPool != nullptr )
+        {
+            const int roomId = mNextRoomId++;
+            const std::string& password = req.has_password() ? req.password() : std::string();
+            if( !mWorkerPool->createRoom( clientConnection, roomId, password, roomConfig, mSettings->getRoomLimits() ) )
+            {
+                sendCreateRoomFailureRsp( clientConnection, proto::CreateRoomFailureRsp::RESULT_GENERAL_ERROR );
+            }
+            return;
+        }
+
         // Create dispensers.
         CardDispenserFactory factory( mAllSetsData );
         DraftCardDispenserSharedPtrVector<DraftCard> dispensers =
@@ -621,23 +949,19 @@ Server::handleMessageFromClient( const proto::ClientToServerMsg& msg )
         const int roomId = mNextRoomId++;
         const std::string& password = req.has_password() ? req.password() : std::string();
         const QString loggingConfigName = "serverroom-" + QString::number( roomId );
-        ServerRoom* room = new ServerRoom( roomId, password, roomConfig, dispensers,
+        ServerRoom* room = new ServerRoom( roomId, password, roomConfig, dispensers, mSettings->getRoomLimits(),
                 mLoggingConfig.createChildConfig( loggingConfigName.toStdString() ), this );
         mRoomMap[roomId] = room;
+        mPayloadStore.add( room->getRoomConfigPayload() );
         connect( room, &ServerRoom::playerCountChanged, this, &Server::handleRoomPlayerCountChanged );
         connect( room, &ServerRoom::roomExpired, this, &Server::handleRoomExpired );
         connect( room, &ServerRoom::roomError, this, &Server::handleRoomError );
 
         // Add the room to the room information differences list.
-        mRoomsInfoDiffAddedRoomIds.push_back( roomId );
-        armRoomsInfoDiffBroadcastTimer();
+        addRoomsInfoDiffRoom( roomId );
 
         // Send response to client.
-        mLogger->debug( "sendCreateRoomSuccessRsp: roomId={}", roomId );
-        proto::ServerToClientMsg msg;
-        proto::CreateRoomSuccessRsp* createRoomSuccessRsp = msg.mutable_create_room_success_rsp();
-        createRoomSuccessRsp->set_room_id( roomId );
-        clientConnection->sendProtoMsg( msg );
+        sendCreateRoomSuccessRsp( clientConnection, roomId );
     }
     else if( msg.has_join_room_req() && loggedIn )
     {
@@ -650,19 +974,50 @@ Server::handleMessageFromClient( const proto::ClientToServerMsg& msg )
         if( room != nullptr )
         {
             int chairIndex = -1;
-            bool result = room->join( clientConnection, loginName, password, chairIndex );
-            if( !result )
+            const proto::SessionResume* sessionResume =
+                    req.has_session_resume() ? &req.session_resume() : nullptr;
+            bool result = room->join( clientConnection, loginName, password, chairIndex, sessionResume );
+            if( result )
+            {
+                mChatEngine->setUserRoom( clientConnection, roomId );
+            }
+            else
             {
                 // This is normal, e.g. room full or bad password.
                 mLogger->info( "{} failed to join room", loginName );
             }
         }
-        else
+        else if( (mWorkerPool == nullptr) || !mWorkerPool->joinRoom( clientConnection, loginName, msg ) )
         {
             sendJoinRoomFailureRsp( clientConnection,
                     proto::JoinRoomFailureRsp::RESULT_INVALID_ROOM, roomId );
         }
     }
+    else if( msg.has_lobby_subscription_ind() && loggedIn )
+    {
+        const proto::LobbySubscriptionInd& ind = msg.lobby_subscription_ind();
+        mLogger->debug( "lobby subscription: rooms={}, users={}", ind.rooms(), ind.users() );
+
+        LobbySubscription subscription;
+        subscription.roomsMode = ind.rooms();
+        subscription.usersMode = ind.users();
+        subscription.roomsPageOffset = ind.rooms_page_offset();
+        subscription.roomsPageSize = std::min( ind.rooms_page_size(), ROOMS_PAGE_SIZE_MAX );
+        subscription.roomsNameFilter = QString::fromStdString( ind.rooms_name_filter() );
+        subscription.roomsHideFull = ind.rooms_hide_full();
+        mLobbySubscriptionMap.insert( clientConnection, subscription );
+
+        // Baselines for the new subscription.  Pending room differences go
+        // out first so the baseline matches what later diffs build on.
+        broadcastRoomsInfoDiffs();
+        sendBaselineRoomsInfo( clientConnection );
+        sendBaselineUsersInfo( clientConnection );
+    }
+    else if( msg.has_payload_fetch_req() && loggedIn )
+    {
+        const proto::PayloadFetchReq& req = msg.payload_fetch_req();
+        sendPayloadInd( clientConnection, QByteArray( req.hash().data(), req.hash().size() ) );
+    }
     else if( msg.has_depart_room_ind() && loggedIn )
     {
         // If the client is in a room, remove the client.
@@ -676,6 +1031,13 @@ Server::handleMessageFromClient( const proto::ClientToServerMsg& msg )
                 break;
             }
         }
+        mChatEngine->setUserRoom( clientConnection, -1 );
+
+        if( mWorkerPool != nullptr ) mWorkerPool->forwardClientMsg( clientConnection, msg );
+    }
+    else if( loggedIn && (mWorkerPool != nullptr) && mWorkerPool->forwardClientMsg( clientConnection, msg ) )
+    {
+        // Draft traffic for a room hosted by a worker.
     }
     else
     {
@@ -720,17 +1082,24 @@ Server::handleClientDisconnected()
             break;
         }
     }
+    if( mWorkerPool != nullptr ) mWorkerPool->removeClientConnection( clientConnection );
+    mChatEngine->removeUser( clientConnection );
 
     // If the client was logged in, broadcast that the user is gone.
     auto iter = mClientConnectionLoginMap.find( clientConnection );
     if( iter != mClientConnectionLoginMap.end() )
     {
-        mUsersInfoDiffRemovedNames.push_back( iter.value() );
-        broadcastUsersInfoDiffs();
+        // A user who was never announced needn't be.
+        if( !mUsersInfoDiffAddedNames.removeOne( iter.value() ) )
+        {
+            mUsersInfoDiffRemovedNames.push_back( iter.value() );
+        }
+        armUsersInfoDiffBroadcastTimer();
     }
 
-    // Remove client from login map.
+    // Remove client from login and subscription maps.
     mClientConnectionLoginMap.remove( clientConnection );
+    mLobbySubscriptionMap.remove( clientConnection );
 
     // Log network activity for diagnostics.
     mTotalDisconnectedClientBytesSent += clientConnection->getBytesSent();
@@ -810,8 +1179,28 @@ Server::teardownRoom( ServerRoom* room )
 
     // Remove room from room map.
     mRoomMap.remove( roomId );
+    mPayloadStore.release( room->getRoomConfigHash() );
 
     // Update room differences and ready an update.
+    removeRoomsInfoDiffRoom( roomId );
+    mChatEngine->removeRoomChannel( roomId );
+
+    // Destroy the room.
+    room->deleteLater();
+}
+
+
+void
+Server::addRoomsInfoDiffRoom( int roomId )
+{
+    mRoomsInfoDiffAddedRoomIds.push_back( roomId );
+    armRoomsInfoDiffBroadcastTimer();
+}
+
+
+void
+Server::removeRoomsInfoDiffRoom( int roomId )
+{
     if( mRoomsInfoDiffAddedRoomIds.contains( roomId ) )
     {
         // It's possible the room was very recently added.  If so, just
@@ -824,9 +1213,63 @@ Server::teardownRoom( ServerRoom* room )
         mRoomsInfoDiffRemovedRoomIds.push_back( roomId );
     }
     armRoomsInfoDiffBroadcastTimer();
+}
+
+
+void
+Server::handleWorkerRoomCreated( unsigned int roomId, ClientConnection* creator )
+{
+    mLogger->info( "worker room created: roomId={}", roomId );
+    mPayloadStore.add( mWorkerPool->getRoomConfigPayload( roomId ) );
+    addRoomsInfoDiffRoom( roomId );
+
+    // The creator may have disconnected in the meantime.
+    if( creator != nullptr ) sendCreateRoomSuccessRsp( creator, roomId );
+}
+
+
+void
+Server::handleWorkerRoomCreateFailed( unsigned int roomId, ClientConnection* creator,
+                                      proto::CreateRoomFailureRsp_ResultType result )
+{
+    mLogger->notice( "worker failed to create room: roomId={}, result={}", roomId, result );
+    if( creator != nullptr ) sendCreateRoomFailureRsp( creator, result );
+}
+
+
+void
+Server::handleWorkerRoomPlayerCountChanged( unsigned int roomId, int playerCount )
+{
+    mLogger->debug( "player count changed: roomId={}, playerCount={}", roomId, playerCount );
+    mRoomsInfoDiffPlayerCountsMap.insert( roomId, playerCount );
+    armRoomsInfoDiffBroadcastTimer();
+}
 
-    // Destroy the room.
-    room->deleteLater();
+
+void
+Server::handleWorkerRoomClosed( unsigned int roomId )
+{
+    mLogger->info( "worker room closed: roomId={}", roomId );
+    mPayloadStore.release( mWorkerPool->getRoomConfigHash( roomId ) );
+    removeRoomsInfoDiffRoom( roomId );
+    mChatEngine->removeRoomChannel( roomId );
+}
+
+
+void
+Server::handleWorkerClientRoomChanged( ClientConnection* clientConnection, int roomId )
+{
+    mChatEngine->setUserRoom( clientConnection, roomId );
+}
+
+
+void
+Server::handleUsersInfoDiffBroadcastTimerTimeout()
+{
+    mLogger->trace( "handleUsersInfoDiffBroadcastTimerTimeout" );
+
+    // Broadcast the user update to all clients.
+    broadcastUsersInfoDiffs();
 }
 
 
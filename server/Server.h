@@ -11,11 +11,16 @@ QT_END_NAMESPACE
 #include <QAbstractSocket>
 #include <QList>
 #include <QMap>
+#include <QSet>
 #include <memory>
+#include <set>
 
 #include "messages.pb.h"
 #include "AllSetsData.h"
 #include "RoomConfigValidator.h"
+#include "PayloadStore.h"
+#include "RoomDiagnostics.h"
+#include "CardCacheStats.h"
 
 #include "Logging.h"
 
@@ -24,6 +29,8 @@ class ClientConnection;
 class ServerRoom;
 class ServerSettings;
 class ClientNotices;
+class RoomWorkerPool;
+class ChatEngine;
 
 class Server : public QObject
 {
@@ -39,6 +46,31 @@ public:
 
     virtual ~Server();
 
+    // Host new rooms in worker processes rather than in this process.
+    // Must be set before start().
+    void setWorkerPool( RoomWorkerPool* workerPool );
+
+    // Snapshot of a client connection for the admin shell.
+    struct ConnectionDiagnostics
+    {
+        std::string  name;          // empty if not logged in
+        std::string  peerAddress;
+        uint64_t     bytesSent;
+        uint64_t     bytesReceived;
+        qint64       backlogBytes;
+        qint64       idleMillis;
+        int          roomId;        // -1 if not in a room
+    };
+
+    QList<ConnectionDiagnostics> getConnectionDiagnostics() const;
+
+    // Local and worker rooms in ascending room ID order.
+    QList<RoomDiagnostics> getRoomDiagnostics() const;
+
+    // Card cache counters reported by room workers; empty if rooms are
+    // hosted by this process.
+    QList<CardCacheStats> getWorkerCardCacheStats() const;
+
 public slots:
 
     void start();
@@ -63,7 +95,45 @@ private slots:
     void handleRoomExpired();
     void handleRoomError();
 
+    void handleWorkerRoomCreated( unsigned int roomId, ClientConnection* creator );
+    void handleWorkerRoomCreateFailed( unsigned int roomId, ClientConnection* creator,
+                                       proto::CreateRoomFailureRsp_ResultType result );
+    void handleWorkerRoomPlayerCountChanged( unsigned int roomId, int playerCount );
+    void handleWorkerRoomClosed( unsigned int roomId );
+    void handleWorkerClientRoomChanged( ClientConnection* clientConnection, int roomId );
+
     void handleRoomsInfoDiffBroadcastTimerTimeout();
+    void handleUsersInfoDiffBroadcastTimerTimeout();
+
+private:  // Types
+
+    // What lobby information a client wants (see LobbySubscriptionInd).
+    struct LobbySubscription
+    {
+        LobbySubscription()
+          : roomsMode( proto::LobbySubscriptionInd::ROOMS_ALL ),
+            usersMode( proto::LobbySubscriptionInd::USERS_ALL ),
+            roomsPageOffset( 0 ),
+            roomsPageSize( 0 ),
+            roomsHideFull( false ),
+            sentTotalRoomCount( 0 ),
+            sentUserCount( 0 )
+        {}
+
+        proto::LobbySubscriptionInd::RoomsMode roomsMode;
+        proto::LobbySubscriptionInd::UsersMode usersMode;
+        unsigned int                           roomsPageOffset;
+        unsigned int                           roomsPageSize;
+        QString                                roomsNameFilter;
+        bool                                   roomsHideFull;
+
+        // Cursor for ROOMS_PAGE: the rooms the client has.
+        QSet<int>                              sentRoomIds;
+        unsigned int                           sentTotalRoomCount;
+
+        // Cursor for USERS_SUMMARY.
+        unsigned int                           sentUserCount;
+    };
 
 private:  // Methods
 
@@ -71,29 +141,63 @@ private:  // Methods
     void sendAnnouncementsInd( ClientConnection* clientConnection, const std::string& text );
     void sendAlertsInd( ClientConnection* clientConnection, const std::string& text );
     void sendRoomCapabilitiesInd( ClientConnection* clientConnection );
+    void sendPayloadInd( ClientConnection* clientConnection, const QByteArray& hash );
     void sendLoginRsp( ClientConnection* clientConnection,
-                       const proto::LoginRsp::ResultType& result );
+                       const proto::LoginRsp::ResultType& result,
+                       unsigned int streamCompressionVersion = 0 );
     void sendCreateRoomFailureRsp( ClientConnection* clientConnection,
                                    proto::CreateRoomFailureRsp_ResultType result );
     void sendJoinRoomFailureRsp( ClientConnection* clientConnection,
                                  proto::JoinRoomFailureRsp_ResultType result, int roomId );
+    void sendCreateRoomSuccessRsp( ClientConnection* clientConnection, int roomId );
+
+    // Room configuration of a local or worker room, or null if there
+    // is no such room.
+    const proto::RoomConfig* findRoomConfig( int roomId ) const;
+
+    // Add a room to the rooms information differences list.
+    void addRoomsInfoDiffRoom( int roomId );
 
-    // Send a baseline rooms information message to a client.
+    // Remove a room from the rooms information differences list.
+    void removeRoomsInfoDiffRoom( int roomId );
+
+    // Send a baseline rooms information message to a client according
+    // to its subscription.  Pending differences must have been broadcast.
     void sendBaselineRoomsInfo( ClientConnection* clientConnection );
 
-    // Broadcast rooms information differences to all clients.
+    // Broadcast rooms information differences to subscribed clients.
     void broadcastRoomsInfoDiffs();
 
+    // Send a paged subscriber the differences between the rooms page it
+    // has and its current page.
+    void sendRoomsPageDiff( ClientConnection* clientConnection, LobbySubscription& subscription );
+
+    // IDs of all local and worker rooms in ascending order.
+    QList<int> getRoomIds() const;
+    unsigned int getRoomPlayerCount( int roomId ) const;
+
+    // Rooms on a paged subscriber's page, and the number of rooms
+    // matching its filter.
+    QList<int> getRoomsPage( const LobbySubscription& subscription, unsigned int& totalRoomCount ) const;
+
+    // Add a room with its abridged configuration to a message.
+    void addRoomInfo( proto::RoomsInfoInd* roomsInfoInd, int roomId, bool includePlayerCount ) const;
+
     // Arms the timer to send out a rooms info diff broadcast, unless
     // it was already armed.
     void armRoomsInfoDiffBroadcastTimer();
 
-    // Send a baseline users information message to a client.
+    // Send a baseline users information message to a client according
+    // to its subscription.
     void sendBaselineUsersInfo( ClientConnection* clientConnection );
 
-    // Broadcast users information differences to all clients.
+    // Broadcast users information differences to subscribed clients.
     void broadcastUsersInfoDiffs();
 
+    // Arms the timer to send out a users info diff broadcast, unless
+    // it was already armed.
+    void armUsersInfoDiffBroadcastTimer();
+
     // Teardown a room after expiration or error.
     void teardownRoom( ServerRoom* room );
 
@@ -115,13 +219,33 @@ private:  // Data
     unsigned int                        mNextRoomId;
     QMap<unsigned int,ServerRoom*>      mRoomMap;
 
+    // Optional; rooms hosted by worker processes.  Room IDs are shared
+    // between local and worker rooms.
+    RoomWorkerPool*                     mWorkerPool;
+
+    // Lobby and room chat channels.
+    ChatEngine*                         mChatEngine;
+
+    // Payloads clients may fetch by hash.
+    PayloadStore                        mPayloadStore;
+
+    // Room capabilities never change, so the messages carrying them
+    // (in full and by reference) are serialized once.
+    QByteArray                          mRoomCapabilitiesMsg;
+    QByteArray                          mRoomCapabilitiesRefMsg;
+
     QList<int>       mRoomsInfoDiffAddedRoomIds;
     QList<int>       mRoomsInfoDiffRemovedRoomIds;
     QMap<int,int>    mRoomsInfoDiffPlayerCountsMap;
     QTimer*          mRoomsInfoDiffBroadcastTimer;
 
-    QList<std::string> mUsersInfoDiffAddedNames;
-    QList<std::string> mUsersInfoDiffRemovedNames;
+    // Users as of the last users info broadcast, and changes since.
+    std::set<std::string> mPublishedUserNames;
+    QList<std::string>    mUsersInfoDiffAddedNames;
+    QList<std::string>    mUsersInfoDiffRemovedNames;
+    QTimer*               mUsersInfoDiffBroadcastTimer;
+
+    QMap<ClientConnection*,LobbySubscription> mLobbySubscriptionMap;
 
     uint64_t mTotalDisconnectedClientBytesSent;
     uint64_t mTotalDisconnectedClientBytesReceived;
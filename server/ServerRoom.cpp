@@ -1,9 +1,11 @@
 #include "ServerRoom.h"
 
 #include <stdlib.h>
+#include <algorithm>
 #include <memory>
 
 #include <QTimer>
+#include <QSet>
 
 #include "ClientConnection.h"
 #include "HumanPlayer.h"
@@ -12,24 +14,48 @@
 
 static const int CREATED_ROOM_EXPIRATION_SECONDS   =  10;
 static const int ABANDONED_ROOM_EXPIRATION_SECONDS = 120;
+static const int DECK_UPDATE_DELAY_MILLIS          = 500;
+static const int DRAFT_TIMER_TICK_MILLIS           = 1000;
+
+// How often room resource use is checked against the limits.
+static const int LIMIT_CHECK_INTERVAL_MILLIS       = 10000;
+
+// A degraded room broadcasts booster draft state every this many ticks
+// rather than on every tick and pack queue change.
+static const unsigned int DEGRADED_DRAFT_STATE_TICKS = 5;
+
+// A degraded room collects deck updates for longer.
+static const int DEGRADED_DECK_UPDATE_DELAY_MILLIS = 5000;
 
 ServerRoom::ServerRoom( unsigned int                      roomId,
                         const std::string&                password,
                         const proto::RoomConfig&          roomConfig,
                         const DraftCardDispenserSharedPtrVector<DraftCard>& dispensers,
+                        const RoomLimits&                 limits,
                         const Logging::Config&            loggingConfig,
                         QObject*                          parent )
 :   QObject( parent ),
     mRoomId( roomId ),
     mPassword( password ),
     mRoomConfig( roomConfig ),
+    mRoomConfigPayload( serializePayload( roomConfig ) ),
+    mRoomConfigHash( computePayloadHash( mRoomConfigPayload ) ),
     mDispensers( dispensers ),
     mChairCount( mRoomConfig.draft_config().chair_count() ),
     mBotPlayerCount( mRoomConfig.bot_count() ),
+    mDraftPtr( nullptr ),
     mDraftComplete( false ),
+    mDraftReleased( false ),
     mPublicStatePresent( false ),
     mPostRoundTimerActive( false ),
     mPostRoundTimerTicksRemaining( 0 ),
+    mDraftTimerTickLagMillis( 0 ),
+    mDraftTimerMaxTickLagMillis( 0 ),
+    mLimitChecker( limits ),
+    mLimitCheckCpuNanos( 0 ),
+    mCpuPercent( 0 ),
+    mDegraded( false ),
+    mDegradedTickCount( 0 ),
     mLoggingConfig( loggingConfig ),
     mLogger( mLoggingConfig.createLogger() )
 {
@@ -43,6 +69,8 @@ ServerRoom::ServerRoom( unsigned int                      roomId,
 void
 ServerRoom::initialize()
 {
+    RoomCpuMeter::Scope cpuScope( mCpuMeter );
+
     if( (mChairCount <= 0) )
     {
         mLogger->error( "invalid room configuration!" );
@@ -70,6 +98,20 @@ ServerRoom::initialize()
     mDraftTimer = new QTimer( this );
     connect(mDraftTimer, SIGNAL(timeout()), this, SLOT(handleDraftTimerTick()));
 
+    // Deck updates are throttled rather than sent on every card move.  The
+    // first change starts the timer and later changes join the same batch,
+    // so updates go out at most once per interval even while a player
+    // keeps moving cards.
+    mDeckUpdateTimer = new QTimer( this );
+    mDeckUpdateTimer->setSingleShot( true );
+    mDeckUpdateTimer->setInterval( DECK_UPDATE_DELAY_MILLIS );
+    connect( mDeckUpdateTimer, &QTimer::timeout, this, &ServerRoom::handleDeckUpdateTimeout );
+
+    mLimitCheckTimer = new QTimer( this );
+    connect( mLimitCheckTimer, &QTimer::timeout, this, &ServerRoom::handleLimitCheckTimeout );
+    mLimitCheckTimer->start( LIMIT_CHECK_INTERVAL_MILLIS );
+    mSinceLimitCheck.start();
+
     // Add in the bots.
     unsigned int botPlayerCount = mBotPlayerCount;
     if( botPlayerCount > mChairCount )
@@ -125,8 +167,14 @@ ServerRoom::~ServerRoom()
 
 
 bool
-ServerRoom::join( ClientConnection* clientConnection, const std::string& name, const std::string& password, int& chairIndex )
+ServerRoom::join( ClientConnection*            clientConnection,
+                  const std::string&           name,
+                  const std::string&           password,
+                  int&                         chairIndex,
+                  const proto::SessionResume*  sessionResume )
 {
+    RoomCpuMeter::Scope cpuScope( mCpuMeter );
+
     // REFACTOR - this code and rejoin() have a LOT in common
 
     // This could be a rejoin - find the human by name.
@@ -134,7 +182,7 @@ ServerRoom::join( ClientConnection* clientConnection, const std::string& name, c
     if( humanPlayer  )
     {
         mLogger->debug( "join: rejoining existing player to room" );
-        return rejoin( clientConnection, name );
+        return rejoin( clientConnection, name, sessionResume );
     }
 
     if( !mPassword.empty() && (password != mPassword) )
@@ -144,14 +192,14 @@ ServerRoom::join( ClientConnection* clientConnection, const std::string& name, c
     }
 
     int playerIdx = getNextAvailablePlayerIndex();
-    if( playerIdx == -1 )
+    if( (playerIdx == -1) || mDraftReleased )
     {
         sendJoinRoomFailureRsp( clientConnection, proto::JoinRoomFailureRsp::RESULT_ROOM_FULL, mRoomId );
         return false;
     }
     chairIndex = playerIdx;
 
-    HumanPlayer *human = new HumanPlayer( playerIdx, mDraftPtr, mLoggingConfig.createChildConfig( "humanplayer" ), this );
+    HumanPlayer *human = new HumanPlayer( playerIdx, mDraftPtr, mCpuMeter, mLoggingConfig.createChildConfig( "humanplayer" ), this );
     connect( human, &HumanPlayer::readyUpdate, this, &ServerRoom::handleHumanReadyUpdate );
     connect( human, &HumanPlayer::deckUpdate, this, &ServerRoom::handleHumanDeckUpdate );
     human->setName( name );
@@ -174,7 +222,7 @@ ServerRoom::join( ClientConnection* clientConnection, const std::string& name, c
     mDraftPtr->addObserver( human );
 
     // Inform the client that the room join was successful.
-    sendJoinRoomSuccessRspInd( clientConnection, mRoomId, false, chairIndex );
+    sendJoinRoomSuccessRspInd( clientConnection, mRoomId, false, chairIndex, human, false );
 
     emit playerCountChanged( getPlayerCount() );
 
@@ -188,6 +236,8 @@ ServerRoom::join( ClientConnection* clientConnection, const std::string& name, c
 void
 ServerRoom::leave( ClientConnection* clientConnection )
 {
+    RoomCpuMeter::Scope cpuScope( mCpuMeter );
+
     QMap<ClientConnection*,HumanPlayer*>::iterator iter = mClientConnectionMap.find( clientConnection );
     if( iter != mClientConnectionMap.end() )
     {
@@ -217,7 +267,7 @@ ServerRoom::leave( ClientConnection* clientConnection )
         {
             // The draft hasn't started yet, so remove and destroy the human.
 
-            mDraftPtr->removeObserver( human );
+            if( mDraftPtr != nullptr ) mDraftPtr->removeObserver( human );
             mHumanList.removeOne( human );
             delete human;
 
@@ -246,8 +296,10 @@ ServerRoom::leave( ClientConnection* clientConnection )
 
 
 bool
-ServerRoom::rejoin( ClientConnection* clientConnection, const std::string& name )
+ServerRoom::rejoin( ClientConnection* clientConnection, const std::string& name, const proto::SessionResume* sessionResume )
 {
+    RoomCpuMeter::Scope cpuScope( mCpuMeter );
+
     mLogger->trace( "rejoin room, client={}, name={}", (std::size_t)clientConnection, name );
 
     // Find the human by name.
@@ -280,21 +332,48 @@ ServerRoom::rejoin( ClientConnection* clientConnection, const std::string& name
     // With at least one connection don't let the room expire.
     mRoomExpirationTimer->stop();
 
+    // If the client presented a valid resume token and everything it
+    // missed is still buffered, replay the missed messages rather than
+    // resending the inventory.
+    const bool resumed = (sessionResume != nullptr) &&
+                         (sessionResume->room_id() == mRoomId) &&
+                         (sessionResume->resume_token() == humanPlayer->getResumeToken()) &&
+                         humanPlayer->canReplayAfter( sessionResume->last_sequence() );
+
     // Send the user a room join success indication with the rejoin flag set.
-    sendJoinRoomSuccessRspInd( clientConnection, mRoomId, true, chairIndex );
+    sendJoinRoomSuccessRspInd( clientConnection, mRoomId, true, chairIndex, humanPlayer, resumed );
+
+    if( resumed )
+    {
+        mLogger->debug( "resuming session for {} after seq {}", name, sessionResume->last_sequence() );
+        humanPlayer->replayAfter( sessionResume->last_sequence() );
+    }
+    else
+    {
+        if( sessionResume != nullptr )
+        {
+            mLogger->info( "unable to resume session for {}, sending full state", name );
+        }
+        humanPlayer->resetInventoryUpdateSequence();
+    }
 
     emit playerCountChanged( getPlayerCount() );
 
     // Inform all occupants (including the new user) of user states.
     broadcastRoomOccupantsInfo();
 
-    // Send the rejoining user their inventory of cards.
-    humanPlayer->sendInventoryToClient();
+    // Send the rejoining user their inventory of cards.  A resumed
+    // session already has it, plus any changes from the replay.
+    if( !resumed )
+    {
+        humanPlayer->sendInventoryToClient();
+    }
 
     // Send user a room stage update indication.
+    const DraftType::StateType draftState = mDraftReleased ? DraftType::STATE_COMPLETE : mDraftPtr->getState();
     proto::ServerToClientMsg msg;
     proto::RoomStageInd* roomStageInd = msg.mutable_room_stage_ind();
-    switch( mDraftPtr->getState() )
+    switch( draftState )
     {
         case DraftType::STATE_NEW:
             roomStageInd->set_stage( proto::RoomStageInd::STAGE_NEW );
@@ -316,24 +395,24 @@ ServerRoom::rejoin( ClientConnection* clientConnection, const std::string& name
             roomStageInd->set_stage( proto::RoomStageInd::STAGE_COMPLETE );
             break;
         default:
-            mLogger->error( "unhandled room state {}", mDraftPtr->getState() );
+            mLogger->error( "unhandled room state {}", draftState );
     }
     mLogger->debug( "sending RoomStageInd, size={} to client {}",
             msg.ByteSize(), (std::size_t)clientConnection );
-    clientConnection->sendProtoMsg( msg );
+    humanPlayer->sendServerToClientMsg( msg );
 
     // Send current draft state information if draft is running.
-    if( mDraftPtr->getState() == DraftType::STATE_RUNNING )
+    if( draftState == DraftType::STATE_RUNNING )
     {
         // Send user current pack, if any.
         humanPlayer->sendCurrentPackToClient();
 
         // Update the client's public state, if any.
-        sendPublicState( { clientConnection } );
+        sendPublicState( { humanPlayer } );
     }
 
     // Send all current hashes if the round is complete.
-    if( mDraftPtr->getState() == DraftType::STATE_COMPLETE )
+    if( draftState == DraftType::STATE_COMPLETE )
     {
         msg.Clear();
         proto::RoomChairsDeckInfoInd* deckInfoInd = msg.mutable_room_chairs_deck_info_ind();
@@ -348,7 +427,7 @@ ServerRoom::rejoin( ClientConnection* clientConnection, const std::string& name
 
         mLogger->debug( "sending deckInfoInd, size={} to client {}",
                 msg.ByteSize(), (std::size_t)clientConnection );
-        clientConnection->sendProtoMsg( msg );
+        humanPlayer->sendServerToClientMsg( msg );
     }
 
     return true;
@@ -371,8 +450,8 @@ ServerRoom::getChairInfo( unsigned int  chairIndex,
         {
             name = player->getName();
             isBot = mBotList.contains( (BotPlayer*)player );
-            packsQueued = mDraftPtr->getPackQueueSize( chairIndex );
-            ticksRemaining = mDraftPtr->getTicksRemaining( chairIndex );
+            packsQueued = (mDraftPtr != nullptr) ? mDraftPtr->getPackQueueSize( chairIndex ) : 0;
+            ticksRemaining = (mDraftPtr != nullptr) ? mDraftPtr->getTicksRemaining( chairIndex ) : 0;
         }
         else
         {
@@ -390,11 +469,68 @@ ServerRoom::getChairInfo( unsigned int  chairIndex,
 }
 
 
+RoomDiagnostics
+ServerRoom::getDiagnostics() const
+{
+    RoomDiagnostics diagnostics;
+    diagnostics.roomId = mRoomId;
+    diagnostics.name = mRoomConfig.name();
+    diagnostics.playerCount = getPlayerCount();
+    diagnostics.chairCount = mChairCount;
+    diagnostics.tickLagMillis = mDraftTimerTickLagMillis;
+    diagnostics.maxTickLagMillis = mDraftTimerMaxTickLagMillis;
+    diagnostics.memoryBytes = getApproximateMemoryBytes();
+    diagnostics.cpuMillis = mCpuMeter.getMillis();
+    diagnostics.cpuPercent = mCpuPercent;
+    diagnostics.overBudget = mLimitChecker.isOverBudget();
+
+    if( mDraftPtr == nullptr )
+    {
+        diagnostics.phase = mDraftReleased ? "complete" : "initializing";
+        return diagnostics;
+    }
+
+    switch( mDraftPtr->getState() )
+    {
+        case DraftType::STATE_NEW:
+            diagnostics.phase = "waiting";
+            break;
+        case DraftType::STATE_RUNNING:
+            diagnostics.phase = "round " + std::to_string( mDraftPtr->getCurrentRound() + 1 ) +
+                    "/" + std::to_string( mDraftPtr->getRoundCount() );
+            break;
+        case DraftType::STATE_COMPLETE:
+            diagnostics.phase = "complete";
+            break;
+        default:
+            diagnostics.phase = "error";
+            break;
+    }
+    return diagnostics;
+}
+
+
+std::size_t
+ServerRoom::getApproximateMemoryBytes() const
+{
+    std::size_t bytes = sizeof( *this ) + mRoomConfig.ByteSize() + mRoomConfigPayload.size() +
+            mPublicCardStates.size() * sizeof( PublicCardState );
+
+    if( mDraftPtr != nullptr ) bytes += mDraftPtr->getApproximateMemoryBytes();
+    for( const auto& dispenser : mDispensers ) bytes += dispenser->getApproximateMemoryBytes();
+    for( const HumanPlayer* human : mHumanList ) bytes += human->getApproximateMemoryBytes();
+
+    return bytes;
+}
+
+
 void
-ServerRoom::sendJoinRoomSuccessRspInd( ClientConnection* clientConnection,
-                                       int               roomId,
-                                       bool              rejoin,
-                                       int               chairIndex )
+ServerRoom::sendJoinRoomSuccessRspInd( ClientConnection*   clientConnection,
+                                       int                 roomId,
+                                       bool                rejoin,
+                                       int                 chairIndex,
+                                       const HumanPlayer*  human,
+                                       bool                resumed )
 {
     mLogger->trace( "sendJoinRoomSuccessRspInd" );
     proto::ServerToClientMsg msg;
@@ -402,10 +538,25 @@ ServerRoom::sendJoinRoomSuccessRspInd( ClientConnection* clientConnection,
     joinRoomSuccessRspInd->set_room_id( roomId );
     joinRoomSuccessRspInd->set_rejoin( rejoin );
     joinRoomSuccessRspInd->set_chair_idx( chairIndex );
+    joinRoomSuccessRspInd->set_resume_token( human->getResumeToken() );
+    joinRoomSuccessRspInd->set_resumed( resumed );
 
-    // Assemble room configuration.
-    proto::RoomConfig* roomConfig = joinRoomSuccessRspInd->mutable_room_config();
-    *roomConfig = mRoomConfig;
+    // Assemble room configuration, by reference if the client can take it.
+    if( clientConnection->getPayloadRefsSupported() )
+    {
+        joinRoomSuccessRspInd->set_room_config_hash( mRoomConfigHash.constData(), mRoomConfigHash.size() );
+    }
+    else if( mDraftReleased )
+    {
+        // The held config is abridged; the payload has it all.
+        proto::RoomConfig* roomConfig = joinRoomSuccessRspInd->mutable_room_config();
+        roomConfig->ParseFromArray( mRoomConfigPayload.constData(), mRoomConfigPayload.size() );
+    }
+    else
+    {
+        proto::RoomConfig* roomConfig = joinRoomSuccessRspInd->mutable_room_config();
+        *roomConfig = mRoomConfig;
+    }
 
     clientConnection->sendProtoMsg( msg );
 }
@@ -455,12 +606,12 @@ ServerRoom::broadcastRoomOccupantsInfo()
 
     const int protoSize = msg.ByteSize();
 
-    // Send the message to each client connection.
-    for( auto clientConn : mClientConnectionMap.keys())
+    // Send the message to all humans in the room.
+    for( HumanPlayer* human : mHumanList )
     {
-        mLogger->debug( "sending roomOccupantsInfoInd, size={} to client {}",
-                protoSize, (std::size_t)clientConn );
-        clientConn->sendProtoMsg( msg );
+        mLogger->debug( "sending roomOccupantsInfoInd, size={} to human {}",
+                protoSize, (std::size_t)human );
+        human->sendServerToClientMsg( msg );
     }
 }
 
@@ -487,18 +638,18 @@ ServerRoom::broadcastBoosterDraftState()
 
     const int protoSize = msg.ByteSize();
 
-    // Send the message to all active client connections.
-    for( ClientConnection* clientConnection : mClientConnectionMap.keys() )
+    // Send the message to all humans in the room.
+    for( HumanPlayer* human : mHumanList )
     {
-        mLogger->debug( "sending roomChairsInfoInd, size={} to client {}",
-                protoSize, (std::size_t)clientConnection );
-        clientConnection->sendProtoMsg( msg );
+        mLogger->debug( "sending roomChairsInfoInd, size={} to human {}",
+                protoSize, (std::size_t)human );
+        human->sendServerToClientMsg( msg );
     }
 }
 
 
 void
-ServerRoom::sendPublicState( const QList<ClientConnection*> clientConnections )
+ServerRoom::sendPublicState( const QList<HumanPlayer*>& humans )
 {
     if( !mPublicStatePresent )
     {
@@ -526,36 +677,42 @@ ServerRoom::sendPublicState( const QList<ClientConnection*> clientConnections )
 
     const int protoSize = msg.ByteSize();
 
-    // Send the message to all active client connections.
-    for( ClientConnection* clientConnection : clientConnections )
+    // Send the message to the requested humans.
+    for( HumanPlayer* human : humans )
     {
-        mLogger->debug( "sending PublicStateInd, size={} to client {}",
-                protoSize, (std::size_t)clientConnection );
-        clientConnection->sendProtoMsg( msg );
+        mLogger->debug( "sending PublicStateInd, size={} to human {}",
+                protoSize, (std::size_t)human );
+        human->sendServerToClientMsg( msg );
     }
 }
 
 
 void
-ServerRoom::broadcastRoomChairsDeckInfo( const HumanPlayer& human )
+ServerRoom::broadcastRoomChairsDeckInfo( const QList<HumanPlayer*>& humans )
 {
+    // Nobody to observe the hashes, so don't bother computing them.
+    if( humans.isEmpty() || mClientConnectionMap.isEmpty() ) return;
+
     // Build the message.
     proto::ServerToClientMsg msg;
     proto::RoomChairsDeckInfoInd* ind = msg.mutable_room_chairs_deck_info_ind();
 
-    proto::RoomChairsDeckInfoInd::Chair* chair = ind->add_chairs();
-    chair->set_chair_index( human.getChairIndex() );
-    chair->set_cockatrice_hash( human.getCockatriceHash().toStdString() );
-    chair->set_mws_hash( "" );
+    for( HumanPlayer* human : humans )
+    {
+        proto::RoomChairsDeckInfoInd::Chair* chair = ind->add_chairs();
+        chair->set_chair_index( human->getChairIndex() );
+        chair->set_cockatrice_hash( human->getCockatriceHash().toStdString() );
+        chair->set_mws_hash( "" );
+    }
 
     const int protoSize = msg.ByteSize();
 
-    // Send the message to all active client connections.
-    for( ClientConnection* clientConnection : mClientConnectionMap.keys() )
+    // Send the message to all humans in the room.
+    for( HumanPlayer* human : mHumanList )
     {
-        mLogger->debug( "sending roomChairsDeckInfoInd, size={} to client {}",
-                protoSize, (std::size_t)clientConnection );
-        clientConnection->sendProtoMsg( msg );
+        mLogger->debug( "sending roomChairsDeckInfoInd, size={} to human {}",
+                protoSize, (std::size_t)human );
+        human->sendServerToClientMsg( msg );
     }
 }
 
@@ -563,15 +720,23 @@ ServerRoom::broadcastRoomChairsDeckInfo( const HumanPlayer& human )
 void
 ServerRoom::handleDraftTimerTick()
 {
+    RoomCpuMeter::Scope cpuScope( mCpuMeter );
     mLogger->trace( "tick" );
 
+    // A busy event loop delays ticks.
+    mDraftTimerTickLagMillis = static_cast<int>( std::max<qint64>( 0, mSinceDraftTimerTick.restart() - DRAFT_TIMER_TICK_MILLIS ) );
+    mDraftTimerMaxTickLagMillis = std::max( mDraftTimerMaxTickLagMillis, mDraftTimerTickLagMillis );
+
     if( mPostRoundTimerActive ) mPostRoundTimerTicksRemaining--;
 
     mDraftPtr->tick();
 
     if( (mDraftPtr->getState() == DraftType::STATE_RUNNING) && (mDraftPtr->isBoosterRound()) )
     {
-        broadcastBoosterDraftState();
+        if( !mDegraded || (++mDegradedTickCount % DEGRADED_DRAFT_STATE_TICKS == 0) )
+        {
+            broadcastBoosterDraftState();
+        }
     }
 }
 
@@ -579,6 +744,7 @@ ServerRoom::handleDraftTimerTick()
 void
 ServerRoom::handleHumanReadyUpdate( bool ready )
 {
+    RoomCpuMeter::Scope cpuScope( mCpuMeter );
     mLogger->trace( "handleHumanReady: ready={}", ready );
     HumanPlayer *human = qobject_cast<HumanPlayer*>( QObject::sender() );
 
@@ -625,7 +791,8 @@ ServerRoom::handleHumanReadyUpdate( bool ready )
     if( allChairsReady )
     {
         mLogger->info( "starting the draft!" );
-        mDraftTimer->start( 1000 );
+        mDraftTimer->start( DRAFT_TIMER_TICK_MILLIS );
+        mSinceDraftTimerTick.start();
         mDraftPtr->start();
     }
 }
@@ -634,17 +801,138 @@ ServerRoom::handleHumanReadyUpdate( bool ready )
 void
 ServerRoom::handleHumanDeckUpdate()
 {
+    RoomCpuMeter::Scope cpuScope( mCpuMeter );
     mLogger->trace( "handleHumanDeckUpdate" );
 
-    // If the draft is complete, broadcast the deck update message.
+    // If the draft is complete, queue the deck update message.  Players
+    // manipulate decks rapidly, so updates are bundled and sent when the
+    // timer fires.
     if( mDraftComplete )
     {
         HumanPlayer *human = qobject_cast<HumanPlayer*>( QObject::sender() );
-        broadcastRoomChairsDeckInfo( *human );
+        if( human == nullptr ) return;
+        mPendingDeckUpdateChairs.insert( human->getChairIndex() );
+        if( !mDeckUpdateTimer->isActive() ) mDeckUpdateTimer->start();
+    }
+}
+
+
+void
+ServerRoom::handleDeckUpdateTimeout()
+{
+    RoomCpuMeter::Scope cpuScope( mCpuMeter );
 
-        // OPTIMIZATION - this is going to send a lot of messages as
-        // players manipulate decks.  Bundle updates an send out on a timer.
+    QList<HumanPlayer*> humans;
+    for( HumanPlayer* human : mHumanList )
+    {
+        if( mPendingDeckUpdateChairs.contains( human->getChairIndex() ) ) humans.append( human );
+    }
+    mPendingDeckUpdateChairs.clear();
+
+    mLogger->debug( "sending {} pending deck updates", humans.size() );
+    broadcastRoomChairsDeckInfo( humans );
+}
+
+
+void
+ServerRoom::handleLimitCheckTimeout()
+{
+    const int64_t elapsedNanos = mSinceLimitCheck.nsecsElapsed();
+    mSinceLimitCheck.start();
+
+    const int64_t cpuNanos = mCpuMeter.getNanos() - mLimitCheckCpuNanos;
+    mLimitCheckCpuNanos = mCpuMeter.getNanos();
+    mCpuPercent = (elapsedNanos > 0) ? static_cast<unsigned int>( cpuNanos * 100 / elapsedNanos ) : 0;
+
+    const std::size_t memoryBytes = getApproximateMemoryBytes();
+    mLogger->trace( "resource check: cpu={}% memory={}", mCpuPercent, memoryBytes );
+
+    const RoomLimitChecker::Step step = mLimitChecker.check( mCpuPercent, memoryBytes );
+    if( step == RoomLimitChecker::STEP_NONE ) return;
+
+    if( step == RoomLimitChecker::STEP_RECOVER )
+    {
+        mLogger->info( "room back within limits: cpu={}% memory={}", mCpuPercent, memoryBytes );
+        setDegraded( false );
+        return;
+    }
+
+    const RoomLimits& limits = mLimitChecker.getLimits();
+    mLogger->warn( "room over limits: cpu={}% (limit {}%) memory={} (limit {}), action={}",
+            mCpuPercent, limits.cpuPercent, memoryBytes, limits.memoryBytes, stringify( limits.action ) );
+    switch( step )
+    {
+        case RoomLimitChecker::STEP_DEGRADE:
+            setDegraded( true );
+            break;
+        case RoomLimitChecker::STEP_EXPIRE:
+            mLimitCheckTimer->stop();
+            expireRoom();
+            break;
+        default:
+            break;
+    }
+}
+
+
+void
+ServerRoom::expireRoom()
+{
+    // Send humans a room error indication so they leave the room.
+    proto::ServerToClientMsg msg;
+    (void*) msg.mutable_room_error_ind();
+    mLogger->debug( "sending RoomErrorInd for expiring room" );
+    for( HumanPlayer* human : mHumanList )
+    {
+        human->sendServerToClientMsg( msg );
+    }
+
+    emit roomExpired();
+}
+
+
+void
+ServerRoom::releaseDraft()
+{
+    RoomCpuMeter::Scope cpuScope( mCpuMeter );
+    if( mDraftReleased || (mDraftPtr == nullptr) ) return;
+
+    const std::size_t bytesBefore = getApproximateMemoryBytes();
+
+    for( HumanPlayer* human : mHumanList )
+    {
+        human->releaseDraft();
     }
+
+    // Bots stay as occupants but hold nothing of the draft.
+    delete mDraftPtr;
+    mDraftPtr = nullptr;
+    DraftCardDispenserSharedPtrVector<DraftCard>().swap( mDispensers );
+
+    mPublicStatePresent = false;
+    std::vector<PublicCardState>().swap( mPublicCardStates );
+
+    // Drop custom card list contents, as the lobby's abridged room info
+    // does.  Anything needing the full config can parse the payload.
+    proto::DraftConfig* draftConfig = mRoomConfig.mutable_draft_config();
+    for( int i = 0; i < draftConfig->custom_card_lists_size(); ++i )
+    {
+        draftConfig->mutable_custom_card_lists( i )->clear_card_quantities();
+    }
+
+    mDraftReleased = true;
+    mLogger->info( "released completed draft, approximate memory {} -> {}",
+            bytesBefore, getApproximateMemoryBytes() );
+}
+
+
+void
+ServerRoom::setDegraded( bool degraded )
+{
+    if( degraded == mDegraded ) return;
+    mDegraded = degraded;
+    mDegradedTickCount = 0;
+    mDeckUpdateTimer->setInterval( degraded ? DEGRADED_DECK_UPDATE_DELAY_MILLIS : DECK_UPDATE_DELAY_MILLIS );
 }
 
 
@@ -653,7 +941,8 @@ ServerRoom::notifyPackQueueSizeChanged( DraftType& draft, int chairIndex, int pa
 {
     mLogger->trace( "chair {} packQueueSize={}", chairIndex, packQueueSize );
 
-    broadcastBoosterDraftState();
+    // Degraded rooms leave this to the draft timer.
+    if( !mDegraded ) broadcastBoosterDraftState();
 }
 
 
@@ -668,7 +957,7 @@ ServerRoom::notifyPublicState( DraftType& draft, uint32_t packId, const std::vec
     mPublicActiveChairIndex = activeChairIndex;
 
     // Broadcast public state to all clients.
-    sendPublicState( mClientConnectionMap.keys() );
+    sendPublicState( mHumanList );
 }
 
 
@@ -700,11 +989,11 @@ ServerRoom::notifyPostRoundTimerStarted( DraftType& draft, int roundIndex, int t
     mLogger->debug( "sending RoomStageInd (STAGE_RUNNING), size={} round={} postRoundTimerMillis={} ",
             protoSize, roomStageInd->round_info().round(), postRoundTimeRemainingMillis );
 
-    // Send the message to all active client connections.
-    for( ClientConnection* clientConnection : mClientConnectionMap.keys() )
+    // Send the message to all humans in the room.
+    for( HumanPlayer* human : mHumanList )
     {
-        mLogger->debug( "sending to client {}", (std::size_t)clientConnection );
-        clientConnection->sendProtoMsg( msg );
+        mLogger->debug( "sending to human {}", (std::size_t)human );
+        human->sendServerToClientMsg( msg );
     }
 }
 
@@ -727,11 +1016,11 @@ ServerRoom::notifyNewRound( DraftType& draft, int roundIndex )
     mLogger->debug( "sending RoomStageInd (STAGE_RUNNING), size={} round={}",
             protoSize, roomStageInd->round_info().round() );
 
-    // Send the message to all active client connections.
-    for( ClientConnection* clientConnection : mClientConnectionMap.keys() )
+    // Send the message to all humans in the room.
+    for( HumanPlayer* human : mHumanList )
     {
-        mLogger->debug( "sending to client {}", (std::size_t)clientConnection );
-        clientConnection->sendProtoMsg( msg );
+        mLogger->debug( "sending to human {}", (std::size_t)human );
+        human->sendServerToClientMsg( msg );
     }
 }
 
@@ -755,20 +1044,18 @@ ServerRoom::notifyDraftComplete( DraftType& draft )
     int protoSize = msg.ByteSize();
     mLogger->debug( "sending RoomStageInd (STAGE_COMPLETE), size={}", protoSize );
 
-    // Send the message to all active client connections.
-    for( ClientConnection* clientConnection : mClientConnectionMap.keys() )
+    // Send the message to all humans in the room.
+    for( HumanPlayer* human : mHumanList )
     {
-        mLogger->debug( "sending to client {}", (std::size_t)clientConnection );
-        clientConnection->sendProtoMsg( msg );
+        mLogger->debug( "sending to human {}", (std::size_t)human );
+        human->sendServerToClientMsg( msg );
     }
 
-    // Send out all current hash values.
-    // OPTIMIZATION - the message allows for multiple hashes, so this
-    // could easily go out as a single message.
-    for( auto human : mHumanList )
-    {
-        broadcastRoomChairsDeckInfo( *human );
-    }
+    // Send out all current hash values in a single message.
+    broadcastRoomChairsDeckInfo( mHumanList );
+
+    // The draft is still on the call stack, so release it afterward.
+    QTimer::singleShot( 0, this, SLOT(releaseDraft()) );
 }
 
 
@@ -781,11 +1068,11 @@ ServerRoom::notifyDraftError( DraftType& draft )
     int protoSize = msg.ByteSize();
     mLogger->debug( "sending RoomErrorInd, size={}", protoSize );
 
-    // Send the message to all active client connections.
-    for( ClientConnection* clientConnection : mClientConnectionMap.keys() )
+    // Send the message to all humans in the room.
+    for( HumanPlayer* human : mHumanList )
     {
-        mLogger->debug( "sending to client {}", (std::size_t)clientConnection );
-        clientConnection->sendProtoMsg( msg );
+        mLogger->debug( "sending to human {}", (std::size_t)human );
+        human->sendServerToClientMsg( msg );
     }
 
     emit roomError();
@@ -799,6 +1086,18 @@ ServerRoom::getNextAvailablePlayerIndex() const
 }
 
 
+std::vector<std::string>
+ServerRoom::getHumanPlayerNames() const
+{
+    std::vector<std::string> names;
+    for( auto human : mHumanList )
+    {
+        names.push_back( human->getName() );
+    }
+    return names;
+}
+
+
 HumanPlayer*
 ServerRoom::getHumanPlayer( const std::string& name ) const
 {
@@ -7,15 +7,21 @@ QT_BEGIN_NAMESPACE
 class QTimer;
 QT_END_NAMESPACE
 
+#include <QElapsedTimer>
 #include <QList>
 #include <QMap>
+#include <QSet>
 #include <memory>
 
 #include "messages.pb.h"
 #include "Draft.h"
+#include "PayloadStore.h"
 
 #include "Logging.h"
 #include "DraftTypes.h"
+#include "RoomDiagnostics.h"
+#include "RoomLimitChecker.h"
+#include "RoomCpuMeter.h"
 
 class ConnectionServer;
 class ClientConnection;
@@ -44,6 +50,7 @@ public:
                 const std::string&                                  password,
                 const proto::RoomConfig&                            roomConfig,
                 const DraftCardDispenserSharedPtrVector<DraftCard>& dispensers,
+                const RoomLimits&                                   limits,
                 const Logging::Config&                              loggingConfig = Logging::Config(),
                 QObject*                                            parent = 0 );
 
@@ -60,16 +67,24 @@ public:
 
     bool containsConnection( ClientConnection* clientConnection ) const { return mClientConnectionMap.contains( clientConnection ); }
     bool containsHumanPlayer( const std::string& name ) const { return getHumanPlayer( name ) != nullptr; }
+
+    // Names of human players, including departed players who may rejoin.
+    std::vector<std::string> getHumanPlayerNames() const;
     QList<ClientConnection*> getClientConnections() const { return mClientConnectionMap.keys(); }
 
     // Join a user connection to the room.
-    bool join( ClientConnection* clientConnection, const std::string& name, const std::string& password, int& chairIndex );
+    bool join( ClientConnection*            clientConnection,
+               const std::string&           name,
+               const std::string&           password,
+               int&                         chairIndex,
+               const proto::SessionResume*  sessionResume = nullptr );
 
     // Process a client disconnect from the room.
     void leave( ClientConnection* clientConnection );
 
-    // Rejoin a previously-disconnected user to the room.
-    bool rejoin( ClientConnection* clientConnection, const std::string& name );
+    // Rejoin a previously-disconnected user to the room.  If valid session
+    // resume info is supplied only the messages missed are resent.
+    bool rejoin( ClientConnection* clientConnection, const std::string& name, const proto::SessionResume* sessionResume = nullptr );
 
     bool getChairInfo( unsigned int  chairIndex,
                        std::string&  name,           // output
@@ -78,11 +93,23 @@ public:
                        unsigned int& packsQueued,    // output
                        unsigned int& ticksRemaining  /* output */ ) const;
 
+    // Abridged once the draft completes; the payload remains complete.
     const proto::RoomConfig& getRoomConfig() const
     {
         return mRoomConfig;
     }
 
+    // Serialized room configuration and its hash, for sending by reference.
+    const QByteArray& getRoomConfigPayload() const { return mRoomConfigPayload; }
+    const QByteArray& getRoomConfigHash() const { return mRoomConfigHash; }
+
+    // Current phase, resource usage and draft timer lag.
+    RoomDiagnostics getDiagnostics() const;
+
+    // Approximate memory held by the room: configuration, draft,
+    // dispensers and player state.
+    std::size_t getApproximateMemoryBytes() const;
+
 signals:
 
     void playerCountChanged( int playerCount );
@@ -95,26 +122,37 @@ private slots:
     void handleDraftTimerTick();
     void handleHumanReadyUpdate( bool ready );
     void handleHumanDeckUpdate();
+    void handleDeckUpdateTimeout();
+    void handleLimitCheckTimeout();
+    void releaseDraft();
 
 private:  // Methods
 
-    void sendJoinRoomSuccessRspInd( ClientConnection* clientConnection,
-                                    int               roomId,
-                                    bool              rejoin,
-                                    int               chairIndex );
+    void sendJoinRoomSuccessRspInd( ClientConnection*   clientConnection,
+                                    int                 roomId,
+                                    bool                rejoin,
+                                    int                 chairIndex,
+                                    const HumanPlayer*  human,
+                                    bool                resumed );
     void sendJoinRoomFailureRsp( ClientConnection*                    clientConnection,
                                  proto::JoinRoomFailureRsp_ResultType result,
                                  int                                  roomId );
     void broadcastRoomOccupantsInfo();
     void broadcastBoosterDraftState();
-    void sendPublicState( const QList<ClientConnection*> clientConnections );
-    void broadcastRoomChairsDeckInfo( const HumanPlayer& human );
+    void sendPublicState( const QList<HumanPlayer*>& humans );
+    void broadcastRoomChairsDeckInfo( const QList<HumanPlayer*>& humans );
 
     int getNextAvailablePlayerIndex() const;
     HumanPlayer* getHumanPlayer( const std::string& name ) const;
 
     int getPostRoundTimeRemainingMillis() const;
 
+    // Degraded rooms send fewer draft state and deck updates.
+    void setDegraded( bool degraded );
+
+    // Tell humans the room is closing, then close it.
+    void expireRoom();
+
     // --- Draft Observer BEGIN ---
     virtual void notifyPackQueueSizeChanged( DraftType& draft, int chairIndex, int packQueueSize ) override;
     virtual void notifyNewPack( DraftType& draft, int chairIndex, uint32_t packId, const std::vector<DraftCard>& unselectedCards ) override {}
@@ -133,16 +171,28 @@ private:  // Data
 
     const unsigned int       mRoomId;
     const std::string        mPassword;
-    const proto::RoomConfig  mRoomConfig;
-    const DraftCardDispenserSharedPtrVector<DraftCard> mDispensers;
+    proto::RoomConfig        mRoomConfig;
+    const QByteArray         mRoomConfigPayload;
+    const QByteArray         mRoomConfigHash;
+    DraftCardDispenserSharedPtrVector<DraftCard> mDispensers;
     const unsigned int       mChairCount;
     const unsigned int       mBotPlayerCount;
 
     DraftType* mDraftPtr;
     bool       mDraftComplete;
 
+    // Once the draft completes the room keeps only what deckbuilding
+    // needs: occupants, inventories and deck hashes.  The draft and
+    // dispensers are destroyed and the room config is abridged.
+    bool       mDraftReleased;
+
     QTimer *mRoomExpirationTimer;
     QTimer *mDraftTimer;
+    QTimer *mDeckUpdateTimer;
+    QTimer *mLimitCheckTimer;
+
+    // Chairs with deck changes not yet broadcast.
+    QSet<int> mPendingDeckUpdateChairs;
 
     // Lists of specific occupant types.
     QList<BotPlayer*>   mBotList;
@@ -171,6 +221,21 @@ private:  // Data
     bool mPostRoundTimerActive;
     int  mPostRoundTimerTicksRemaining;
 
+    // Draft timer lag: time since the last tick, and how late ticks were.
+    QElapsedTimer mSinceDraftTimerTick;
+    int           mDraftTimerTickLagMillis;
+    int           mDraftTimerMaxTickLagMillis;
+
+    // Resource accounting.  CPU use is checked against the limits as a
+    // share of the time since the previous check.
+    RoomLimitChecker mLimitChecker;
+    RoomCpuMeter     mCpuMeter;
+    QElapsedTimer    mSinceLimitCheck;
+    int64_t          mLimitCheckCpuNanos;
+    unsigned int     mCpuPercent;
+    bool             mDegraded;
+    unsigned int     mDegradedTickCount;
+
     Logging::Config                 mLoggingConfig;
     std::shared_ptr<spdlog::logger> mLogger;
 };
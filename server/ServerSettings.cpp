@@ -3,6 +3,9 @@
 #include <QSettings>
 
 const QString KEY_SERVER_NAME = "servername";
+const QString KEY_ROOM_CPU_LIMIT_PERCENT = "room_cpu_limit_percent";
+const QString KEY_ROOM_MEMORY_LIMIT_MB = "room_memory_limit_mb";
+const QString KEY_ROOM_LIMIT_ACTION = "room_limit_action";
 
 
 static void
@@ -21,6 +24,9 @@ ServerSettings::ServerSettings( QObject* parent )
     mSettings = new QSettings( "thicketserver.ini", QSettings::IniFormat, this );
 
     setValueIfEmpty( mSettings, KEY_SERVER_NAME, "Thicket Server" );
+    setValueIfEmpty( mSettings, KEY_ROOM_CPU_LIMIT_PERCENT, 0 );
+    setValueIfEmpty( mSettings, KEY_ROOM_MEMORY_LIMIT_MB, 0 );
+    setValueIfEmpty( mSettings, KEY_ROOM_LIMIT_ACTION, "log" );
 }
 
 
@@ -29,3 +35,19 @@ ServerSettings::getServerName()
 {
     return mSettings->value( KEY_SERVER_NAME ).toString();
 }
+
+
+RoomLimits
+ServerSettings::getRoomLimits()
+{
+    RoomLimits limits;
+    limits.cpuPercent = mSettings->value( KEY_ROOM_CPU_LIMIT_PERCENT ).toUInt();
+    limits.memoryBytes = mSettings->value( KEY_ROOM_MEMORY_LIMIT_MB ).toULongLong() * 1024 * 1024;
+
+    const QString action = mSettings->value( KEY_ROOM_LIMIT_ACTION ).toString().toLower();
+    if( action == "degrade" )     limits.action = RoomLimits::ACTION_DEGRADE;
+    else if( action == "expire" ) limits.action = RoomLimits::ACTION_EXPIRE;
+    else                          limits.action = RoomLimits::ACTION_LOG;
+
+    return limits;
+}
@@ -3,6 +3,8 @@
 
 #include <QObject>
 
+#include "RoomLimits.h"
+
 QT_BEGIN_NAMESPACE
 class QSettings;
 QT_END_NAMESPACE
@@ -17,6 +19,9 @@ public:
 
     QString getServerName();
 
+    // Per-room resource budgets.
+    RoomLimits getRoomLimits();
+
 private:
 
     QSettings* mSettings;
@@ -0,0 +1,82 @@
+#ifndef SESSIONREPLAYRING_H
+#define SESSIONREPLAYRING_H
+
+#include <deque>
+#include <cstdint>
+#include <QByteArray>
+#include <QList>
+#include "messages.pb.h"
+
+// Bounded ring of the most recent serialized messages sent to a player,
+// each with a session sequence number.  A client that reconnects within
+// a short time can be brought up to date by replaying what it missed
+// rather than with a full room state resync.  Sequence numbers start at
+// 1; 0 means "nothing received".
+class SessionReplayRing
+{
+public:
+
+    explicit SessionReplayRing( std::size_t maxMessages = 256, std::size_t maxBytes = 256 * 1024 )
+      : mMaxMessages( maxMessages ),
+        mMaxBytes( maxBytes ),
+        mNextSequence( 1 ),
+        mBytes( 0 )
+    {}
+
+    // Sequence number the next recorded message will get.
+    uint32_t getNextSequence() const { return mNextSequence; }
+
+    struct Entry
+    {
+        uint32_t                          sequence;
+        QByteArray                        msg;
+        proto::ServerToClientMsg::MsgCase msgCase;
+    };
+
+    // Record a message with the sequence from getNextSequence().
+    void record( const QByteArray& msg, proto::ServerToClientMsg::MsgCase msgCase )
+    {
+        mEntries.push_back( Entry{ mNextSequence++, msg, msgCase } );
+        mBytes += msg.size();
+        while( (mEntries.size() > mMaxMessages) ||
+               ((mBytes > mMaxBytes) && (mEntries.size() > 1)) )
+        {
+            mBytes -= mEntries.front().msg.size();
+            mEntries.pop_front();
+        }
+    }
+
+    // True if every message after lastSequence is still in the ring.
+    bool canReplayAfter( uint32_t lastSequence ) const
+    {
+        if( lastSequence >= mNextSequence ) return false;   // from the future
+        if( lastSequence + 1 == mNextSequence ) return true; // nothing missed
+        return !mEntries.empty() && (mEntries.front().sequence <= lastSequence + 1);
+    }
+
+    // Approximate memory held by the recorded messages.
+    std::size_t getApproximateMemoryBytes() const { return mBytes + mEntries.size() * sizeof( Entry ); }
+
+    // Messages after lastSequence, oldest first.  Only meaningful if
+    // canReplayAfter() is true.
+    QList<Entry> getMessagesAfter( uint32_t lastSequence ) const
+    {
+        QList<Entry> entries;
+        for( const Entry& entry : mEntries )
+        {
+            if( entry.sequence > lastSequence ) entries.append( entry );
+        }
+        return entries;
+    }
+
+private:
+
+    const std::size_t mMaxMessages;
+    const std::size_t mMaxBytes;
+
+    std::deque<Entry> mEntries;
+    uint32_t          mNextSequence;
+    std::size_t       mBytes;
+};
+
+#endif
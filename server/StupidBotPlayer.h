@@ -39,7 +39,7 @@ public:
             return;
         }
 
-        GridHelper gh;
+        const GridHelper& gh = draft.getGridHelper();
         if( cardStates.size() < gh.getIndexCount() )
         {
             mLogger->warn( "less than {} cards ({}) in grid pack!", gh.getIndexCount(), cardStates.size() );
@@ -48,17 +48,16 @@ public:
 
         if( getChairIndex() == activeChairIndex )
         {
-            // Build set of unavailable indices.
-            GridHelper::IndexSet unavailableIndices;
+            // Build mask of unavailable indices.
+            GridHelper::IndexMask unavailableMask = 0;
             for( std::size_t i = 0; i < cardStates.size(); ++i )
             {
-                if( cardStates[i].getSelectedChairIndex() != -1 ) unavailableIndices.insert( i );
+                if( cardStates[i].getSelectedChairIndex() != -1 ) unavailableMask |= GridHelper::IndexMask( 1 ) << i;
             }
 
             // Get available selections.
-            GridHelper gridHelper;
-            auto availableSelectionsMap = gridHelper.getAvailableSelectionsMap( unavailableIndices );
-            if( availableSelectionsMap.empty() )
+            const std::vector<unsigned int> availableSlices = gh.getAvailableSlices( unavailableMask );
+            if( availableSlices.empty() )
             {
                 mLogger->error( "no available selections in grid pack!" );
                 return;
@@ -66,12 +65,10 @@ public:
 
             // Randomly pick a selection.
             SimpleRandGen rng;
-            const int adv = rng.generateInRange( 0, availableSelectionsMap.size() - 1 );
-            auto iter = availableSelectionsMap.begin();
-            std::advance( iter, adv );
+            const unsigned int slice = availableSlices[rng.generateInRange( 0, availableSlices.size() - 1 )];
 
-            mLogger->debug( "selecting slice {}", iter->second );
-            std::vector<int> indices( iter->first.begin(), iter->first.end() );
+            mLogger->debug( "selecting slice {}", slice );
+            std::vector<int> indices = GridHelper::getIndices( gh.getSliceMask( slice ) & ~unavailableMask );
             bool result = draft.makeIndexedCardSelection( getChairIndex(), packId, indices );
 
             if( !result )
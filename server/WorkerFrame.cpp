@@ -0,0 +1,43 @@
+#include "WorkerFrame.h"
+
+#include <QtEndian>
+
+const int WorkerFrame::HEADER_BYTES;
+const quint32 WorkerFrame::MAX_LENGTH;
+
+
+QByteArray
+WorkerFrame::encodeHeader( quint32 connId, quint32 tag, int payloadSize )
+{
+    QByteArray header;
+    header.resize( HEADER_BYTES );
+    uchar* data = reinterpret_cast<uchar*>( header.data() );
+    qToBigEndian<quint32>( payloadSize + 8, data );
+    qToBigEndian<quint32>( connId, data + 4 );
+    qToBigEndian<quint32>( tag, data + 8 );
+    return header;
+}
+
+
+WorkerFrame::DecodeResult
+WorkerFrame::decode( const QByteArray& buffer,
+                     int&              offset,
+                     quint32&          connId,
+                     quint32&          tag,
+                     int&              payloadOffset,
+                     int&              payloadSize )
+{
+    if( buffer.size() - offset < HEADER_BYTES ) return DECODE_INCOMPLETE;
+
+    const uchar* header = reinterpret_cast<const uchar*>( buffer.constData() + offset );
+    const quint32 length = qFromBigEndian<quint32>( header );
+    if( (length < 8) || (length > MAX_LENGTH) ) return DECODE_INVALID;
+    if( static_cast<quint32>( buffer.size() - offset - 4 ) < length ) return DECODE_INCOMPLETE;
+
+    connId = qFromBigEndian<quint32>( header + 4 );
+    tag = qFromBigEndian<quint32>( header + 8 );
+    payloadOffset = offset + HEADER_BYTES;
+    payloadSize = length - 8;
+    offset += 4 + length;
+    return DECODE_OK;
+}
@@ -0,0 +1,42 @@
+#ifndef WORKERFRAME_H
+#define WORKERFRAME_H
+
+#include <QByteArray>
+
+// Encoding and decoding of the frames carried by a WorkerLink.  Each
+// frame is
+//
+//     [length:4][connection ID:4][tag:4][payload:length-8]
+//
+// in network byte order.
+class WorkerFrame
+{
+public:
+
+    // Header is length, connection ID and tag.
+    static const int HEADER_BYTES = 12;
+
+    // Frames larger than this indicate a corrupt stream.
+    static const quint32 MAX_LENGTH = 64 * 1024 * 1024;
+
+    enum DecodeResult
+    {
+        DECODE_OK,
+        DECODE_INCOMPLETE,
+        DECODE_INVALID
+    };
+
+    static QByteArray encodeHeader( quint32 connId, quint32 tag, int payloadSize );
+
+    // Decode the frame starting at 'offset' in 'buffer'.  On DECODE_OK the
+    // frame fields are filled in and 'offset' is advanced past the frame;
+    // otherwise nothing is changed.
+    static DecodeResult decode( const QByteArray& buffer,
+                                int&              offset,
+                                quint32&          connId,
+                                quint32&          tag,
+                                int&              payloadOffset,
+                                int&              payloadSize );
+};
+
+#endif
@@ -0,0 +1,15 @@
+#include "WorkerHello.h"
+
+
+WorkerHello::Result
+WorkerHello::check( unsigned int       workerIndex,
+                    const QString&     secret,
+                    const QStringList& workerSecrets )
+{
+    if( workerIndex >= static_cast<unsigned int>( workerSecrets.size() ) ) return RESULT_UNKNOWN_WORKER;
+
+    const QString& expectedSecret = workerSecrets[workerIndex];
+    if( expectedSecret.isEmpty() || (secret != expectedSecret) ) return RESULT_WRONG_SECRET;
+
+    return RESULT_OK;
+}
@@ -0,0 +1,28 @@
+#ifndef WORKERHELLO_H
+#define WORKERHELLO_H
+
+#include <QString>
+#include <QStringList>
+
+// Decides whether a newly connected link may claim a worker slot.  A
+// worker must name an existing slot and present the secret that slot's
+// process was spawned with.
+class WorkerHello
+{
+public:
+
+    enum Result
+    {
+        RESULT_OK,
+        RESULT_UNKNOWN_WORKER,
+        RESULT_WRONG_SECRET
+    };
+
+    // 'workerSecrets' holds the current secret of each slot, empty for a
+    // slot with no process.
+    static Result check( unsigned int       workerIndex,
+                         const QString&     secret,
+                         const QStringList& workerSecrets );
+};
+
+#endif
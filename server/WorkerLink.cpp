@@ -0,0 +1,128 @@
+#include "WorkerLink.h"
+
+#include <QLocalSocket>
+
+#include "WorkerFrame.h"
+
+const quint32 WorkerLink::WORKER_MSG_CONN_ID;
+
+
+WorkerLink::WorkerLink( QLocalSocket*          socket,
+                        const Logging::Config& loggingConfig,
+                        QObject*               parent )
+  : QObject( parent ),
+    mSocket( socket ),
+    mLogger( loggingConfig.createLogger() )
+{
+    mSocket->setParent( this );
+    connect( mSocket, &QLocalSocket::readyRead, this, &WorkerLink::handleReadyRead );
+    connect( mSocket, &QLocalSocket::disconnected, this, &WorkerLink::disconnected );
+
+    // Data may have arrived before the link was set up.
+    if( mSocket->bytesAvailable() > 0 ) handleReadyRead();
+}
+
+
+bool
+WorkerLink::isConnected() const
+{
+    return mSocket->state() == QLocalSocket::ConnectedState;
+}
+
+
+bool
+WorkerLink::sendWorkerMsg( const proto::WorkerMsg& msg )
+{
+    const int size = msg.ByteSize();
+    QByteArray msgByteArray;
+    msgByteArray.resize( size );
+    msg.SerializeToArray( msgByteArray.data(), size );
+    return sendFrame( WORKER_MSG_CONN_ID, msg.msg_case(), msgByteArray.constData(), size );
+}
+
+
+bool
+WorkerLink::sendRelayedMsg( quint32 connId, const QByteArray& msg, quint32 tag )
+{
+    if( connId == WORKER_MSG_CONN_ID )
+    {
+        mLogger->error( "relayed message with reserved connection ID" );
+        return false;
+    }
+    return sendFrame( connId, tag, msg.constData(), msg.size() );
+}
+
+
+void
+WorkerLink::abort()
+{
+    mSocket->abort();
+}
+
+
+bool
+WorkerLink::sendFrame( quint32 connId, quint32 tag, const char* data, int size )
+{
+    if( !isConnected() )
+    {
+        mLogger->debug( "dropping frame - not connected" );
+        return false;
+    }
+
+    const QByteArray header = WorkerFrame::encodeHeader( connId, tag, size );
+
+    // The socket buffers internally, so both writes go out together.
+    if( (mSocket->write( header ) != header.size()) ||
+        (mSocket->write( data, size ) != size) )
+    {
+        mLogger->error( "failed writing frame: {}", mSocket->errorString() );
+        mSocket->abort();
+        return false;
+    }
+    return true;
+}
+
+
+void
+WorkerLink::handleReadyRead()
+{
+    mRxBuffer.append( mSocket->readAll() );
+
+    // Walk all complete frames, then drop them from the buffer at once.
+    int offset = 0;
+    quint32 connId;
+    quint32 tag;
+    int payloadOffset;
+    int payloadSize;
+    for( ;; )
+    {
+        const WorkerFrame::DecodeResult result =
+                WorkerFrame::decode( mRxBuffer, offset, connId, tag, payloadOffset, payloadSize );
+        if( result == WorkerFrame::DECODE_INCOMPLETE ) break;
+        if( result == WorkerFrame::DECODE_INVALID )
+        {
+            mLogger->error( "invalid frame, aborting link" );
+            mRxBuffer.clear();
+            mSocket->abort();
+            return;
+        }
+
+        const char* payload = mRxBuffer.constData() + payloadOffset;
+        if( connId == WORKER_MSG_CONN_ID )
+        {
+            proto::WorkerMsg msg;
+            if( !msg.ParseFromArray( payload, payloadSize ) )
+            {
+                mLogger->warn( "failed to parse worker msg (tag {})", tag );
+                continue;
+            }
+            emit workerMsgReceived( msg );
+        }
+        else
+        {
+            emit relayedMsgReceived( connId, QByteArray( payload, payloadSize ), tag );
+        }
+    }
+
+    if( offset > 0 ) mRxBuffer.remove( 0, offset );
+}
@@ -0,0 +1,63 @@
+#ifndef WORKERLINK_H
+#define WORKERLINK_H
+
+#include <QObject>
+#include <QByteArray>
+
+QT_BEGIN_NAMESPACE
+class QLocalSocket;
+QT_END_NAMESPACE
+
+#include "WorkerMessages.pb.h"
+#include "Logging.h"
+
+// Framed link between the lobby and a room worker process over a local
+// (UNIX-domain) socket, using the frame format in WorkerFrame.h.
+// Connection ID 0 carries a serialized WorkerMsg.  Any other ID carries a
+// client message relayed as-is: a serialized ClientToServerMsg toward the
+// worker, or a serialized ServerToClientMsg with its message case as the
+// tag toward the lobby.  The tag's top bit
+// marks a message carrying a session sequence, which the lobby must not
+// reorder.  Relayed messages are never parsed on the way through.
+class WorkerLink : public QObject
+{
+    Q_OBJECT
+
+public:
+
+    static const quint32 WORKER_MSG_CONN_ID = 0;
+    static const quint32 RELAY_TAG_SEQUENCED = 0x80000000;
+
+    // Takes ownership of the socket.
+    WorkerLink( QLocalSocket*          socket,
+                const Logging::Config& loggingConfig = Logging::Config(),
+                QObject*               parent = 0 );
+
+    bool isConnected() const;
+
+    bool sendWorkerMsg( const proto::WorkerMsg& msg );
+    bool sendRelayedMsg( quint32 connId, const QByteArray& msg, quint32 tag = 0 );
+
+    void abort();
+
+signals:
+
+    void workerMsgReceived( const proto::WorkerMsg& msg );
+    void relayedMsgReceived( quint32 connId, const QByteArray& msg, quint32 tag );
+    void disconnected();
+
+private slots:
+
+    void handleReadyRead();
+
+private:
+
+    bool sendFrame( quint32 connId, quint32 tag, const char* data, int size );
+
+    QLocalSocket* mSocket;
+    QByteArray    mRxBuffer;
+
+    std::shared_ptr<spdlog::logger> mLogger;
+};
+
+#endif
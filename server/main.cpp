@@ -5,6 +5,8 @@
 #include <stdlib.h>
 
 #include "Server.h"
+#include "RoomWorker.h"
+#include "RoomWorkerPool.h"
 #include "ServerSettings.h"
 #include "ClientNotices.h"
 #include "AdminShell.h"
@@ -31,6 +33,9 @@ int main(int argc, char *argv[])
     loggingConfig.setStdoutLogging( true );
     loggingConfig.setLevel( spdlog::level::info );
 
+    // Format and write log output on a background thread.
+    loggingConfig.setAsyncLogging( 8192 );
+
     gLogger = loggingConfig.createLogger();
 
     //
@@ -64,9 +69,40 @@ int main(int argc, char *argv[])
     const QCommandLineOption logRotateFileCountOption(
             QStringList() << "logrotate-file-count", "Number of files to rotate (default 2).", "file-count", "2" );
     parser.addOption( logRotateFileCountOption );
+    const QCommandLineOption workersOption(
+            QStringList() << "workers", "Host rooms in <count> worker processes.  (default: 0, rooms hosted in-process)", "count", "0" );
+    parser.addOption( workersOption );
+    const QCommandLineOption adminOption(
+            QStringList() << "admin", "Run <command> in the admin shell of the server running on this host, print its JSON result and exit.  May be repeated.", "command" );
+    parser.addOption( adminOption );
+
+    // Internal options used when the server starts its own room workers.
+    QCommandLineOption workerOption( QStringList() << "worker", "Run as a room worker for a lobby.", "server-name" );
+    workerOption.setFlags( QCommandLineOption::HiddenFromHelp );
+    parser.addOption( workerOption );
+    QCommandLineOption workerIndexOption( QStringList() << "worker-index", "Room worker index.", "index", "0" );
+    workerIndexOption.setFlags( QCommandLineOption::HiddenFromHelp );
+    parser.addOption( workerIndexOption );
+    QCommandLineOption workerSecretOption( QStringList() << "worker-secret", "Room worker secret.", "secret" );
+    workerSecretOption.setFlags( QCommandLineOption::HiddenFromHelp );
+    parser.addOption( workerSecretOption );
 
     parser.process( app );
 
+    // Script mode against an already running server.
+    if( parser.isSet( adminOption ) )
+    {
+        return AdminShell::runCommands( parser.values( adminOption ) );
+    }
+
+    const bool workerMode = parser.isSet( workerOption );
+    const unsigned int workerIndex = parser.value( workerIndexOption ).toUInt();
+    if( workerMode )
+    {
+        loggingConfig.setName( "worker-" + std::to_string( workerIndex ) );
+        gLogger = loggingConfig.createLogger();
+    }
+
     // Parse logging-related options and update the logger first so
     // properly-configured logging is in effect ASAP.
     {
@@ -86,6 +122,13 @@ int main(int argc, char *argv[])
             gLogger->debug( "command-line args: logfile={}", logfile );
             if( !logfile.isEmpty() )
             {
+                // Workers each write their own file alongside the lobby's.
+                if( workerMode )
+                {
+                    int index = logfile.lastIndexOf( '.' );
+                    logfile.insert( (index > 0) ? index : logfile.size(), "-worker" + QString::number( workerIndex ) );
+                }
+
                 if( parser.isSet( logRotateOption ) )
                 {
                     bool convertResult = true;
@@ -139,6 +182,9 @@ int main(int argc, char *argv[])
     bool argsOk = true;
     unsigned int port = parser.value( portOption ).toUInt( &convertResult );
     argsOk &= convertResult;
+    gLogger->debug( "command-line args: workers={}", parser.value( workersOption ) );
+    unsigned int workerCount = parser.value( workersOption ).toUInt( &convertResult );
+    argsOk &= convertResult;
     if( !argsOk )
     {
         gLogger->critical( "invalid argument" );
@@ -171,6 +217,7 @@ int main(int argc, char *argv[])
     // is used later but ensures cleanup on error.
     auto allSetsData = new MtgJsonAllSetsData();
     auto allSetsDataSharedPtr = std::shared_ptr<const AllSetsData>( allSetsData );
+    auto mtgJsonAllSetsDataSharedPtr = std::shared_ptr<const MtgJsonAllSetsData>( allSetsDataSharedPtr, allSetsData );
     bool parseResult = allSetsData->parse( allSetsDataFile );
     fclose( allSetsDataFile );
     if( !parseResult )
@@ -179,6 +226,18 @@ int main(int argc, char *argv[])
         return ERROR_CODE_DATAERR;
     }
 
+    //
+    // As a room worker, host rooms for the lobby and nothing else.
+    //
+    if( workerMode )
+    {
+        RoomWorker* worker = new RoomWorker( parser.value( workerOption ), workerIndex,
+                parser.value( workerSecretOption ), allSetsDataSharedPtr, loggingConfig, &app );
+        QObject::connect( worker, SIGNAL(finished()), &app, SLOT(quit()) );
+        QTimer::singleShot( 0, worker, SLOT(start()) );
+        return app.exec();
+    }
+
     //
     // Instantiate server settings.
     //
@@ -202,6 +261,32 @@ int main(int argc, char *argv[])
     // This will cause the application to exit when the server signals finished.    
     QObject::connect(server, SIGNAL(finished()), &app, SLOT(quit()));
 
+    // Optionally spawn room workers.  Workers inherit the logging options.
+    if( workerCount > 0 )
+    {
+        QStringList workerArgs;
+        if( parser.isSet( verboseOption ) ) workerArgs << "--verbose";
+        if( parser.isSet( logfileOption ) )
+        {
+            workerArgs << "--logfile" << parser.value( logfileOption );
+            if( parser.isSet( logRotateOption ) )
+            {
+                workerArgs << "--logrotate"
+                           << "--logrotate-size-limit" << parser.value( logRotateSizeLimitOption )
+                           << "--logrotate-file-count" << parser.value( logRotateFileCountOption );
+            }
+        }
+
+        RoomWorkerPool* workerPool = new RoomWorkerPool( workerCount, workerArgs,
+                loggingConfig.createChildConfig( "workerpool" ), &app );
+        if( !workerPool->start() )
+        {
+            return EXIT_FAILURE;
+        }
+        server->setWorkerPool( workerPool );
+        gLogger->info( "Hosting rooms in {} worker processes", workerCount );
+    }
+
     // This will start the server from the application event loop.
     QTimer::singleShot( 0, server, SLOT(start()) );
 
@@ -209,7 +294,8 @@ int main(int argc, char *argv[])
     // Create and start the admin shell.
     //
 
-    AdminShell* adminShell = new AdminShell( clientNotices, loggingConfig.createChildConfig( "adminshell" ), &app );
+    AdminShell* adminShell = new AdminShell( clientNotices, server, mtgJsonAllSetsDataSharedPtr,
+            loggingConfig.createChildConfig( "adminshell" ), &app );
 
     // This will start the admin shell from the application event loop.
     QTimer::singleShot( 0, adminShell, SLOT(start()) );
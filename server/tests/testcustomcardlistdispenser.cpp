@@ -53,6 +53,7 @@ CATCH_TEST_CASE( "CustomCardListDispenser", "[customcardlistdispenser]" )
         CustomCardListDispenser disp( dispenserSpec, customCardListSpec, loggingConfig );
         CATCH_REQUIRE( disp.isValid() );
         CATCH_REQUIRE( disp.getPoolSize() == 6 );
+        CATCH_REQUIRE( disp.getApproximateMemoryBytes() >= sizeof( disp ) + 6 * sizeof( DraftCard ) );
 
         std::vector<DraftCard> cardsDispensed;
         for( int i = 0; i < 60; ++i )
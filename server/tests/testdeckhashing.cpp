@@ -113,3 +113,54 @@ CATCH_TEST_CASE( "DeckHashing", "[deckhashing]" )
         CATCH_REQUIRE( hash == "g233t401" );
     }
 }
+
+
+CATCH_TEST_CASE( "DeckHashing - incremental", "[deckhashing]" )
+{
+    CockatriceDeckHash deckHash;
+    CATCH_REQUIRE( deckHash.getHash() == "r8sq7riu" );
+
+    CATCH_SECTION( "Matches full computation" )
+    {
+        deckHash.adjustCard( "Fireball", false );
+        deckHash.adjustCard( "Chainer's Edict", false );
+        deckHash.adjustCard( "Disenchant", false );
+        CATCH_REQUIRE( deckHash.getHash() == "9ed4d2v3" );
+
+        deckHash.adjustCard( "Fireball", true );
+        deckHash.adjustCard( "Chainer's Edict", true );
+        deckHash.adjustCard( "Disenchant", true );
+        CATCH_REQUIRE( deckHash.getHash() == "fi8ie39c" );
+    }
+
+    CATCH_SECTION( "Moves back and forth" )
+    {
+        deckHash.adjustCard( "Fire/Ice", false );
+        deckHash.adjustCard( "Fire // Ice", false );
+        CATCH_REQUIRE( deckHash.getHash() != "iq0uqup7" );
+        deckHash.adjustCard( "Fire//Ice", false );
+        deckHash.adjustCard( "Fire / Ice", false );
+        CATCH_REQUIRE( deckHash.getHash() == "iq0uqup7" );
+
+        // Move a copy to the sideboard and back.
+        deckHash.adjustCard( "Fire/Ice", false, -1 );
+        deckHash.adjustCard( "Fire/Ice", true );
+        CATCH_REQUIRE( deckHash.getHash() != "iq0uqup7" );
+        deckHash.adjustCard( "Fire/Ice", true, -1 );
+        deckHash.adjustCard( "Fire/Ice", false );
+        CATCH_REQUIRE( deckHash.getHash() == "iq0uqup7" );
+    }
+
+    CATCH_SECTION( "Basic lands" )
+    {
+        for( auto basic : gBasicLandTypeArray )
+        {
+            deckHash.adjustBasicLand( basic, false, 2 );
+            deckHash.adjustBasicLand( basic, false, -1 );
+        }
+        CATCH_REQUIRE( deckHash.getHash() == "lhdodeb5" );
+
+        deckHash.clear();
+        CATCH_REQUIRE( deckHash.getHash() == "r8sq7riu" );
+    }
+}
@@ -0,0 +1,85 @@
+#include "catch.hpp"
+#include "OutboundMsgQueue.h"
+
+#include <vector>
+
+typedef proto::ServerToClientMsg Msg;
+
+static std::vector<QByteArray> popAll( OutboundMsgQueue& queue )
+{
+    std::vector<QByteArray> msgs;
+    while( !queue.empty() ) msgs.push_back( queue.pop() );
+    return msgs;
+}
+
+
+CATCH_TEST_CASE( "OutboundMsgQueue - priority", "[outboundmsgqueue]" )
+{
+    OutboundMsgQueue queue;
+
+    // Unsequenced messages are overtaken by pick-critical ones.
+    queue.push( "rooms", Msg::kRoomsInfoInd, false );
+    queue.push( "chat", Msg::kChatMessageDeliveryInd, false );
+    queue.push( "pack", Msg::kPlayerCurrentPackInd, true );
+    CATCH_REQUIRE( queue.getBytes() == 13 );
+    CATCH_REQUIRE( popAll( queue ) == std::vector<QByteArray>( { "pack", "rooms", "chat" } ) );
+    CATCH_REQUIRE( queue.getBytes() == 0 );
+
+    // Barriers are never overtaken.
+    queue.push( "stage", Msg::kRoomStageInd, false );
+    queue.push( "pack", Msg::kPlayerCurrentPackInd, false );
+    CATCH_REQUIRE( popAll( queue ) == std::vector<QByteArray>( { "stage", "pack" } ) );
+
+    // Once the barrier is gone priority applies again.
+    queue.push( "stage", Msg::kRoomStageInd, false );
+    CATCH_REQUIRE( queue.pop() == "stage" );
+    queue.push( "chat", Msg::kChatMessageDeliveryInd, false );
+    queue.push( "rsp", Msg::kPlayerNamedCardSelectionRsp, false );
+    CATCH_REQUIRE( popAll( queue ) == std::vector<QByteArray>( { "rsp", "chat" } ) );
+}
+
+
+CATCH_TEST_CASE( "OutboundMsgQueue - sequenced messages keep their order", "[outboundmsgqueue]" )
+{
+    OutboundMsgQueue queue;
+
+    // A pick-critical message must not overtake an earlier sequenced
+    // message, or a client resuming after its sequence would miss it.
+    queue.push( "chat", Msg::kChatMessageDeliveryInd, false );
+    queue.push( "ack1", Msg::kPlayerInventoryUpdateAckInd, true );
+    queue.push( "rsp2", Msg::kPlayerNamedCardSelectionRsp, true );
+    queue.push( "pack3", Msg::kPlayerCurrentPackInd, true );
+    CATCH_REQUIRE( popAll( queue ) == std::vector<QByteArray>( { "chat", "ack1", "rsp2", "pack3" } ) );
+
+    // Sequenced priority messages already ahead stay ahead of later ones.
+    queue.push( "chat", Msg::kChatMessageDeliveryInd, false );
+    queue.push( "pack1", Msg::kPlayerCurrentPackInd, true );
+    queue.push( "ack2", Msg::kPlayerInventoryUpdateAckInd, true );
+    queue.push( "rsp3", Msg::kPlayerNamedCardSelectionRsp, true );
+    CATCH_REQUIRE( popAll( queue ) == std::vector<QByteArray>( { "pack1", "chat", "ack2", "rsp3" } ) );
+}
+
+
+CATCH_TEST_CASE( "OutboundMsgQueue - snapshots", "[outboundmsgqueue]" )
+{
+    OutboundMsgQueue queue;
+
+    queue.push( "state1", Msg::kBoosterDraftStateInd, true );
+    queue.push( "ack2", Msg::kPlayerInventoryUpdateAckInd, true );
+    queue.push( "state3", Msg::kBoosterDraftStateInd, true );
+    CATCH_REQUIRE( queue.getBytes() == 10 );
+    CATCH_REQUIRE( popAll( queue ) == std::vector<QByteArray>( { "ack2", "state3" } ) );
+
+    // A replaced snapshot no longer holds back priority messages.
+    queue.push( "state1", Msg::kBoosterDraftStateInd, true );
+    queue.push( "state2", Msg::kBoosterDraftStateInd, true );
+    CATCH_REQUIRE( queue.pop() == "state2" );
+    queue.push( "chat", Msg::kChatMessageDeliveryInd, false );
+    queue.push( "pack3", Msg::kPlayerCurrentPackInd, true );
+    CATCH_REQUIRE( popAll( queue ) == std::vector<QByteArray>( { "pack3", "chat" } ) );
+
+    queue.push( "state", Msg::kBoosterDraftStateInd, false );
+    queue.clear();
+    CATCH_REQUIRE( queue.empty() );
+    CATCH_REQUIRE( queue.getBytes() == 0 );
+}
@@ -0,0 +1,65 @@
+#include "catch.hpp"
+#include "RoomLimitChecker.h"
+
+static RoomLimits
+makeLimits( RoomLimits::Action action )
+{
+    RoomLimits limits;
+    limits.cpuPercent = 50;
+    limits.memoryBytes = 1000;
+    limits.action = action;
+    return limits;
+}
+
+
+CATCH_TEST_CASE( "Room limits are unlimited by default", "[roomlimits]" )
+{
+    RoomLimitChecker checker( RoomLimits{} );
+    CATCH_CHECK( checker.check( 100, 1000000 ) == RoomLimitChecker::STEP_NONE );
+    CATCH_CHECK_FALSE( checker.isOverBudget() );
+}
+
+
+CATCH_TEST_CASE( "Room limits degrade and recover", "[roomlimits]" )
+{
+    RoomLimitChecker checker( makeLimits( RoomLimits::ACTION_DEGRADE ) );
+
+    CATCH_CHECK( checker.check( 50, 1000 ) == RoomLimitChecker::STEP_NONE );
+
+    // Over on CPU, staying over only acts once.
+    CATCH_CHECK( checker.check( 51, 0 ) == RoomLimitChecker::STEP_DEGRADE );
+    CATCH_CHECK( checker.isOverBudget() );
+    CATCH_CHECK( checker.check( 90, 0 ) == RoomLimitChecker::STEP_NONE );
+
+    // Still over while memory is over.
+    CATCH_CHECK( checker.check( 0, 1001 ) == RoomLimitChecker::STEP_NONE );
+
+    CATCH_CHECK( checker.check( 0, 0 ) == RoomLimitChecker::STEP_RECOVER );
+    CATCH_CHECK_FALSE( checker.isOverBudget() );
+    CATCH_CHECK( checker.check( 0, 0 ) == RoomLimitChecker::STEP_NONE );
+
+    // Degrades again on the next excursion.
+    CATCH_CHECK( checker.check( 0, 2000 ) == RoomLimitChecker::STEP_DEGRADE );
+}
+
+
+CATCH_TEST_CASE( "Room limits expire once", "[roomlimits]" )
+{
+    RoomLimitChecker checker( makeLimits( RoomLimits::ACTION_EXPIRE ) );
+
+    CATCH_CHECK( checker.check( 10, 10 ) == RoomLimitChecker::STEP_NONE );
+    CATCH_CHECK( checker.check( 10, 5000 ) == RoomLimitChecker::STEP_EXPIRE );
+
+    // An expired room never recovers or expires again.
+    CATCH_CHECK( checker.check( 0, 0 ) == RoomLimitChecker::STEP_NONE );
+    CATCH_CHECK( checker.check( 100, 5000 ) == RoomLimitChecker::STEP_NONE );
+}
+
+
+CATCH_TEST_CASE( "Room limits log only", "[roomlimits]" )
+{
+    RoomLimitChecker checker( makeLimits( RoomLimits::ACTION_LOG ) );
+
+    CATCH_CHECK( checker.check( 60, 0 ) == RoomLimitChecker::STEP_LOG );
+    CATCH_CHECK( checker.check( 0, 0 ) == RoomLimitChecker::STEP_RECOVER );
+}
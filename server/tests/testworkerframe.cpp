@@ -0,0 +1,82 @@
+#include "catch.hpp"
+#include "WorkerFrame.h"
+
+static QByteArray
+makeFrame( quint32 connId, quint32 tag, const QByteArray& payload )
+{
+    QByteArray frame = WorkerFrame::encodeHeader( connId, tag, payload.size() );
+    frame.append( payload );
+    return frame;
+}
+
+
+CATCH_TEST_CASE( "Worker frames round trip", "[workerframe]" )
+{
+    QByteArray buffer = makeFrame( 0, 3, QByteArray( "hello" ) );
+    buffer.append( makeFrame( 7, 0x80000012, QByteArray() ) );
+
+    int offset = 0;
+    quint32 connId;
+    quint32 tag;
+    int payloadOffset;
+    int payloadSize;
+
+    CATCH_REQUIRE( WorkerFrame::decode( buffer, offset, connId, tag, payloadOffset, payloadSize ) == WorkerFrame::DECODE_OK );
+    CATCH_CHECK( connId == 0 );
+    CATCH_CHECK( tag == 3 );
+    CATCH_CHECK( payloadOffset == WorkerFrame::HEADER_BYTES );
+    CATCH_CHECK( QByteArray( buffer.constData() + payloadOffset, payloadSize ) == QByteArray( "hello" ) );
+    CATCH_CHECK( offset == WorkerFrame::HEADER_BYTES + 5 );
+
+    CATCH_REQUIRE( WorkerFrame::decode( buffer, offset, connId, tag, payloadOffset, payloadSize ) == WorkerFrame::DECODE_OK );
+    CATCH_CHECK( connId == 7 );
+    CATCH_CHECK( tag == 0x80000012 );
+    CATCH_CHECK( payloadSize == 0 );
+    CATCH_CHECK( offset == buffer.size() );
+
+    CATCH_CHECK( WorkerFrame::decode( buffer, offset, connId, tag, payloadOffset, payloadSize ) == WorkerFrame::DECODE_INCOMPLETE );
+}
+
+
+CATCH_TEST_CASE( "Worker frames wait for complete data", "[workerframe]" )
+{
+    const QByteArray frame = makeFrame( 2, 0, QByteArray( "payload" ) );
+
+    int offset = 0;
+    quint32 connId;
+    quint32 tag;
+    int payloadOffset;
+    int payloadSize;
+
+    // Partial header.
+    QByteArray buffer( frame.constData(), WorkerFrame::HEADER_BYTES - 1 );
+    CATCH_CHECK( WorkerFrame::decode( buffer, offset, connId, tag, payloadOffset, payloadSize ) == WorkerFrame::DECODE_INCOMPLETE );
+
+    // Full header, partial payload.
+    buffer = QByteArray( frame.constData(), frame.size() - 1 );
+    CATCH_CHECK( WorkerFrame::decode( buffer, offset, connId, tag, payloadOffset, payloadSize ) == WorkerFrame::DECODE_INCOMPLETE );
+    CATCH_CHECK( offset == 0 );
+
+    buffer = frame;
+    CATCH_CHECK( WorkerFrame::decode( buffer, offset, connId, tag, payloadOffset, payloadSize ) == WorkerFrame::DECODE_OK );
+    CATCH_CHECK( payloadSize == 7 );
+}
+
+
+CATCH_TEST_CASE( "Worker frames reject invalid lengths", "[workerframe]" )
+{
+    int offset = 0;
+    quint32 connId;
+    quint32 tag;
+    int payloadOffset;
+    int payloadSize;
+
+    // Length too short to hold the connection ID and tag.
+    QByteArray buffer = WorkerFrame::encodeHeader( 1, 0, -1 );
+    CATCH_CHECK( WorkerFrame::decode( buffer, offset, connId, tag, payloadOffset, payloadSize ) == WorkerFrame::DECODE_INVALID );
+
+    // Length beyond the maximum, rejected before the payload arrives.
+    buffer = WorkerFrame::encodeHeader( 1, 0, WorkerFrame::MAX_LENGTH );
+    CATCH_CHECK( WorkerFrame::decode( buffer, offset, connId, tag, payloadOffset, payloadSize ) == WorkerFrame::DECODE_INVALID );
+    CATCH_CHECK( offset == 0 );
+}
@@ -0,0 +1,31 @@
+#include "catch.hpp"
+#include "WorkerHello.h"
+
+
+CATCH_TEST_CASE( "Worker hello checks", "[workerhello]" )
+{
+    const QStringList secrets = { "aaaa", "bbbb", QString() };
+
+    CATCH_SECTION( "Matching secret" )
+    {
+        CATCH_CHECK( WorkerHello::check( 0, "aaaa", secrets ) == WorkerHello::RESULT_OK );
+        CATCH_CHECK( WorkerHello::check( 1, "bbbb", secrets ) == WorkerHello::RESULT_OK );
+    }
+
+    CATCH_SECTION( "Unknown worker" )
+    {
+        CATCH_CHECK( WorkerHello::check( 3, "aaaa", secrets ) == WorkerHello::RESULT_UNKNOWN_WORKER );
+        CATCH_CHECK( WorkerHello::check( 0, "aaaa", QStringList() ) == WorkerHello::RESULT_UNKNOWN_WORKER );
+    }
+
+    CATCH_SECTION( "Wrong secret" )
+    {
+        CATCH_CHECK( WorkerHello::check( 0, "bbbb", secrets ) == WorkerHello::RESULT_WRONG_SECRET );
+        CATCH_CHECK( WorkerHello::check( 0, "", secrets ) == WorkerHello::RESULT_WRONG_SECRET );
+    }
+
+    CATCH_SECTION( "Slot without a process" )
+    {
+        CATCH_CHECK( WorkerHello::check( 2, "", secrets ) == WorkerHello::RESULT_WRONG_SECRET );
+    }
+}
@@ -19,6 +19,17 @@ config.client_update.site_url       = "http://github.com/mildmongrel/thicket/rel
 config.mtgjson_update.latest_version = "3.6.0";
 config.mtgjson_update.download_url   = "http://localhost/mtgjson/AllSets-3.6.json"
 
+// delta updates for clients holding an older published version
+// NOTES:
+//   - files are in www/mtgjson; latest_file is the file behind download_url
+//   - history lists previously published versions, oldest first
+//   - clients further behind than max_delta_chain versions get the full file
+//   - leave delta_base_url empty to disable deltas
+config.mtgjson_update.latest_file     = "AllSets-3.6.json";
+config.mtgjson_update.history         = [ { version: "3.5.0", file: "AllSets-3.5.json" } ];
+config.mtgjson_update.max_delta_chain = 5;
+config.mtgjson_update.delta_base_url  = "http://localhost:53332/mtgjson/deltas";
+
 // redirect link to find client releases
 config.redirects.releases_url = "http://github.com/mildmongrel/thicket/releases";
 
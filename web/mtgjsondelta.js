@@ -0,0 +1,148 @@
+//
+// mtgjsondelta.js
+//
+// Binary deltas between published MTGJSON files; see thicket.js for the
+// format.  Computing a delta takes a while for a full AllSets file, so
+// the web services run this as a child process:
+//
+//   node mtgjsondelta.js <old file> <new file>
+//
+// writes the delta to stdout.
+//
+
+const crypto = require('crypto');
+const fs     = require('fs');
+
+const DELTA_BLOCK_SIZE = 4096;
+const DELTA_OP_END     = 0;
+const DELTA_OP_COPY    = 1;
+const DELTA_OP_DATA    = 2;
+
+// Rolling checksum over a block, as in rsync.
+function blockChecksum(buf, off)
+{
+    var a = 0, b = 0;
+    for(var i = 0; i < DELTA_BLOCK_SIZE; ++i)
+    {
+        a += buf[off + i];
+        b += (DELTA_BLOCK_SIZE - i) * buf[off + i];
+    }
+    return { a: a & 0xffff, b: b & 0xffff };
+}
+
+function checksumKey(sum)
+{
+    return (sum.a | (sum.b << 16)) >>> 0;
+}
+
+function writeUInt64BE(buf, value, off)
+{
+    buf.writeUInt32BE(Math.floor(value / 0x100000000), off);
+    buf.writeUInt32BE(value % 0x100000000, off + 4);
+}
+
+function makeDelta(oldBuf, newBuf)
+{
+    // Index the base file's blocks by checksum.
+    var index = new Map();
+    for(var off = 0; off + DELTA_BLOCK_SIZE <= oldBuf.length; off += DELTA_BLOCK_SIZE)
+    {
+        var key = checksumKey(blockChecksum(oldBuf, off));
+        if(!index.has(key)) index.set(key, []);
+        index.get(key).push(off);
+    }
+
+    // Scan the new file for blocks found in the base, extending each match
+    // as far as it goes.  Everything else is literal data.
+    var ops = [];
+    var literalStart = 0;
+    var k = 0;
+    var sum = (newBuf.length >= DELTA_BLOCK_SIZE) ? blockChecksum(newBuf, 0) : null;
+    while(k + DELTA_BLOCK_SIZE <= newBuf.length)
+    {
+        var matchOff = -1;
+        var candidates = index.get(checksumKey(sum));
+        if(candidates)
+        {
+            for(var c = 0; c < candidates.length; ++c)
+            {
+                if(oldBuf.compare(newBuf, k, k + DELTA_BLOCK_SIZE, candidates[c], candidates[c] + DELTA_BLOCK_SIZE) === 0)
+                {
+                    matchOff = candidates[c];
+                    break;
+                }
+            }
+        }
+
+        if(matchOff >= 0)
+        {
+            if(literalStart < k) ops.push({ op: DELTA_OP_DATA, data: newBuf.slice(literalStart, k) });
+            var len = DELTA_BLOCK_SIZE;
+            while(matchOff + len < oldBuf.length && k + len < newBuf.length &&
+                  oldBuf[matchOff + len] === newBuf[k + len] && len < 0xffffffff)
+            {
+                ++len;
+            }
+            var last = ops[ops.length - 1];
+            if(last && last.op === DELTA_OP_COPY && last.offset + last.length === matchOff && last.length + len <= 0xffffffff)
+            {
+                last.length += len;
+            }
+            else
+            {
+                ops.push({ op: DELTA_OP_COPY, offset: matchOff, length: len });
+            }
+            k += len;
+            literalStart = k;
+            if(k + DELTA_BLOCK_SIZE <= newBuf.length) sum = blockChecksum(newBuf, k);
+        }
+        else
+        {
+            if(k + DELTA_BLOCK_SIZE < newBuf.length)
+            {
+                var x = newBuf[k], y = newBuf[k + DELTA_BLOCK_SIZE];
+                sum.a = (sum.a - x + y) & 0xffff;
+                sum.b = (sum.b - DELTA_BLOCK_SIZE * x + sum.a) & 0xffff;
+            }
+            ++k;
+        }
+    }
+    if(literalStart < newBuf.length) ops.push({ op: DELTA_OP_DATA, data: newBuf.slice(literalStart) });
+
+    // Encode.
+    var header = Buffer.alloc(4 + 32 + 32 + 8);
+    header.write('TDL1', 0, 'ascii');
+    crypto.createHash('sha256').update(oldBuf).digest().copy(header, 4);
+    crypto.createHash('sha256').update(newBuf).digest().copy(header, 36);
+    writeUInt64BE(header, newBuf.length, 68);
+    var parts = [header];
+    ops.forEach(function(op)
+    {
+        if(op.op === DELTA_OP_COPY)
+        {
+            var rec = Buffer.alloc(13);
+            rec.writeUInt8(DELTA_OP_COPY, 0);
+            writeUInt64BE(rec, op.offset, 1);
+            rec.writeUInt32BE(op.length, 9);
+            parts.push(rec);
+        }
+        else
+        {
+            var rec = Buffer.alloc(5);
+            rec.writeUInt8(DELTA_OP_DATA, 0);
+            rec.writeUInt32BE(op.data.length, 1);
+            parts.push(rec, op.data);
+        }
+    });
+    parts.push(Buffer.from([DELTA_OP_END]));
+    return Buffer.concat(parts);
+}
+
+module.exports.makeDelta = makeDelta;
+
+if(require.main === module)
+{
+    var oldBuf = fs.readFileSync(process.argv[2]);
+    var newBuf = fs.readFileSync(process.argv[3]);
+    process.stdout.write(makeDelta(oldBuf, newBuf));
+}
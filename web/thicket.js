@@ -14,6 +14,8 @@ var express    = require('express');        // call express
 var app        = express();                 // define our app using express
 var semver     = require('semver');
 const assert   = require('assert');
+const execFile = require('child_process').execFile;
+const path     = require('path');
 
 // load configuration
 var config     = require('./config');
@@ -24,6 +26,114 @@ assert(semver.valid(config.client_update.latest_version),
        '** invalid config: client version **');
 assert(semver.valid(config.mtgjson_update.latest_version),
        '** invalid config: mtgjson version **');
+(config.mtgjson_update.history || []).forEach(function(entry)
+{
+    assert(semver.valid(entry.version) && entry.file,
+           '** invalid config: mtgjson history entry **');
+});
+
+// MTGJSON DELTAS
+// =============================================================================
+//
+// Published AllSets files are kept in www/mtgjson.  Clients holding an
+// older published version can fetch a chain of deltas, one per version
+// step, instead of the full file.  A delta is a generic binary diff:
+//
+//   magic "TDL1", base SHA-256 (32 bytes), result SHA-256 (32 bytes),
+//   result size (u64), then operations until END (all big-endian):
+//     END  (0)
+//     COPY (1): offset (u64), length (u32) - copy from the base file
+//     DATA (2): length (u32), bytes         - literal data
+//
+// Deltas are computed by mtgjsondelta.js in a child process so the event
+// loop never waits on them.  All published steps are computed at startup;
+// a request arriving before its delta is ready waits for it.  Finished
+// deltas are kept in memory.
+
+const MTGJSON_DIR     = 'www/mtgjson';
+const DELTA_MAX_BYTES = 512 * 1024 * 1024;
+
+var deltaCache = {};         // key -> delta buffer
+var deltaWaiters = {};       // key -> callbacks waiting on a computation
+
+// Published versions, oldest first, ending with the latest.
+function getPublishedVersions()
+{
+    var versions = (config.mtgjson_update.history || []).slice();
+    versions.push({ version: config.mtgjson_update.latest_version,
+                    file:    config.mtgjson_update.latest_file });
+    return versions;
+}
+
+// Deltas taking a client from its version to the latest, or null if the
+// version isn't published or the chain is too long.
+function getDeltaChain(fromVersion)
+{
+    if(!config.mtgjson_update.delta_base_url || !config.mtgjson_update.latest_file) return null;
+    var versions = getPublishedVersions();
+    var idx = versions.findIndex(function(entry) { return entry.version === fromVersion; });
+    if(idx < 0 || idx === versions.length - 1) return null;
+    if(versions.length - 1 - idx > config.mtgjson_update.max_delta_chain) return null;
+
+    var chain = [];
+    for(var i = idx; i < versions.length - 1; ++i)
+    {
+        chain.push({ from: versions[i].version,
+                     to:   versions[i + 1].version,
+                     url:  config.mtgjson_update.delta_base_url + '/' +
+                           versions[i].version + '/' + versions[i + 1].version });
+    }
+    return chain;
+}
+
+// Calls back with the delta between two consecutive published versions,
+// or null if there is none.
+function getDelta(fromVersion, toVersion, callback)
+{
+    var key = fromVersion + '/' + toVersion;
+    if(deltaCache[key]) return callback(null, deltaCache[key]);
+
+    var versions = getPublishedVersions();
+    var idx = versions.findIndex(function(entry) { return entry.version === fromVersion; });
+    if(idx < 0 || idx === versions.length - 1 || versions[idx + 1].version !== toVersion) return callback(null, null);
+
+    // Join a computation already running.
+    if(deltaWaiters[key]) return deltaWaiters[key].push(callback);
+    deltaWaiters[key] = [callback];
+
+    var args = [path.join(__dirname, 'mtgjsondelta.js'),
+                path.join(MTGJSON_DIR, versions[idx].file),
+                path.join(MTGJSON_DIR, versions[idx + 1].file)];
+    execFile(process.execPath, args, { encoding: 'buffer', maxBuffer: DELTA_MAX_BYTES },
+        function(err, stdout, stderr)
+        {
+            if(err)
+            {
+                console.log('  delta ' + key + ' failed: ' + err.message);
+            }
+            else
+            {
+                console.log('  computed delta ' + key + ': ' + stdout.length + ' bytes');
+                deltaCache[key] = stdout;
+            }
+            var waiters = deltaWaiters[key];
+            delete deltaWaiters[key];
+            waiters.forEach(function(waiter) { waiter(err, err ? null : stdout); });
+        });
+}
+
+// Compute every published step, one at a time, ahead of requests.
+function precomputeDeltas()
+{
+    if(!config.mtgjson_update.delta_base_url || !config.mtgjson_update.latest_file) return;
+    var versions = getPublishedVersions();
+    var next = function(i)
+    {
+        if(i >= versions.length - 1) return;
+        getDelta(versions[i].version, versions[i + 1].version, function() { next(i + 1); });
+    };
+    next(0);
+}
 
 // ROUTES FOR OUR API
 // =============================================================================
@@ -89,9 +199,19 @@ router.route('/update/mtgjson/:client_version')
         }
         else
         {
-            console.log('  OK (update available)');
-            res.json({ version:      config.mtgjson_update.latest_version,
-                       download_url: config.mtgjson_update.download_url });
+            var reply = { version:      config.mtgjson_update.latest_version,
+                          download_url: config.mtgjson_update.download_url };
+            var deltas = getDeltaChain(client_allsets_version);
+            if(deltas)
+            {
+                console.log('  OK (update available, ' + deltas.length + ' deltas)');
+                reply.deltas = deltas;
+            }
+            else
+            {
+                console.log('  OK (update available)');
+            }
+            res.json(reply);
         }
     });
 
@@ -105,6 +225,25 @@ app.use('/redirect/downloads', function (req, res, next) {
     res.redirect(config.redirects.releases_url);
 });
 
+// SETUP DELTA SERVING ------------------------------
+app.get('/mtgjson/deltas/:from/:to', function (req, res) {
+    console.log('[' + req.ip + '] mtgjson delta request: ' + req.params.from + ' -> ' + req.params.to);
+    getDelta(req.params.from, req.params.to, function(err, delta)
+    {
+        if(err)
+        {
+            console.log('  ERROR (' + err.message + ')');
+        }
+        if(!delta)
+        {
+            res.status(404).end();
+            return;
+        }
+        res.type('application/octet-stream');
+        res.send(delta);
+    });
+});
+
 // SETUP STATIC FILE SERVING -------------------------
 app.use('/mtgjson', function (req, res, next) {
     console.log('[' + req.ip + '] static mtgjson request: ' + req.url);
@@ -116,4 +255,5 @@ app.use('/mtgjson', express.static('www/mtgjson'));
 // =============================================================================
 app.listen(config.port);
 console.log('Thicket web services started on port ' + config.port);
+precomputeDeltas();
 